@@ -0,0 +1,27 @@
+# Writes the kernel modules in KERNEL_DIR to OUTPUT as null terminated byte arrays, for ComputeProgram::loadModules
+# ------------------------------------
+#
+# Usage: cmake -DKERNEL_DIR=<directory> -DOUTPUT=<header> -P EmbedKernels.cmake
+
+file(GLOB KERNEL_FILES "${KERNEL_DIR}/*.cl")
+
+list(SORT KERNEL_FILES)
+
+set(ARRAYS "")
+set(ENTRIES "")
+
+foreach(KERNEL_FILE ${KERNEL_FILES})
+    get_filename_component(NAME ${KERNEL_FILE} NAME_WE)
+
+    file(READ ${KERNEL_FILE} CONTENT HEX)
+
+    string(REGEX REPLACE "([0-9a-f][0-9a-f])" "0x\\1," CONTENT "${CONTENT}")
+
+    set(ARRAYS "${ARRAYS}\tstatic const unsigned char ${NAME}Source[] = { ${CONTENT}0x00 };\n\n")
+    set(ENTRIES "${ENTRIES}\t\t{ \"${NAME}\", ${NAME}Source },\n")
+endforeach()
+
+file(WRITE ${OUTPUT}.tmp "// Generated by EmbedKernels.cmake from ${KERNEL_DIR}, do not edit\n\n#pragma once\n\nnamespace neoKernels {\n${ARRAYS}\tstruct Source {\n\t\tconst char* _name;\n\t\tconst unsigned char* _data;\n\t};\n\n\tstatic const Source sources[] = {\n${ENTRIES}\t\t{ nullptr, nullptr }\n\t};\n}\n")
+
+# Only touch the header when the kernels changed, so it does not trigger rebuilds
+execute_process(COMMAND ${CMAKE_COMMAND} -E copy_if_different ${OUTPUT}.tmp ${OUTPUT})
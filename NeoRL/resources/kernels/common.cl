@@ -0,0 +1,261 @@
+// Shared samplers, constants and helpers, prepended to every module before it is compiled.
+// Everything here is static, so each module gets its own copy and modules link without clashes
+
+// ----------------------------------------- Samplers -----------------------------------------
+
+static constant sampler_t normalizedClampedNearestSampler = CLK_NORMALIZED_COORDS_TRUE |
+	CLK_ADDRESS_CLAMP |
+	CLK_FILTER_NEAREST;
+
+static constant sampler_t normalizedClampedToEdgeNearestSampler = CLK_NORMALIZED_COORDS_TRUE |
+	CLK_ADDRESS_CLAMP_TO_EDGE |
+	CLK_FILTER_NEAREST;
+
+static constant sampler_t unnormalizedClampedNearestSampler = CLK_NORMALIZED_COORDS_FALSE |
+	CLK_ADDRESS_CLAMP |
+	CLK_FILTER_NEAREST;
+
+static constant sampler_t defaultNormalizedSampler = CLK_NORMALIZED_COORDS_TRUE |
+	CLK_ADDRESS_CLAMP_TO_EDGE |
+	CLK_FILTER_NEAREST;
+
+static constant sampler_t defaultUnnormalizedSampler = CLK_NORMALIZED_COORDS_FALSE |
+	CLK_ADDRESS_CLAMP_TO_EDGE |
+	CLK_FILTER_NEAREST;
+
+// ----------------------------------------- Common -----------------------------------------
+
+static constant float minFloatEpsilon = 0.0001f;
+
+static float randFloat(uint2* state) {
+	const float invMaxInt = 1.0f / 4294967296.0f;
+	uint x = (*state).x * 17 + (*state).y * 13123;
+	(*state).x = (x << 13) ^ x;
+	(*state).y ^= (x << 7);
+
+	uint tmp = x * (x * x * 15731 + 74323) + 871483;
+
+	return convert_float(tmp) * invMaxInt;
+}
+
+static float randNormal(uint2* state) {
+	float u1 = randFloat(state);
+	float u2 = randFloat(state);
+
+	return sqrt(-2.0f * log(u1)) * cos(6.28318f * u2);
+}
+
+static float sigmoid(float x) {
+	return 1.0f / (1.0f + exp(-x));
+}
+
+static float relu(float x, float leak) {
+	if (x > 1.0f)
+		return 1.0f + (x - 1.0f) * leak;
+
+	return x > 0.0f ? x : x * leak;
+}
+
+static float relud(float x, float leak) {
+	return x > 0.0f && x < 1.0f ? 1.0f : leak;
+}
+
+static float elu(float x, float alpha) {
+	return x >= 0.0f ? x : alpha * (exp(x) - 1.0f);
+}
+
+static float elud(float x, float alpha) {
+	return x >= 0.0f ? 1.0f : x + alpha;
+}
+
+static bool inBounds0(int2 position, int2 upperBound) {
+	return position.x >= 0 && position.x < upperBound.x && position.y >= 0 && position.y < upperBound.y;
+}
+
+static bool inBounds(int2 position, int2 lowerBound, int2 upperBound) {
+	return position.x >= lowerBound.x && position.x < upperBound.x && position.y >= lowerBound.y && position.y < upperBound.y;
+}
+
+// Accumulate the weighted receptive field of a hidden unit onto a running sum
+static float accumulateField(float sum, read_only image2d_t visibleStates, read_only image3d_t weights,
+	int2 hiddenPosition, int2 visibleSize, float2 hiddenToVisible, int radius, uchar ignoreMiddle)
+{
+	int2 visiblePositionCenter = (int2)(hiddenPosition.x * hiddenToVisible.x + 0.5f, hiddenPosition.y * hiddenToVisible.y + 0.5f);
+
+	int2 fieldLowerBound = visiblePositionCenter - (int2)(radius);
+
+	for (int dx = -radius; dx <= radius; dx++)
+		for (int dy = -radius; dy <= radius; dy++) {
+			if (ignoreMiddle && dx == 0 && dy == 0)
+				continue;
+
+			int2 visiblePosition = visiblePositionCenter + (int2)(dx, dy);
+
+			if (inBounds0(visiblePosition, visibleSize)) {
+				int2 offset = visiblePosition - fieldLowerBound;
+
+				int wi = offset.y + offset.x * (radius * 2 + 1);
+
+				float weight = read_imagef(weights, (int4)(hiddenPosition.x, hiddenPosition.y, wi, 0)).x;
+
+				float state = read_imagef(visibleStates, visiblePosition).x;
+
+				sum += weight * state;
+			}
+		}
+
+	return sum;
+}
+
+// Same as accumulateField, but for weights with lazily decayed traces. The effective weight is x + y * pendingReward (see scAdvanceLazyTraces)
+// Without lazy traces pendingTraces is a placeholder that is not read
+static float accumulateFieldLazy(float sum, read_only image2d_t visibleStates, read_only image3d_t weights, read_only image2d_t pendingTraces,
+	int2 hiddenPosition, int2 visibleSize, float2 hiddenToVisible, int radius, uchar lazyTraces)
+{
+	int2 visiblePositionCenter = (int2)(hiddenPosition.x * hiddenToVisible.x + 0.5f, hiddenPosition.y * hiddenToVisible.y + 0.5f);
+
+	int2 fieldLowerBound = visiblePositionCenter - (int2)(radius);
+
+	float pendingReward = lazyTraces ? read_imagef(pendingTraces, hiddenPosition).x : 0.0f;
+
+	for (int dx = -radius; dx <= radius; dx++)
+		for (int dy = -radius; dy <= radius; dy++) {
+			int2 visiblePosition = visiblePositionCenter + (int2)(dx, dy);
+
+			if (inBounds0(visiblePosition, visibleSize)) {
+				int2 offset = visiblePosition - fieldLowerBound;
+
+				int wi = offset.y + offset.x * (radius * 2 + 1);
+
+				float2 weightTrace = read_imagef(weights, (int4)(hiddenPosition.x, hiddenPosition.y, wi, 0)).xy;
+
+				float state = read_imagef(visibleStates, visiblePosition).x;
+
+				sum += (weightTrace.x + weightTrace.y * pendingReward) * state;
+			}
+		}
+
+	return sum;
+}
+
+// Load the activations covered by a work group plus a halo of radius into local memory.
+// The image holds the activations from imageOrigin on, reads past its edges are clamped
+static void loadInhibitionTile(read_only image2d_t activations, local float* tile, int2 tileSize, int radius, int2 imageOrigin) {
+	int2 tileOrigin = (int2)(get_global_offset(0) + get_group_id(0) * get_local_size(0), get_global_offset(1) + get_group_id(1) * get_local_size(1)) - (int2)(radius);
+
+	int localIndex = get_local_id(0) + get_local_id(1) * get_local_size(0);
+	int localCount = get_local_size(0) * get_local_size(1);
+
+	for (int ti = localIndex; ti < tileSize.x * tileSize.y; ti += localCount) {
+		int2 tilePosition = (int2)(ti % tileSize.x, ti / tileSize.x);
+
+		tile[ti] = read_imagef(activations, unnormalizedClampedNearestSampler, tileOrigin + tilePosition - imageOrigin).x;
+	}
+
+	barrier(CLK_LOCAL_MEM_FENCE);
+}
+
+// Local k-WTA from a tile loaded by loadInhibitionTile. Same result as counting every neighbour that outranks the unit,
+// but the window is clipped up front and the scan stops as soon as the unit is known to lose
+static float localKWTA(local const float* tile, int2 tileSize, int2 hiddenPosition, int2 hiddenSize, int radius, float activeRatio) {
+	int2 center = (int2)(get_local_id(0), get_local_id(1)) + (int2)(radius);
+
+	float activation = tile[center.x + center.y * tileSize.x];
+
+	int2 lowerBound = max(hiddenPosition - (int2)(radius), (int2)(0)) - hiddenPosition;
+	int2 upperBound = min(hiddenPosition + (int2)(radius), hiddenSize - (int2)(1)) - hiddenPosition;
+
+	float counter = (upperBound.x - lowerBound.x + 1) * (upperBound.y - lowerBound.y + 1) - 1;
+
+	float maxInhibition = counter * activeRatio;
+
+	float inhibition = 0.0f;
+
+	for (int dx = lowerBound.x; dx <= upperBound.x; dx++)
+		for (int dy = lowerBound.y; dy <= upperBound.y; dy++) {
+			if (dx == 0 && dy == 0)
+				continue;
+
+			inhibition += tile[(center.x + dx) + (center.y + dy) * tileSize.x] >= activation ? 1.0f : 0.0f;
+
+			if (inhibition >= maxInhibition)
+				return 0.0f;
+		}
+
+	return inhibition < maxInhibition ? 1.0f : 0.0f;
+}
+
+// Whether any tile overlapping the (inclusive) region is flagged as changed. Past maxChangedTiles everything counts as changed
+static bool regionChanged(global const int* changedTiles, global const int* changedCount, int maxChangedTiles, int2 tileCounts, int tileSize,
+	int2 lowerBound, int2 upperBound)
+{
+	if (*changedCount > maxChangedTiles)
+		return true;
+
+	int2 tileLowerBound = max(lowerBound, (int2)(0)) / tileSize;
+	int2 tileUpperBound = min(max(upperBound, (int2)(0)) / tileSize, tileCounts - (int2)(1));
+
+	for (int tx = tileLowerBound.x; tx <= tileUpperBound.x; tx++)
+		for (int ty = tileLowerBound.y; ty <= tileUpperBound.y; ty++)
+			if (changedTiles[tx + ty * tileCounts.x])
+				return true;
+
+	return false;
+}
+
+// Whitened color of a single pixel from its local neighbourhood
+static float4 whitenColor(read_only image2d_t input, int2 position, int2 imageSize, int kernelRadius, float intensity) {
+	float4 currentColor = read_imagef(input, position);
+
+	float4 center = currentColor;
+
+	float count = 0.0f;
+
+	for (int dx = -kernelRadius; dx <= kernelRadius; dx++)
+		for (int dy = -kernelRadius; dy <= kernelRadius; dy++) {
+			if (dx == 0 && dy == 0)
+				continue;
+			
+			int2 otherPosition = position + (int2)(dx, dy);
+
+			if (inBounds0(otherPosition, imageSize)) {
+				float4 otherColor = read_imagef(input, otherPosition);
+
+				center += otherColor;
+
+				count++;
+			}
+		}
+
+	center /= count + 1.0f;
+
+	float4 centeredCurrentColor = currentColor - center;
+
+	float4 covariances = (float4)(0.0f);
+
+	for (int dx = -kernelRadius; dx <= kernelRadius; dx++)
+		for (int dy = -kernelRadius; dy <= kernelRadius; dy++) {
+			if (dx == 0 && dy == 0)
+				continue;
+			
+			int2 otherPosition = position + (int2)(dx, dy);
+
+			if (inBounds0(otherPosition, imageSize)) {
+				float4 otherColor = read_imagef(input, otherPosition);
+
+				float4 centeredOtherColor = otherColor - center;
+
+				covariances += centeredOtherColor * centeredCurrentColor;
+			}
+		}
+
+	covariances /= fmax(1.0f, count);
+
+	float4 centeredCurrentColorSigns = (float4)(centeredCurrentColor.x > 0.0f ? 1.0f : -1.0f,
+		centeredCurrentColor.y > 0.0f ? 1.0f : -1.0f,
+		centeredCurrentColor.z > 0.0f ? 1.0f : -1.0f,
+		centeredCurrentColor.w > 0.0f ? 1.0f : -1.0f);
+
+	// Modify color
+	return fmin(1.0f, fmax(-1.0f, (centeredCurrentColor > 0.0f ? (float4)(1.0f) : (float4)(-1.0f)) * (1.0f - exp(-fabs(intensity * covariances)))));
+}
@@ -0,0 +1,106 @@
+// Initialization kernels (random weights) and active unit bookkeeping
+
+// ----------------------------------------- Initialization -----------------------------------------
+
+// Initialize a random uniform 2D image (X field)
+void kernel randomUniform2D(write_only image2d_t values, uint2 seed, float2 minMax) {
+	uint2 seedValue = seed + (uint2)(get_global_id(0) * 29 + 12, get_global_id(1) * 16 + 23) * 36;
+
+	int2 position = (int2)(get_global_id(0), get_global_id(1));
+
+	float value = randFloat(&seedValue) * (minMax.y - minMax.x) + minMax.x;
+
+	write_imagef(values, position, (float4)(value, 0.0f, 0.0f, 0.0f));
+}
+
+// Initialize a random uniform 3D image (X field)
+void kernel randomUniform3D(write_only image3d_t values, uint2 seed, float2 minMax) {
+	uint2 seedValue = seed + (uint2)(get_global_id(0) * 12 + 76 + get_global_id(2) * 3, get_global_id(1) * 21 + 42 + get_global_id(2) * 7) * 12;
+
+	int3 position = (int3)(get_global_id(0), get_global_id(1), get_global_id(2));
+
+	float value = randFloat(&seedValue) * (minMax.y - minMax.x) + minMax.x;
+
+	write_imagef(values, (int4)(position, 0), (float4)(value, 0.0f, 0.0f, 0.0f));
+}
+
+// Initialize a random uniform 2D image (XY fields)
+void kernel randomUniform2DXY(write_only image2d_t values, uint2 seed, float2 minMax) {
+	uint2 seedValue = seed + (uint2)(get_global_id(0) * 15 + 66, get_global_id(1) * 61 + 2) * 56;
+
+	int2 position = (int2)(get_global_id(0), get_global_id(1));
+
+	float2 v = (float2)(randFloat(&seedValue) * (minMax.y - minMax.x) + minMax.x, randFloat(&seedValue) * (minMax.y - minMax.x) + minMax.x);
+
+	write_imagef(values, position, (float4)(v.x, v.y, 0.0f, 0.0f));
+}
+
+// Initialize a random uniform 2D image (XYZ fields)
+void kernel randomUniform2DXYZ(write_only image2d_t values, uint2 seed, float2 minMax) {
+	uint2 seedValue = seed + (uint2)(get_global_id(0) * 15 + 66, get_global_id(1) * 61 + 2) * 56;
+
+	int2 position = (int2)(get_global_id(0), get_global_id(1));
+
+	float3 v = (float3)(randFloat(&seedValue) * (minMax.y - minMax.x) + minMax.x, randFloat(&seedValue) * (minMax.y - minMax.x) + minMax.x, randFloat(&seedValue) * (minMax.y - minMax.x) + minMax.x);
+
+	write_imagef(values, position, (float4)(v.x, v.y, v.z, 0.0f));
+}
+
+// Initialize a random uniform 2D image (XZ fields)
+void kernel randomUniform2DXZ(write_only image2d_t values, uint2 seed, float2 minMax) {
+	uint2 seedValue = seed + (uint2)(get_global_id(0) * 29 + 12, get_global_id(1) * 16 + 23) * 36;
+
+	int2 position = (int2)(get_global_id(0), get_global_id(1));
+
+	float2 v = (float2)(randFloat(&seedValue) * (minMax.y - minMax.x) + minMax.x, randFloat(&seedValue) * (minMax.y - minMax.x) + minMax.x);
+
+	write_imagef(values, position, (float4)(v.x, 0.0f, v.y, 0.0f));
+}
+
+// Initialize a random uniform 3D image (XY fields)
+void kernel randomUniform3DXY(write_only image3d_t values, uint2 seed, float2 minMax) {
+	uint2 seedValue = seed + (uint2)(get_global_id(0) * 12 + 76 + get_global_id(2) * 3, get_global_id(1) * 21 + 42 + get_global_id(2) * 7) * 12;
+
+	int3 position = (int3)(get_global_id(0), get_global_id(1), get_global_id(2));
+
+	float2 v = (float2)(randFloat(&seedValue) * (minMax.y - minMax.x) + minMax.x, randFloat(&seedValue) * (minMax.y - minMax.x) + minMax.x);
+
+	write_imagef(values, (int4)(position, 0), (float4)(v.x, v.y, 0.0f, 0.0f));
+}
+
+// Initialize a random uniform 3D image (XZ fields)
+void kernel randomUniform3DXZ(write_only image3d_t values, uint2 seed, float2 minMax) {
+	uint2 seedValue = seed + (uint2)(get_global_id(0) * 12 + 76 + get_global_id(2) * 3, get_global_id(1) * 21 + 42 + get_global_id(2) * 7) * 12;
+
+	int3 position = (int3)(get_global_id(0), get_global_id(1), get_global_id(2));
+
+	float2 v = (float2)(randFloat(&seedValue) * (minMax.y - minMax.x) + minMax.x, randFloat(&seedValue) * (minMax.y - minMax.x) + minMax.x);
+
+	write_imagef(values, (int4)(position, 0), (float4)(v.x, 0.0f, v.y, 0.0f));
+}
+
+// Compact the positions of all units with a nonzero state into a list. activeCount must be zeroed before
+void kernel compactActiveUnits(read_only image2d_t hiddenStates, global int* activeCount, global int2* activeUnits) {
+	int2 hiddenPosition = (int2)(get_global_id(0), get_global_id(1));
+
+	float state = read_imagef(hiddenStates, hiddenPosition).x;
+
+	if (state != 0.0f)
+		activeUnits[atomic_inc(activeCount)] = hiddenPosition;
+}
+
+// Copy the weight slices of listed units only. Launched over the whole layer, work items past the list end exit immediately
+void kernel copyActiveSlices(read_only image3d_t weightsFrom, write_only image3d_t weightsTo,
+	global const int* activeCount, global const int2* activeUnits, int numWeights)
+{
+	if (get_global_id(0) >= *activeCount)
+		return;
+
+	int2 hiddenPosition = activeUnits[get_global_id(0)];
+
+	for (int wi = 0; wi < numWeights; wi++) {
+		float4 weight = read_imagef(weightsFrom, (int4)(hiddenPosition.x, hiddenPosition.y, wi, 0));
+
+		write_imagef(weightsTo, (int4)(hiddenPosition.x, hiddenPosition.y, wi, 0), weight);
+	}
+}
@@ -0,0 +1,767 @@
+// Predictor kernels (Predictor, SparsePredictor) and the PredictiveHierarchy inference megakernel
+
+// ----------------------------------------- Predictor -----------------------------------------
+
+void kernel predActivate(read_only image2d_t visibleStates,
+	read_only image2d_t hiddenSummationTempBack, write_only image2d_t hiddenSummationTempFront, read_only image3d_t weights,
+	int2 visibleSize, float2 hiddenToVisible, int radius)
+{
+	int2 hiddenPosition = (int2)(get_global_id(0), get_global_id(1));
+	int2 visiblePositionCenter = (int2)(hiddenPosition.x * hiddenToVisible.x + 0.5f, hiddenPosition.y * hiddenToVisible.y + 0.5f);
+	
+	float sum = read_imagef(hiddenSummationTempBack, hiddenPosition).x;
+
+	int2 fieldLowerBound = visiblePositionCenter - (int2)(radius);
+
+	float subSum = 0.0f;
+
+	for (int dx = -radius; dx <= radius; dx++)
+		for (int dy = -radius; dy <= radius; dy++) {
+			int2 visiblePosition = visiblePositionCenter + (int2)(dx, dy);
+
+			if (inBounds0(visiblePosition, visibleSize)) {
+				int2 offset = visiblePosition - fieldLowerBound;
+
+				int wi = offset.y + offset.x * (radius * 2 + 1);
+
+				float weight = read_imagef(weights, (int4)(hiddenPosition.x, hiddenPosition.y, wi, 0)).x;
+
+				float state = read_imagef(visibleStates, visiblePosition).x;
+
+				subSum += weight * state;
+			}
+		}
+
+	write_imagef(hiddenSummationTempFront, hiddenPosition, (float4)(sum + subSum));
+}
+
+void kernel predSolveHiddenBinary(read_only image2d_t hiddenSummationTemp,
+	write_only image2d_t hiddenStatesFront) 
+{
+	int2 hiddenPosition = (int2)(get_global_id(0), get_global_id(1));
+	
+	float sum = read_imagef(hiddenSummationTemp, hiddenPosition).x;
+
+	write_imagef(hiddenStatesFront, hiddenPosition, (float4)(sum > 0.5f ? 1.0f : 0.0f));
+}
+
+void kernel predSolveHiddenTanH(read_only image2d_t hiddenSummationTemp,
+	write_only image2d_t hiddenStatesFront) 
+{
+	int2 hiddenPosition = (int2)(get_global_id(0), get_global_id(1));
+	
+	float sum = read_imagef(hiddenSummationTemp, hiddenPosition).x;
+
+	write_imagef(hiddenStatesFront, hiddenPosition, (float4)(tanh(sum)));
+}
+
+void kernel predLearnWeights(read_only image2d_t visibleStatesPrev, 
+	read_only image2d_t targets, read_only image2d_t predictionsPrev, read_only image3d_t weightsBack, write_only image3d_t weightsFront,
+	int2 visibleSize, float2 hiddenToVisible, int radius, float weightAlpha)
+{
+	int2 hiddenPosition = (int2)(get_global_id(0), get_global_id(1));
+	int2 visiblePositionCenter = (int2)(hiddenPosition.x * hiddenToVisible.x + 0.5f, hiddenPosition.y * hiddenToVisible.y + 0.5f);
+
+	int2 fieldLowerBound = visiblePositionCenter - (int2)(radius);
+	
+	float target = read_imagef(targets, hiddenPosition).x;
+	float predPrev = read_imagef(predictionsPrev, hiddenPosition).x;
+
+	float alphaError = weightAlpha * (target - predPrev);
+
+	for (int dx = -radius; dx <= radius; dx++)
+		for (int dy = -radius; dy <= radius; dy++) {
+			int2 visiblePosition = visiblePositionCenter + (int2)(dx, dy);
+
+			if (inBounds0(visiblePosition, visibleSize)) {
+				int2 offset = visiblePosition - fieldLowerBound;
+
+				int wi = offset.y + offset.x * (radius * 2 + 1);
+
+				float weightPrev = read_imagef(weightsBack, (int4)(hiddenPosition.x, hiddenPosition.y, wi, 0)).x;
+
+				float state = read_imagef(visibleStatesPrev, visiblePosition).x;
+
+				float weight = weightPrev + alphaError * state;
+
+				write_imagef(weightsFront, (int4)(hiddenPosition.x, hiddenPosition.y, wi, 0), (float4)(weight));
+			}
+		}
+}
+
+void kernel predLearnWeightsTraces(read_only image2d_t visibleStatesPrev, 
+	read_only image2d_t targets, read_only image2d_t predictionsPrev, read_only image3d_t weightsBack, write_only image3d_t weightsFront,
+	int2 visibleSize, float2 hiddenToVisible, int radius, float weightAlpha, float weightLambda, float tdError)
+{
+	int2 hiddenPosition = (int2)(get_global_id(0), get_global_id(1));
+	int2 visiblePositionCenter = (int2)(hiddenPosition.x * hiddenToVisible.x + 0.5f, hiddenPosition.y * hiddenToVisible.y + 0.5f);
+
+	int2 fieldLowerBound = visiblePositionCenter - (int2)(radius);
+	
+	float target = read_imagef(targets, hiddenPosition).x;
+	float predPrev = read_imagef(predictionsPrev, hiddenPosition).x;
+
+	for (int dx = -radius; dx <= radius; dx++)
+		for (int dy = -radius; dy <= radius; dy++) {
+			int2 visiblePosition = visiblePositionCenter + (int2)(dx, dy);
+
+			if (inBounds0(visiblePosition, visibleSize)) {
+				int2 offset = visiblePosition - fieldLowerBound;
+
+				int wi = offset.y + offset.x * (radius * 2 + 1);
+
+				float2 weightPrev = read_imagef(weightsBack, (int4)(hiddenPosition.x, hiddenPosition.y, wi, 0)).xy;
+
+				float statePrev = read_imagef(visibleStatesPrev, visiblePosition).x;
+
+				float newTrace = weightPrev.y * weightLambda + (target - predPrev) * statePrev;
+	
+				float2 weight = (float2)(weightPrev.x + weightAlpha * (fmax(0.0f, tdError) * newTrace), newTrace);
+
+				write_imagef(weightsFront, (int4)(hiddenPosition.x, hiddenPosition.y, wi, 0), (float4)(weight, 0.0f, 0.0f));
+			}
+		}
+}
+
+void kernel predLearnQWeightsTraces(read_only image2d_t visibleStatesPrev, 
+	read_only image2d_t predictionsPrev, read_only image3d_t weightsBack, write_only image3d_t weightsFront,
+	int2 visibleSize, float2 hiddenToVisible, int radius, float weightAlpha, float weightLambda, float tdError)
+{
+	int2 hiddenPosition = (int2)(get_global_id(0), get_global_id(1));
+	int2 visiblePositionCenter = (int2)(hiddenPosition.x * hiddenToVisible.x + 0.5f, hiddenPosition.y * hiddenToVisible.y + 0.5f);
+
+	int2 fieldLowerBound = visiblePositionCenter - (int2)(radius);
+
+	float alphaError = weightAlpha;
+
+	for (int dx = -radius; dx <= radius; dx++)
+		for (int dy = -radius; dy <= radius; dy++) {
+			int2 visiblePosition = visiblePositionCenter + (int2)(dx, dy);
+
+			if (inBounds0(visiblePosition, visibleSize)) {
+				int2 offset = visiblePosition - fieldLowerBound;
+
+				int wi = offset.y + offset.x * (radius * 2 + 1);
+
+				float2 weightPrev = read_imagef(weightsBack, (int4)(hiddenPosition.x, hiddenPosition.y, wi, 0)).xy;
+
+				float state = read_imagef(visibleStatesPrev, visiblePosition).x;
+
+				float newTrace = weightPrev.y * weightLambda + alphaError * state;
+
+				float2 weight = (float2)(weightPrev.x + tdError * newTrace, newTrace);
+
+				write_imagef(weightsFront, (int4)(hiddenPosition.x, hiddenPosition.y, wi, 0), (float4)(weight, 0.0f, 0.0f));
+			}
+		}
+}
+
+// ----------------------------------------- Sparse Predictor -----------------------------------------
+
+void kernel spEncode(read_only image2d_t visibleStates,
+	read_only image2d_t hiddenSummationTempBack, write_only image2d_t hiddenSummationTempFront, read_only image3d_t weights,
+	int2 visibleSize, float2 hiddenToVisible, int radius, uchar ignoreMiddle, int2 summationOrigin)
+{
+	int2 hiddenPosition = (int2)(get_global_id(0), get_global_id(1));
+	int2 visiblePositionCenter = (int2)(hiddenPosition.x * hiddenToVisible.x + 0.5f, hiddenPosition.y * hiddenToVisible.y + 0.5f);
+	
+	float sum = read_imagef(hiddenSummationTempBack, hiddenPosition - summationOrigin).x;
+
+	int2 fieldLowerBound = visiblePositionCenter - (int2)(radius);
+
+	for (int dx = -radius; dx <= radius; dx++)
+		for (int dy = -radius; dy <= radius; dy++) {
+			if (ignoreMiddle && dx == 0 && dy == 0)
+				continue;
+
+			int2 visiblePosition = visiblePositionCenter + (int2)(dx, dy);
+
+			if (inBounds0(visiblePosition, visibleSize)) {
+				int2 offset = visiblePosition - fieldLowerBound;
+
+				int wi = offset.y + offset.x * (radius * 2 + 1);
+
+				float weight = read_imagef(weights, (int4)(hiddenPosition.x, hiddenPosition.y, wi, 0)).x;
+
+				float state = read_imagef(visibleStates, visiblePosition).x;
+
+				sum += state * weight;
+			}
+		}
+
+	write_imagef(hiddenSummationTempFront, hiddenPosition - summationOrigin, (float4)(sum));
+}
+
+// Fused encoding of two visible layers
+void kernel spEncode2(read_only image2d_t visibleStates0, read_only image2d_t visibleStates1,
+	read_only image2d_t hiddenSummationTempBack, write_only image2d_t hiddenSummationTempFront,
+	read_only image3d_t weights0, read_only image3d_t weights1,
+	int2 visibleSize0, int2 visibleSize1, float2 hiddenToVisible0, float2 hiddenToVisible1, int radius0, int radius1,
+	uchar ignoreMiddle0, uchar ignoreMiddle1, int2 summationOrigin)
+{
+	int2 hiddenPosition = (int2)(get_global_id(0), get_global_id(1));
+	
+	float sum = read_imagef(hiddenSummationTempBack, hiddenPosition - summationOrigin).x;
+
+	sum = accumulateField(sum, visibleStates0, weights0, hiddenPosition, visibleSize0, hiddenToVisible0, radius0, ignoreMiddle0);
+	sum = accumulateField(sum, visibleStates1, weights1, hiddenPosition, visibleSize1, hiddenToVisible1, radius1, ignoreMiddle1);
+
+	write_imagef(hiddenSummationTempFront, hiddenPosition - summationOrigin, (float4)(sum));
+}
+
+// Encode a visible layer, recomputing its contribution only where the receptive field touches a changed tile.
+// Elsewhere the contribution cached from the last computation is reused
+void kernel spEncodeChanged(read_only image2d_t visibleStates,
+	read_only image2d_t hiddenSummationTempBack, write_only image2d_t hiddenSummationTempFront,
+	read_only image2d_t encodeCacheBack, write_only image2d_t encodeCacheFront, read_only image3d_t weights,
+	int2 visibleSize, float2 hiddenToVisible, int radius, uchar ignoreMiddle,
+	global const int* changedTiles, global const int* changedCount, int maxChangedTiles, int2 tileCounts, int tileSize, int dilation, int2 summationOrigin)
+{
+	int2 hiddenPosition = (int2)(get_global_id(0), get_global_id(1));
+	int2 visiblePositionCenter = (int2)(hiddenPosition.x * hiddenToVisible.x + 0.5f, hiddenPosition.y * hiddenToVisible.y + 0.5f);
+
+	int2 reach = (int2)(radius + dilation);
+
+	float contribution;
+
+	if (regionChanged(changedTiles, changedCount, maxChangedTiles, tileCounts, tileSize, visiblePositionCenter - reach, visiblePositionCenter + reach))
+		contribution = accumulateField(0.0f, visibleStates, weights, hiddenPosition, visibleSize, hiddenToVisible, radius, ignoreMiddle);
+	else
+		contribution = read_imagef(encodeCacheBack, hiddenPosition).x;
+
+	write_imagef(encodeCacheFront, hiddenPosition, (float4)(contribution));
+
+	float sum = read_imagef(hiddenSummationTempBack, hiddenPosition - summationOrigin).x + contribution;
+
+	write_imagef(hiddenSummationTempFront, hiddenPosition - summationOrigin, (float4)(sum));
+}
+
+void kernel spDecode(read_only image2d_t hiddenStates, read_only image2d_t feedBackStates,
+	write_only image2d_t predictions, read_only image3d_t predWeights, read_only image3d_t feedBackWeights,
+	int2 hiddenSize, int2 feedBackSize, float2 visibleToHidden, float2 visibleToFeedBack, int predRadius, int feedBackRadius, uchar predictThresholded,
+	int2 predictionsOrigin)
+{
+	int2 visiblePosition = (int2)(get_global_id(0), get_global_id(1));
+	int2 hiddenPositionCenter = (int2)(visiblePosition.x * visibleToHidden.x + 0.5f, visiblePosition.y * visibleToHidden.y + 0.5f);
+	int2 feedBackPositionCenter = (int2)(visiblePosition.x * visibleToFeedBack.x + 0.5f, visiblePosition.y * visibleToFeedBack.y + 0.5f);
+	
+	int2 hiddenFieldLowerBound = hiddenPositionCenter - (int2)(predRadius);
+	int2 feedBackFieldLowerBound = feedBackPositionCenter - (int2)(feedBackRadius);
+
+	float sum = 0.0f;
+
+	for (int dx = -predRadius; dx <= predRadius; dx++)
+		for (int dy = -predRadius; dy <= predRadius; dy++) {
+			int2 hiddenPosition = hiddenPositionCenter + (int2)(dx, dy);
+
+			if (inBounds0(hiddenPosition, hiddenSize)) {
+				int2 offset = hiddenPosition - hiddenFieldLowerBound;
+
+				int wi = offset.y + offset.x * (predRadius * 2 + 1);
+
+				float weight = read_imagef(predWeights, (int4)(visiblePosition.x, visiblePosition.y, wi, 0)).x;
+
+				float state = read_imagef(hiddenStates, hiddenPosition).x;
+
+				sum += state * weight;
+			}
+		}
+
+	for (int dx = -feedBackRadius; dx <= feedBackRadius; dx++)
+		for (int dy = -feedBackRadius; dy <= feedBackRadius; dy++) {
+			int2 feedBackPosition = feedBackPositionCenter + (int2)(dx, dy);
+
+			if (inBounds0(feedBackPosition, feedBackSize)) {
+				int2 offset = feedBackPosition - feedBackFieldLowerBound;
+
+				int wi = offset.y + offset.x * (feedBackRadius * 2 + 1);
+
+				float weight = read_imagef(feedBackWeights, (int4)(visiblePosition.x, visiblePosition.y, wi, 0)).x;
+
+				float state = read_imagef(feedBackStates, feedBackPosition).x;
+
+				sum += state * weight;
+			}
+		}
+
+	write_imagef(predictions, visiblePosition - predictionsOrigin, (float4)(predictThresholded ? (sum > 0.5f ? 1.0f : 0.0f) : sum));
+}
+
+void kernel spSolveHidden(read_only image2d_t hiddenSummationTemp,
+	write_only image2d_t hiddenStatesFront,
+	int2 hiddenSize, int radius, float activeRatio, int2 summationOrigin, int2 statesOrigin)
+{
+	int2 hiddenPosition = (int2)(get_global_id(0), get_global_id(1));
+	
+	float activation = read_imagef(hiddenSummationTemp, hiddenPosition - summationOrigin).x;
+
+	float inhibition = 0.0f;
+
+	float counter = 0.0f;
+
+	for (int dx = -radius; dx <= radius; dx++)
+		for (int dy = -radius; dy <= radius; dy++) {
+			if (dx == 0 && dy == 0)
+				continue;
+			
+			int2 otherPosition = hiddenPosition + (int2)(dx, dy);
+
+			if (inBounds0(otherPosition, hiddenSize)) {
+				float otherActivation = read_imagef(hiddenSummationTemp, otherPosition - summationOrigin).x;
+
+				inhibition += otherActivation >= activation ? 1.0f : 0.0f;
+
+				counter++;
+			}
+		}
+
+	float state = inhibition < (counter * activeRatio) ? 1.0f : 0.0f;
+
+	write_imagef(hiddenStatesFront, hiddenPosition - statesOrigin, (float4)(state));
+}
+
+// Tiled version of spSolveHidden, the global size is rounded up to a multiple of the work group size.
+// The rounding can run past the rows the states image holds, those positions are discarded like the ones outside of the layer
+void kernel spSolveHiddenTiled(read_only image2d_t hiddenSummationTemp,
+	write_only image2d_t hiddenStatesFront, local float* tile,
+	int2 hiddenSize, int radius, float activeRatio, int2 summationOrigin, int2 statesOrigin)
+{
+	int2 hiddenPosition = (int2)(get_global_id(0), get_global_id(1));
+
+	int2 tileSize = (int2)(get_local_size(0), get_local_size(1)) + (int2)(radius * 2);
+
+	loadInhibitionTile(hiddenSummationTemp, tile, tileSize, radius, summationOrigin);
+
+	int2 statesPosition = hiddenPosition - statesOrigin;
+
+	if (!inBounds0(hiddenPosition, hiddenSize) || !inBounds0(statesPosition, get_image_dim(hiddenStatesFront)))
+		return;
+
+	float state = localKWTA(tile, tileSize, hiddenPosition, hiddenSize, radius, activeRatio);
+
+	write_imagef(hiddenStatesFront, statesPosition, (float4)(state));
+}
+
+void kernel spPredictionError(read_only image2d_t predictionsPrev, read_only image2d_t visibleStates, read_only image2d_t additionalErrors,
+	write_only image2d_t errors)
+{
+	int2 visiblePosition = (int2)(get_global_id(0), get_global_id(1));
+
+	float predPrev = read_imagef(predictionsPrev, visiblePosition).x;
+	float visibleState = read_imagef(visibleStates, visiblePosition).x;
+
+	float predError = visibleState - predPrev;
+
+	float additionalError = read_imagef(additionalErrors, visiblePosition).x;
+
+	write_imagef(errors, visiblePosition, (float4)(predError + additionalError));
+}
+
+void kernel spReverseEncode(read_only image2d_t hiddenStates, read_only image2d_t visibleStates,
+	write_only image2d_t reconError, read_only image3d_t weights,
+	int2 visibleSize, int2 hiddenSize, float2 visibleToHidden, float2 hiddenToVisible, int radius, int2 reverseRadii)
+{
+	int2 visiblePosition = (int2)(get_global_id(0), get_global_id(1));
+	int2 hiddenPositionCenter = (int2)(visiblePosition.x * visibleToHidden.x + 0.5f, visiblePosition.y * visibleToHidden.y + 0.5f);
+	
+	float recon = 0.0f;
+
+	for (int dx = -reverseRadii.x; dx <= reverseRadii.x; dx++)
+		for (int dy = -reverseRadii.y; dy <= reverseRadii.y; dy++) {
+			int2 hiddenPosition = hiddenPositionCenter + (int2)(dx, dy);
+		
+			if (inBounds0(hiddenPosition, hiddenSize)) {
+				// Next layer node's receptive field
+				int2 fieldCenter = (int2)(hiddenPosition.x * hiddenToVisible.x + 0.5f, hiddenPosition.y * hiddenToVisible.y + 0.5f);
+
+				int2 fieldLowerBound = fieldCenter - (int2)(radius);
+				int2 fieldUpperBound = fieldCenter + (int2)(radius + 1); // So is included in inBounds
+		
+				// Check for containment
+				if (inBounds(visiblePosition, fieldLowerBound, fieldUpperBound)) {	
+					int2 offset = visiblePosition - fieldLowerBound;
+
+					float hiddenState = read_imagef(hiddenStates, hiddenPosition).x;
+
+					int wi = offset.y + offset.x * (radius * 2 + 1);
+
+					float weight = read_imagef(weights, (int4)(hiddenPosition.x, hiddenPosition.y, wi, 0)).x;
+				
+					recon += hiddenState * weight;
+				}
+			}
+		}
+
+	float visibleState = read_imagef(visibleStates, visiblePosition).x;
+
+	write_imagef(reconError, visiblePosition, (float4)(visibleState - recon));
+}
+
+void kernel spErrorPropagation(read_only image2d_t errors,
+	read_only image2d_t hiddenErrorSummationTempBack, write_only image2d_t hiddenErrorSummationTempFront,
+	read_only image3d_t predWeights,
+	int2 visibleSize, int2 hiddenSize, float2 visibleToHidden, float2 hiddenToVisible, int predRadius, int2 reversePredDecodeRadii)
+{
+	int2 hiddenPosition = (int2)(get_global_id(0), get_global_id(1));
+	int2 visiblePositionCenter = (int2)(hiddenPosition.x * hiddenToVisible.x + 0.5f, hiddenPosition.y * hiddenToVisible.y + 0.5f);
+	
+	float error = read_imagef(hiddenErrorSummationTempBack, hiddenPosition).x;
+
+	for (int dx = -reversePredDecodeRadii.x; dx <= reversePredDecodeRadii.x; dx++)
+		for (int dy = -reversePredDecodeRadii.y; dy <= reversePredDecodeRadii.y; dy++) {
+			int2 visiblePosition = visiblePositionCenter + (int2)(dx, dy);
+		
+			if (inBounds0(visiblePosition, visibleSize)) {
+				// Next layer node's receptive field
+				int2 fieldCenter = (int2)(visiblePosition.x * visibleToHidden.x + 0.5f, visiblePosition.y * visibleToHidden.y + 0.5f);
+
+				int2 fieldLowerBound = fieldCenter - (int2)(predRadius);
+				int2 fieldUpperBound = fieldCenter + (int2)(predRadius + 1); // So is included in inBounds
+		
+				// Check for containment
+				if (inBounds(hiddenPosition, fieldLowerBound, fieldUpperBound)) {	
+					int2 offset = hiddenPosition - fieldLowerBound;
+
+					float visibleError = read_imagef(errors, visiblePosition).x;
+
+					int wi = offset.y + offset.x * (predRadius * 2 + 1);
+
+					float weight = read_imagef(predWeights, (int4)(visiblePosition.x, visiblePosition.y, wi, 0)).x;
+				
+					error += visibleError * weight;
+				}
+			}
+		}
+
+	write_imagef(hiddenErrorSummationTempFront, hiddenPosition, (float4)(error));
+}
+
+void kernel spLearnDecoderWeights(read_only image2d_t errors, read_only image2d_t hiddenStatesPrev, read_only image2d_t feedBackStatesPrev,
+	read_only image3d_t predWeightsBack, write_only image3d_t predWeightsFront,
+	read_only image3d_t feedBackWeightsBack, write_only image3d_t feedBackWeightsFront,
+	int2 hiddenSize, int2 feedBackSize, float2 visibleToHidden, float2 visibleToFeedBack, int predRadius, int feedBackRadius, float weightAlpha)
+{
+	int2 visiblePosition = (int2)(get_global_id(0), get_global_id(1));
+	int2 hiddenPositionCenter = (int2)(visiblePosition.x * visibleToHidden.x + 0.5f, visiblePosition.y * visibleToHidden.y + 0.5f);
+	int2 feedBackPositionCenter = (int2)(visiblePosition.x * visibleToFeedBack.x + 0.5f, visiblePosition.y * visibleToFeedBack.y + 0.5f);
+	
+	int2 hiddenFieldLowerBound = hiddenPositionCenter - (int2)(predRadius);
+	int2 feedBackFieldLowerBound = feedBackPositionCenter - (int2)(feedBackRadius);
+
+	float error = read_imagef(errors, visiblePosition).x;
+
+	for (int dx = -predRadius; dx <= predRadius; dx++)
+		for (int dy = -predRadius; dy <= predRadius; dy++) {
+			int2 hiddenPosition = hiddenPositionCenter + (int2)(dx, dy);
+
+			if (inBounds0(hiddenPosition, hiddenSize)) {
+				int2 offset = hiddenPosition - hiddenFieldLowerBound;
+
+				int wi = offset.y + offset.x * (predRadius * 2 + 1);
+
+				float2 weightPrev = read_imagef(predWeightsBack, (int4)(visiblePosition.x, visiblePosition.y, wi, 0)).xy;
+
+				float statePrev = read_imagef(hiddenStatesPrev, hiddenPosition).x;
+
+				float2 weight = (float2)(weightPrev.x + weightAlpha * error * statePrev, 0.0f);
+
+				write_imagef(predWeightsFront, (int4)(visiblePosition.x, visiblePosition.y, wi, 0), (float4)(weight.x, weight.y, 0.0f, 0.0f));
+			}
+		}
+
+	for (int dx = -feedBackRadius; dx <= feedBackRadius; dx++)
+		for (int dy = -feedBackRadius; dy <= feedBackRadius; dy++) {
+			int2 feedBackPosition = feedBackPositionCenter + (int2)(dx, dy);
+
+			if (inBounds0(feedBackPosition, feedBackSize)) {
+				int2 offset = feedBackPosition - feedBackFieldLowerBound;
+
+				int wi = offset.y + offset.x * (feedBackRadius * 2 + 1);
+
+				float4 weightPrev = read_imagef(feedBackWeightsBack, (int4)(visiblePosition.x, visiblePosition.y, wi, 0));
+
+				float statePrev = read_imagef(feedBackStatesPrev, feedBackPosition).x;
+				
+				float2 weight = (float2)(weightPrev.x + weightAlpha * error * statePrev, 0.0f);
+
+				write_imagef(feedBackWeightsFront, (int4)(visiblePosition.x, visiblePosition.y, wi, 0), (float4)(weight.x, weight.y, 0.0f, 0.0f));
+			}
+		}
+}
+
+void kernel spLearnEncoderWeights(read_only image2d_t hiddenErrors, read_only image2d_t hiddenStates, read_only image2d_t hiddenStatesPrev, read_only image2d_t hiddenActivations,
+	read_only image2d_t visibleStates, read_only image3d_t weightsBack, write_only image3d_t weightsFront,
+	int2 visibleSize, float2 hiddenToVisible, int radius, float weightAlpha, float weightLambda)
+{
+	int2 hiddenPosition = (int2)(get_global_id(0), get_global_id(1));
+	int2 visiblePositionCenter = (int2)(hiddenPosition.x * hiddenToVisible.x + 0.5f, hiddenPosition.y * hiddenToVisible.y + 0.5f);
+	
+	int2 fieldLowerBound = visiblePositionCenter - (int2)(radius);
+
+	float hiddenState = read_imagef(hiddenStates, hiddenPosition).x;
+	float hiddenStatePrev = read_imagef(hiddenStatesPrev, hiddenPosition).x;
+	float activation = read_imagef(hiddenActivations, hiddenPosition).x;
+
+	float hiddenError = read_imagef(hiddenErrors, hiddenPosition).x * hiddenStatePrev;
+
+	float reward = hiddenError * hiddenError;
+
+	for (int dx = -radius; dx <= radius; dx++)
+		for (int dy = -radius; dy <= radius; dy++) {
+			int2 visiblePosition = visiblePositionCenter + (int2)(dx, dy);
+
+			if (inBounds0(visiblePosition, visibleSize)) {
+				int2 offset = visiblePosition - fieldLowerBound;
+
+				int wi = offset.y + offset.x * (radius * 2 + 1);
+
+				float2 weightPrev = read_imagef(weightsBack, (int4)(hiddenPosition.x, hiddenPosition.y, wi, 0)).xy;
+
+				float state = read_imagef(visibleStates, visiblePosition).x;
+		
+				float2 weight = (float2)(weightPrev.x + weightAlpha * reward * weightPrev.y, weightPrev.y * weightLambda + hiddenError * state);
+
+				write_imagef(weightsFront, (int4)(hiddenPosition.x, hiddenPosition.y, wi, 0), (float4)(weight.x, weight.y, 0.0f, 0.0f));
+			}
+		}
+}
+
+void kernel spLearnBiases(read_only image2d_t hiddenStates, read_only image2d_t hiddenBiasesBack, write_only image2d_t hiddenBiasesFront, float biasAlpha, float activeRatio) {
+	int2 hiddenPosition = (int2)(get_global_id(0), get_global_id(1));
+
+	float hiddenState = read_imagef(hiddenStates, hiddenPosition).x;
+
+	float hiddenBiasPrev = read_imagef(hiddenBiasesBack, hiddenPosition).x;
+
+	write_imagef(hiddenBiasesFront, hiddenPosition, (float4)(hiddenBiasPrev + biasAlpha * (activeRatio - hiddenState)));
+}
+
+void kernel spAverageErrors(read_only image2d_t hiddenStatesPrev, read_only image2d_t hiddenErrorSummationTemp,
+	read_only image2d_t hiddenAverageErrorsBack, write_only image2d_t hiddenAverageErrorsFront, float averageErrorDecay)
+{
+	int2 hiddenPosition = (int2)(get_global_id(0), get_global_id(1));
+
+	float hiddenStatePrev = read_imagef(hiddenStatesPrev, hiddenPosition).x;
+
+	float error = read_imagef(hiddenErrorSummationTemp, hiddenPosition).x * hiddenStatePrev;
+
+	float averagePrev = read_imagef(hiddenAverageErrorsBack, hiddenPosition).x;
+
+	float average = (1.0f - averageErrorDecay) * averagePrev + averageErrorDecay * error * error;
+
+	write_imagef(hiddenAverageErrorsFront, hiddenPosition, (float4)(average));
+}
+
+// ----------------------------------------- Predictive Hierarchy -----------------------------------------
+
+// Layout of the per layer tables of phInferenceMegakernel (see HierarchyMegakernel)
+constant int phIntsPerLayer = 20;
+
+constant int phFloatsPerLayer = 8;
+
+// Barrier across every work group of the dispatch. One group only needs the group barrier,
+// with more groups all of them must be resident at the same time, otherwise this never returns.
+// OpenCL 1.2 gives no such forward progress guarantee between groups, HierarchyMegakernel::create only allows it on CPUs within the compute unit count
+void phGlobalBarrier(volatile global int* counter, int* generation) {
+	barrier(CLK_GLOBAL_MEM_FENCE);
+
+	if (get_num_groups(0) > 1) {
+		(*generation)++;
+
+		if (get_local_id(0) == 0) {
+			atomic_inc(counter);
+
+			int target = *generation * get_num_groups(0);
+
+			while (atomic_add(counter, 0) < target);
+		}
+
+		barrier(CLK_GLOBAL_MEM_FENCE);
+	}
+}
+
+// Feed forward and feed back of a whole predictive hierarchy without learning, in one dispatch.
+// Mirrors spEncode (first visible layer only), spSolveHidden and spDecode per layer, reading weights and writing states in flat buffers.
+// Layers not set in tickingMask hold their states and predictions
+void kernel phInferenceMegakernel(read_only image2d_t input, global const float* weights, global float* states,
+	global const int* layerInts, global const float* layerFloats, volatile global int* barrierCounter,
+	int numLayers, uint tickingMask)
+{
+	int generation = 0;
+
+	// Feed forward
+	for (int l = 0; l < numLayers; l++) {
+		if (!(tickingMask & (1u << l)))
+			continue;
+
+		global const int* li = layerInts + l * phIntsPerLayer;
+		global const float* lf = layerFloats + l * phFloatsPerLayer;
+
+		int2 hiddenSize = (int2)(li[0], li[1]);
+		int2 visibleSize = (int2)(li[2], li[3]);
+		int radius = li[6];
+		int lateralRadius = li[7];
+		uchar ignoreMiddle = li[11];
+
+		float2 hiddenToVisible = (float2)(lf[0], lf[1]);
+		float activeRatio = lf[6];
+
+		int numHidden = hiddenSize.x * hiddenSize.y;
+
+		global const float* encoderWeights = weights + li[12];
+		global const float* biases = weights + li[15];
+		global const float* visibleStates = states + (l > 0 ? layerInts[(l - 1) * phIntsPerLayer + 16] : 0);
+		global float* hiddenStates = states + li[16];
+		global float* summation = states + li[17];
+
+		// Encode, starting from the biases. A negative radius means the layer has no input
+		for (int hi = get_global_id(0); hi < numHidden; hi += get_global_size(0)) {
+			int2 hiddenPosition = (int2)(hi % hiddenSize.x, hi / hiddenSize.x);
+
+			float sum = biases[hi];
+
+			if (radius >= 0) {
+				int2 visiblePositionCenter = (int2)(hiddenPosition.x * hiddenToVisible.x + 0.5f, hiddenPosition.y * hiddenToVisible.y + 0.5f);
+
+				int2 fieldLowerBound = visiblePositionCenter - (int2)(radius);
+
+				for (int dx = -radius; dx <= radius; dx++)
+					for (int dy = -radius; dy <= radius; dy++) {
+						if (ignoreMiddle && dx == 0 && dy == 0)
+							continue;
+
+						int2 visiblePosition = visiblePositionCenter + (int2)(dx, dy);
+
+						if (inBounds0(visiblePosition, visibleSize)) {
+							int2 offset = visiblePosition - fieldLowerBound;
+
+							int wi = offset.y + offset.x * (radius * 2 + 1);
+
+							float weight = encoderWeights[2 * (hi + wi * numHidden)];
+
+							float state;
+
+							if (l > 0)
+								state = visibleStates[visiblePosition.x + visiblePosition.y * visibleSize.x];
+							else
+								state = read_imagef(input, visiblePosition).x;
+
+							sum += state * weight;
+						}
+					}
+			}
+
+			summation[hi] = sum;
+		}
+
+		phGlobalBarrier(barrierCounter, &generation);
+
+		// Solve
+		for (int hi = get_global_id(0); hi < numHidden; hi += get_global_size(0)) {
+			int2 hiddenPosition = (int2)(hi % hiddenSize.x, hi / hiddenSize.x);
+
+			float activation = summation[hi];
+
+			float inhibition = 0.0f;
+
+			float counter = 0.0f;
+
+			for (int dx = -lateralRadius; dx <= lateralRadius; dx++)
+				for (int dy = -lateralRadius; dy <= lateralRadius; dy++) {
+					if (dx == 0 && dy == 0)
+						continue;
+
+					int2 otherPosition = hiddenPosition + (int2)(dx, dy);
+
+					if (inBounds0(otherPosition, hiddenSize)) {
+						float otherActivation = summation[otherPosition.x + otherPosition.y * hiddenSize.x];
+
+						inhibition += otherActivation >= activation ? 1.0f : 0.0f;
+
+						counter++;
+					}
+				}
+
+			hiddenStates[hi] = inhibition < (counter * activeRatio) ? 1.0f : 0.0f;
+		}
+
+		phGlobalBarrier(barrierCounter, &generation);
+	}
+
+	// Feed back, the top layer has none
+	for (int l = numLayers - 1; l >= 0; l--) {
+		if (!(tickingMask & (1u << l)))
+			continue;
+
+		global const int* li = layerInts + l * phIntsPerLayer;
+		global const float* lf = layerFloats + l * phFloatsPerLayer;
+
+		int2 hiddenSize = (int2)(li[0], li[1]);
+		int2 visibleSize = (int2)(li[2], li[3]);
+		int2 feedBackSize = (int2)(li[4], li[5]);
+		int predRadius = li[8];
+		int feedBackRadius = l < numLayers - 1 ? li[9] : -1;
+		uchar predictThresholded = li[10];
+
+		float2 visibleToHidden = (float2)(lf[2], lf[3]);
+		float2 visibleToFeedBack = (float2)(lf[4], lf[5]);
+
+		int numVisible = visibleSize.x * visibleSize.y;
+
+		global const float* predWeights = weights + li[13];
+		global const float* feedBackWeights = weights + li[14];
+		global const float* hiddenStates = states + li[16];
+		global const float* feedBackStates = states + (l < numLayers - 1 ? layerInts[(l + 1) * phIntsPerLayer + 18] : 0);
+		global float* predictions = states + li[18];
+
+		for (int vi = get_global_id(0); vi < numVisible; vi += get_global_size(0)) {
+			int2 visiblePosition = (int2)(vi % visibleSize.x, vi / visibleSize.x);
+			int2 hiddenPositionCenter = (int2)(visiblePosition.x * visibleToHidden.x + 0.5f, visiblePosition.y * visibleToHidden.y + 0.5f);
+			int2 feedBackPositionCenter = (int2)(visiblePosition.x * visibleToFeedBack.x + 0.5f, visiblePosition.y * visibleToFeedBack.y + 0.5f);
+
+			int2 hiddenFieldLowerBound = hiddenPositionCenter - (int2)(predRadius);
+			int2 feedBackFieldLowerBound = feedBackPositionCenter - (int2)(feedBackRadius);
+
+			float sum = 0.0f;
+
+			for (int dx = -predRadius; dx <= predRadius; dx++)
+				for (int dy = -predRadius; dy <= predRadius; dy++) {
+					int2 hiddenPosition = hiddenPositionCenter + (int2)(dx, dy);
+
+					if (inBounds0(hiddenPosition, hiddenSize)) {
+						int2 offset = hiddenPosition - hiddenFieldLowerBound;
+
+						int wi = offset.y + offset.x * (predRadius * 2 + 1);
+
+						float weight = predWeights[2 * (vi + wi * numVisible)];
+
+						float state = hiddenStates[hiddenPosition.x + hiddenPosition.y * hiddenSize.x];
+
+						sum += state * weight;
+					}
+				}
+
+			for (int dx = -feedBackRadius; dx <= feedBackRadius; dx++)
+				for (int dy = -feedBackRadius; dy <= feedBackRadius; dy++) {
+					int2 feedBackPosition = feedBackPositionCenter + (int2)(dx, dy);
+
+					if (inBounds0(feedBackPosition, feedBackSize)) {
+						int2 offset = feedBackPosition - feedBackFieldLowerBound;
+
+						int wi = offset.y + offset.x * (feedBackRadius * 2 + 1);
+
+						float weight = feedBackWeights[2 * (vi + wi * numVisible)];
+
+						float state = feedBackStates[feedBackPosition.x + feedBackPosition.y * feedBackSize.x];
+
+						sum += state * weight;
+					}
+				}
+
+			predictions[vi] = predictThresholded ? (sum > 0.5f ? 1.0f : 0.0f) : sum;
+		}
+
+		if (l > 0)
+			phGlobalBarrier(barrierCounter, &generation);
+	}
+}
@@ -0,0 +1,417 @@
+// Agent kernels of the reinforcement learning hierarchies (prediction reward, Q routing, AgentPredQ)
+
+// ----------------------------------------- Predictive Hierarchy -----------------------------------------
+
+void kernel phPredictionReward(read_only image2d_t predictions, read_only image2d_t hiddenStates,
+	write_only image2d_t rewards, read_only image2d_t hiddenBaselinesBack, write_only image2d_t hiddenBaselinesFront, float activeRatio, float baselineDecay)
+{
+	int2 position = (int2)(get_global_id(0), get_global_id(1));
+	
+	float pred = read_imagef(predictions, position).x;
+
+	float state = read_imagef(hiddenStates, position).x;
+
+	float reward = pred * state;// + (1.0f - pred) * (1.0f - state) * activeRatio);
+
+	float baselinePrev = read_imagef(hiddenBaselinesBack, position).x;
+
+	float baseline = (1.0f - baselineDecay) * baselinePrev + baselineDecay * reward;
+
+	write_imagef(hiddenBaselinesFront, position, (float4)(baseline));
+	write_imagef(rewards, position, (float4)(fmax(0.0f, reward - baselinePrev)));
+}
+
+void kernel phPredictionRewardPropagation(read_only image2d_t rewards, write_only image2d_t propagatedRewards,
+	float2 hiddenToVisible, int2 visibleSize, int radius)
+{
+	int2 hiddenPosition = (int2)(get_global_id(0), get_global_id(1));
+	int2 visiblePositionCenter = (int2)(hiddenPosition.x * hiddenToVisible.x + 0.5f, hiddenPosition.y * hiddenToVisible.y + 0.5f);
+	
+	int2 fieldLowerBound = visiblePositionCenter - (int2)(radius);
+
+	float total = 0.0f;
+	float count = 0.0f;
+
+	for (int dx = -radius; dx <= radius; dx++)
+		for (int dy = -radius; dy <= radius; dy++) {
+			int2 visiblePosition = visiblePositionCenter + (int2)(dx, dy);
+
+			if (inBounds0(visiblePosition, visibleSize)) {
+				//int2 offset = visiblePosition - fieldLowerBound;
+
+				//int wi = offset.y + offset.x * (radius * 2 + 1);
+
+				float reward = read_imagef(rewards, visiblePosition).x;
+
+				total += reward;
+
+				count++;
+			}
+		}
+
+	write_imagef(propagatedRewards, hiddenPosition, (float4)(total / fmax(1.0f, count)));
+}
+
+void kernel phModulate(read_only image2d_t inputsLeft, read_only image2d_t inputsRight,
+	write_only image2d_t states, float minAttention)
+{
+	int2 position = (int2)(get_global_id(0), get_global_id(1));
+	
+	float left = read_imagef(inputsLeft, position).x;
+	float right = read_imagef(inputsRight, position).x;
+
+	write_imagef(states, position, (float4)(left * (minAttention + (1.0f - minAttention) * right)));
+}
+
+void kernel phCopyAction(read_only image2d_t source, write_only image2d_t destination) {
+	int2 position = (int2)(get_global_id(0), get_global_id(1));
+	
+	float s = read_imagef(source, position).x;
+	
+	write_imagef(destination, position, (float4)(s));
+}
+
+void kernel phExploration(read_only image2d_t actions,
+	write_only image2d_t actionsExploratory, float expPert, float expBreak, uint2 seed)  
+{
+	uint2 seedValue = seed + (uint2)(get_global_id(0) * 45 + 25, get_global_id(1) * 56 + 24) * 6;
+
+	int2 position = (int2)(get_global_id(0), get_global_id(1));
+	
+	float action = read_imagef(actions, position).x;
+	
+	write_imagef(actionsExploratory, position, (float4)(randFloat(&seedValue) < expBreak ? randFloat(&seedValue) * 2.0f - 1.0f : fmin(1.0f, fmax(-1.0f, action + expPert * randNormal(&seedValue)))));
+}
+
+void kernel phSetQ(read_only image2d_t qTransforms, write_only image2d_t qValues, float q) {
+	int2 position = (int2)(get_global_id(0), get_global_id(1));
+	
+	float3 trans = read_imagef(qTransforms, position).xyz;
+	
+	float wQ = q * q * trans.x + q * trans.y + trans.z;
+
+	write_imagef(qValues, position, (float4)(wQ));
+}
+
+void kernel phGetQ(read_only image2d_t qPreds, read_only image2d_t qTransforms, write_only image2d_t qValues) {
+	int2 position = (int2)(get_global_id(0), get_global_id(1));
+	
+	float pred = read_imagef(qPreds, position).x;
+	
+	float2 trans = read_imagef(qTransforms, position).xy;
+	
+	float wQ = (pred - trans.y) / (trans.x == 0.0f ? 1.0f : trans.x);
+
+	write_imagef(qValues, position, (float4)(wQ));
+}
+
+// ----------------------------------------- Q Route -----------------------------------------
+
+void kernel qForward(read_only image2d_t hiddenStates, read_only image3d_t qWeights, read_only image2d_t qBiases, read_only image2d_t qStatesPrev, write_only image2d_t qStatesFront,
+	int2 visibleSize, float2 hiddenToVisible, int radius, float reluLeak)
+{
+	int2 hiddenPosition = (int2)(get_global_id(0), get_global_id(1));
+	int2 visiblePositionCenter = (int2)(hiddenPosition.x * hiddenToVisible.x + 0.5f, hiddenPosition.y * hiddenToVisible.y + 0.5f);
+	
+	float sum = read_imagef(qBiases, hiddenPosition).x;
+
+	int2 fieldLowerBound = visiblePositionCenter - (int2)(radius);
+
+	for (int dx = -radius; dx <= radius; dx++)
+		for (int dy = -radius; dy <= radius; dy++) {
+			int2 visiblePosition = visiblePositionCenter + (int2)(dx, dy);
+
+			if (inBounds0(visiblePosition, visibleSize)) {
+				int2 offset = visiblePosition - fieldLowerBound;
+
+				int wi = offset.y + offset.x * (radius * 2 + 1);
+
+				float weight = read_imagef(qWeights, (int4)(hiddenPosition.x, hiddenPosition.y, wi, 0)).x;
+
+				float state = read_imagef(qStatesPrev, visiblePosition).x;
+
+				sum += weight * state;
+			}
+		}
+
+	float hiddenState = read_imagef(hiddenStates, hiddenPosition).x;
+
+	float state = sigmoid(sum) * hiddenState;
+	
+	write_imagef(qStatesFront, hiddenPosition, (float4)(state));
+}
+
+void kernel qLastForward(read_only image3d_t qWeights, read_only image2d_t qBiases, read_only image2d_t qStatesPrev, write_only image2d_t qStatesFront,
+	int2 visibleSize, float2 hiddenToVisible, int radius)
+{
+	int2 hiddenPosition = (int2)(get_global_id(0), get_global_id(1));
+	int2 visiblePositionCenter = (int2)(hiddenPosition.x * hiddenToVisible.x + 0.5f, hiddenPosition.y * hiddenToVisible.y + 0.5f);
+	
+	float sum = 0.0f;//read_imagef(qBiases, hiddenPosition).x;
+
+	int2 fieldLowerBound = visiblePositionCenter - (int2)(radius);
+
+	for (int dx = -radius; dx <= radius; dx++)
+		for (int dy = -radius; dy <= radius; dy++) {
+			int2 visiblePosition = visiblePositionCenter + (int2)(dx, dy);
+
+			if (inBounds0(visiblePosition, visibleSize)) {
+				int2 offset = visiblePosition - fieldLowerBound;
+
+				int wi = offset.y + offset.x * (radius * 2 + 1);
+
+				float weight = read_imagef(qWeights, (int4)(hiddenPosition.x, hiddenPosition.y, wi, 0)).x;
+
+				float state = read_imagef(qStatesPrev, visiblePosition).x;
+
+				sum += weight * state;
+			}
+		}
+
+	write_imagef(qStatesFront, hiddenPosition, (float4)(sum));
+}
+
+void kernel qBackward(read_only image2d_t hiddenStates, read_only image2d_t qStates, read_only image3d_t qWeights, read_only image2d_t qErrorsNext, write_only image2d_t qErrors,
+	int2 visibleSize, int2 hiddenSize, float2 visibleToHidden, float2 hiddenToVisible, int radius, int2 reverseRadii, float reluLeak)
+{
+	int2 visiblePosition = (int2)(get_global_id(0), get_global_id(1));
+	int2 hiddenPositionCenter = (int2)(visiblePosition.x * visibleToHidden.x + 0.5f, visiblePosition.y * visibleToHidden.y + 0.5f);
+	
+	float sum = 0.0f;
+
+	for (int dx = -reverseRadii.x; dx <= reverseRadii.x; dx++)
+		for (int dy = -reverseRadii.y; dy <= reverseRadii.y; dy++) {
+			int2 hiddenPosition = hiddenPositionCenter + (int2)(dx, dy);
+		
+			if (inBounds0(hiddenPosition, hiddenSize)) {
+				// Next layer node's receptive field
+				int2 fieldCenter = (int2)(hiddenPosition.x * hiddenToVisible.x + 0.5f, hiddenPosition.y * hiddenToVisible.y + 0.5f);
+
+				int2 fieldLowerBound = fieldCenter - (int2)(radius);
+				int2 fieldUpperBound = fieldCenter + (int2)(radius + 1); // So is included in inBounds
+		
+				// Check for containment
+				if (inBounds(visiblePosition, fieldLowerBound, fieldUpperBound)) {	
+					int2 offset = visiblePosition - fieldLowerBound;
+
+					float errorNext = read_imagef(qErrorsNext, hiddenPosition).x;
+
+					int wi = offset.y + offset.x * (radius * 2 + 1);
+
+					float weight = read_imagef(qWeights, (int4)(hiddenPosition.x, hiddenPosition.y, wi, 0)).x;
+				
+					sum += errorNext * weight;
+				}
+			}
+		}
+
+	sum = sum > 0.0f ? 1.0f : -1.0f;
+
+	float qState = read_imagef(qStates, visiblePosition).x;
+
+	float hiddenState = read_imagef(hiddenStates, visiblePosition).x;
+
+	float error = sum * qState * (1.0f - qState);// * hiddenState;
+
+	write_imagef(qErrors, visiblePosition, (float4)(error));
+}
+
+void kernel qLastBackward(read_only image2d_t hiddenStates, read_only image2d_t qStates, read_only image3d_t qWeights, write_only image2d_t qErrors,
+	int2 visibleSize, int2 hiddenSize, float2 visibleToHidden, float2 hiddenToVisible, int radius, int2 reverseRadii, float reluLeak)
+{
+	int2 visiblePosition = (int2)(get_global_id(0), get_global_id(1));
+	int2 hiddenPositionCenter = (int2)(visiblePosition.x * visibleToHidden.x + 0.5f, visiblePosition.y * visibleToHidden.y + 0.5f);
+	
+	float sum = 0.0f;
+
+	for (int dx = -reverseRadii.x; dx <= reverseRadii.x; dx++)
+		for (int dy = -reverseRadii.y; dy <= reverseRadii.y; dy++) {
+			int2 hiddenPosition = hiddenPositionCenter + (int2)(dx, dy);
+		
+			if (inBounds0(hiddenPosition, hiddenSize)) {
+				// Next layer node's receptive field
+				int2 fieldCenter = (int2)(hiddenPosition.x * hiddenToVisible.x + 0.5f, hiddenPosition.y * hiddenToVisible.y + 0.5f);
+
+				int2 fieldLowerBound = fieldCenter - (int2)(radius);
+				int2 fieldUpperBound = fieldCenter + (int2)(radius + 1); // So is included in inBounds
+		
+				// Check for containment
+				if (inBounds(visiblePosition, fieldLowerBound, fieldUpperBound)) {	
+					int2 offset = visiblePosition - fieldLowerBound;
+
+					int wi = offset.y + offset.x * (radius * 2 + 1);
+
+					float weight = read_imagef(qWeights, (int4)(hiddenPosition.x, hiddenPosition.y, wi, 0)).x;
+				
+					sum += weight;
+				}
+			}
+		}
+
+	sum = sum > 0.0f ? 1.0f : -1.0f;
+
+	float qState = read_imagef(qStates, visiblePosition).x;
+
+	float hiddenState = read_imagef(hiddenStates, visiblePosition).x;
+
+	float error = sum * qState * (1.0f - qState);// * hiddenState;
+
+	write_imagef(qErrors, visiblePosition, (float4)(error));
+}
+
+void kernel qFirstBackward(read_only image2d_t inputStates, read_only image3d_t qWeights, read_only image2d_t qErrorsNext, write_only image2d_t qErrors,
+	int2 visibleSize, int2 hiddenSize, float2 visibleToHidden, float2 hiddenToVisible, int radius, int2 reverseRadii)
+{
+	int2 visiblePosition = (int2)(get_global_id(0), get_global_id(1));
+	int2 hiddenPositionCenter = (int2)(visiblePosition.x * visibleToHidden.x + 0.5f, visiblePosition.y * visibleToHidden.y + 0.5f);
+	
+	float inputState = read_imagef(inputStates, visiblePosition).x;
+
+	float sum = 0.0f;
+
+	for (int dx = -reverseRadii.x; dx <= reverseRadii.x; dx++)
+		for (int dy = -reverseRadii.y; dy <= reverseRadii.y; dy++) {
+			int2 hiddenPosition = hiddenPositionCenter + (int2)(dx, dy);
+		
+			if (inBounds0(hiddenPosition, hiddenSize)) {
+				// Next layer node's receptive field
+				int2 fieldCenter = (int2)(hiddenPosition.x * hiddenToVisible.x + 0.5f, hiddenPosition.y * hiddenToVisible.y + 0.5f);
+
+				int2 fieldLowerBound = fieldCenter - (int2)(radius);
+				int2 fieldUpperBound = fieldCenter + (int2)(radius + 1); // So is included in inBounds
+		
+				// Check for containment
+				if (inBounds(visiblePosition, fieldLowerBound, fieldUpperBound)) {	
+					int2 offset = visiblePosition - fieldLowerBound;
+
+					float errorNext = read_imagef(qErrorsNext, hiddenPosition).x;
+
+					int wi = offset.y + offset.x * (radius * 2 + 1);
+
+					float weight = read_imagef(qWeights, (int4)(hiddenPosition.x, hiddenPosition.y, wi, 0)).x;
+
+					sum += errorNext * weight;
+				}
+			}
+		}
+
+	write_imagef(qErrors, visiblePosition, (float4)(sum));
+}
+
+void kernel qWeightUpdate(read_only image2d_t qStatesPrev, read_only image2d_t qStates, read_only image2d_t qErrors,
+	read_only image3d_t qWeightsBack, write_only image3d_t qWeightsFront,
+	read_only image2d_t qBiasesBack, write_only image2d_t qBiasesFront,
+	int2 visibleSize, float2 hiddenToVisible, int radius, float alpha, float biasAlpha, float lambda, float tdError)
+{
+	int2 hiddenPosition = (int2)(get_global_id(0), get_global_id(1));
+	int2 visiblePositionCenter = (int2)(hiddenPosition.x * hiddenToVisible.x + 0.5f, hiddenPosition.y * hiddenToVisible.y + 0.5f);
+	
+	float state = read_imagef(qStates, hiddenPosition).x;
+
+	float error = read_imagef(qErrors, hiddenPosition).x;
+	
+	// Bias
+	float2 biasPrev = read_imagef(qBiasesBack, hiddenPosition).xy;
+
+	//float2 bias = (float2)(biasPrev.x + alpha * tdError * biasPrev.y, biasPrev.y * lambda + error);
+	float2 bias = (float2)(biasPrev.x + biasAlpha * (0.5f - state), biasPrev.y * lambda + error);
+
+	write_imagef(qBiasesFront, hiddenPosition, (float4)(bias, 0.0f, 0.0f));
+
+	int2 fieldLowerBound = visiblePositionCenter - (int2)(radius);
+
+	for (int dx = -radius; dx <= radius; dx++)
+		for (int dy = -radius; dy <= radius; dy++) {
+			int2 visiblePosition = visiblePositionCenter + (int2)(dx, dy);
+
+			if (inBounds0(visiblePosition, visibleSize)) {
+				int2 offset = visiblePosition - fieldLowerBound;
+
+				int wi = offset.y + offset.x * (radius * 2 + 1);
+
+				float2 weightPrev = read_imagef(qWeightsBack, (int4)(hiddenPosition.x, hiddenPosition.y, wi, 0)).xy;
+
+				float statePrev = read_imagef(qStatesPrev, visiblePosition).x;
+
+				float2 weight = (float2)(weightPrev.x + alpha * tdError * weightPrev.y, weightPrev.y * lambda + error * statePrev);//(statePrev - error * weightPrev.x));
+
+				write_imagef(qWeightsFront, (int4)(hiddenPosition.x, hiddenPosition.y, wi, 0), (float4)(weight, 0.0f, 0.0f));
+			}
+		}
+}
+
+void kernel qLastWeightUpdate(read_only image2d_t qStatesPrev, read_only image2d_t qStates,
+	read_only image3d_t qWeightsBack, write_only image3d_t qWeightsFront,
+	read_only image2d_t qBiasesBack, write_only image2d_t qBiasesFront,
+	int2 visibleSize, float2 hiddenToVisible, int radius, float alpha, float biasAlpha, float lambda, float tdError)
+{
+	int2 hiddenPosition = (int2)(get_global_id(0), get_global_id(1));
+	int2 visiblePositionCenter = (int2)(hiddenPosition.x * hiddenToVisible.x + 0.5f, hiddenPosition.y * hiddenToVisible.y + 0.5f);
+	
+	float state = read_imagef(qStates, hiddenPosition).x;
+
+	// Bias
+	float2 biasPrev = read_imagef(qBiasesBack, hiddenPosition).xy;
+
+	//float2 bias = (float2)(biasPrev.x + alpha * tdError * biasPrev.y, biasPrev.y * lambda + 1.0f);
+	float2 bias = (float2)(biasPrev.x + biasAlpha * (0.5f - state), biasPrev.y * lambda + 1.0f);
+
+	write_imagef(qBiasesFront, hiddenPosition, (float4)(bias, 0.0f, 0.0f));
+
+	int2 fieldLowerBound = visiblePositionCenter - (int2)(radius);
+
+	for (int dx = -radius; dx <= radius; dx++)
+		for (int dy = -radius; dy <= radius; dy++) {
+			int2 visiblePosition = visiblePositionCenter + (int2)(dx, dy);
+
+			if (inBounds0(visiblePosition, visibleSize)) {
+				int2 offset = visiblePosition - fieldLowerBound;
+
+				int wi = offset.y + offset.x * (radius * 2 + 1);
+
+				float2 weightPrev = read_imagef(qWeightsBack, (int4)(hiddenPosition.x, hiddenPosition.y, wi, 0)).xy;
+
+				float statePrev = read_imagef(qStatesPrev, visiblePosition).x;
+
+				float2 weight = (float2)(weightPrev.x + alpha * tdError * weightPrev.y, weightPrev.y * lambda + statePrev);
+
+				write_imagef(qWeightsFront, (int4)(hiddenPosition.x, hiddenPosition.y, wi, 0), (float4)(weight, 0.0f, 0.0f));
+			}
+		}
+}
+
+void kernel qActionUpdate(read_only image2d_t actionsPrev, read_only image2d_t errors, write_only image2d_t actions, float alpha) {
+	int2 position = (int2)(get_global_id(0), get_global_id(1));
+	
+	float actionPrev = read_imagef(actionsPrev, position).x;
+
+	float error = read_imagef(errors, position).x;
+
+	float action = fmin(1.0f, fmax(-1.0f, actionPrev + alpha * (error > 0.0f ? 1.0f : -1.0f)));
+
+	write_imagef(actions, position, (float4)(action));
+}
+
+// ----------------------------------------- AgentPredQ -----------------------------------------
+
+void kernel pqSetQ(read_only image2d_t qTransforms, write_only image2d_t qValues, float q) {
+	int2 position = (int2)(get_global_id(0), get_global_id(1));
+	
+	float2 trans = read_imagef(qTransforms, position).xy;
+	
+	float wQ = q * trans.x + trans.y;
+
+	write_imagef(qValues, position, (float4)(wQ));
+}
+
+void kernel pqGetQ(read_only image2d_t qPreds, read_only image2d_t qTransforms, write_only image2d_t qValues) {
+	int2 position = (int2)(get_global_id(0), get_global_id(1));
+	
+	float pred = read_imagef(qPreds, position).x;
+	
+	float2 trans = read_imagef(qTransforms, position).xy;
+	
+	float wQ = (pred - trans.y) / (trans.x == 0.0f ? 1.0f : trans.x);
+
+	write_imagef(qValues, position, (float4)(wQ));
+}
@@ -0,0 +1,917 @@
+// Sparse coder kernels (ComparisonSparseCoder, SparseCoder)
+
+// ----------------------------------------- Comparison Sparse Coder -----------------------------------------
+
+void kernel cscActivate(read_only image2d_t visibleStates,
+	read_only image2d_t hiddenSummationTempBack, write_only image2d_t hiddenSummationTempFront, read_only image3d_t weights,
+	int2 visibleSize, float2 hiddenToVisible, int radius)
+{
+	int2 hiddenPosition = (int2)(get_global_id(0), get_global_id(1));
+	int2 visiblePositionCenter = (int2)(hiddenPosition.x * hiddenToVisible.x + 0.5f, hiddenPosition.y * hiddenToVisible.y + 0.5f);
+	
+	float sum = read_imagef(hiddenSummationTempBack, hiddenPosition).x;
+
+	int2 fieldLowerBound = visiblePositionCenter - (int2)(radius);
+
+	float subSum = 0.0f;
+
+	for (int dx = -radius; dx <= radius; dx++)
+		for (int dy = -radius; dy <= radius; dy++) {
+			int2 visiblePosition = visiblePositionCenter + (int2)(dx, dy);
+
+			if (inBounds0(visiblePosition, visibleSize)) {
+				int2 offset = visiblePosition - fieldLowerBound;
+
+				int wi = offset.y + offset.x * (radius * 2 + 1);
+
+				float weight = read_imagef(weights, (int4)(hiddenPosition.x, hiddenPosition.y, wi, 0)).x;
+
+				float state = read_imagef(visibleStates, visiblePosition).x;
+
+				subSum += state * weight;
+			}
+		}
+
+	write_imagef(hiddenSummationTempFront, hiddenPosition, (float4)(sum + subSum));
+}
+
+void kernel cscActivateIgnoreMiddle(read_only image2d_t visibleStates,
+	read_only image2d_t hiddenSummationTempBack, write_only image2d_t hiddenSummationTempFront, read_only image3d_t weights,
+	int2 visibleSize, float2 hiddenToVisible, int radius)
+{
+	int2 hiddenPosition = (int2)(get_global_id(0), get_global_id(1));
+	int2 visiblePositionCenter = (int2)(hiddenPosition.x * hiddenToVisible.x + 0.5f, hiddenPosition.y * hiddenToVisible.y + 0.5f);
+	
+	float sum = read_imagef(hiddenSummationTempBack, hiddenPosition).x;
+
+	int2 fieldLowerBound = visiblePositionCenter - (int2)(radius);
+
+	float subSum = 0.0f;
+
+	for (int dx = -radius; dx <= radius; dx++)
+		for (int dy = -radius; dy <= radius; dy++) {
+			if (dx == 0 && dy == 0)
+				continue;
+
+			int2 visiblePosition = visiblePositionCenter + (int2)(dx, dy);
+
+			if (inBounds0(visiblePosition, visibleSize)) {
+				int2 offset = visiblePosition - fieldLowerBound;
+
+				int wi = offset.y + offset.x * (radius * 2 + 1);
+
+				float weight = read_imagef(weights, (int4)(hiddenPosition.x, hiddenPosition.y, wi, 0)).x;
+
+				float state = read_imagef(visibleStates, visiblePosition).x;
+
+				subSum += state * weight;
+			}
+		}
+
+	write_imagef(hiddenSummationTempFront, hiddenPosition, (float4)(sum + subSum));
+}
+
+// Fused activation for two visible layers, starting from the back buffer only if accumulating
+void kernel cscActivate2(read_only image2d_t visibleStates0, read_only image2d_t visibleStates1,
+	read_only image2d_t hiddenSummationTempBack, write_only image2d_t hiddenSummationTempFront,
+	read_only image3d_t weights0, read_only image3d_t weights1,
+	int2 visibleSize0, int2 visibleSize1, float2 hiddenToVisible0, float2 hiddenToVisible1, int radius0, int radius1,
+	uchar ignoreMiddle0, uchar ignoreMiddle1, uchar accumulate)
+{
+	int2 hiddenPosition = (int2)(get_global_id(0), get_global_id(1));
+	
+	float sum = accumulate ? read_imagef(hiddenSummationTempBack, hiddenPosition).x : 0.0f;
+
+	sum += accumulateField(0.0f, visibleStates0, weights0, hiddenPosition, visibleSize0, hiddenToVisible0, radius0, ignoreMiddle0);
+	sum += accumulateField(0.0f, visibleStates1, weights1, hiddenPosition, visibleSize1, hiddenToVisible1, radius1, ignoreMiddle1);
+
+	write_imagef(hiddenSummationTempFront, hiddenPosition, (float4)(sum));
+}
+
+void kernel cscSolveHidden(read_only image2d_t hiddenActivationSummationTemp, read_only image2d_t hiddenPredictionSummationTemp,
+	write_only image2d_t hiddenStatesFront,
+	int2 hiddenSize, int radius, float activeRatio)
+{
+	int2 hiddenPosition = (int2)(get_global_id(0), get_global_id(1));
+	
+	float activation = read_imagef(hiddenActivationSummationTemp, hiddenPosition).x;
+
+	float inhibition = 0.0f;
+
+	float counter = 0.0f;
+
+	for (int dx = -radius; dx <= radius; dx++)
+		for (int dy = -radius; dy <= radius; dy++) {
+			if (dx == 0 && dy == 0)
+				continue;
+			
+			int2 otherPosition = hiddenPosition + (int2)(dx, dy);
+
+			if (inBounds0(otherPosition, hiddenSize)) {
+				float otherActivation = read_imagef(hiddenActivationSummationTemp, otherPosition).x;
+
+				inhibition += otherActivation >= activation ? 1.0f : 0.0f;
+
+				counter++;
+			}
+		}
+
+	float prediction = read_imagef(hiddenPredictionSummationTemp, hiddenPosition).x;
+
+	float binaryPred = prediction > 0.5f ? 1.0f : 0.0f;
+
+	float state = inhibition < (counter * activeRatio) ? (1.0f - binaryPred) : 0.0f;
+
+	write_imagef(hiddenStatesFront, hiddenPosition, (float4)(state));
+}
+
+// Tiled version of cscSolveHidden, the global size is rounded up to a multiple of the work group size
+void kernel cscSolveHiddenTiled(read_only image2d_t hiddenActivationSummationTemp, read_only image2d_t hiddenPredictionSummationTemp,
+	write_only image2d_t hiddenStatesFront, local float* tile,
+	int2 hiddenSize, int radius, float activeRatio)
+{
+	int2 hiddenPosition = (int2)(get_global_id(0), get_global_id(1));
+
+	int2 tileSize = (int2)(get_local_size(0), get_local_size(1)) + (int2)(radius * 2);
+
+	loadInhibitionTile(hiddenActivationSummationTemp, tile, tileSize, radius, (int2)(0));
+
+	if (!inBounds0(hiddenPosition, hiddenSize))
+		return;
+
+	float prediction = read_imagef(hiddenPredictionSummationTemp, hiddenPosition).x;
+
+	float binaryPred = prediction > 0.5f ? 1.0f : 0.0f;
+
+	float state = localKWTA(tile, tileSize, hiddenPosition, hiddenSize, radius, activeRatio) * (1.0f - binaryPred);
+
+	write_imagef(hiddenStatesFront, hiddenPosition, (float4)(state));
+}
+
+void kernel cscLearnHiddenBiases(read_only image2d_t biasesBack, write_only image2d_t biasesFront,
+	read_only image2d_t hiddenStates,
+	float alpha, float activeRatio)
+{
+	int2 hiddenPosition = (int2)(get_global_id(0), get_global_id(1));
+	
+	float biasPrev = read_imagef(biasesBack, hiddenPosition).x;
+
+	float state = read_imagef(hiddenStates, hiddenPosition).x;
+
+	float bias = biasPrev + alpha * (activeRatio - state);
+
+	write_imagef(biasesFront, hiddenPosition, (float4)(bias));
+}
+
+void kernel cscLearnHiddenWeightsActivation(read_only image2d_t visibleStates,
+	read_only image2d_t hiddenStates, read_only image2d_t hiddenActivations,
+	read_only image3d_t weightsBack, write_only image3d_t weightsFront,
+	int2 visibleSize, float2 hiddenToVisible, int radius, float weightAlpha)
+{
+	int2 hiddenPosition = (int2)(get_global_id(0), get_global_id(1));
+	int2 visiblePositionCenter = (int2)(hiddenPosition.x * hiddenToVisible.x + 0.5f, hiddenPosition.y * hiddenToVisible.y + 0.5f);
+
+	int2 fieldLowerBound = visiblePositionCenter - (int2)(radius);
+
+	float state = read_imagef(hiddenStates, hiddenPosition).x;
+	float activation = read_imagef(hiddenActivations, hiddenPosition).x;
+	
+	for (int dx = -radius; dx <= radius; dx++)
+		for (int dy = -radius; dy <= radius; dy++) {
+			int2 visiblePosition = visiblePositionCenter + (int2)(dx, dy);
+
+			if (inBounds0(visiblePosition, visibleSize)) {
+				int2 offset = visiblePosition - fieldLowerBound;
+
+				int wi = offset.y + offset.x * (radius * 2 + 1);
+
+				float weightPrev = read_imagef(weightsBack, (int4)(hiddenPosition.x, hiddenPosition.y, wi, 0)).x;
+
+				float visibleState = read_imagef(visibleStates, visiblePosition).x;
+			
+				float weight = weightPrev + weightAlpha * state * (visibleState - state * weightPrev);
+	
+				write_imagef(weightsFront, (int4)(hiddenPosition.x, hiddenPosition.y, wi, 0), (float4)(weight));
+			}
+		}
+}
+
+// Same update as cscLearnHiddenWeightsActivation, but only for the units in the active list (see compactActiveUnits)
+void kernel cscLearnHiddenWeightsActivationActive(read_only image2d_t visibleStates,
+	read_only image2d_t hiddenStates,
+	read_only image3d_t weightsBack, write_only image3d_t weightsFront,
+	global const int* activeCount, global const int2* activeUnits,
+	int2 visibleSize, float2 hiddenToVisible, int radius, float weightAlpha)
+{
+	if (get_global_id(0) >= *activeCount)
+		return;
+
+	int2 hiddenPosition = activeUnits[get_global_id(0)];
+	int2 visiblePositionCenter = (int2)(hiddenPosition.x * hiddenToVisible.x + 0.5f, hiddenPosition.y * hiddenToVisible.y + 0.5f);
+
+	int2 fieldLowerBound = visiblePositionCenter - (int2)(radius);
+
+	float state = read_imagef(hiddenStates, hiddenPosition).x;
+
+	for (int dx = -radius; dx <= radius; dx++)
+		for (int dy = -radius; dy <= radius; dy++) {
+			int2 visiblePosition = visiblePositionCenter + (int2)(dx, dy);
+
+			if (inBounds0(visiblePosition, visibleSize)) {
+				int2 offset = visiblePosition - fieldLowerBound;
+
+				int wi = offset.y + offset.x * (radius * 2 + 1);
+
+				float weightPrev = read_imagef(weightsBack, (int4)(hiddenPosition.x, hiddenPosition.y, wi, 0)).x;
+
+				float visibleState = read_imagef(visibleStates, visiblePosition).x;
+
+				float weight = weightPrev + weightAlpha * state * (visibleState - state * weightPrev);
+
+				write_imagef(weightsFront, (int4)(hiddenPosition.x, hiddenPosition.y, wi, 0), (float4)(weight));
+			}
+		}
+}
+
+void kernel cscLearnHiddenWeightsTracesActivation(read_only image2d_t rewards, read_only image2d_t visibleStates,
+	read_only image2d_t hiddenStates, read_only image2d_t hiddenActivations,
+	read_only image3d_t weightsBack, write_only image3d_t weightsFront,
+	int2 visibleSize, float2 hiddenToVisible, int radius, float weightAlpha, float weightLambda)
+{
+	int2 hiddenPosition = (int2)(get_global_id(0), get_global_id(1));
+	int2 visiblePositionCenter = (int2)(hiddenPosition.x * hiddenToVisible.x + 0.5f, hiddenPosition.y * hiddenToVisible.y + 0.5f);
+
+	int2 fieldLowerBound = visiblePositionCenter - (int2)(radius);
+
+	float reward = read_imagef(rewards, hiddenPosition).x;
+
+	float state = read_imagef(hiddenStates, hiddenPosition).x;
+	float activation = read_imagef(hiddenActivations, hiddenPosition).x;
+	
+	for (int dx = -radius; dx <= radius; dx++)
+		for (int dy = -radius; dy <= radius; dy++) {
+			int2 visiblePosition = visiblePositionCenter + (int2)(dx, dy);
+
+			if (inBounds0(visiblePosition, visibleSize)) {
+				int2 offset = visiblePosition - fieldLowerBound;
+
+				int wi = offset.y + offset.x * (radius * 2 + 1);
+
+				float2 weightPrev = read_imagef(weightsBack, (int4)(hiddenPosition.x, hiddenPosition.y, wi, 0)).xy;
+				
+				float visibleState = read_imagef(visibleStates, visiblePosition).x;
+	
+				float2 weight = (float2)(weightPrev.x + reward * weightPrev.y, weightPrev.y * weightLambda + weightAlpha * state * (visibleState - state * weightPrev.x));
+	
+				write_imagef(weightsFront, (int4)(hiddenPosition.x, hiddenPosition.y, wi, 0), (float4)(weight, 0.0f, 0.0f));
+			}
+		}
+}
+
+void kernel cscLearnHiddenWeightsPrediction(read_only image2d_t visibleStates,
+	read_only image2d_t hiddenStates, read_only image2d_t hiddenPredictions, 
+	read_only image3d_t weightsBack, write_only image3d_t weightsFront,
+	int2 visibleSize, float2 hiddenToVisible, int radius, float weightAlpha)
+{
+	int2 hiddenPosition = (int2)(get_global_id(0), get_global_id(1));
+	int2 visiblePositionCenter = (int2)(hiddenPosition.x * hiddenToVisible.x + 0.5f, hiddenPosition.y * hiddenToVisible.y + 0.5f);
+
+	int2 fieldLowerBound = visiblePositionCenter - (int2)(radius);
+
+	float state = read_imagef(hiddenStates, hiddenPosition).x;
+	float prediction = read_imagef(hiddenPredictions, hiddenPosition).x;
+
+	float error = state - (prediction > 0.5f ? 1.0f : 0.0f);
+
+	for (int dx = -radius; dx <= radius; dx++)
+		for (int dy = -radius; dy <= radius; dy++) {
+			int2 visiblePosition = visiblePositionCenter + (int2)(dx, dy);
+
+			if (inBounds0(visiblePosition, visibleSize)) {
+				int2 offset = visiblePosition - fieldLowerBound;
+
+				int wi = offset.y + offset.x * (radius * 2 + 1);
+
+				float weightPrev = read_imagef(weightsBack, (int4)(hiddenPosition.x, hiddenPosition.y, wi, 0)).x;
+
+				float visibleState = read_imagef(visibleStates, visiblePosition).x;
+			
+				float weight = weightPrev + weightAlpha * error * visibleState;
+	
+				write_imagef(weightsFront, (int4)(hiddenPosition.x, hiddenPosition.y, wi, 0), (float4)(weight));
+			}
+		}
+}
+
+void kernel cscLearnHiddenWeightsTracesPrediction(read_only image2d_t rewards, read_only image2d_t visibleStates,
+	read_only image2d_t hiddenStates, read_only image2d_t hiddenPredictions,  
+	read_only image3d_t weightsBack, write_only image3d_t weightsFront,
+	int2 visibleSize, float2 hiddenToVisible, int radius, float weightAlpha, float weightLambda)
+{
+	int2 hiddenPosition = (int2)(get_global_id(0), get_global_id(1));
+	int2 visiblePositionCenter = (int2)(hiddenPosition.x * hiddenToVisible.x + 0.5f, hiddenPosition.y * hiddenToVisible.y + 0.5f);
+
+	int2 fieldLowerBound = visiblePositionCenter - (int2)(radius);
+
+	float reward = read_imagef(rewards, hiddenPosition).x;
+
+	float state = read_imagef(hiddenStates, hiddenPosition).x;
+	float prediction = read_imagef(hiddenPredictions, hiddenPosition).x;
+
+	float error = state - (prediction > 0.5f ? 1.0f : 0.0f);
+
+	for (int dx = -radius; dx <= radius; dx++)
+		for (int dy = -radius; dy <= radius; dy++) {
+			int2 visiblePosition = visiblePositionCenter + (int2)(dx, dy);
+
+			if (inBounds0(visiblePosition, visibleSize)) {
+				int2 offset = visiblePosition - fieldLowerBound;
+
+				int wi = offset.y + offset.x * (radius * 2 + 1);
+
+				float2 weightPrev = read_imagef(weightsBack, (int4)(hiddenPosition.x, hiddenPosition.y, wi, 0)).xy;
+				
+				float visibleState = read_imagef(visibleStates, visiblePosition).x;
+	
+				float2 weight = (float2)(weightPrev.x + reward * weightPrev.y, weightPrev.y * weightLambda + weightAlpha * error * visibleState);
+	
+				write_imagef(weightsFront, (int4)(hiddenPosition.x, hiddenPosition.y, wi, 0), (float4)(weight, 0.0f, 0.0f));
+			}
+		}
+}
+
+void kernel cscForward(read_only image2d_t hiddenStates,
+	write_only image2d_t reconstruction, read_only image3d_t weights,
+	int2 visibleSize, int2 hiddenSize, float2 visibleToHidden, float2 hiddenToVisible, int radius, int2 reverseRadii)
+{
+	int2 visiblePosition = (int2)(get_global_id(0), get_global_id(1));
+	int2 hiddenPositionCenter = (int2)(visiblePosition.x * visibleToHidden.x + 0.5f, visiblePosition.y * visibleToHidden.y + 0.5f);
+	
+	float recon = 0.0f;
+
+	for (int dx = -reverseRadii.x; dx <= reverseRadii.x; dx++)
+		for (int dy = -reverseRadii.y; dy <= reverseRadii.y; dy++) {
+			int2 hiddenPosition = hiddenPositionCenter + (int2)(dx, dy);
+		
+			if (inBounds0(hiddenPosition, hiddenSize)) {
+				// Next layer node's receptive field
+				int2 fieldCenter = (int2)(hiddenPosition.x * hiddenToVisible.x + 0.5f, hiddenPosition.y * hiddenToVisible.y + 0.5f);
+
+				int2 fieldLowerBound = fieldCenter - (int2)(radius);
+				int2 fieldUpperBound = fieldCenter + (int2)(radius + 1); // So is included in inBounds
+		
+				// Check for containment
+				if (inBounds(visiblePosition, fieldLowerBound, fieldUpperBound)) {	
+					int2 offset = visiblePosition - fieldLowerBound;
+
+					float hiddenState = read_imagef(hiddenStates, hiddenPosition).x;
+
+					int wi = offset.y + offset.x * (radius * 2 + 1);
+
+					float weight = read_imagef(weights, (int4)(hiddenPosition.x, hiddenPosition.y, wi, 0)).x;
+				
+					recon += hiddenState * weight;
+				}
+			}
+		}
+
+	write_imagef(reconstruction, visiblePosition, (float4)(recon));
+}
+
+// ----------------------------------------- Sparse Coder -----------------------------------------
+
+void kernel scReconstructVisibleError(read_only image2d_t hiddenStates, read_only image2d_t visibleStates,
+	write_only image2d_t reconstructionError, read_only image3d_t weights,
+	int2 visibleSize, int2 hiddenSize, float2 visibleToHidden, float2 hiddenToVisible, int radius, int2 reverseRadii)
+{
+	int2 visiblePosition = (int2)(get_global_id(0), get_global_id(1));
+	int2 hiddenPositionCenter = (int2)(visiblePosition.x * visibleToHidden.x + 0.5f, visiblePosition.y * visibleToHidden.y + 0.5f);
+	
+	float recon = 0.0f;
+
+	for (int dx = -reverseRadii.x; dx <= reverseRadii.x; dx++)
+		for (int dy = -reverseRadii.y; dy <= reverseRadii.y; dy++) {
+			int2 hiddenPosition = hiddenPositionCenter + (int2)(dx, dy);
+		
+			if (inBounds0(hiddenPosition, hiddenSize)) {
+				// Next layer node's receptive field
+				int2 fieldCenter = (int2)(hiddenPosition.x * hiddenToVisible.x + 0.5f, hiddenPosition.y * hiddenToVisible.y + 0.5f);
+
+				int2 fieldLowerBound = fieldCenter - (int2)(radius);
+				int2 fieldUpperBound = fieldCenter + (int2)(radius + 1); // So is included in inBounds
+		
+				// Check for containment
+				if (inBounds(visiblePosition, fieldLowerBound, fieldUpperBound)) {	
+					int2 offset = visiblePosition - fieldLowerBound;
+
+					float hiddenState = read_imagef(hiddenStates, hiddenPosition).x;
+
+					int wi = offset.y + offset.x * (radius * 2 + 1);
+
+					float weight = read_imagef(weights, (int4)(hiddenPosition.x, hiddenPosition.y, wi, 0)).x;
+				
+					recon += hiddenState * weight;
+				}
+			}
+		}
+
+	float state = read_imagef(visibleStates, visiblePosition).x;
+
+	float error = state - recon;
+
+	write_imagef(reconstructionError, visiblePosition, (float4)(error));
+}
+
+void kernel scReconstructVisible(read_only image2d_t hiddenStates,
+	write_only image2d_t reconstruction, read_only image3d_t weights, read_only image2d_t pendingTraces,
+	int2 visibleSize, int2 hiddenSize, float2 visibleToHidden, float2 hiddenToVisible, int radius, int2 reverseRadii, uchar lazyTraces)
+{
+	int2 visiblePosition = (int2)(get_global_id(0), get_global_id(1));
+	int2 hiddenPositionCenter = (int2)(visiblePosition.x * visibleToHidden.x + 0.5f, visiblePosition.y * visibleToHidden.y + 0.5f);
+	
+	float recon = 0.0f;
+
+	for (int dx = -reverseRadii.x; dx <= reverseRadii.x; dx++)
+		for (int dy = -reverseRadii.y; dy <= reverseRadii.y; dy++) {
+			int2 hiddenPosition = hiddenPositionCenter + (int2)(dx, dy);
+		
+			if (inBounds0(hiddenPosition, hiddenSize)) {
+				// Next layer node's receptive field
+				int2 fieldCenter = (int2)(hiddenPosition.x * hiddenToVisible.x + 0.5f, hiddenPosition.y * hiddenToVisible.y + 0.5f);
+
+				int2 fieldLowerBound = fieldCenter - (int2)(radius);
+				int2 fieldUpperBound = fieldCenter + (int2)(radius + 1); // So is included in inBounds
+		
+				// Check for containment
+				if (inBounds(visiblePosition, fieldLowerBound, fieldUpperBound)) {	
+					int2 offset = visiblePosition - fieldLowerBound;
+
+					float hiddenState = read_imagef(hiddenStates, hiddenPosition).x;
+
+					int wi = offset.y + offset.x * (radius * 2 + 1);
+
+					float2 weightTrace = read_imagef(weights, (int4)(hiddenPosition.x, hiddenPosition.y, wi, 0)).xy;
+
+					float pendingReward = lazyTraces ? read_imagef(pendingTraces, hiddenPosition).x : 0.0f;
+
+					float weight = weightTrace.x + weightTrace.y * pendingReward;
+				
+					recon += hiddenState * weight;
+				}
+			}
+		}
+
+	write_imagef(reconstruction, visiblePosition, (float4)(recon));
+}
+
+void kernel scActivate(read_only image2d_t visibleStates,
+	read_only image2d_t hiddenSummationTempBack, write_only image2d_t hiddenSummationTempFront, read_only image3d_t weights, read_only image2d_t pendingTraces,
+	int2 visibleSize, float2 hiddenToVisible, int radius, uchar lazyTraces)
+{
+	int2 hiddenPosition = (int2)(get_global_id(0), get_global_id(1));
+	
+	float sum = read_imagef(hiddenSummationTempBack, hiddenPosition).x;
+
+	sum = accumulateFieldLazy(sum, visibleStates, weights, pendingTraces, hiddenPosition, visibleSize, hiddenToVisible, radius, lazyTraces);
+
+	write_imagef(hiddenSummationTempFront, hiddenPosition, (float4)(sum));
+}
+
+// Fused activation for two visible layers, starting from the back buffer only if accumulating
+void kernel scActivate2(read_only image2d_t visibleStates0, read_only image2d_t visibleStates1,
+	read_only image2d_t hiddenSummationTempBack, write_only image2d_t hiddenSummationTempFront,
+	read_only image3d_t weights0, read_only image3d_t weights1,
+	read_only image2d_t pendingTraces0, read_only image2d_t pendingTraces1,
+	int2 visibleSize0, int2 visibleSize1, float2 hiddenToVisible0, float2 hiddenToVisible1, int radius0, int radius1,
+	uchar lazyTraces0, uchar lazyTraces1, uchar accumulate)
+{
+	int2 hiddenPosition = (int2)(get_global_id(0), get_global_id(1));
+	
+	float sum = accumulate ? read_imagef(hiddenSummationTempBack, hiddenPosition).x : 0.0f;
+
+	sum = accumulateFieldLazy(sum, visibleStates0, weights0, pendingTraces0, hiddenPosition, visibleSize0, hiddenToVisible0, radius0, lazyTraces0);
+	sum = accumulateFieldLazy(sum, visibleStates1, weights1, pendingTraces1, hiddenPosition, visibleSize1, hiddenToVisible1, radius1, lazyTraces1);
+
+	write_imagef(hiddenSummationTempFront, hiddenPosition, (float4)(sum));
+}
+
+void kernel scSolveHidden(read_only image2d_t hiddenSummationTemp,
+	read_only image2d_t hiddenSpikesBack, write_only image2d_t hiddenSpikesFront, 
+	read_only image2d_t hiddenStatesBack, write_only image2d_t hiddenStatesFront, 
+	read_only image2d_t hiddenActivationsBack, write_only image2d_t hiddenActivationsFront, 
+	read_only image2d_t hiddenThresholds, read_only image3d_t weightsLateral,
+	global int* spikesChanged,
+	int2 hiddenSize, int radius, float leak, float accum, uchar checkConvergence) 
+{
+	int2 hiddenPosition = (int2)(get_global_id(0), get_global_id(1));
+	
+	float excitation = read_imagef(hiddenSummationTemp, hiddenPosition).x;
+
+	float statePrev = read_imagef(hiddenStatesBack, hiddenPosition).x;
+
+	float spikePrev = read_imagef(hiddenSpikesBack, hiddenPosition).x;
+
+	int2 fieldLowerBound = hiddenPosition - (int2)(radius);
+
+	float inhibition = 0.0f;
+
+	for (int dx = -radius; dx <= radius; dx++)
+		for (int dy = -radius; dy <= radius; dy++) {
+			if (dx == 0 && dy == 0)
+				continue;
+			
+			int2 otherPosition = hiddenPosition + (int2)(dx, dy);
+
+			if (inBounds0(otherPosition, hiddenSize)) {
+				int2 offset = otherPosition - fieldLowerBound;
+
+				int wi = offset.y + offset.x * (radius * 2 + 1);
+
+				float weight = read_imagef(weightsLateral, (int4)(hiddenPosition.x, hiddenPosition.y, wi, 0)).x;
+
+				float otherSpike = read_imagef(hiddenSpikesBack, otherPosition).x;
+
+				inhibition += weight * otherSpike;
+			}
+		}
+
+	float activation = read_imagef(hiddenActivationsBack, hiddenPosition).x;
+
+	activation = (1.0f - leak) * activation + excitation - inhibition;
+
+	float spike = 0.0f;
+
+	float threshold = read_imagef(hiddenThresholds, hiddenPosition).x;
+
+	if (activation > threshold) {
+		spike = 1.0f;
+
+		activation = 0.0f;
+	}
+
+	float state = spike;//(1.0f - accum) * statePrev + accum * spike;
+
+	// Flag that the spike pattern has not converged yet, only when the host reads the flag
+	if (checkConvergence && spike != spikePrev)
+		atomic_or(spikesChanged, 1);
+
+	write_imagef(hiddenSpikesFront, hiddenPosition, (float4)(spike));
+	write_imagef(hiddenStatesFront, hiddenPosition, (float4)(state));
+	write_imagef(hiddenActivationsFront, hiddenPosition, (float4)(activation));
+}
+
+// Runs all solver iterations in a single work group, keeping spikes and activations in local memory. Only usable when the whole hidden layer fits
+// When checkConvergence is set, stops once an iteration leaves the spike pattern unchanged.
+// solveStats layout: [0] changed flag (unused here), [1] total iterations, [2] steps, [3] max iterations, [4] min iterations
+void kernel scSolveHiddenPersistent(read_only image2d_t hiddenSummationTemp,
+	read_only image2d_t hiddenSpikesBack, write_only image2d_t hiddenSpikesFront, 
+	write_only image2d_t hiddenStatesFront, write_only image2d_t hiddenActivationsFront, 
+	read_only image2d_t hiddenThresholds, read_only image3d_t weightsLateral,
+	local uchar* spikesLocal0, local uchar* spikesLocal1, local float* activationsLocal,
+	global int* solveStats,
+	int2 hiddenSize, int radius, float leak, int iterations, uchar checkConvergence) 
+{
+	// Rotating change flags, so one can be cleared while another is being read without an extra barrier
+	local int changedLocal[3];
+
+	int numHidden = hiddenSize.x * hiddenSize.y;
+
+	int localIndex = get_local_id(0);
+	int localSize = get_local_size(0);
+
+	if (localIndex == 0) {
+		changedLocal[0] = 0;
+		changedLocal[1] = 0;
+		changedLocal[2] = 0;
+	}
+
+	// Spikes carry over from the previous step, activations start from zero
+	for (int hi = localIndex; hi < numHidden; hi += localSize) {
+		int2 hiddenPosition = (int2)(hi % hiddenSize.x, hi / hiddenSize.x);
+
+		spikesLocal0[hi] = read_imagef(hiddenSpikesBack, hiddenPosition).x > 0.0f ? 1 : 0;
+
+		activationsLocal[hi] = 0.0f;
+	}
+
+	barrier(CLK_LOCAL_MEM_FENCE);
+
+	local uchar* spikesPrev = spikesLocal0;
+	local uchar* spikes = spikesLocal1;
+
+	int iterationsUsed = iterations;
+
+	for (int iter = 0; iter < iterations; iter++) {
+		if (localIndex == 0)
+			changedLocal[(iter + 1) % 3] = 0;
+
+		for (int hi = localIndex; hi < numHidden; hi += localSize) {
+			int2 hiddenPosition = (int2)(hi % hiddenSize.x, hi / hiddenSize.x);
+
+			float excitation = read_imagef(hiddenSummationTemp, hiddenPosition).x;
+
+			int2 fieldLowerBound = hiddenPosition - (int2)(radius);
+
+			float inhibition = 0.0f;
+
+			for (int dx = -radius; dx <= radius; dx++)
+				for (int dy = -radius; dy <= radius; dy++) {
+					if (dx == 0 && dy == 0)
+						continue;
+
+					int2 otherPosition = hiddenPosition + (int2)(dx, dy);
+
+					if (inBounds0(otherPosition, hiddenSize)) {
+						int2 offset = otherPosition - fieldLowerBound;
+
+						int wi = offset.y + offset.x * (radius * 2 + 1);
+
+						float weight = read_imagef(weightsLateral, (int4)(hiddenPosition.x, hiddenPosition.y, wi, 0)).x;
+
+						float otherSpike = spikesPrev[otherPosition.x + otherPosition.y * hiddenSize.x];
+
+						inhibition += weight * otherSpike;
+					}
+				}
+
+			float activation = (1.0f - leak) * activationsLocal[hi] + excitation - inhibition;
+
+			uchar spike = 0;
+
+			float threshold = read_imagef(hiddenThresholds, hiddenPosition).x;
+
+			if (activation > threshold) {
+				spike = 1;
+
+				activation = 0.0f;
+			}
+
+			if (spike != spikesPrev[hi])
+				atomic_or(&changedLocal[iter % 3], 1);
+
+			spikes[hi] = spike;
+			activationsLocal[hi] = activation;
+		}
+
+		barrier(CLK_LOCAL_MEM_FENCE);
+
+		local uchar* temp = spikesPrev;
+		spikesPrev = spikes;
+		spikes = temp;
+
+		// Uniform across the work group, all items read the same flag after the barrier
+		if (checkConvergence && changedLocal[iter % 3] == 0) {
+			iterationsUsed = iter + 1;
+
+			break;
+		}
+	}
+
+	if (localIndex == 0) {
+		atomic_add(&solveStats[1], iterationsUsed);
+		atomic_inc(&solveStats[2]);
+		atomic_max(&solveStats[3], iterationsUsed);
+		atomic_min(&solveStats[4], iterationsUsed);
+	}
+
+	// Last iteration is now in spikesPrev
+	for (int hi = localIndex; hi < numHidden; hi += localSize) {
+		int2 hiddenPosition = (int2)(hi % hiddenSize.x, hi / hiddenSize.x);
+
+		float spike = spikesPrev[hi];
+
+		write_imagef(hiddenSpikesFront, hiddenPosition, (float4)(spike));
+		write_imagef(hiddenStatesFront, hiddenPosition, (float4)(spike));
+		write_imagef(hiddenActivationsFront, hiddenPosition, (float4)(activationsLocal[hi]));
+	}
+}
+
+void kernel scLearnThresholds(read_only image2d_t hiddenThresholdsBack, write_only image2d_t hiddenThresholdsFront,
+	read_only image2d_t hiddenStates,
+	float thresholdAlpha, float activeRatio)
+{
+	int2 hiddenPosition = (int2)(get_global_id(0), get_global_id(1));
+	
+	float thresholdPrev = read_imagef(hiddenThresholdsBack, hiddenPosition).x;
+
+	float hiddenState = read_imagef(hiddenStates, hiddenPosition).x;
+
+	float threshold = thresholdPrev + thresholdAlpha * ((hiddenState == 0.0f ? 0.0f : 1.0f) - activeRatio);
+
+	write_imagef(hiddenThresholdsFront, hiddenPosition, (float4)(threshold));
+}
+
+void kernel scLearnSparseCoderWeights(read_only image2d_t visibleStates,
+	read_only image2d_t hiddenStates, read_only image3d_t weightsBack, write_only image3d_t weightsFront,
+	int2 visibleSize, float2 hiddenToVisible, int radius, float weightAlpha)
+{
+	int2 hiddenPosition = (int2)(get_global_id(0), get_global_id(1));
+	int2 visiblePositionCenter = (int2)(hiddenPosition.x * hiddenToVisible.x + 0.5f, hiddenPosition.y * hiddenToVisible.y + 0.5f);
+
+	int2 fieldLowerBound = visiblePositionCenter - (int2)(radius);
+
+	float state = read_imagef(hiddenStates, hiddenPosition).x;
+
+	for (int dx = -radius; dx <= radius; dx++)
+		for (int dy = -radius; dy <= radius; dy++) {
+			int2 visiblePosition = visiblePositionCenter + (int2)(dx, dy);
+
+			if (inBounds0(visiblePosition, visibleSize)) {
+				int2 offset = visiblePosition - fieldLowerBound;
+
+				int wi = offset.y + offset.x * (radius * 2 + 1);
+
+				float weightPrev = read_imagef(weightsBack, (int4)(hiddenPosition.x, hiddenPosition.y, wi, 0)).x;
+
+				float visibleState = read_imagef(visibleStates, visiblePosition).x;
+
+				float weight = weightPrev + weightAlpha * state * (visibleState - state * weightPrev);
+
+				write_imagef(weightsFront, (int4)(hiddenPosition.x, hiddenPosition.y, wi, 0), (float4)(weight));
+			}
+		}
+}
+
+// Same update as scLearnSparseCoderWeights, but only for the units in the active list (see compactActiveUnits)
+void kernel scLearnSparseCoderWeightsActive(read_only image2d_t visibleStates,
+	read_only image2d_t hiddenStates, read_only image3d_t weightsBack, write_only image3d_t weightsFront,
+	global const int* activeCount, global const int2* activeUnits,
+	int2 visibleSize, float2 hiddenToVisible, int radius, float weightAlpha)
+{
+	if (get_global_id(0) >= *activeCount)
+		return;
+
+	int2 hiddenPosition = activeUnits[get_global_id(0)];
+	int2 visiblePositionCenter = (int2)(hiddenPosition.x * hiddenToVisible.x + 0.5f, hiddenPosition.y * hiddenToVisible.y + 0.5f);
+
+	int2 fieldLowerBound = visiblePositionCenter - (int2)(radius);
+
+	float state = read_imagef(hiddenStates, hiddenPosition).x;
+
+	for (int dx = -radius; dx <= radius; dx++)
+		for (int dy = -radius; dy <= radius; dy++) {
+			int2 visiblePosition = visiblePositionCenter + (int2)(dx, dy);
+
+			if (inBounds0(visiblePosition, visibleSize)) {
+				int2 offset = visiblePosition - fieldLowerBound;
+
+				int wi = offset.y + offset.x * (radius * 2 + 1);
+
+				float weightPrev = read_imagef(weightsBack, (int4)(hiddenPosition.x, hiddenPosition.y, wi, 0)).x;
+
+				float visibleState = read_imagef(visibleStates, visiblePosition).x;
+
+				float weight = weightPrev + weightAlpha * state * (visibleState - state * weightPrev);
+
+				write_imagef(weightsFront, (int4)(hiddenPosition.x, hiddenPosition.y, wi, 0), (float4)(weight));
+			}
+		}
+}
+
+void kernel scLearnSparseCoderWeightsTraces(read_only image2d_t visibleStates,
+	read_only image2d_t hiddenStates, read_only image3d_t weightsBack, write_only image3d_t weightsFront,
+	read_only image2d_t rewards,
+	int2 visibleSize, float2 hiddenToVisible, int radius, float weightAlpha, float weightTraceLambda)
+{
+	int2 hiddenPosition = (int2)(get_global_id(0), get_global_id(1));
+	int2 visiblePositionCenter = (int2)(hiddenPosition.x * hiddenToVisible.x + 0.5f, hiddenPosition.y * hiddenToVisible.y + 0.5f);
+
+	int2 fieldLowerBound = visiblePositionCenter - (int2)(radius);
+
+	float state = read_imagef(hiddenStates, hiddenPosition).x;
+
+	float reward = read_imagef(rewards, hiddenPosition).x;
+
+	for (int dx = -radius; dx <= radius; dx++)
+		for (int dy = -radius; dy <= radius; dy++) {
+			int2 visiblePosition = visiblePositionCenter + (int2)(dx, dy);
+
+			if (inBounds0(visiblePosition, visibleSize)) {
+				int2 offset = visiblePosition - fieldLowerBound;
+
+				int wi = offset.y + offset.x * (radius * 2 + 1);
+
+				float2 weightPrev = read_imagef(weightsBack, (int4)(hiddenPosition.x, hiddenPosition.y, wi, 0)).xy;
+
+				float visibleState = read_imagef(visibleStates, visiblePosition).x;
+
+				float2 weight = (float2)(weightPrev.x + reward * weightPrev.y, weightPrev.y * weightTraceLambda + weightAlpha * state * (visibleState - state * weightPrev.x));
+
+				write_imagef(weightsFront, (int4)(hiddenPosition.x, hiddenPosition.y, wi, 0), (float4)(weight, 0.0f, 0.0f));
+			}
+		}
+}
+
+// Lazy version of scLearnSparseCoderWeightsTraces for the units in the active list (see compactActiveUnits).
+// Rows of inactive units only decay their traces and consume rewards, which scAdvanceLazyTraces folds into two numbers per row:
+// the effective weight is x + y * pendingTraces.x, the effective trace is y * pendingTraces.y. Active rows are brought up to date here
+void kernel scLearnSparseCoderWeightsTracesLazy(read_only image2d_t visibleStates,
+	read_only image2d_t hiddenStates, read_only image3d_t weightsBack, write_only image3d_t weightsFront,
+	read_only image2d_t rewards, read_only image2d_t pendingTraces,
+	global const int* activeCount, global const int2* activeUnits,
+	int2 visibleSize, float2 hiddenToVisible, int radius, float weightAlpha, float weightTraceLambda)
+{
+	if (get_global_id(0) >= *activeCount)
+		return;
+
+	int2 hiddenPosition = activeUnits[get_global_id(0)];
+	int2 visiblePositionCenter = (int2)(hiddenPosition.x * hiddenToVisible.x + 0.5f, hiddenPosition.y * hiddenToVisible.y + 0.5f);
+
+	int2 fieldLowerBound = visiblePositionCenter - (int2)(radius);
+
+	float state = read_imagef(hiddenStates, hiddenPosition).x;
+
+	float reward = read_imagef(rewards, hiddenPosition).x;
+
+	float2 pending = read_imagef(pendingTraces, hiddenPosition).xy;
+
+	for (int dx = -radius; dx <= radius; dx++)
+		for (int dy = -radius; dy <= radius; dy++) {
+			int2 visiblePosition = visiblePositionCenter + (int2)(dx, dy);
+
+			if (inBounds0(visiblePosition, visibleSize)) {
+				int2 offset = visiblePosition - fieldLowerBound;
+
+				int wi = offset.y + offset.x * (radius * 2 + 1);
+
+				float2 weightStored = read_imagef(weightsBack, (int4)(hiddenPosition.x, hiddenPosition.y, wi, 0)).xy;
+
+				float2 weightPrev = (float2)(weightStored.x + weightStored.y * pending.x, weightStored.y * pending.y);
+
+				float visibleState = read_imagef(visibleStates, visiblePosition).x;
+
+				float2 weight = (float2)(weightPrev.x + reward * weightPrev.y, weightPrev.y * weightTraceLambda + weightAlpha * state * (visibleState - state * weightPrev.x));
+
+				write_imagef(weightsFront, (int4)(hiddenPosition.x, hiddenPosition.y, wi, 0), (float4)(weight, 0.0f, 0.0f));
+			}
+		}
+}
+
+// Advance the pending reward integral (x) and trace decay (y) of every row by one step. Active rows were brought up to date, so they restart
+void kernel scAdvanceLazyTraces(read_only image2d_t hiddenStates, read_only image2d_t rewards,
+	read_only image2d_t pendingTracesBack, write_only image2d_t pendingTracesFront,
+	float weightTraceLambda)
+{
+	int2 hiddenPosition = (int2)(get_global_id(0), get_global_id(1));
+
+	float state = read_imagef(hiddenStates, hiddenPosition).x;
+
+	float2 pending = (float2)(0.0f, 1.0f);
+
+	if (state == 0.0f) {
+		float reward = read_imagef(rewards, hiddenPosition).x;
+
+		float2 pendingPrev = read_imagef(pendingTracesBack, hiddenPosition).xy;
+
+		pending = (float2)(pendingPrev.x + reward * pendingPrev.y, pendingPrev.y * weightTraceLambda);
+	}
+
+	write_imagef(pendingTracesFront, hiddenPosition, (float4)(pending, 0.0f, 0.0f));
+}
+
+// Bring every row of lazily decayed weights up to date
+void kernel scFlushLazyTraces(read_only image3d_t weightsBack, write_only image3d_t weightsFront,
+	read_only image2d_t pendingTraces, int numWeights)
+{
+	int2 hiddenPosition = (int2)(get_global_id(0), get_global_id(1));
+
+	float2 pending = read_imagef(pendingTraces, hiddenPosition).xy;
+
+	for (int wi = 0; wi < numWeights; wi++) {
+		float2 weightStored = read_imagef(weightsBack, (int4)(hiddenPosition.x, hiddenPosition.y, wi, 0)).xy;
+
+		float2 weight = (float2)(weightStored.x + weightStored.y * pending.x, weightStored.y * pending.y);
+
+		write_imagef(weightsFront, (int4)(hiddenPosition.x, hiddenPosition.y, wi, 0), (float4)(weight, 0.0f, 0.0f));
+	}
+}
+
+void kernel scLearnSparseCoderWeightsLateral(read_only image2d_t hiddenStates,
+	read_only image3d_t weightsLateralBack, write_only image3d_t weightsLateralFront,
+	int2 hiddenSize, int radius, float weightLateralAlpha, float activeRatioSquared)
+{
+	int2 hiddenPosition = (int2)(get_global_id(0), get_global_id(1));
+	
+	int2 fieldLowerBound = hiddenPosition - (int2)(radius);
+
+	float state = read_imagef(hiddenStates, hiddenPosition).x;
+
+	for (int dx = -radius; dx <= radius; dx++)
+		for (int dy = -radius; dy <= radius; dy++) {
+			int2 otherPosition = hiddenPosition + (int2)(dx, dy);
+
+			if (inBounds0(otherPosition, hiddenSize)) {
+				int2 offset = otherPosition - fieldLowerBound;
+
+				int wi = offset.y + offset.x * (radius * 2 + 1);
+
+				float weightPrev = read_imagef(weightsLateralBack, (int4)(hiddenPosition.x, hiddenPosition.y, wi, 0)).x;
+
+				float otherState = read_imagef(hiddenStates, otherPosition).x;
+
+				float weight = fmax(0.0f, weightPrev + weightLateralAlpha * ((state == 0.0f ? 0.0f : 1.0f) * (otherState == 0.0f ? 0.0f : 1.0f) - activeRatioSquared));
+
+				write_imagef(weightsLateralFront, (int4)(hiddenPosition.x, hiddenPosition.y, wi, 0), (float4)(weight));
+			}
+		}
+}
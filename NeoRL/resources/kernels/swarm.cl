@@ -0,0 +1,602 @@
+// Predictor swarm kernels (PredictorSwarm, Swarm)
+
+// ----------------------------------------- Predictor Swarm -----------------------------------------
+
+void kernel predErrorPropagateSwarm(read_only image2d_t targets, read_only image2d_t hiddenStatesPrev,
+	write_only image2d_t errors, read_only image3d_t weights,
+	int2 visibleSize, int2 hiddenSize, float2 visibleToHidden, float2 hiddenToVisible, int radius, int2 reverseRadii)
+{
+	int2 visiblePosition = (int2)(get_global_id(0), get_global_id(1));
+	int2 hiddenPositionCenter = (int2)(visiblePosition.x * visibleToHidden.x + 0.5f, visiblePosition.y * visibleToHidden.y + 0.5f);
+	
+	float error = 0.0f;
+
+	for (int dx = -reverseRadii.x; dx <= reverseRadii.x; dx++)
+		for (int dy = -reverseRadii.y; dy <= reverseRadii.y; dy++) {
+			int2 hiddenPosition = hiddenPositionCenter + (int2)(dx, dy);
+		
+			if (inBounds0(hiddenPosition, hiddenSize)) {
+				// Next layer node's receptive field
+				int2 fieldCenter = (int2)(hiddenPosition.x * hiddenToVisible.x + 0.5f, hiddenPosition.y * hiddenToVisible.y + 0.5f);
+
+				int2 fieldLowerBound = fieldCenter - (int2)(radius);
+				int2 fieldUpperBound = fieldCenter + (int2)(radius + 1); // So is included in inBounds
+		
+				// Check for containment
+				if (inBounds(visiblePosition, fieldLowerBound, fieldUpperBound)) {	
+					int2 offset = visiblePosition - fieldLowerBound;
+
+					float predError = read_imagef(targets, hiddenPosition).x - read_imagef(hiddenStatesPrev, hiddenPosition).x;
+
+					int wi = offset.y + offset.x * (radius * 2 + 1);
+
+					float weight = read_imagef(weights, (int4)(hiddenPosition.x, hiddenPosition.y, wi, 0)).x;
+				
+					error += predError * weight;
+				}
+			}
+		}
+
+	write_imagef(errors, visiblePosition, (float4)(error));
+}
+
+void kernel predActivateSwarm(read_only image2d_t visibleStates,
+	read_only image2d_t hiddenSummationTempBack, write_only image2d_t hiddenSummationTempFront, read_only image3d_t weights,
+	int2 visibleSize, float2 hiddenToVisible, int radius)
+{
+	int2 hiddenPosition = (int2)(get_global_id(0), get_global_id(1));
+	int2 visiblePositionCenter = (int2)(hiddenPosition.x * hiddenToVisible.x + 0.5f, hiddenPosition.y * hiddenToVisible.y + 0.5f);
+	
+	float2 sum = read_imagef(hiddenSummationTempBack, hiddenPosition).xy;
+
+	int2 fieldLowerBound = visiblePositionCenter - (int2)(radius);
+
+	for (int dx = -radius; dx <= radius; dx++)
+		for (int dy = -radius; dy <= radius; dy++) {
+			int2 visiblePosition = visiblePositionCenter + (int2)(dx, dy);
+
+			if (inBounds0(visiblePosition, visibleSize)) {
+				int2 offset = visiblePosition - fieldLowerBound;
+
+				int wi = offset.y + offset.x * (radius * 2 + 1);
+
+				float2 weight = read_imagef(weights, (int4)(hiddenPosition.x, hiddenPosition.y, wi, 0)).xz;
+
+				float state = read_imagef(visibleStates, visiblePosition).x;
+
+				sum += weight * state;
+			}
+		}
+
+	write_imagef(hiddenSummationTempFront, hiddenPosition, (float4)(sum, 0.0f, 0.0f));
+}
+
+void kernel predLearnBiasesSwarm(read_only image2d_t hiddenStates, read_only image2d_t hiddenBiasesBack, write_only image2d_t hiddenBiasesFront,
+	float alpha, float activeRatio)
+{
+	int2 hiddenPosition = (int2)(get_global_id(0), get_global_id(1));
+
+	float state = read_imagef(hiddenStates, hiddenPosition).x;
+
+	float biasPrev = read_imagef(hiddenBiasesBack, hiddenPosition).x;
+
+	float bias = biasPrev + alpha * (activeRatio - state);
+
+	write_imagef(hiddenBiasesFront, hiddenPosition, (float4)(bias, 0.0f, 0.0f, 0.0f));
+}
+
+void kernel predLearnWeightsTracesSwarm(read_only image2d_t visibleStatesPrev, read_only image2d_t targets,
+	read_only image2d_t predictionStates, read_only image2d_t predictionActivationsPrev, read_only image2d_t predictionStatesPrev,
+	read_only image3d_t weightsBack, write_only image3d_t weightsFront,
+	read_only image3d_t qTracesBack, write_only image3d_t qTracesFront,
+	int2 visibleSize, float2 hiddenToVisible, int radius, float2 weightAlpha, float2 weightLambda,
+	float reward, float gamma, float activeRatio, float noise)
+{
+	int2 hiddenPosition = (int2)(get_global_id(0), get_global_id(1));
+	int2 visiblePositionCenter = (int2)(hiddenPosition.x * hiddenToVisible.x + 0.5f, hiddenPosition.y * hiddenToVisible.y + 0.5f);
+
+	int2 fieldLowerBound = visiblePositionCenter - (int2)(radius);
+	
+	float target = read_imagef(targets, hiddenPosition).x;
+	float2 state = read_imagef(predictionStates, hiddenPosition).xy;
+	float predActPrev = read_imagef(predictionActivationsPrev, hiddenPosition).x;
+	float2 predPrev = read_imagef(predictionStatesPrev, hiddenPosition).xy;
+
+	float predError = target - predPrev.x;
+
+	float tdError = reward + gamma * state.y - predPrev.y;
+
+	for (int dx = -radius; dx <= radius; dx++)
+		for (int dy = -radius; dy <= radius; dy++) {
+			int2 visiblePosition = visiblePositionCenter + (int2)(dx, dy);
+
+			if (inBounds0(visiblePosition, visibleSize)) {
+				int2 offset = visiblePosition - fieldLowerBound;
+
+				int wi = offset.y + offset.x * (radius * 2 + 1);
+
+				float4 weightPrev = read_imagef(weightsBack, (int4)(hiddenPosition.x, hiddenPosition.y, wi, 0));
+				float qTracePrev = read_imagef(qTracesBack, (int4)(hiddenPosition.x, hiddenPosition.y, wi, 0)).x;
+
+				float statePrev = read_imagef(visibleStatesPrev, visiblePosition).x;
+
+				//float clear = 1.0f - statePrev;
+
+				float newYTrace = weightPrev.y * weightLambda.x + predError * statePrev;
+				float newWTrace = weightPrev.w * weightLambda.x + 0.0f;//predPrev.x * statePrev; // Reversal trace
+				float newQTrace = qTracePrev * weightLambda.y + statePrev;
+
+				float change = tdError * newYTrace;
+
+				float4 weight = (float4)(fmin(1.0f, fmax(-1.0f, weightPrev.x + weightAlpha.x * tdError * newYTrace)), newYTrace,
+						weightPrev.z + weightAlpha.y * tdError * newQTrace, newWTrace);
+
+				write_imagef(weightsFront, (int4)(hiddenPosition.x, hiddenPosition.y, wi, 0), weight);
+				write_imagef(qTracesFront, (int4)(hiddenPosition.x, hiddenPosition.y, wi, 0), (float4)(newQTrace));
+			}
+		}
+}
+
+void kernel predSolveHiddenSwarm(read_only image2d_t sums,
+	write_only image2d_t states, write_only image2d_t activations,
+	int2 size, int radius, float activeRatio)
+{
+	int2 position = (int2)(get_global_id(0), get_global_id(1));
+	
+	float2 sum = read_imagef(sums, position).xy;
+
+	float inhibition = 0.0f;
+
+	float counter = 0.0f;
+
+	for (int dx = -radius; dx <= radius; dx++)
+		for (int dy = -radius; dy <= radius; dy++) {
+			if (dx == 0 && dy == 0)
+				continue;
+			
+			int2 otherPosition = position + (int2)(dx, dy);
+
+			if (inBounds0(otherPosition, size)) {
+				float otherSum = read_imagef(sums, otherPosition).x;
+
+				inhibition += otherSum >= sum.x ? 1.0f : 0.0f;
+
+				counter++;
+			}
+		}
+
+	float state = inhibition < (counter * activeRatio) ? 1.0f : 0.0f;
+
+	write_imagef(states, position, (float4)(state, sum.y, 0.0f, 0.0f));
+	write_imagef(activations, position, (float4)(sum.x, sum.y, 0.0f, 0.0f));
+}
+
+void kernel predSolveHiddenNoInhibitionSwarm(read_only image2d_t sums,
+	write_only image2d_t states, write_only image2d_t activations)
+{
+	int2 position = (int2)(get_global_id(0), get_global_id(1));
+	
+	float2 sum = read_imagef(sums, position).xy;
+
+	float state = sigmoid(sum.x);
+
+	write_imagef(states, position, (float4)(state, sum.y, 0.0f, 0.0f));
+	write_imagef(activations, position, (float4)(sum.x, sum.y, 0.0f, 0.0f));
+}
+
+void kernel predReconstructionErrorSwarm(read_only image2d_t hiddenStates, read_only image2d_t visibleStatesPrev,
+	write_only image2d_t reconstructionError, read_only image3d_t weights,
+	int2 visibleSize, int2 hiddenSize, float2 visibleToHidden, float2 hiddenToVisible, int radius, int2 reverseRadii)
+{
+	int2 visiblePosition = (int2)(get_global_id(0), get_global_id(1));
+	int2 hiddenPositionCenter = (int2)(visiblePosition.x * visibleToHidden.x + 0.5f, visiblePosition.y * visibleToHidden.y + 0.5f);
+	
+	float recon = 0.0f;
+
+	for (int dx = -reverseRadii.x; dx <= reverseRadii.x; dx++)
+		for (int dy = -reverseRadii.y; dy <= reverseRadii.y; dy++) {
+			int2 hiddenPosition = hiddenPositionCenter + (int2)(dx, dy);
+		
+			if (inBounds0(hiddenPosition, hiddenSize)) {
+				// Next layer node's receptive field
+				int2 fieldCenter = (int2)(hiddenPosition.x * hiddenToVisible.x + 0.5f, hiddenPosition.y * hiddenToVisible.y + 0.5f);
+
+				int2 fieldLowerBound = fieldCenter - (int2)(radius);
+				int2 fieldUpperBound = fieldCenter + (int2)(radius + 1); // So is included in inBounds
+		
+				// Check for containment
+				if (inBounds(visiblePosition, fieldLowerBound, fieldUpperBound)) {	
+					int2 offset = visiblePosition - fieldLowerBound;
+
+					float hiddenState = read_imagef(hiddenStates, hiddenPosition).x;
+		
+					int wi = offset.y + offset.x * (radius * 2 + 1);
+
+					float weight = read_imagef(weights, (int4)(hiddenPosition.x, hiddenPosition.y, wi, 0)).x;
+				
+					recon += hiddenState * weight;
+				}
+			}
+		}
+
+	float state = read_imagef(visibleStatesPrev, visiblePosition).x;
+
+	float error = state - recon;
+
+	write_imagef(reconstructionError, visiblePosition, (float4)(error));
+}
+
+void kernel swarmQPropagateToHiddenError(read_only image3d_t weights, write_only image2d_t hiddenErrors,
+	int2 qSize, int2 hiddenSize, float2 qToHidden, float2 hiddenToQ, int radius, int2 reverseQRadii)
+{
+	int2 hiddenPosition = (int2)(get_global_id(0), get_global_id(1));
+	int2 qPositionCenter = (int2)(hiddenPosition.x * hiddenToQ.x + 0.5f, hiddenPosition.y * hiddenToQ.y + 0.5f);
+	
+	float2 error = (float2)(0.0f);
+
+	for (int dx = -reverseQRadii.x; dx <= reverseQRadii.x; dx++)
+		for (int dy = -reverseQRadii.y; dy <= reverseQRadii.y; dy++) {
+			int2 qPosition = qPositionCenter + (int2)(dx, dy);
+		
+			if (inBounds0(qPosition, hiddenSize)) {
+				// Next layer node's receptive field
+				int2 fieldCenter = (int2)(qPosition.x * qToHidden.x + 0.5f, qPosition.y * qToHidden.y + 0.5f);
+
+				int2 fieldLowerBound = fieldCenter - (int2)(radius);
+				int2 fieldUpperBound = fieldCenter + (int2)(radius + 1); // So is included in inBounds
+		
+				// Check for containment
+				if (inBounds(hiddenPosition, fieldLowerBound, fieldUpperBound)) {	
+					int2 offset = hiddenPosition - fieldLowerBound;
+
+					//float qState = read_imagef(qStates, qPosition).x;
+
+					int wi = offset.y + offset.x * (radius * 2 + 1);
+
+					float2 weight = read_imagef(weights, (int4)(qPosition.x, qPosition.y, wi, 0)).xz;
+				
+					error += weight;
+				}
+			}
+		}
+
+	write_imagef(hiddenErrors, hiddenPosition, (float4)(error.x, error.y, 0.0f, 0.0f));
+}
+
+void kernel swarmQPropagateToHiddenTD(read_only image2d_t qStates, read_only image2d_t qStatesPrev, 
+	write_only image2d_t hiddenTDErrors,
+	int2 qSize, int2 hiddenSize, float2 qToHidden, float2 hiddenToQ, int radius, int2 reverseQRadii,
+	float reward, float gamma)
+{
+	int2 hiddenPosition = (int2)(get_global_id(0), get_global_id(1));
+	int2 qPositionCenter = (int2)(hiddenPosition.x * hiddenToQ.x + 0.5f, hiddenPosition.y * hiddenToQ.y + 0.5f);
+	
+	float sum = 0.0f;
+	float div = 0.0f;
+
+	for (int dx = -reverseQRadii.x; dx <= reverseQRadii.x; dx++)
+		for (int dy = -reverseQRadii.y; dy <= reverseQRadii.y; dy++) {
+			int2 qPosition = qPositionCenter + (int2)(dx, dy);
+		
+			if (inBounds0(qPosition, hiddenSize)) {
+				// Next layer node's receptive field
+				int2 fieldCenter = (int2)(qPosition.x * qToHidden.x + 0.5f, qPosition.y * qToHidden.y + 0.5f);
+
+				int2 fieldLowerBound = fieldCenter - (int2)(radius);
+				int2 fieldUpperBound = fieldCenter + (int2)(radius + 1); // So is included in inBounds
+		
+				// Check for containment
+				if (inBounds(hiddenPosition, fieldLowerBound, fieldUpperBound)) {	
+					float qState = read_imagef(qStates, qPosition).x;
+					float qStatePrev = read_imagef(qStatesPrev, qPosition).x;
+
+					float tdError = reward + gamma * qState - qStatePrev;
+
+					sum += tdError;
+					div += 1.0f;
+				}
+			}
+		}
+
+	write_imagef(hiddenTDErrors, hiddenPosition, (float4)(sum / fmax(1.0f, div)));
+}
+
+void kernel swarmPredictAction(read_only image2d_t hiddenStatesFeedForward, read_only image2d_t actionsFeedBack,
+	read_only image3d_t weights, write_only image2d_t predictedAction,
+	int2 hiddenSize, float2 visibleToHidden, int radius)
+{
+	int2 visiblePosition = (int2)(get_global_id(0), get_global_id(1));
+	int2 hiddenPositionCenter = (int2)(visiblePosition.x * visibleToHidden.x + 0.5f, visiblePosition.y * visibleToHidden.y + 0.5f);
+	
+	float sum = 0.0f;
+
+	int2 fieldLowerBound = hiddenPositionCenter - (int2)(radius);
+
+	for (int dx = -radius; dx <= radius; dx++)
+		for (int dy = -radius; dy <= radius; dy++) {
+			int2 hiddenPosition = hiddenPositionCenter + (int2)(dx, dy);
+
+			if (inBounds0(hiddenPosition, hiddenSize)) {
+				int2 offset = hiddenPosition - fieldLowerBound;
+
+				int wi = offset.y + offset.x * (radius * 2 + 1);
+
+				float2 weight = read_imagef(weights, (int4)(visiblePosition.x, visiblePosition.y, wi, 0)).xy;
+
+				float hsff = read_imagef(hiddenStatesFeedForward, hiddenPosition).x;
+				float afb = read_imagef(actionsFeedBack, hiddenPosition).x;
+
+				sum += weight.x * hsff + weight.y * afb;
+			}
+		}
+
+	write_imagef(predictedAction, visiblePosition, (float4)(tanh(sum)));
+}
+
+void kernel swarmInitSummation(read_only image2d_t hiddenBiases, write_only image2d_t hiddenSummationTempFront) {
+	int2 hiddenPosition = (int2)(get_global_id(0), get_global_id(1));
+	
+	float2 biases = read_imagef(hiddenBiases, hiddenPosition).xz;
+	
+	write_imagef(hiddenSummationTempFront, hiddenPosition, (float4)(biases.x, biases.y, 0.0f, 0.0f));
+}
+
+void kernel swarmQActivateToHidden(read_only image2d_t visibleStates,
+	read_only image2d_t hiddenSummationTempBack, write_only image2d_t hiddenSummationTempFront, read_only image3d_t weights,
+	int2 visibleSize, float2 hiddenToVisible, int radius)
+{
+	int2 hiddenPosition = (int2)(get_global_id(0), get_global_id(1));
+	int2 visiblePositionCenter = (int2)(hiddenPosition.x * hiddenToVisible.x + 0.5f, hiddenPosition.y * hiddenToVisible.y + 0.5f);
+	
+	float2 sum = read_imagef(hiddenSummationTempBack, hiddenPosition).xy;
+
+	int2 fieldLowerBound = visiblePositionCenter - (int2)(radius);
+
+	for (int dx = -radius; dx <= radius; dx++)
+		for (int dy = -radius; dy <= radius; dy++) {
+			int2 visiblePosition = visiblePositionCenter + (int2)(dx, dy);
+
+			if (inBounds0(visiblePosition, visibleSize)) {
+				int2 offset = visiblePosition - fieldLowerBound;
+
+				int wi = offset.y + offset.x * (radius * 2 + 1);
+
+				float2 weight = read_imagef(weights, (int4)(hiddenPosition.x, hiddenPosition.y, wi, 0)).xz;
+
+				float state = read_imagef(visibleStates, visiblePosition).x;
+
+				sum += weight * state;
+			}
+		}
+
+	write_imagef(hiddenSummationTempFront, hiddenPosition, (float4)(sum.x, sum.y, 0.0f, 0.0f));
+}
+
+void kernel swarmQSolveHidden(read_only image2d_t hiddenSummationTemp,
+	read_only image2d_t hiddenStatesFeedForward, read_only image2d_t actionsFeedBack,
+	write_only image2d_t hiddenStates) 
+{
+	int2 hiddenPosition = (int2)(get_global_id(0), get_global_id(1));
+	
+	float2 sum = read_imagef(hiddenSummationTemp, hiddenPosition).xy;
+
+	float hsff = read_imagef(hiddenStatesFeedForward, hiddenPosition).x;
+	float afb = read_imagef(actionsFeedBack, hiddenPosition).x;
+
+	write_imagef(hiddenStates, hiddenPosition, (float4)(tanh(sum.x) * hsff, tanh(sum.y) * afb, 0.0f, 0.0f));
+}
+
+void kernel swarmHiddenPropagateToVisibleAction(read_only image2d_t hiddenErrors, read_only image2d_t hiddenStates,
+	read_only image3d_t weights, read_only image2d_t actionsBack, write_only image2d_t actionsFront,
+	int2 hiddenSize, int2 visibleSize, float2 hiddenToVisible, float2 visibleToHidden, int radius, int2 reverseRadii,
+	float actionAlpha)
+{
+	int2 visiblePosition = (int2)(get_global_id(0), get_global_id(1));
+	int2 hiddenPositionCenter = (int2)(visiblePosition.x * visibleToHidden.x + 0.5f, visiblePosition.y * visibleToHidden.y + 0.5f);
+	
+	float error = 0.0f;
+
+	for (int dx = -reverseRadii.x; dx <= reverseRadii.x; dx++)
+		for (int dy = -reverseRadii.y; dy <= reverseRadii.y; dy++) {
+			int2 hiddenPosition = hiddenPositionCenter + (int2)(dx, dy);
+		
+			if (inBounds0(hiddenPosition, hiddenSize)) {
+				// Next layer node's receptive field
+				int2 fieldCenter = (int2)(hiddenPosition.x * hiddenToVisible.x + 0.5f, hiddenPosition.y * hiddenToVisible.y + 0.5f);
+
+				int2 fieldLowerBound = fieldCenter - (int2)(radius);
+				int2 fieldUpperBound = fieldCenter + (int2)(radius + 1); // So is included in inBounds
+		
+				// Check for containment
+				if (inBounds(visiblePosition, fieldLowerBound, fieldUpperBound)) {	
+					int2 offset = visiblePosition - fieldLowerBound;
+
+					float2 hiddenState = read_imagef(hiddenStates, hiddenPosition).xy;
+					float2 hiddenError = read_imagef(hiddenErrors, hiddenPosition).xy;
+
+					int wi = offset.y + offset.x * (radius * 2 + 1);
+
+					float2 weight = read_imagef(weights, (int4)(hiddenPosition.x, hiddenPosition.y, wi, 0)).xz;
+				
+					error += dot((1.0f - hiddenState * hiddenState) * hiddenError, weight);
+				}
+			}
+		}
+
+	float prevAction = read_imagef(actionsBack, visiblePosition).x;
+
+	float nextAction = fmin(1.0f, fmax(-1.0f, prevAction + actionAlpha * (error > 0.0f ? 1.0f : -1.0f)));
+
+	write_imagef(actionsFront, visiblePosition, (float4)(nextAction));
+}
+
+void kernel swarmExploration(read_only image2d_t actions,
+	write_only image2d_t actionsExploratory, float expPert, float expBreak, uint2 seed)  
+{
+	uint2 seedValue = seed + (uint2)(get_global_id(0) * 45 + 25, get_global_id(1) * 56 + 24) * 6;
+
+	int2 position = (int2)(get_global_id(0), get_global_id(1));
+	
+	float action = read_imagef(actions, position).x;
+	
+	write_imagef(actionsExploratory, position, (float4)(randFloat(&seedValue) < expBreak ? randFloat(&seedValue) * 2.0f - 1.0f : fmin(1.0f, fmax(0.0f, action + expPert * randNormal(&seedValue)))));
+}
+
+void kernel swarmQActivateToQ(read_only image2d_t hiddenStates,
+	read_only image3d_t weights, write_only image2d_t qStates,
+	int2 hiddenSize, float2 qToHidden, int radius)
+{
+	int2 qPosition = (int2)(get_global_id(0), get_global_id(1));
+	int2 hiddenPositionCenter = (int2)(qPosition.x * qToHidden.x + 0.5f, qPosition.y * qToHidden.y + 0.5f);
+	
+	float sum = 0.0f;
+
+	int2 fieldLowerBound = hiddenPositionCenter - (int2)(radius);
+
+	for (int dx = -radius; dx <= radius; dx++)
+		for (int dy = -radius; dy <= radius; dy++) {
+			int2 hiddenPosition = hiddenPositionCenter + (int2)(dx, dy);
+
+			if (inBounds0(hiddenPosition, hiddenSize)) {
+				int2 offset = hiddenPosition - fieldLowerBound;
+
+				int wi = offset.y + offset.x * (radius * 2 + 1);
+
+				float2 weight = read_imagef(weights, (int4)(qPosition.x, qPosition.y, wi, 0)).xy;
+
+				float2 state = read_imagef(hiddenStates, hiddenPosition).xy;
+
+				sum += dot(weight, state);
+			}
+		}
+
+	write_imagef(qStates, qPosition, (float4)(sum));
+}
+
+void kernel swarmQLearnVisibleWeightsTraces(read_only image2d_t actionsExploratory, 
+	read_only image2d_t hiddenErrors, read_only image2d_t hiddenTD, read_only image2d_t hiddenStates,
+	read_only image3d_t weightsBack, write_only image3d_t weightsFront,
+	int2 visibleSize, float2 hiddenToVisible, int radius, float alpha, float lambda)
+{
+	int2 hiddenPosition = (int2)(get_global_id(0), get_global_id(1));
+	int2 visiblePositionCenter = (int2)(hiddenPosition.x * hiddenToVisible.x + 0.5f, hiddenPosition.y * hiddenToVisible.y + 0.5f);
+
+	int2 fieldLowerBound = visiblePositionCenter - (int2)(radius);
+	
+	float tdError = read_imagef(hiddenTD, hiddenPosition).x;
+
+	float2 hiddenState = read_imagef(hiddenStates, hiddenPosition).xy;
+
+	float2 hiddenError = read_imagef(hiddenErrors, hiddenPosition).xy;
+
+	float2 error = hiddenError * (1.0f - hiddenState * hiddenState);
+
+	for (int dx = -radius; dx <= radius; dx++)
+		for (int dy = -radius; dy <= radius; dy++) {
+			int2 visiblePosition = visiblePositionCenter + (int2)(dx, dy);
+
+			if (inBounds0(visiblePosition, visibleSize)) {
+				int2 offset = visiblePosition - fieldLowerBound;
+
+				int wi = offset.y + offset.x * (radius * 2 + 1);
+
+				float4 weightPrev = read_imagef(weightsBack, (int4)(hiddenPosition.x, hiddenPosition.y, wi, 0));
+
+				float state = read_imagef(actionsExploratory, visiblePosition).x;
+
+				float4 weight = (float4)(weightPrev.x + tdError * weightPrev.y, lambda * weightPrev.y + alpha * error.x * state,
+						weightPrev.z + tdError * weightPrev.w, lambda * weightPrev.w + alpha * error.y * state);
+
+				write_imagef(weightsFront, (int4)(hiddenPosition.x, hiddenPosition.y, wi, 0), weight);
+			}
+		}
+}
+
+void kernel swarmStartLearnWeights(read_only image2d_t actions, read_only image2d_t predictedAction,
+	read_only image2d_t hiddenStatesFeedForward, read_only image2d_t actionsFeedBack,
+	read_only image3d_t weightsPrev, write_only image3d_t weights,
+	int2 hiddenSize, float2 visibleToHidden, int radius,
+	float alpha)
+{
+	int2 visiblePosition = (int2)(get_global_id(0), get_global_id(1));
+	int2 hiddenPositionCenter = (int2)(visiblePosition.x * visibleToHidden.x + 0.5f, visiblePosition.y * visibleToHidden.y + 0.5f);
+	
+	float alphaError = alpha * (read_imagef(actions, visiblePosition).x - read_imagef(predictedAction, visiblePosition).x);
+
+	int2 fieldLowerBound = hiddenPositionCenter - (int2)(radius);
+
+	for (int dx = -radius; dx <= radius; dx++)
+		for (int dy = -radius; dy <= radius; dy++) {
+			int2 hiddenPosition = hiddenPositionCenter + (int2)(dx, dy);
+
+			if (inBounds0(hiddenPosition, hiddenSize)) {
+				int2 offset = hiddenPosition - fieldLowerBound;
+
+				int wi = offset.y + offset.x * (radius * 2 + 1);
+
+				float2 weightPrev = read_imagef(weightsPrev, (int4)(visiblePosition.x, visiblePosition.y, wi, 0)).xy;
+
+				float hsff = read_imagef(hiddenStatesFeedForward, hiddenPosition).x;
+				float afb = read_imagef(actionsFeedBack, hiddenPosition).x;
+
+				float2 weight = weightPrev + alphaError * (float2)(hsff, afb);
+				
+				write_imagef(weights, (int4)(visiblePosition.x, visiblePosition.y, wi, 0), (float4)(weight, 0.0f, 0.0f));
+			}
+		}
+}
+
+void kernel swarmQLearnHiddenWeightsTraces(read_only image2d_t hiddenStates,
+	read_only image2d_t qStates, read_only image2d_t qStatesPrev,
+	read_only image3d_t weightsPrev, write_only image3d_t weights,
+	int2 hiddenSize, float2 qToHidden, int radius,
+	float alpha, float lambda, float reward, float gamma)
+{
+	int2 qPosition = (int2)(get_global_id(0), get_global_id(1));
+	int2 hiddenPositionCenter = (int2)(qPosition.x * qToHidden.x + 0.5f, qPosition.y * qToHidden.y + 0.5f);
+	
+	float qState = read_imagef(qStates, qPosition).x;
+	float qStatePrev = read_imagef(qStatesPrev, qPosition).x;
+
+	float tdError = reward + gamma * qState - qStatePrev;
+
+	int2 fieldLowerBound = hiddenPositionCenter - (int2)(radius);
+
+	for (int dx = -radius; dx <= radius; dx++)
+		for (int dy = -radius; dy <= radius; dy++) {
+			int2 hiddenPosition = hiddenPositionCenter + (int2)(dx, dy);
+
+			if (inBounds0(hiddenPosition, hiddenSize)) {
+				int2 offset = hiddenPosition - fieldLowerBound;
+
+				int wi = offset.y + offset.x * (radius * 2 + 1);
+
+				float4 weightPrev = read_imagef(weightsPrev, (int4)(qPosition.x, qPosition.y, wi, 0));
+
+				float2 state = read_imagef(hiddenStates, hiddenPosition).xy;
+
+				float4 weight = (float4)(weightPrev.x + tdError * weightPrev.y, weightPrev.y * lambda + alpha * state.x,
+					weightPrev.z + tdError * weightPrev.w, weightPrev.w * lambda + alpha * state.y);
+				
+				write_imagef(weights, (int4)(qPosition.x, qPosition.y, wi, 0), weight);
+			}
+		}
+}
+
+void kernel swarmQLearnHiddenBiasesTraces(read_only image2d_t hiddenTD, read_only image2d_t hiddenErrors,
+	read_only image2d_t biasesBack, write_only image2d_t biasesFront,
+	float alpha, float lambda)  
+{
+	int2 hiddenPosition = (int2)(get_global_id(0), get_global_id(1));
+
+	float4 biasPrev = read_imagef(biasesBack, hiddenPosition);
+
+	float tdError = read_imagef(hiddenTD, hiddenPosition).x;
+
+	float2 error = read_imagef(hiddenErrors, hiddenPosition).xy;
+
+	float4 bias = (float4)(biasPrev.x + tdError * biasPrev.y, biasPrev.y * lambda + alpha * error.x,
+		biasPrev.z + tdError * biasPrev.w, biasPrev.w * lambda + alpha * error.y);
+				
+	write_imagef(biasesFront, hiddenPosition, bias);
+}
@@ -0,0 +1,158 @@
+// Preprocessing kernels (whitening, frame preprocessing, change detection)
+
+// ----------------------------------------- Preprocessing -----------------------------------------
+
+void kernel whiten(read_only image2d_t input, write_only image2d_t result, int2 imageSize, int kernelRadius, float intensity) {
+	int2 position = (int2)(get_global_id(0), get_global_id(1));
+
+	write_imagef(result, position, whitenColor(input, position, imageSize, kernelRadius, intensity));
+}
+
+// Whitened color from the sum over its (in bounds) window, same result as whitenColor.
+// The covariance term only needs the window sum: sum over others of (o - m)(c - m) = (c - m)(sum - c - count * m)
+float4 whitenColorFromSum(float4 currentColor, float4 windowSum, float count, float intensity) {
+	float4 center = windowSum / (count + 1.0f);
+
+	float4 centeredCurrentColor = currentColor - center;
+
+	float4 covariances = centeredCurrentColor * (windowSum - currentColor - count * center) / fmax(1.0f, count);
+
+	return fmin(1.0f, fmax(-1.0f, (centeredCurrentColor > 0.0f ? (float4)(1.0f) : (float4)(-1.0f)) * (1.0f - exp(-fabs(intensity * covariances)))));
+}
+
+// Sliding window sums along each row, one work item per row
+void kernel whitenRowSums(read_only image2d_t input, write_only image2d_t rowSums, int2 imageSize, int kernelRadius) {
+	int y = get_global_id(0);
+
+	float4 sum = (float4)(0.0f);
+
+	for (int x = 0; x < min(kernelRadius, imageSize.x); x++)
+		sum += read_imagef(input, (int2)(x, y));
+
+	for (int x = 0; x < imageSize.x; x++) {
+		if (x + kernelRadius < imageSize.x)
+			sum += read_imagef(input, (int2)(x + kernelRadius, y));
+
+		if (x - kernelRadius - 1 >= 0)
+			sum -= read_imagef(input, (int2)(x - kernelRadius - 1, y));
+
+		write_imagef(rowSums, (int2)(x, y), sum);
+	}
+}
+
+// Sliding window sums of the row sums along each column, one work item per column
+void kernel whitenColumnSums(read_only image2d_t rowSums, write_only image2d_t windowSums, int2 imageSize, int kernelRadius) {
+	int x = get_global_id(0);
+
+	float4 sum = (float4)(0.0f);
+
+	for (int y = 0; y < min(kernelRadius, imageSize.y); y++)
+		sum += read_imagef(rowSums, (int2)(x, y));
+
+	for (int y = 0; y < imageSize.y; y++) {
+		if (y + kernelRadius < imageSize.y)
+			sum += read_imagef(rowSums, (int2)(x, y + kernelRadius));
+
+		if (y - kernelRadius - 1 >= 0)
+			sum -= read_imagef(rowSums, (int2)(x, y - kernelRadius - 1));
+
+		write_imagef(windowSums, (int2)(x, y), sum);
+	}
+}
+
+// Whiten from the window sums, constant cost per pixel regardless of the radius
+void kernel whitenFromSums(read_only image2d_t input, read_only image2d_t windowSums, write_only image2d_t result, int2 imageSize, int kernelRadius, float intensity) {
+	int2 position = (int2)(get_global_id(0), get_global_id(1));
+
+	int2 lowerBound = max(position - (int2)(kernelRadius), (int2)(0));
+	int2 upperBound = min(position + (int2)(kernelRadius), imageSize - (int2)(1));
+
+	float count = (upperBound.x - lowerBound.x + 1) * (upperBound.y - lowerBound.y + 1) - 1;
+
+	write_imagef(result, position, whitenColorFromSum(read_imagef(input, position), read_imagef(windowSums, position), count, intensity));
+}
+
+// Largest absolute difference between two images. Non-negative floats order like their bit patterns, so an integer max works
+void kernel whitenDifference(read_only image2d_t a, read_only image2d_t b, global int* difference) {
+	int2 position = (int2)(get_global_id(0), get_global_id(1));
+
+	float4 d = fabs(read_imagef(a, position) - read_imagef(b, position));
+
+	atomic_max(difference, as_int(fmax(fmax(d.x, d.y), fmax(d.z, d.w))));
+}
+
+// Convert a region of an RGBA8 frame to a single normalized channel, area averaging it down to the result size.
+// Channels are optionally stepped (> channelThreshold) before weighting. The result can be blended with another image (e.g. a prediction)
+void kernel preprocessFrame(read_only image2d_t frame, read_only image2d_t blend, write_only image2d_t result,
+	int2 cropOrigin, int2 cropSize, int2 resultSize, float4 channelWeights, float channelThreshold, float2 normalization, float2 outputRange, float blendRatio)
+{
+	int2 position = (int2)(get_global_id(0), get_global_id(1));
+
+	int2 lowerBound = cropOrigin + (position * cropSize) / resultSize;
+	int2 upperBound = max(lowerBound + (int2)(1), cropOrigin + ((position + (int2)(1)) * cropSize) / resultSize);
+
+	float sum = 0.0f;
+
+	for (int x = lowerBound.x; x < upperBound.x; x++)
+		for (int y = lowerBound.y; y < upperBound.y; y++) {
+			float4 color = read_imagef(frame, defaultUnnormalizedSampler, (int2)(x, y));
+
+			if (channelThreshold >= 0.0f)
+				color = select((float4)(0.0f), (float4)(1.0f), isgreater(color, (float4)(channelThreshold)));
+
+			sum += dot(color, channelWeights);
+		}
+
+	float area = (upperBound.x - lowerBound.x) * (upperBound.y - lowerBound.y);
+
+	float value = fmin(outputRange.y, fmax(outputRange.x, (sum / area - normalization.x) * normalization.y));
+
+	if (blendRatio > 0.0f)
+		value = (1.0f - blendRatio) * value + blendRatio * read_imagef(blend, defaultUnnormalizedSampler, position).x;
+
+	write_imagef(result, position, (float4)(value));
+}
+
+// Compare each tile of the input against the previous frame, flag tiles that changed and keep a copy of the frame for the next comparison
+void kernel detectChangedTiles(read_only image2d_t input, read_only image2d_t inputPrev, write_only image2d_t inputCopy,
+	global int* changedTiles, global int* changedCount, int2 imageSize, int tileSize, float threshold)
+{
+	int2 tilePosition = (int2)(get_global_id(0), get_global_id(1));
+	int2 tileCounts = (int2)(get_global_size(0), get_global_size(1));
+
+	int2 lowerBound = tilePosition * tileSize;
+	int2 upperBound = min(lowerBound + (int2)(tileSize), imageSize);
+
+	int changed = 0;
+
+	for (int x = lowerBound.x; x < upperBound.x; x++)
+		for (int y = lowerBound.y; y < upperBound.y; y++) {
+			int2 position = (int2)(x, y);
+
+			float4 color = read_imagef(input, position);
+
+			float4 difference = fabs(color - read_imagef(inputPrev, position));
+
+			if (fmax(fmax(difference.x, difference.y), fmax(difference.z, difference.w)) > threshold)
+				changed = 1;
+
+			write_imagef(inputCopy, position, color);
+		}
+
+	changedTiles[tilePosition.x + tilePosition.y * tileCounts.x] = changed;
+
+	if (changed)
+		atomic_inc(changedCount);
+}
+
+// Whiten only pixels whose neighbourhood touches a changed tile, the rest of the result is left as it was
+void kernel whitenChanged(read_only image2d_t input, write_only image2d_t result, int2 imageSize, int kernelRadius, float intensity,
+	global const int* changedTiles, global const int* changedCount, int maxChangedTiles, int2 tileCounts, int tileSize)
+{
+	int2 position = (int2)(get_global_id(0), get_global_id(1));
+
+	if (!regionChanged(changedTiles, changedCount, maxChangedTiles, tileCounts, tileSize, position - (int2)(kernelRadius), position + (int2)(kernelRadius)))
+		return;
+
+	write_imagef(result, position, whitenColor(input, position, imageSize, kernelRadius, intensity));
+}
@@ -0,0 +1,226 @@
+#include "Settings.h"
+
+#if EXPERIMENT_SELECTION == EXPERIMENT_ALLOCATION_CHECK
+
+#include <system/ComputeSystem.h>
+#include <system/ComputeProgram.h>
+
+#include <neo/PredictiveHierarchy.h>
+#include <neo/AgentSPG.h>
+#include <neo/AgentER.h>
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <random>
+#include <functional>
+#include <memory>
+#include <atomic>
+#include <new>
+#include <cstdlib>
+#include <algorithm>
+
+// Checks that steady-state stepping does not touch the heap. Global operator new is replaced with a counting one, every model is
+// stepped until warmed up (the agent replay buffer fills after its maximum frame count), then the allocations made by further steps
+// are counted, with and without learning. Any allocation after warm-up makes the exit code nonzero.
+// Only C++ allocations are seen, whatever the OpenCL runtime allocates internally is not counted
+
+namespace {
+	std::atomic<size_t> numAllocations(0);
+}
+
+void* operator new(std::size_t size) {
+	numAllocations++;
+
+	void* p = std::malloc(size == 0 ? 1 : size);
+
+	if (p == nullptr)
+		throw std::bad_alloc();
+
+	return p;
+}
+
+void* operator new[](std::size_t size) {
+	return operator new(size);
+}
+
+void operator delete(void* p) noexcept {
+	std::free(p);
+}
+
+void operator delete[](void* p) noexcept {
+	std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+	std::free(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept {
+	std::free(p);
+}
+
+std::vector<std::string> parseNames(const std::string &list) {
+	std::vector<std::string> items;
+
+	std::istringstream is(list);
+
+	std::string item;
+
+	while (std::getline(is, item, ','))
+		items.push_back(item);
+
+	return items;
+}
+
+int main(int argc, char* argv[]) {
+	std::vector<std::string> models = { "ph", "spg", "er" };
+
+	int warmupSteps = 700;
+	int measuredSteps = 100;
+	int numLayers = 2;
+
+	cl_int layerSide = 16;
+	cl_int radius = 4;
+	cl_int inputSide = 16;
+
+	for (int i = 1; i + 1 < argc; i += 2) {
+		std::string option = argv[i];
+		std::string value = argv[i + 1];
+
+		if (option == "--models")
+			models = parseNames(value);
+		else if (option == "--warmup")
+			warmupSteps = std::max(0, std::stoi(value));
+		else if (option == "--steps")
+			measuredSteps = std::max(1, std::stoi(value));
+		else if (option == "--layers")
+			numLayers = std::max(1, std::stoi(value));
+		else {
+			std::cerr << "Usage: " << argv[0] << " [--models ph,spg,er] [--warmup steps] [--steps n] [--layers n]" << std::endl;
+
+			return 1;
+		}
+	}
+
+	std::mt19937 generator(1234);
+
+	sys::ComputeSystem cs;
+
+	cs.create(sys::ComputeSystem::_auto);
+
+	sys::ComputeProgram prog;
+
+	prog.loadModules(cs);
+
+	const cl_int2 inputSize = { inputSide, inputSide };
+	const cl_int2 layerSize = { layerSide, layerSide };
+	const cl_int2 actionSize = { 8, 8 };
+	const cl_int2 qSize = { 4, 4 };
+	const int numInputFrames = 4;
+
+	std::uniform_real_distribution<float> dist01(0.0f, 1.0f);
+
+	// A few random frames, cycled through so inputs change every step
+	std::vector<cl::Image2D> inputs(numInputFrames);
+
+	std::vector<cl_float> frame(inputSide * inputSide);
+
+	for (int f = 0; f < numInputFrames; f++) {
+		inputs[f] = neo::createImage2D(cs, inputSize, CL_R, CL_FLOAT, "input");
+
+		for (int i = 0; i < frame.size(); i++)
+			frame[i] = dist01(generator);
+
+		cs.getQueue().enqueueWriteImage(inputs[f], CL_TRUE, { 0, 0, 0 }, { static_cast<cl::size_type>(inputSide), static_cast<cl::size_type>(inputSide), 1 }, 0, 0, frame.data());
+	}
+
+	cl::Image2D actionTaken = neo::createImage2D(cs, actionSize, CL_R, CL_FLOAT, "actionTaken");
+
+	cs.getQueue().enqueueFillImage(actionTaken, cl_float4{ 0.0f, 0.0f, 0.0f, 0.0f }, { 0, 0, 0 }, { static_cast<cl::size_type>(actionSize.x), static_cast<cl::size_type>(actionSize.y), 1 });
+
+	int failures = 0;
+
+	for (int mi = 0; mi < models.size(); mi++)
+	for (int learn = 0; learn < 2; learn++) {
+		const std::string &model = models[mi];
+
+		std::unique_ptr<neo::PredictiveHierarchy> ph;
+		std::unique_ptr<neo::AgentSPG> spg;
+		std::unique_ptr<neo::AgentER> er;
+
+		std::function<void(const cl::Image2D &)> step;
+
+		if (model == "ph") {
+			std::vector<neo::PredictiveHierarchy::LayerDesc> layerDescs(numLayers);
+
+			for (int l = 0; l < layerDescs.size(); l++) {
+				layerDescs[l]._size = layerSize;
+				layerDescs[l]._feedForwardRadius = layerDescs[l]._recurrentRadius = layerDescs[l]._lateralRadius = layerDescs[l]._feedBackRadius = layerDescs[l]._predictiveRadius = radius;
+			}
+
+			ph.reset(new neo::PredictiveHierarchy());
+
+			ph->createRandom(cs, prog, inputSize, layerDescs, { -0.01f, 0.01f }, generator);
+
+			step = [&](const cl::Image2D &input) { ph->simStep(cs, input, learn != 0); };
+		}
+		else if (model == "spg") {
+			std::vector<neo::AgentSPG::LayerDesc> layerDescs(numLayers);
+
+			for (int l = 0; l < layerDescs.size(); l++) {
+				layerDescs[l]._size = layerSize;
+				layerDescs[l]._feedForwardRadius = layerDescs[l]._recurrentRadius = layerDescs[l]._lateralRadius = layerDescs[l]._feedBackRadius = layerDescs[l]._predictiveRadius = radius;
+			}
+
+			spg.reset(new neo::AgentSPG());
+
+			spg->createRandom(cs, prog, inputSize, actionSize, radius, layerDescs, { -0.01f, 0.01f }, generator);
+
+			step = [&](const cl::Image2D &input) { spg->simStep(cs, 0.0f, input, actionTaken, generator, learn != 0); };
+		}
+		else if (model == "er") {
+			std::vector<neo::AgentER::LayerDesc> layerDescs(numLayers);
+
+			for (int l = 0; l < layerDescs.size(); l++) {
+				layerDescs[l]._size = layerSize;
+				layerDescs[l]._feedForwardRadius = layerDescs[l]._recurrentRadius = layerDescs[l]._lateralRadius = layerDescs[l]._feedBackRadius = layerDescs[l]._predictiveRadius = radius;
+			}
+
+			er.reset(new neo::AgentER());
+
+			er->createRandom(cs, prog, inputSize, actionSize, qSize, layerDescs, { -0.01f, 0.01f }, generator);
+
+			step = [&](const cl::Image2D &input) { er->simStep(cs, input, actionTaken, 0.0f, generator, learn != 0); };
+		}
+		else {
+			std::cerr << "Unknown model " << model << std::endl;
+
+			return 1;
+		}
+
+		for (int s = 0; s < warmupSteps; s++)
+			step(inputs[s % numInputFrames]);
+
+		cs.getQueue().finish();
+
+		size_t allocationsBefore = numAllocations;
+
+		for (int s = 0; s < measuredSteps; s++)
+			step(inputs[(warmupSteps + s) % numInputFrames]);
+
+		size_t allocations = numAllocations - allocationsBefore;
+
+		cs.getQueue().finish();
+
+		std::cout << model << (learn != 0 ? " (learn)" : "") << ": " << allocations << " allocations in " << measuredSteps << " steps"
+			<< (allocations > 0 ? " FAILED" : "") << std::endl;
+
+		if (allocations > 0)
+			failures++;
+	}
+
+	return failures > 0 ? 2 : 0;
+}
+
+#endif
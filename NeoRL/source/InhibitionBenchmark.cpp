@@ -0,0 +1,127 @@
+#include "Settings.h"
+
+#if EXPERIMENT_SELECTION == EXPERIMENT_INHIBITION_BENCHMARK
+
+#include <system/ComputeSystem.h>
+#include <system/ComputeProgram.h>
+
+#include <neo/Helpers.h>
+
+#include <time.h>
+#include <iostream>
+#include <random>
+#include <chrono>
+
+// Compares the untiled local k-WTA kernel against the tiled one for a range of lateral radii
+int main() {
+	std::mt19937 generator(time(nullptr));
+
+	sys::ComputeSystem cs;
+
+	cs.create(sys::ComputeSystem::_gpu);
+
+	sys::ComputeProgram prog;
+
+	prog.loadModules(cs);
+
+	if (!prog.requireModules(cs, { "init", "predictor" })) {
+		std::cerr << "Could not build the kernel modules." << std::endl;
+
+		return 1;
+	}
+
+	const cl_int2 hiddenSize = { 128, 128 };
+	const float activeRatio = 0.02f;
+	const int repetitions = 100;
+
+	cl::Image2D activations = cl::Image2D(cs.getContext(), CL_MEM_READ_WRITE, cl::ImageFormat(CL_R, CL_FLOAT), hiddenSize.x, hiddenSize.y);
+	cl::Image2D statesUntiled = cl::Image2D(cs.getContext(), CL_MEM_READ_WRITE, cl::ImageFormat(CL_R, CL_FLOAT), hiddenSize.x, hiddenSize.y);
+	cl::Image2D statesTiled = cl::Image2D(cs.getContext(), CL_MEM_READ_WRITE, cl::ImageFormat(CL_R, CL_FLOAT), hiddenSize.x, hiddenSize.y);
+
+	cl::Kernel randomUniform2DKernel = cl::Kernel(prog.getProgram(), "randomUniform2D");
+	cl::Kernel solveHiddenKernel = cl::Kernel(prog.getProgram(), "spSolveHidden");
+	cl::Kernel solveHiddenTiledKernel = cl::Kernel(prog.getProgram(), "spSolveHiddenTiled");
+
+	neo::randomUniform(activations, cs, randomUniform2DKernel, hiddenSize, { -1.0f, 1.0f }, generator);
+
+	cl::array<cl::size_type, 3> zeroOrigin = { 0, 0, 0 };
+	cl::array<cl::size_type, 3> hiddenRegion = { static_cast<cl::size_type>(hiddenSize.x), static_cast<cl::size_type>(hiddenSize.y), 1 };
+
+	std::vector<float> resultUntiled(hiddenSize.x * hiddenSize.y);
+	std::vector<float> resultTiled(hiddenSize.x * hiddenSize.y);
+
+	std::cout << "radius, untiled (ms), tiled (ms), speedup, mismatches" << std::endl;
+
+	for (cl_int radius = 5; radius <= 12; radius++) {
+		if (!neo::inhibitionTileFits(cs, solveHiddenTiledKernel, radius)) {
+			std::cout << radius << ", tile does not fit in local memory" << std::endl;
+
+			continue;
+		}
+
+		{
+			int argIndex = 0;
+
+			solveHiddenKernel.setArg(argIndex++, activations);
+			solveHiddenKernel.setArg(argIndex++, statesUntiled);
+			solveHiddenKernel.setArg(argIndex++, hiddenSize);
+			solveHiddenKernel.setArg(argIndex++, radius);
+			solveHiddenKernel.setArg(argIndex++, activeRatio);
+			solveHiddenKernel.setArg(argIndex++, cl_int2{ 0, 0 });
+			solveHiddenKernel.setArg(argIndex++, cl_int2{ 0, 0 });
+		}
+
+		{
+			int argIndex = 0;
+
+			solveHiddenTiledKernel.setArg(argIndex++, activations);
+			solveHiddenTiledKernel.setArg(argIndex++, statesTiled);
+			solveHiddenTiledKernel.setArg(argIndex++, cl::Local(neo::inhibitionTileBytes(radius)));
+			solveHiddenTiledKernel.setArg(argIndex++, hiddenSize);
+			solveHiddenTiledKernel.setArg(argIndex++, radius);
+			solveHiddenTiledKernel.setArg(argIndex++, activeRatio);
+			solveHiddenTiledKernel.setArg(argIndex++, cl_int2{ 0, 0 });
+			solveHiddenTiledKernel.setArg(argIndex++, cl_int2{ 0, 0 });
+		}
+
+		// Warm up
+		cs.getQueue().enqueueNDRangeKernel(solveHiddenKernel, cl::NullRange, cl::NDRange(hiddenSize.x, hiddenSize.y));
+		neo::enqueueInhibitionTiled(cs, solveHiddenTiledKernel, hiddenSize);
+		cs.getQueue().finish();
+
+		std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+
+		for (int r = 0; r < repetitions; r++)
+			cs.getQueue().enqueueNDRangeKernel(solveHiddenKernel, cl::NullRange, cl::NDRange(hiddenSize.x, hiddenSize.y));
+
+		cs.getQueue().finish();
+
+		std::chrono::high_resolution_clock::time_point middle = std::chrono::high_resolution_clock::now();
+
+		for (int r = 0; r < repetitions; r++)
+			neo::enqueueInhibitionTiled(cs, solveHiddenTiledKernel, hiddenSize);
+
+		cs.getQueue().finish();
+
+		std::chrono::high_resolution_clock::time_point end = std::chrono::high_resolution_clock::now();
+
+		double untiledTime = std::chrono::duration<double, std::milli>(middle - start).count() / repetitions;
+		double tiledTime = std::chrono::duration<double, std::milli>(end - middle).count() / repetitions;
+
+		// Both kernels must produce identical codes
+		cs.getQueue().enqueueReadImage(statesUntiled, CL_TRUE, zeroOrigin, hiddenRegion, 0, 0, resultUntiled.data());
+		cs.getQueue().enqueueReadImage(statesTiled, CL_TRUE, zeroOrigin, hiddenRegion, 0, 0, resultTiled.data());
+
+		int mismatches = 0;
+
+		for (int i = 0; i < resultUntiled.size(); i++)
+			if (resultUntiled[i] != resultTiled[i])
+				mismatches++;
+
+		std::cout << radius << ", " << untiledTime << ", " << tiledTime << ", " << untiledTime / tiledTime << ", " << mismatches << std::endl;
+	}
+
+	return 0;
+}
+
+#endif
@@ -0,0 +1,455 @@
+#include "Settings.h"
+
+#if EXPERIMENT_SELECTION == EXPERIMENT_KERNEL_BENCHMARK
+
+#include <system/ComputeSystem.h>
+#include <system/ComputeProgram.h>
+
+#include <neo/Helpers.h>
+#include <neo/ImageWhitener.h>
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <random>
+#include <chrono>
+#include <cmath>
+
+// Runs every kernel of every module over a grid of synthetic sizes, radii and densities.
+// Arguments are bound from the kernels' argument info (types and names), with all layers the same size so every mapping is 1:1:
+//   images          - own image per argument, 2D: size x size (R), 3D: size x size x (2 * radius + 1)^2 (RG). Inputs are binary at the density, weights uniform
+//   *adius*, *adii* - the radius (reverse radii radius + 1)
+//   activeRatio     - the density
+//   float2 *To*     - the scale between layers, 1
+//   global buffers  - zeroed, so counts and lists are empty
+//   local buffers   - a tile of the radius, or the whole layer for the persistent solver
+// Throughput counts every image argument as read or written once (GB/s), and a window of the radius per work item as updates.
+// The summed whitening passes are also checked against the direct whitening kernel at every size and radius (lines starting with #),
+// a difference above the tolerance makes the exit code nonzero
+
+struct Result {
+	std::string _kernel;
+	cl_int _size;
+	cl_int _radius;
+	cl_float _density;
+	cl_int _status;
+	double _milliseconds;
+	double _bytes;
+	double _updates;
+};
+
+std::vector<std::string> splitList(const std::string &list) {
+	std::vector<std::string> items;
+
+	std::istringstream is(list);
+
+	std::string item;
+
+	while (std::getline(is, item, ','))
+		items.push_back(item);
+
+	return items;
+}
+
+bool contains(const std::string &name, const std::string &part) {
+	return name.find(part) != std::string::npos;
+}
+
+int main(int argc, char* argv[]) {
+	std::string csvPath;
+	std::string jsonPath;
+	std::string filter;
+
+	std::vector<cl_int> sizes = { 32, 64, 128 };
+	std::vector<cl_int> radii = { 2, 5, 8 };
+	std::vector<cl_float> densities = { 0.02f, 0.05f, 0.1f };
+
+	int repetitions = 20;
+
+	cl_float whiteningTolerance = 0.001f;
+
+	for (int i = 1; i + 1 < argc; i += 2) {
+		std::string option = argv[i];
+		std::string value = argv[i + 1];
+
+		if (option == "--csv")
+			csvPath = value;
+		else if (option == "--json")
+			jsonPath = value;
+		else if (option == "--filter")
+			filter = value;
+		else if (option == "--repetitions")
+			repetitions = std::max(1, std::stoi(value));
+		else if (option == "--whitening-tolerance")
+			whiteningTolerance = std::stof(value);
+		else if (option == "--sizes" || option == "--radii") {
+			std::vector<cl_int> &list = option == "--sizes" ? sizes : radii;
+
+			list.clear();
+
+			for (const std::string &item : splitList(value))
+				list.push_back(std::stoi(item));
+		}
+		else if (option == "--densities") {
+			densities.clear();
+
+			for (const std::string &item : splitList(value))
+				densities.push_back(std::stof(item));
+		}
+		else {
+			std::cerr << "Usage: " << argv[0] << " [--csv file] [--json file] [--filter name] [--repetitions n] [--whitening-tolerance t] [--sizes a,b] [--radii a,b] [--densities a,b]" << std::endl;
+
+			return 1;
+		}
+	}
+
+	std::mt19937 generator(1234);
+
+	sys::ComputeSystem cs;
+
+	cs.create(sys::ComputeSystem::_auto);
+
+	sys::ComputeProgram prog;
+
+	prog.loadModules(cs);
+
+	// Argument names and types are only reported with this option
+	prog.setCompileOptions("-cl-std=CL1.2 -cl-kernel-arg-info");
+
+	if (!prog.requireModules(cs, { "init", "sparseCoder", "predictor", "swarm", "qHierarchy", "whitening" })) {
+		std::cerr << "Could not build the kernel modules." << std::endl;
+
+		return 1;
+	}
+
+	std::vector<cl::Kernel> kernels;
+
+	prog.getProgram().createKernels(&kernels);
+
+	cl::Kernel randomUniform3DKernel = cl::Kernel(prog.getProgram(), "randomUniform3D");
+
+	// Arguments of one configuration are recycled before the next, the pool hands the same images out again
+	neo::setImagePooling(true);
+
+	neo::MemoryScope scope("KernelBenchmark");
+
+	std::vector<Result> results;
+
+	std::ofstream csv;
+
+	if (!csvPath.empty())
+		csv.open(csvPath);
+
+	const std::string header = "kernel,size,radius,density,status,ms,GB/s,updates/s";
+
+	std::cout << header << std::endl;
+
+	if (csv.is_open())
+		csv << header << std::endl;
+
+	for (int k = 0; k < kernels.size(); k++) {
+		cl::Kernel &kernel = kernels[k];
+
+		std::string name = kernel.getInfo<CL_KERNEL_FUNCTION_NAME>();
+
+		// Names may carry the terminator
+		name = name.c_str();
+
+		if (!filter.empty() && !contains(name, filter))
+			continue;
+
+		// Needs a whole hierarchy laid out in its buffers, HierarchyMegakernel covers it
+		if (name == "phInferenceMegakernel")
+			continue;
+
+		cl_uint numArgs = kernel.getInfo<CL_KERNEL_NUM_ARGS>();
+
+		std::vector<std::string> argTypes(numArgs);
+		std::vector<std::string> argNames(numArgs);
+		std::vector<cl_uint> argQualifiers(numArgs);
+
+		bool hasRadius = false;
+		bool hasDensity = false;
+
+		for (cl_uint a = 0; a < numArgs; a++) {
+			argTypes[a] = kernel.getArgInfo<CL_KERNEL_ARG_TYPE_NAME>(a).c_str();
+			argNames[a] = kernel.getArgInfo<CL_KERNEL_ARG_NAME>(a).c_str();
+			argQualifiers[a] = kernel.getArgInfo<CL_KERNEL_ARG_ADDRESS_QUALIFIER>(a);
+
+			hasRadius = hasRadius || contains(argNames[a], "adius") || contains(argNames[a], "adii") || contains(argTypes[a], "image3d_t");
+			hasDensity = hasDensity || contains(argNames[a], "activeRatio") || contains(argTypes[a], "image2d_t");
+		}
+
+		bool persistent = contains(name, "Persistent");
+		bool tiled = contains(name, "Tiled");
+
+		// Parameters a kernel does not depend on are only run at their first value
+		for (int si = 0; si < sizes.size(); si++)
+		for (int ri = 0; ri < (hasRadius ? radii.size() : 1); ri++)
+		for (int di = 0; di < (hasDensity ? densities.size() : 1); di++) {
+			cl_int size = sizes[si];
+			cl_int radius = radii[ri];
+			cl_float density = densities[di];
+
+			cl_int diam = radius * 2 + 1;
+			cl_int numHidden = size * size;
+			cl_int numWeights = diam * diam;
+
+			Result result;
+
+			result._kernel = name;
+			result._size = size;
+			result._radius = hasRadius ? radius : 0;
+			result._density = hasDensity ? density : 0.0f;
+			result._status = CL_SUCCESS;
+			result._milliseconds = 0.0;
+			result._bytes = 0.0;
+			result._updates = static_cast<double>(numHidden) * (hasRadius ? numWeights : 1);
+
+			std::vector<cl::Image2D> images2D;
+			std::vector<cl::Image3D> images3D;
+			std::vector<cl::Buffer> buffers;
+
+			std::vector<cl_float> binary(numHidden);
+
+			std::uniform_real_distribution<float> dist01(0.0f, 1.0f);
+
+			for (cl_uint a = 0; a < numArgs && result._status == CL_SUCCESS; a++) {
+				const std::string &type = argTypes[a];
+				const std::string &argName = argNames[a];
+
+				cl_int error;
+
+				if (type == "image2d_t") {
+					images2D.push_back(neo::createImage2D(cs, { size, size }, CL_R, CL_FLOAT, argName));
+
+					for (int i = 0; i < numHidden; i++)
+						binary[i] = dist01(generator) < density ? 1.0f : 0.0f;
+
+					cs.getQueue().enqueueWriteImage(images2D.back(), CL_TRUE, { 0, 0, 0 }, { static_cast<cl::size_type>(size), static_cast<cl::size_type>(size), 1 }, 0, 0, binary.data());
+
+					error = kernel.setArg(a, images2D.back());
+
+					result._bytes += numHidden * sizeof(cl_float);
+				}
+				else if (type == "image3d_t") {
+					cl_int3 weightsSize = { size, size, numWeights };
+
+					images3D.push_back(neo::createImage3D(cs, weightsSize, CL_RG, CL_FLOAT, argName));
+
+					neo::randomUniform(images3D.back(), cs, randomUniform3DKernel, weightsSize, { -0.01f, 0.01f }, generator);
+
+					error = kernel.setArg(a, images3D.back());
+
+					result._bytes += static_cast<double>(numHidden) * numWeights * 2 * sizeof(cl_float);
+				}
+				else if (argQualifiers[a] == CL_KERNEL_ARG_ADDRESS_LOCAL) {
+					cl::size_type elementSize = contains(type, "uchar") ? sizeof(cl_uchar) : sizeof(cl_float);
+
+					error = kernel.setArg(a, cl::Local(persistent ? numHidden * elementSize : neo::inhibitionTileBytes(radius)));
+				}
+				else if (argQualifiers[a] == CL_KERNEL_ARG_ADDRESS_GLOBAL || argQualifiers[a] == CL_KERNEL_ARG_ADDRESS_CONSTANT) {
+					cl::size_type bytes = numHidden * sizeof(cl_int4);
+
+					buffers.push_back(neo::createBuffer(cs, CL_MEM_READ_WRITE, bytes, argName));
+
+					cs.getQueue().enqueueFillBuffer<cl_int>(buffers.back(), 0, 0, bytes);
+
+					error = kernel.setArg(a, buffers.back());
+				}
+				else if (type == "int") {
+					cl_int value = 1;
+
+					if (contains(argName, "adius"))
+						value = radius;
+					else if (argName == "numWeights")
+						value = numWeights;
+					else if (argName == "iterations")
+						value = 8;
+					else if (argName == "tileSize")
+						value = neo::inhibitionTileSize;
+					else if (argName == "maxChangedTiles")
+						value = numHidden;
+
+					error = kernel.setArg(a, value);
+				}
+				else if (type == "int2") {
+					cl_int2 value = { size, size };
+
+					if (contains(argName, "adii"))
+						value = { radius + 1, radius + 1 };
+					else if (argName == "cropOrigin")
+						value = { 0, 0 };
+					else if (argName == "tileCounts")
+						value = { (size + neo::inhibitionTileSize - 1) / neo::inhibitionTileSize, (size + neo::inhibitionTileSize - 1) / neo::inhibitionTileSize };
+
+					error = kernel.setArg(a, value);
+				}
+				else if (type == "float") {
+					cl_float value = 0.01f;
+
+					if (argName == "activeRatio")
+						value = density;
+					else if (argName == "activeRatioSquared")
+						value = density * density;
+
+					error = kernel.setArg(a, value);
+				}
+				else if (type == "float2") {
+					cl_float2 value = contains(argName, "To") ? cl_float2{ 1.0f, 1.0f } : cl_float2{ 0.0f, 1.0f };
+
+					error = kernel.setArg(a, value);
+				}
+				else if (type == "float4")
+					error = kernel.setArg(a, cl_float4{ 0.25f, 0.25f, 0.25f, 0.25f });
+				else if (type == "uint2") {
+					std::uniform_int_distribution<int> seedDist(0, 999);
+
+					error = kernel.setArg(a, cl_uint2{ static_cast<cl_uint>(seedDist(generator)), static_cast<cl_uint>(seedDist(generator)) });
+				}
+				else if (type == "uint")
+					error = kernel.setArg(a, static_cast<cl_uint>(1));
+				else if (type == "uchar")
+					error = kernel.setArg(a, static_cast<cl_uchar>(0));
+				else
+					error = CL_INVALID_VALUE;
+
+				result._status = error;
+			}
+
+			if (result._status == CL_SUCCESS) {
+				cl::NDRange global(size, size);
+				cl::NDRange local = cl::NullRange;
+
+				if (contains(name, "3D"))
+					global = cl::NDRange(size, size, numWeights);
+				else if (name == "whitenRowSums" || name == "whitenColumnSums")
+					global = cl::NDRange(size);
+				else if (name == "copyActiveSlices")
+					global = cl::NDRange(numHidden);
+				else if (name == "detectChangedTiles")
+					global = cl::NDRange((size + neo::inhibitionTileSize - 1) / neo::inhibitionTileSize, (size + neo::inhibitionTileSize - 1) / neo::inhibitionTileSize);
+				else if (persistent) {
+					cl::size_type groupSize = std::min<cl::size_type>(kernel.getWorkGroupInfo<CL_KERNEL_WORK_GROUP_SIZE>(cs.getDevice()), numHidden);
+
+					global = cl::NDRange(groupSize);
+					local = cl::NDRange(groupSize);
+				}
+				else if (tiled) {
+					cl::size_type tiledSize = (size + neo::inhibitionTileSize - 1) / neo::inhibitionTileSize * neo::inhibitionTileSize;
+
+					global = cl::NDRange(tiledSize, tiledSize);
+					local = cl::NDRange(neo::inhibitionTileSize, neo::inhibitionTileSize);
+
+					if (!neo::inhibitionTileFits(cs, kernel, radius))
+						result._status = CL_INVALID_WORK_GROUP_SIZE;
+				}
+
+				// Warm up
+				if (result._status == CL_SUCCESS)
+					result._status = cs.getQueue().enqueueNDRangeKernel(kernel, cl::NullRange, global, local);
+
+				if (result._status == CL_SUCCESS)
+					result._status = cs.getQueue().finish();
+
+				if (result._status == CL_SUCCESS) {
+					std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+
+					for (int r = 0; r < repetitions; r++)
+						cs.getQueue().enqueueNDRangeKernel(kernel, cl::NullRange, global, local);
+
+					cs.getQueue().finish();
+
+					result._milliseconds = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count() / repetitions;
+				}
+			}
+
+			// The next configuration reuses these images
+			cs.getQueue().finish();
+
+			for (int i = 0; i < images2D.size(); i++)
+				neo::recycleImage(images2D[i]);
+
+			for (int i = 0; i < images3D.size(); i++)
+				neo::recycleImage(images3D[i]);
+
+			results.push_back(result);
+
+			double seconds = result._milliseconds * 0.001;
+
+			std::ostringstream line;
+
+			line << result._kernel << "," << result._size << "," << result._radius << "," << result._density << "," << result._status << ","
+				<< result._milliseconds << "," << (seconds > 0.0 ? result._bytes / seconds * 1e-9 : 0.0) << "," << (seconds > 0.0 ? result._updates / seconds : 0.0);
+
+			std::cout << line.str() << std::endl;
+
+			if (csv.is_open())
+				csv << line.str() << std::endl;
+		}
+	}
+
+	int whiteningMismatches = 0;
+
+	if (filter.empty() || contains("whiten", filter)) {
+		neo::ImageWhitener whitener;
+
+		std::uniform_real_distribution<float> dist01(0.0f, 1.0f);
+
+		for (int si = 0; si < sizes.size(); si++) {
+			cl_int size = sizes[si];
+
+			whitener.create(cs, prog, { size, size }, CL_R, CL_FLOAT);
+
+			cl::Image2D input = neo::createImage2D(cs, { size, size }, CL_R, CL_FLOAT, "whiteningInput");
+
+			std::vector<cl_float> values(size * size);
+
+			for (int i = 0; i < values.size(); i++)
+				values[i] = dist01(generator);
+
+			cs.getQueue().enqueueWriteImage(input, CL_TRUE, { 0, 0, 0 }, { static_cast<cl::size_type>(size), static_cast<cl::size_type>(size), 1 }, 0, 0, values.data());
+
+			for (int ri = 0; ri < radii.size(); ri++) {
+				float difference = whitener.compareModes(cs, input, radii[ri]);
+
+				std::cout << "# whitening " << size << "," << radii[ri] << ": max summed difference to direct " << difference;
+
+				if (difference > whiteningTolerance) {
+					std::cout << " MISMATCH";
+
+					whiteningMismatches++;
+				}
+
+				std::cout << std::endl;
+			}
+		}
+	}
+
+	if (!jsonPath.empty()) {
+		std::ofstream json(jsonPath);
+
+		json << "[" << std::endl;
+
+		for (int i = 0; i < results.size(); i++) {
+			const Result &result = results[i];
+
+			double seconds = result._milliseconds * 0.001;
+
+			json << "  { \"kernel\": \"" << result._kernel << "\", \"size\": " << result._size << ", \"radius\": " << result._radius
+				<< ", \"density\": " << result._density << ", \"status\": " << result._status << ", \"ms\": " << result._milliseconds
+				<< ", \"gbPerSecond\": " << (seconds > 0.0 ? result._bytes / seconds * 1e-9 : 0.0)
+				<< ", \"updatesPerSecond\": " << (seconds > 0.0 ? result._updates / seconds : 0.0) << " }" << (i + 1 < results.size() ? "," : "") << std::endl;
+		}
+
+		json << "]" << std::endl;
+	}
+
+	neo::memoryReport(std::cerr);
+
+	neo::releasePooledImages();
+
+	return whiteningMismatches > 0 ? 2 : 0;
+}
+
+#endif
@@ -0,0 +1,184 @@
+#include "Settings.h"
+
+#if EXPERIMENT_SELECTION == EXPERIMENT_MULTI_AGENT_BENCHMARK
+
+#include <system/ComputeSystem.h>
+#include <system/ComputeProgram.h>
+
+#include <neo/AgentExecutor.h>
+#include <neo/AgentSPG.h>
+#include <neo/AgentER.h>
+
+#include <iostream>
+#include <string>
+#include <random>
+#include <memory>
+#include <algorithm>
+
+// Runs many small agents through the AgentExecutor, which splits the CPU device into its NUMA domains and steals work between them.
+// Agents are placed on the least loaded domain and created with its compute system, then every round steps each of them once.
+// Prints the rounds per second and the executor's per domain report (steps, stolen steps, busy time)
+
+struct AgentSlot {
+	std::unique_ptr<neo::AgentSPG> _spg;
+	std::unique_ptr<neo::AgentER> _er;
+
+	// Each agent has its own generator and inputs, so steps on different threads share nothing
+	std::mt19937 _generator;
+
+	std::vector<cl::Image2D> _inputs;
+	cl::Image2D _actionTaken;
+
+	int _step;
+};
+
+int main(int argc, char* argv[]) {
+	std::string type = "mixed";
+
+	int numAgents = 16;
+	int threadsPerDomain = 2;
+	int warmupRounds = 10;
+	int measuredRounds = 100;
+
+	cl_int layerSide = 16;
+	cl_int radius = 4;
+	cl_int inputSide = 16;
+
+	for (int i = 1; i + 1 < argc; i += 2) {
+		std::string option = argv[i];
+		std::string value = argv[i + 1];
+
+		if (option == "--type")
+			type = value;
+		else if (option == "--agents")
+			numAgents = std::max(1, std::stoi(value));
+		else if (option == "--threads")
+			threadsPerDomain = std::max(1, std::stoi(value));
+		else if (option == "--warmup")
+			warmupRounds = std::max(0, std::stoi(value));
+		else if (option == "--rounds")
+			measuredRounds = std::max(1, std::stoi(value));
+		else if (option == "--size")
+			layerSide = std::max(1, std::stoi(value));
+		else {
+			std::cerr << "Usage: " << argv[0] << " [--type spg|er|mixed] [--agents n] [--threads per domain] [--warmup rounds] [--rounds n] [--size side]" << std::endl;
+
+			return 1;
+		}
+	}
+
+	if (type != "spg" && type != "er" && type != "mixed") {
+		std::cerr << "Unknown agent type " << type << std::endl;
+
+		return 1;
+	}
+
+	neo::AgentExecutor executor;
+
+	if (!executor.create(threadsPerDomain)) {
+		std::cerr << "Could not create the executor, it needs an OpenCL CPU device." << std::endl;
+
+		return 1;
+	}
+
+	if (!executor.getProgram().requireModules(executor.getComputeSystem(0), { "init", "sparseCoder", "predictor", "swarm", "qHierarchy", "whitening" })) {
+		std::cerr << "Could not build the kernel modules." << std::endl;
+
+		return 1;
+	}
+
+	std::cout << executor.getNumDomains() << " domains, " << threadsPerDomain << " threads each" << std::endl;
+
+	const cl_int2 inputSize = { inputSide, inputSide };
+	const cl_int2 layerSize = { layerSide, layerSide };
+	const cl_int2 actionSize = { 8, 8 };
+	const cl_int2 qSize = { 4, 4 };
+	const int numInputFrames = 2;
+
+	std::mt19937 generator(1234);
+
+	std::uniform_real_distribution<float> dist01(0.0f, 1.0f);
+
+	std::vector<AgentSlot> agents(numAgents);
+
+	std::vector<cl_float> frame(inputSide * inputSide);
+
+	for (int a = 0; a < numAgents; a++) {
+		AgentSlot &slot = agents[a];
+
+		int domain = executor.getLeastLoadedDomain();
+
+		sys::ComputeSystem &cs = executor.getComputeSystem(domain);
+
+		slot._generator.seed(generator());
+		slot._step = 0;
+
+		slot._inputs.resize(numInputFrames);
+
+		for (int f = 0; f < numInputFrames; f++) {
+			slot._inputs[f] = neo::createImage2D(cs, inputSize, CL_R, CL_FLOAT, "input");
+
+			for (int i = 0; i < frame.size(); i++)
+				frame[i] = dist01(generator);
+
+			cs.getQueue().enqueueWriteImage(slot._inputs[f], CL_TRUE, { 0, 0, 0 }, { static_cast<cl::size_type>(inputSide), static_cast<cl::size_type>(inputSide), 1 }, 0, 0, frame.data());
+		}
+
+		slot._actionTaken = neo::createImage2D(cs, actionSize, CL_R, CL_FLOAT, "actionTaken");
+
+		cs.getQueue().enqueueFillImage(slot._actionTaken, cl_float4{ 0.0f, 0.0f, 0.0f, 0.0f }, { 0, 0, 0 }, { static_cast<cl::size_type>(actionSize.x), static_cast<cl::size_type>(actionSize.y), 1 });
+
+		if (type == "spg" || (type == "mixed" && a % 2 == 0)) {
+			std::vector<neo::AgentSPG::LayerDesc> layerDescs(2);
+
+			for (int l = 0; l < layerDescs.size(); l++) {
+				layerDescs[l]._size = layerSize;
+				layerDescs[l]._feedForwardRadius = layerDescs[l]._recurrentRadius = layerDescs[l]._lateralRadius = layerDescs[l]._feedBackRadius = layerDescs[l]._predictiveRadius = radius;
+			}
+
+			slot._spg.reset(new neo::AgentSPG());
+
+			slot._spg->createRandom(cs, executor.getProgram(), inputSize, actionSize, radius, layerDescs, { -0.01f, 0.01f }, slot._generator);
+
+			executor.addAgent(domain, [&slot](sys::ComputeSystem &stepCs) {
+				slot._spg->simStep(stepCs, 0.0f, slot._inputs[slot._step++ % numInputFrames], slot._actionTaken, slot._generator);
+			});
+		}
+		else {
+			std::vector<neo::AgentER::LayerDesc> layerDescs(2);
+
+			for (int l = 0; l < layerDescs.size(); l++) {
+				layerDescs[l]._size = layerSize;
+				layerDescs[l]._feedForwardRadius = layerDescs[l]._recurrentRadius = layerDescs[l]._lateralRadius = layerDescs[l]._feedBackRadius = layerDescs[l]._predictiveRadius = radius;
+			}
+
+			slot._er.reset(new neo::AgentER());
+
+			slot._er->createRandom(cs, executor.getProgram(), inputSize, actionSize, qSize, layerDescs, { -0.01f, 0.01f }, slot._generator);
+
+			executor.addAgent(domain, [&slot](sys::ComputeSystem &stepCs) {
+				slot._er->simStep(stepCs, slot._inputs[slot._step++ % numInputFrames], slot._actionTaken, 0.0f, slot._generator);
+			});
+		}
+	}
+
+	for (int r = 0; r < warmupRounds; r++)
+		executor.step();
+
+	double warmupTime = executor.getTotalTime();
+
+	for (int r = 0; r < measuredRounds; r++)
+		executor.step();
+
+	double seconds = executor.getTotalTime() - warmupTime;
+
+	std::cout << numAgents << " " << type << " agents: " << (seconds > 0.0 ? measuredRounds / seconds : 0.0) << " rounds/s, "
+		<< (seconds > 0.0 ? numAgents * measuredRounds / seconds : 0.0) << " agent steps/s" << std::endl;
+
+	// Counters include the warm-up rounds
+	executor.report(std::cout);
+
+	return 0;
+}
+
+#endif
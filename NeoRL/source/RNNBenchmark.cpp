@@ -1,149 +1,363 @@
-#include "Settings.h"
-
-#if EXPERIMENT_SELECTION == EXPERIMENT_RNN_BENCHMARK
-
-#include <sdr/IPredictiveRSDR.h>
-
-#include <simtree/SDRST.h>
-
-#include <time.h>
-#include <iostream>
-#include <fstream>
-#include <string>
-#include <sstream>
-#include <random>
-#include <algorithm>
-
-int main() {
-	std::mt19937 generator(time(nullptr));
-
-	std::vector<std::vector<double>> timeSeries;
-
-	std::ifstream fromFile("resources/data.txt");
-
-	if (!fromFile.is_open()) {
-		std::cerr << "Could not open data.txt!" << std::endl;
-
-		return 1;
-	}
-
-	// Skip first line
-	std::string line;
-
-	std::getline(fromFile, line);
-
-	int numEntries = 1;
-
-	for (int i = 0; i < line.size(); i++)
-		if (line[i] == ',')
-			numEntries++;
-
-	int numSkipEntries = 1;
-
-	int numEntriesUse = numEntries - numSkipEntries;
-
-	std::vector<double> minimums(numEntriesUse, 999999999.0);
-	std::vector<double> maximums(numEntriesUse, -999999999.0);
-
-	while (fromFile.good() && !fromFile.eof()) {
-		std::vector<double> entries(numEntriesUse);
-
-		std::string line;
-
-		std::getline(fromFile, line);
-
-		std::istringstream fromLine(line);
-
-		std::string param;
-
-		// Skip entries
-		for (int i = 0; i < numSkipEntries; i++) {
-			std::string entry;
-
-			std::getline(fromLine, entry, ',');
-		}
-
-		for (int i = 0; i < numEntriesUse; i++) {
-			std::string entry;
-
-			std::getline(fromLine, entry, ',');
-
-			if (entry == "")
-				entries[i] = 0.0;
-			else {
-				double value = std::stod(entry);
-
-				maximums[i] = std::max(maximums[i], value);
-				minimums[i] = std::min(minimums[i], value);
-
-				entries[i] = value;
-			}
-		}
-
-		timeSeries.push_back(entries);
-	}
-
-	// Rescale
-	for (int i = 0; i < timeSeries.size(); i++) {
-		for (int j = 0; j < timeSeries[i].size(); j++) {
-			timeSeries[i][j] = (timeSeries[i][j] - minimums[j]) / std::max(0.0001, (maximums[j] - minimums[j]));
-		}
-	}
-
-	/*timeSeries.clear();
-
-	timeSeries.resize(10);
-	timeSeries[0] = { 0.0f, 1.0f, 0.0f };
-	timeSeries[1] = { 0.0f, 0.0f, 0.0f };
-	timeSeries[2] = { 1.0f, 1.0f, 0.0f };
-	timeSeries[3] = { 0.0f, 0.0f, 1.0f };
-	timeSeries[4] = { 0.0f, 1.0f, 0.0f };
-	timeSeries[5] = { 0.0f, 0.0f, 1.0f };
-	timeSeries[6] = { 0.0f, 0.0f, 0.0f };
-	timeSeries[7] = { 0.0f, 0.0f, 0.0f };
-	timeSeries[8] = { 0.0f, 1.0f, 0.0f };
-	timeSeries[9] = { 0.0f, 1.0f, 1.0f };*/
-
-	std::vector<sdr::IPredictiveRSDR::LayerDesc> layerDescs(3);
-
-	layerDescs[0]._width = 8;
-	layerDescs[0]._height = 8;
-
-	layerDescs[1]._width = 6;
-	layerDescs[1]._height = 6;
-
-	layerDescs[2]._width = 4;
-	layerDescs[2]._height = 4;
-
-	sdr::IPredictiveRSDR prsdr;
-
-	prsdr.createRandom(4, 5, 8, layerDescs, -0.01f, 0.01f, 0.0f, generator);
-
-	float avgError = 1.0f;
-
-	float avgErrorDecay = 0.01f;
-
-	for (int iter = 0; iter < 1000; iter++) {
-		for (int i = 0; i < timeSeries.size(); i++) {
-			float error = 0.0f;
-
-			for (int j = 0; j < timeSeries[i].size(); j++) {
-				error += std::pow(prsdr.getPrediction(j) - timeSeries[i][j], 2);
-
-				prsdr.setInput(j, timeSeries[i][j]);
-			}
-
-			avgError = (1.0f - avgErrorDecay) * avgError + avgErrorDecay * error;
-
-			prsdr.simStep(generator);
-
-			if (i % 10 == 0) {
-				std::cout << "Iteration " << i << ": " << avgError << std::endl;
-			}
-		}
-	}
-
-	return 0;
-}
-
-#endif
\ No newline at end of file
+#include "Settings.h"
+
+#if EXPERIMENT_SELECTION == EXPERIMENT_RNN_BENCHMARK
+
+#include <system/ComputeSystem.h>
+#include <system/ComputeProgram.h>
+
+#include <neo/PredictiveHierarchy.h>
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <random>
+#include <chrono>
+#include <cstdlib>
+#include <cstdint>
+#include <algorithm>
+
+// Streams a multi-variate time series through a predictive hierarchy one row at a time and reports prediction error next to
+// steps per second and memory, so accuracy per compute can be tracked across releases on a series of any length.
+// Input is a CSV file with a header line, or a binary file (.bin) of a 32 bit column count followed by float32 rows.
+// Leading columns such as a timestamp are skipped with --skip, by default the first column of a CSV file and none of a binary file.
+// Rows are never held beyond the current one: a first pass over the file finds the ranges to normalize with, then every pass
+// encodes each row into the input image (one pixel per variable) as it is read.
+// Error is the mean squared error of the normalized values against the prediction made the step before.
+// Weights are initialized from a fixed seed (--seed), so runs on the same data are comparable
+
+class SeriesReader {
+private:
+	std::ifstream _file;
+	bool _binary;
+	int _numColumns;
+	int _numSkipColumns;
+	std::streampos _dataStart;
+
+	// Reused so reading a row does not allocate
+	std::string _line;
+	std::vector<float> _record;
+
+public:
+	SeriesReader()
+		: _binary(false), _numColumns(0), _numSkipColumns(0)
+	{}
+
+	bool open(const std::string &path, bool binary, int numSkipColumns) {
+		_binary = binary;
+		_numSkipColumns = numSkipColumns;
+
+		_file.open(path, binary ? std::ios::in | std::ios::binary : std::ios::in);
+
+		if (!_file.is_open())
+			return false;
+
+		int numEntries = 0;
+
+		if (_binary) {
+			std::int32_t count;
+
+			if (!_file.read(reinterpret_cast<char*>(&count), sizeof(count)))
+				return false;
+
+			numEntries = count;
+
+			_record.resize(std::max(0, numEntries));
+		}
+		else {
+			// Header line, one name per column
+			if (!std::getline(_file, _line))
+				return false;
+
+			numEntries = 1;
+
+			for (int i = 0; i < _line.size(); i++)
+				if (_line[i] == ',')
+					numEntries++;
+		}
+
+		_numColumns = numEntries - _numSkipColumns;
+
+		_dataStart = _file.tellg();
+
+		return _numColumns > 0;
+	}
+
+	// Read the next row into values (getNumColumns() entries), false at the end of the series
+	bool next(std::vector<float> &values) {
+		if (_binary) {
+			if (!_file.read(reinterpret_cast<char*>(_record.data()), _record.size() * sizeof(float)))
+				return false;
+
+			std::copy(_record.begin() + _numSkipColumns, _record.end(), values.begin());
+
+			return true;
+		}
+
+		// Skip blank lines, such as a trailing newline
+		do {
+			if (!std::getline(_file, _line))
+				return false;
+		} while (_line.empty() || _line == "\r");
+
+		const char* p = _line.c_str();
+
+		for (int i = 0; i < _numSkipColumns + _numColumns; i++) {
+			const char* end = p;
+
+			while (*end != ',' && *end != '\0')
+				end++;
+
+			if (i >= _numSkipColumns) {
+				// Missing entries are zero
+				char* parsedEnd;
+
+				double value = std::strtod(p, &parsedEnd);
+
+				values[i - _numSkipColumns] = parsedEnd == p ? 0.0f : static_cast<float>(value);
+			}
+
+			p = *end == ',' ? end + 1 : end;
+		}
+
+		return true;
+	}
+
+	void rewind() {
+		_file.clear();
+		_file.seekg(_dataStart);
+	}
+
+	int getNumColumns() const {
+		return _numColumns;
+	}
+};
+
+std::vector<int> parseList(const std::string &list) {
+	std::vector<int> items;
+
+	std::istringstream is(list);
+
+	std::string item;
+
+	while (std::getline(is, item, ','))
+		items.push_back(std::stoi(item));
+
+	return items;
+}
+
+int main(int argc, char* argv[]) {
+	std::string dataPath = "resources/data.txt";
+
+	bool binary = false;
+
+	// Unset until the format is known
+	int numSkipColumns = -1;
+	int numPasses = 1;
+	int reportInterval = 1000;
+
+	std::vector<int> layerSizes = { 8, 6, 4 };
+
+	cl_int radius = 5;
+
+	std::string csvPath;
+
+	unsigned int seed = 1234;
+
+	for (int i = 1; i + 1 < argc; i += 2) {
+		std::string option = argv[i];
+		std::string value = argv[i + 1];
+
+		if (option == "--data")
+			dataPath = value;
+		else if (option == "--skip")
+			numSkipColumns = std::max(0, std::stoi(value));
+		else if (option == "--passes")
+			numPasses = std::max(1, std::stoi(value));
+		else if (option == "--report")
+			reportInterval = std::max(1, std::stoi(value));
+		else if (option == "--sizes")
+			layerSizes = parseList(value);
+		else if (option == "--radius")
+			radius = std::stoi(value);
+		else if (option == "--csv")
+			csvPath = value;
+		else if (option == "--seed")
+			seed = static_cast<unsigned int>(std::stoul(value));
+		else {
+			std::cerr << "Usage: " << argv[0] << " [--data file.txt|file.bin] [--skip columns] [--passes n] [--report steps]"
+				<< " [--sizes a,b,c] [--radius r] [--csv file] [--seed n]" << std::endl
+				<< "--skip applies to both formats, it defaults to 1 for CSV and 0 for binary files" << std::endl;
+
+			return 1;
+		}
+	}
+
+	binary = dataPath.size() >= 4 && dataPath.compare(dataPath.size() - 4, 4, ".bin") == 0;
+
+	if (numSkipColumns < 0)
+		numSkipColumns = binary ? 0 : 1;
+
+	SeriesReader reader;
+
+	if (!reader.open(dataPath, binary, numSkipColumns)) {
+		std::cerr << "Could not open " << dataPath << "!" << std::endl;
+
+		return 1;
+	}
+
+	int numColumns = reader.getNumColumns();
+
+	std::vector<float> values(numColumns);
+
+	// Ranges to normalize with
+	std::vector<float> minimums(numColumns, 999999999.0f);
+	std::vector<float> maximums(numColumns, -999999999.0f);
+
+	size_t numRows = 0;
+
+	while (reader.next(values)) {
+		for (int j = 0; j < numColumns; j++) {
+			minimums[j] = std::min(minimums[j], values[j]);
+			maximums[j] = std::max(maximums[j], values[j]);
+		}
+
+		numRows++;
+	}
+
+	if (numRows == 0) {
+		std::cerr << "No rows in " << dataPath << "!" << std::endl;
+
+		return 1;
+	}
+
+	std::cout << numRows << " rows of " << numColumns << " variables" << std::endl;
+
+	// --------------------------- Create the Hierarchy ---------------------------
+
+	std::mt19937 generator(seed);
+
+	sys::ComputeSystem cs;
+
+	cs.create(sys::ComputeSystem::_auto);
+
+	sys::ComputeProgram prog;
+
+	prog.loadModules(cs);
+
+	// Square input with one pixel per variable, the rest stays zero
+	cl_int inputSide = 1;
+
+	while (inputSide * inputSide < numColumns)
+		inputSide++;
+
+	cl_int2 inputSize = { inputSide, inputSide };
+
+	cl::Image2D inputImage = neo::createImage2D(cs, inputSize, CL_R, CL_FLOAT, "input");
+
+	std::vector<neo::PredictiveHierarchy::LayerDesc> layerDescs(layerSizes.size());
+
+	for (int l = 0; l < layerDescs.size(); l++) {
+		layerDescs[l]._size = { layerSizes[l], layerSizes[l] };
+		layerDescs[l]._feedForwardRadius = layerDescs[l]._recurrentRadius = layerDescs[l]._lateralRadius = radius;
+		layerDescs[l]._feedBackRadius = layerDescs[l]._predictiveRadius = radius + 1;
+	}
+
+	neo::PredictiveHierarchy ph;
+
+	ph.createRandom(cs, prog, inputSize, layerDescs, { -0.01f, 0.01f }, generator);
+
+	std::vector<float> input(inputSide * inputSide, 0.0f);
+	std::vector<float> prediction(inputSide * inputSide, 0.0f);
+
+	// --------------------------- Stream ---------------------------
+
+	std::ofstream csv;
+
+	if (!csvPath.empty()) {
+		csv.open(csvPath);
+
+		csv << "step,window_mse,total_mse,steps_per_second,memory_mb" << std::endl;
+	}
+
+	double windowError = 0.0;
+	double totalError = 0.0;
+
+	size_t windowSteps = 0;
+	size_t errorSteps = 0;
+	size_t step = 0;
+
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+	std::chrono::high_resolution_clock::time_point windowStart = start;
+
+	for (int pass = 0; pass < numPasses; pass++) {
+		reader.rewind();
+
+		while (reader.next(values)) {
+			for (int j = 0; j < numColumns; j++)
+				input[j] = (values[j] - minimums[j]) / std::max(0.0001f, maximums[j] - minimums[j]);
+
+			// The first step has nothing to compare against
+			if (step > 0) {
+				double error = 0.0;
+
+				for (int j = 0; j < numColumns; j++) {
+					double delta = prediction[j] - input[j];
+
+					error += delta * delta;
+				}
+
+				error /= numColumns;
+
+				windowError += error;
+				totalError += error;
+
+				errorSteps++;
+			}
+
+			cs.getQueue().enqueueWriteImage(inputImage, CL_TRUE, { 0, 0, 0 }, { static_cast<cl::size_type>(inputSide), static_cast<cl::size_type>(inputSide), 1 }, 0, 0, input.data());
+
+			ph.simStep(cs, inputImage);
+
+			cs.getQueue().enqueueReadImage(ph.getPrediction(), CL_TRUE, { 0, 0, 0 }, { static_cast<cl::size_type>(inputSide), static_cast<cl::size_type>(inputSide), 1 }, 0, 0, prediction.data());
+
+			step++;
+			windowSteps++;
+
+			if (step % reportInterval == 0) {
+				std::chrono::high_resolution_clock::time_point now = std::chrono::high_resolution_clock::now();
+
+				double seconds = std::chrono::duration<double>(now - windowStart).count();
+
+				double stepsPerSecond = seconds > 0.0 ? windowSteps / seconds : 0.0;
+				double memoryMB = neo::getMemoryInUse() / (1024.0 * 1024.0);
+
+				double windowMSE = windowError / std::max<size_t>(1, std::min(windowSteps, errorSteps));
+				double totalMSE = totalError / std::max<size_t>(1, errorSteps);
+
+				std::cout << "Step " << step << " (pass " << pass << "): mse " << windowMSE << " (total " << totalMSE << "), "
+					<< stepsPerSecond << " steps/s, " << memoryMB << " MB" << std::endl;
+
+				if (csv.is_open())
+					csv << step << "," << windowMSE << "," << totalMSE << "," << stepsPerSecond << "," << memoryMB << std::endl;
+
+				windowError = 0.0;
+				windowSteps = 0;
+				windowStart = now;
+			}
+		}
+	}
+
+	double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+	double totalMSE = totalError / std::max<size_t>(1, errorSteps);
+
+	std::cout << "Done: " << step << " steps, mse " << totalMSE << ", "
+		<< (seconds > 0.0 ? step / seconds : 0.0) << " steps/s" << std::endl;
+
+	neo::memoryReport(std::cout);
+
+	return 0;
+}
+
+#endif
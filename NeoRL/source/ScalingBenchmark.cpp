@@ -0,0 +1,539 @@
+#include "Settings.h"
+
+#if EXPERIMENT_SELECTION == EXPERIMENT_SCALING_BENCHMARK
+
+#include <system/ComputeSystem.h>
+#include <system/ComputeProgram.h>
+
+#include <neo/PredictiveHierarchy.h>
+#include <neo/AgentSPG.h>
+#include <neo/AgentER.h>
+#include <neo/AgentHA.h>
+#include <neo/AgentPredQ.h>
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <random>
+#include <chrono>
+#include <map>
+#include <functional>
+#include <memory>
+#include <algorithm>
+#include <cmath>
+
+// Builds every model over a matrix of layer counts, layer sizes, radii and input sizes, and times steps with and without learning.
+// Each step is finished before the next, so the times are latencies. Memory is what the model holds through the neo allocation helpers.
+// A baseline written by --write-baseline can be compared against later with --baseline, runs slower or larger than it by more than
+// the tolerance are flagged and make the exit code nonzero.
+// The ph-pipeline model runs the hierarchy as a layer pipeline over --subdevices sub-device queues, ph-bands splits every layer into
+// row bands over them. After timing, both are compared with a sequential hierarchy created from the same seed and stepped through
+// the same inputs (lines starting with #). Bands must match it, mismatches also make the exit code nonzero.
+// The predq models step on frames that only differ in a small patch, predq-changes with change driven input processing
+// (AgentPredQ::_changeTileSize), which steps without learning use. It is compared with a full recompute agent the same way and must match.
+// Models are released into the image pool after their configuration, so later configurations of the same shapes reuse their images
+
+struct Config {
+	std::string _model;
+	int _numLayers;
+	cl_int _layerSize;
+	cl_int _radius;
+	cl_int _inputSize;
+	bool _learn;
+
+	std::string key() const {
+		std::ostringstream os;
+
+		os << _model << "," << _numLayers << "," << _layerSize << "," << _radius << "," << _inputSize << "," << (_learn ? 1 : 0);
+
+		return os.str();
+	}
+};
+
+struct Measurement {
+	double _p50;
+	double _p90;
+	double _p99;
+	double _stepsPerSecond;
+	double _memoryMB;
+};
+
+std::vector<int> parseList(const std::string &list) {
+	std::vector<int> items;
+
+	std::istringstream is(list);
+
+	std::string item;
+
+	while (std::getline(is, item, ','))
+		items.push_back(std::stoi(item));
+
+	return items;
+}
+
+double percentile(const std::vector<double> &sorted, double p) {
+	return sorted[std::min(sorted.size() - 1, static_cast<size_t>(p * (sorted.size() - 1) + 0.5))];
+}
+
+float imageDifference(sys::ComputeSystem &cs, const cl::Image2D &image, const cl::Image2D &reference, cl_int2 size) {
+	std::vector<cl_float> prediction(size.x * size.y);
+	std::vector<cl_float> referencePrediction(size.x * size.y);
+
+	cs.getQueue().enqueueReadImage(image, CL_TRUE, { 0, 0, 0 }, { static_cast<cl::size_type>(size.x), static_cast<cl::size_type>(size.y), 1 }, 0, 0, prediction.data());
+	cs.getQueue().enqueueReadImage(reference, CL_TRUE, { 0, 0, 0 }, { static_cast<cl::size_type>(size.x), static_cast<cl::size_type>(size.y), 1 }, 0, 0, referencePrediction.data());
+
+	float difference = 0.0f;
+
+	for (int i = 0; i < prediction.size(); i++)
+		difference = std::max(difference, std::abs(prediction[i] - referencePrediction[i]));
+
+	return difference;
+}
+
+int main(int argc, char* argv[]) {
+	std::vector<std::string> models = { "ph", "spg", "er", "ha" };
+	std::vector<int> layerCounts = { 1, 3 };
+	std::vector<int> layerSizes = { 32, 64 };
+	std::vector<int> radii = { 4, 8 };
+	std::vector<int> inputSizes = { 32, 64 };
+
+	int warmupSteps = 10;
+	int measuredSteps = 50;
+
+	int numSubDevices = 0;
+
+	std::string baselinePath;
+	std::string writeBaselinePath;
+
+	double tolerance = 0.1;
+
+	for (int i = 1; i + 1 < argc; i += 2) {
+		std::string option = argv[i];
+		std::string value = argv[i + 1];
+
+		if (option == "--models") {
+			models.clear();
+
+			std::istringstream is(value);
+
+			std::string model;
+
+			while (std::getline(is, model, ','))
+				models.push_back(model);
+		}
+		else if (option == "--layers")
+			layerCounts = parseList(value);
+		else if (option == "--sizes")
+			layerSizes = parseList(value);
+		else if (option == "--radii")
+			radii = parseList(value);
+		else if (option == "--inputs")
+			inputSizes = parseList(value);
+		else if (option == "--warmup")
+			warmupSteps = std::stoi(value);
+		else if (option == "--steps")
+			measuredSteps = std::max(1, std::stoi(value));
+		else if (option == "--baseline")
+			baselinePath = value;
+		else if (option == "--write-baseline")
+			writeBaselinePath = value;
+		else if (option == "--tolerance")
+			tolerance = std::stod(value);
+		else if (option == "--subdevices")
+			numSubDevices = std::max(0, std::stoi(value));
+		else {
+			std::cerr << "Usage: " << argv[0] << " [--models ph,spg,er,ha,ph-pipeline,ph-bands,predq,predq-changes] [--layers a,b] [--sizes a,b] [--radii a,b] [--inputs a,b]"
+				<< " [--warmup n] [--steps n] [--baseline file] [--write-baseline file] [--tolerance fraction] [--subdevices n]" << std::endl;
+
+			return 1;
+		}
+	}
+
+	// Baseline lines are the output lines below: key (6 fields), p50, p90, p99, steps/s, MB
+	std::map<std::string, Measurement> baseline;
+
+	if (!baselinePath.empty()) {
+		std::ifstream is(baselinePath);
+
+		if (!is.is_open()) {
+			std::cerr << "Could not open baseline " << baselinePath << std::endl;
+
+			return 1;
+		}
+
+		std::string line;
+
+		std::getline(is, line);
+
+		while (std::getline(is, line)) {
+			std::vector<std::string> fields;
+
+			std::istringstream ls(line);
+
+			std::string field;
+
+			while (std::getline(ls, field, ','))
+				fields.push_back(field);
+
+			if (fields.size() < 11)
+				continue;
+
+			Measurement m;
+
+			m._p50 = std::stod(fields[6]);
+			m._p90 = std::stod(fields[7]);
+			m._p99 = std::stod(fields[8]);
+			m._stepsPerSecond = std::stod(fields[9]);
+			m._memoryMB = std::stod(fields[10]);
+
+			baseline[fields[0] + "," + fields[1] + "," + fields[2] + "," + fields[3] + "," + fields[4] + "," + fields[5]] = m;
+		}
+	}
+
+	std::mt19937 generator(1234);
+
+	sys::ComputeSystem cs;
+
+	cs.create(sys::ComputeSystem::_auto, false, numSubDevices);
+
+	sys::ComputeProgram prog;
+
+	prog.loadModules(cs);
+
+	neo::setImagePooling(true);
+
+	const cl_int2 actionSize = { 8, 8 };
+	const cl_int2 qSize = { 4, 4 };
+	const int numInputFrames = 4;
+	const cl_int changeTileSize = 4;
+
+	const std::string header = "model,layers,size,radius,input,learn,p50 (ms),p90 (ms),p99 (ms),steps/s,memory (MB)";
+
+	std::cout << header << (baseline.empty() ? "" : ",status") << std::endl;
+
+	std::ofstream writeBaseline;
+
+	if (!writeBaselinePath.empty()) {
+		writeBaseline.open(writeBaselinePath);
+
+		writeBaseline << header << std::endl;
+	}
+
+	int regressions = 0;
+	int mismatches = 0;
+
+	std::uniform_real_distribution<float> dist01(0.0f, 1.0f);
+
+	for (int ii = 0; ii < inputSizes.size(); ii++) {
+		cl_int inputSize = inputSizes[ii];
+
+		// A few random frames, cycled through so inputs change every step
+		std::vector<cl::Image2D> inputs(numInputFrames);
+
+		std::vector<cl_float> frame(inputSize * inputSize);
+
+		for (int f = 0; f < numInputFrames; f++) {
+			inputs[f] = cl::Image2D(cs.getContext(), CL_MEM_READ_WRITE, cl::ImageFormat(CL_R, CL_FLOAT), inputSize, inputSize);
+
+			for (int i = 0; i < frame.size(); i++)
+				frame[i] = dist01(generator);
+
+			cs.getQueue().enqueueWriteImage(inputs[f], CL_TRUE, { 0, 0, 0 }, { static_cast<cl::size_type>(inputSize), static_cast<cl::size_type>(inputSize), 1 }, 0, 0, frame.data());
+		}
+
+		// Frames that differ from the last one only in a tile sized patch each, for change driven processing
+		std::vector<cl::Image2D> patchInputs(numInputFrames);
+
+		for (int f = 0; f < numInputFrames; f++) {
+			patchInputs[f] = cl::Image2D(cs.getContext(), CL_MEM_READ_WRITE, cl::ImageFormat(CL_R, CL_FLOAT), inputSize, inputSize);
+
+			cl_int patchX = (f * 3 * changeTileSize) % std::max(1, inputSize - changeTileSize);
+			cl_int patchY = (f * 5 * changeTileSize) % std::max(1, inputSize - changeTileSize);
+
+			for (int x = patchX; x < std::min(inputSize, patchX + changeTileSize); x++)
+				for (int y = patchY; y < std::min(inputSize, patchY + changeTileSize); y++)
+					frame[x + y * inputSize] = dist01(generator);
+
+			cs.getQueue().enqueueWriteImage(patchInputs[f], CL_TRUE, { 0, 0, 0 }, { static_cast<cl::size_type>(inputSize), static_cast<cl::size_type>(inputSize), 1 }, 0, 0, frame.data());
+		}
+
+		cl::Image2D actionTaken = cl::Image2D(cs.getContext(), CL_MEM_READ_WRITE, cl::ImageFormat(CL_R, CL_FLOAT), actionSize.x, actionSize.y);
+
+		cs.getQueue().enqueueFillImage(actionTaken, cl_float4{ 0.0f, 0.0f, 0.0f, 0.0f }, { 0, 0, 0 }, { static_cast<cl::size_type>(actionSize.x), static_cast<cl::size_type>(actionSize.y), 1 });
+
+		for (int mi = 0; mi < models.size(); mi++)
+		for (int li = 0; li < layerCounts.size(); li++)
+		for (int si = 0; si < layerSizes.size(); si++)
+		for (int ri = 0; ri < radii.size(); ri++)
+		for (int learn = 0; learn < 2; learn++) {
+			Config config;
+
+			config._model = models[mi];
+			config._numLayers = layerCounts[li];
+			config._layerSize = layerSizes[si];
+			config._radius = radii[ri];
+			config._inputSize = inputSize;
+			config._learn = learn != 0;
+
+			cl_int2 layerSize = { config._layerSize, config._layerSize };
+			cl_int radius = config._radius;
+
+			cl::size_type memoryBefore = neo::getMemoryInUse();
+
+			// Hierarchy variants are compared with a sequential hierarchy created from the same seed
+			std::mt19937 referenceGenerator = generator;
+
+			std::vector<neo::PredictiveHierarchy::LayerDesc> phLayerDescs(config._numLayers);
+
+			for (int l = 0; l < phLayerDescs.size(); l++) {
+				phLayerDescs[l]._size = layerSize;
+				phLayerDescs[l]._feedForwardRadius = phLayerDescs[l]._recurrentRadius = phLayerDescs[l]._lateralRadius = phLayerDescs[l]._feedBackRadius = phLayerDescs[l]._predictiveRadius = radius;
+			}
+
+			// Models live until the end of this configuration
+			std::unique_ptr<neo::PredictiveHierarchy> ph;
+			std::unique_ptr<neo::AgentSPG> spg;
+			std::unique_ptr<neo::AgentER> er;
+			std::unique_ptr<neo::AgentHA> ha;
+			std::unique_ptr<neo::AgentPredQ> predq;
+
+			bool isPredQ = config._model == "predq" || config._model == "predq-changes";
+
+			const std::vector<cl::Image2D> &stepInputs = isPredQ ? patchInputs : inputs;
+
+			std::vector<neo::AgentPredQ::LayerDesc> predqLayerDescs(config._numLayers);
+
+			for (int l = 0; l < predqLayerDescs.size(); l++) {
+				predqLayerDescs[l]._size = layerSize;
+				predqLayerDescs[l]._feedForwardRadius = predqLayerDescs[l]._recurrentRadius = predqLayerDescs[l]._lateralRadius = predqLayerDescs[l]._feedBackRadius = predqLayerDescs[l]._predictiveRadius = radius;
+			}
+
+			std::function<void(const cl::Image2D &)> step;
+
+			{
+				neo::MemoryScope scope(config.key());
+
+				if (config._model == "ph" || config._model == "ph-pipeline" || config._model == "ph-bands") {
+					ph.reset(new neo::PredictiveHierarchy());
+
+					ph->createRandom(cs, prog, { inputSize, inputSize }, phLayerDescs, { -0.01f, 0.01f }, generator);
+
+					if ((config._model == "ph-pipeline" || config._model == "ph-bands") && cs.getNumSubQueues() == 0) {
+						std::cerr << config._model << " needs --subdevices > 0" << std::endl;
+
+						return 1;
+					}
+
+					if (config._model == "ph-pipeline")
+						ph->enablePipeline(cs);
+					else if (config._model == "ph-bands") {
+						for (int l = 0; l < config._numLayers; l++)
+							ph->decomposeLayer(cs, l, static_cast<int>(cs.getNumSubQueues()));
+					}
+
+					step = [&](const cl::Image2D &input) { ph->simStep(cs, input, config._learn); };
+				}
+				else if (config._model == "spg") {
+					std::vector<neo::AgentSPG::LayerDesc> layerDescs(config._numLayers);
+
+					for (int l = 0; l < layerDescs.size(); l++) {
+						layerDescs[l]._size = layerSize;
+						layerDescs[l]._feedForwardRadius = layerDescs[l]._recurrentRadius = layerDescs[l]._lateralRadius = layerDescs[l]._feedBackRadius = layerDescs[l]._predictiveRadius = radius;
+					}
+
+					spg.reset(new neo::AgentSPG());
+
+					spg->createRandom(cs, prog, { inputSize, inputSize }, actionSize, radius, layerDescs, { -0.01f, 0.01f }, generator);
+
+					step = [&](const cl::Image2D &input) { spg->simStep(cs, 0.0f, input, actionTaken, generator, config._learn); };
+				}
+				else if (config._model == "er") {
+					std::vector<neo::AgentER::LayerDesc> layerDescs(config._numLayers);
+
+					for (int l = 0; l < layerDescs.size(); l++) {
+						layerDescs[l]._size = layerSize;
+						layerDescs[l]._feedForwardRadius = layerDescs[l]._recurrentRadius = layerDescs[l]._lateralRadius = layerDescs[l]._feedBackRadius = layerDescs[l]._predictiveRadius = radius;
+					}
+
+					er.reset(new neo::AgentER());
+
+					er->createRandom(cs, prog, { inputSize, inputSize }, actionSize, qSize, layerDescs, { -0.01f, 0.01f }, generator);
+
+					step = [&](const cl::Image2D &input) { er->simStep(cs, input, actionTaken, 0.0f, generator, config._learn); };
+				}
+				else if (config._model == "ha") {
+					std::vector<neo::AgentHA::LayerDesc> layerDescs(config._numLayers);
+
+					for (int l = 0; l < layerDescs.size(); l++) {
+						layerDescs[l]._size = layerSize;
+						layerDescs[l]._feedForwardRadius = layerDescs[l]._recurrentRadius = layerDescs[l]._lateralRadius = layerDescs[l]._feedBackRadius = layerDescs[l]._predictiveRadius = radius;
+						layerDescs[l]._qRadius = radius;
+					}
+
+					ha.reset(new neo::AgentHA());
+
+					ha->createRandom(cs, prog, { inputSize, inputSize }, actionSize, layerDescs, { -0.01f, 0.01f }, generator);
+
+					step = [&](const cl::Image2D &input) { ha->simStep(cs, 0.0f, input, generator, config._learn); };
+				}
+				else if (isPredQ) {
+					predq.reset(new neo::AgentPredQ());
+
+					if (config._model == "predq-changes")
+						predq->_changeTileSize = changeTileSize;
+
+					predq->createRandom(cs, prog, { inputSize, inputSize }, actionSize, qSize, predqLayerDescs, { -0.01f, 0.01f }, generator);
+
+					step = [&](const cl::Image2D &input) { predq->simStep(cs, 0.0f, input, actionTaken, config._learn, true); };
+				}
+				else {
+					std::cerr << "Unknown model " << config._model << std::endl;
+
+					return 1;
+				}
+			}
+
+			cs.getQueue().finish();
+
+			Measurement m;
+
+			m._memoryMB = (neo::getMemoryInUse() - memoryBefore) / (1024.0 * 1024.0);
+
+			for (int s = 0; s < warmupSteps; s++)
+				step(stepInputs[s % numInputFrames]);
+
+			cs.getQueue().finish();
+
+			std::vector<double> latencies(measuredSteps);
+
+			for (int s = 0; s < measuredSteps; s++) {
+				std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+
+				step(stepInputs[s % numInputFrames]);
+
+				cs.getQueue().finish();
+
+				latencies[s] = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+			}
+
+			double total = 0.0;
+
+			for (int s = 0; s < latencies.size(); s++)
+				total += latencies[s];
+
+			std::sort(latencies.begin(), latencies.end());
+
+			m._p50 = percentile(latencies, 0.5);
+			m._p90 = percentile(latencies, 0.9);
+			m._p99 = percentile(latencies, 0.99);
+			m._stepsPerSecond = total > 0.0 ? 1000.0 * measuredSteps / total : 0.0;
+
+			std::ostringstream line;
+
+			line << config.key() << "," << m._p50 << "," << m._p90 << "," << m._p99 << "," << m._stepsPerSecond << "," << m._memoryMB;
+
+			std::cout << line.str();
+
+			if (!baseline.empty()) {
+				std::map<std::string, Measurement>::const_iterator it = baseline.find(config.key());
+
+				if (it == baseline.end())
+					std::cout << ",new";
+				else if (m._p50 > it->second._p50 * (1.0 + tolerance) || m._memoryMB > it->second._memoryMB * (1.0 + tolerance)) {
+					std::cout << ",REGRESSION (p50 " << it->second._p50 << " ms, " << it->second._memoryMB << " MB)";
+
+					regressions++;
+				}
+				else
+					std::cout << ",ok";
+			}
+
+			std::cout << std::endl;
+
+			if (writeBaseline.is_open())
+				writeBaseline << line.str() << std::endl;
+
+			// Step a sequential hierarchy through the same inputs as the variant
+			if (ph != nullptr && config._model != "ph") {
+				neo::PredictiveHierarchy reference;
+
+				reference.createRandom(cs, prog, { inputSize, inputSize }, phLayerDescs, { -0.01f, 0.01f }, referenceGenerator);
+
+				for (int s = 0; s < warmupSteps; s++)
+					reference.simStep(cs, inputs[s % numInputFrames], config._learn);
+
+				for (int s = 0; s < measuredSteps; s++)
+					reference.simStep(cs, inputs[s % numInputFrames], config._learn);
+
+				float difference = imageDifference(cs, ph->getPrediction(), reference.getPrediction(), { inputSize, inputSize });
+
+				reference.release();
+
+				std::cout << "# " << config.key() << ": max prediction difference to sequential " << difference;
+
+				// Pipelining delays feed forward by a step per layer, so only the size of its difference is reported
+				if (config._model == "ph-bands" && difference > 0.0001f) {
+					std::cout << " MISMATCH";
+
+					mismatches++;
+				}
+
+				std::cout << std::endl;
+			}
+
+			// Step a full recompute agent through the same inputs as the change driven one
+			if (config._model == "predq-changes") {
+				neo::AgentPredQ reference;
+
+				reference.createRandom(cs, prog, { inputSize, inputSize }, actionSize, qSize, predqLayerDescs, { -0.01f, 0.01f }, referenceGenerator);
+
+				for (int s = 0; s < warmupSteps; s++)
+					reference.simStep(cs, 0.0f, stepInputs[s % numInputFrames], actionTaken, config._learn, true);
+
+				for (int s = 0; s < measuredSteps; s++)
+					reference.simStep(cs, 0.0f, stepInputs[s % numInputFrames], actionTaken, config._learn, true);
+
+				float difference = imageDifference(cs, predq->getAction(), reference.getAction(), actionSize);
+
+				reference.release();
+
+				std::cout << "# " << config.key() << ": max action difference to full recompute " << difference;
+
+				if (difference > 0.0001f) {
+					std::cout << " MISMATCH";
+
+					mismatches++;
+				}
+
+				std::cout << std::endl;
+			}
+
+			cs.getQueue().finish();
+
+			if (ph != nullptr)
+				ph->release();
+			else if (spg != nullptr)
+				spg->release();
+			else if (er != nullptr)
+				er->release();
+			else if (ha != nullptr)
+				ha->release();
+			else if (predq != nullptr)
+				predq->release();
+		}
+	}
+
+	std::cout << "# " << neo::getNumImagesReused() << " images reused from the pool" << std::endl;
+
+	neo::releasePooledImages();
+
+	if (!baseline.empty())
+		std::cout << regressions << " regressions" << std::endl;
+
+	if (mismatches > 0)
+		std::cout << mismatches << " mismatches" << std::endl;
+
+	return regressions > 0 || mismatches > 0 ? 2 : 0;
+}
+
+#endif
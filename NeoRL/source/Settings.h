@@ -1,20 +1,25 @@
-#pragma once
-
-#define EXPERIMENT_SPARSE_CODING 0
-#define EXPERIMENT_SINUS_EXAMPLE 1
-#define EXPERIMENT_BINH_TEST 2
-#define EXPERIMENT_MNIST_VIDEO 3
-#define EXPERIMENT_TEXT_PREDICTION 4
-#define EXPERIMENT_RNN_BENCHMARK 5
-#define EXPERIMENT_AUDIO_GENERATE 6
-#define EXPERIMENT_RUNNER 7
-#define EXPERIMENT_PONG 8
-#define EXPERIMENT_BALANCER 9
-#define EXPERIMENT_SEQUENCE_RECALL 10
-#define EXPERIMENT_COCO 11
-#define EXPERIMENT_TEXT_TRAINING 12
-#define EXPERIMENT_RACING 13
-#define EXPERIMENT_SLIME_VOLLEYBALL 14
-#define EXPERIMENT_N_LEVEL_GENERATOR 15
-
-#define EXPERIMENT_SELECTION EXPERIMENT_TEXT_PREDICTION
+#pragma once
+
+#define EXPERIMENT_SPARSE_CODING 0
+#define EXPERIMENT_SINUS_EXAMPLE 1
+#define EXPERIMENT_BINH_TEST 2
+#define EXPERIMENT_MNIST_VIDEO 3
+#define EXPERIMENT_TEXT_PREDICTION 4
+#define EXPERIMENT_RNN_BENCHMARK 5
+#define EXPERIMENT_AUDIO_GENERATE 6
+#define EXPERIMENT_RUNNER 7
+#define EXPERIMENT_PONG 8
+#define EXPERIMENT_BALANCER 9
+#define EXPERIMENT_SEQUENCE_RECALL 10
+#define EXPERIMENT_COCO 11
+#define EXPERIMENT_TEXT_TRAINING 12
+#define EXPERIMENT_RACING 13
+#define EXPERIMENT_SLIME_VOLLEYBALL 14
+#define EXPERIMENT_N_LEVEL_GENERATOR 15
+#define EXPERIMENT_INHIBITION_BENCHMARK 16
+#define EXPERIMENT_KERNEL_BENCHMARK 17
+#define EXPERIMENT_SCALING_BENCHMARK 18
+#define EXPERIMENT_ALLOCATION_CHECK 19
+#define EXPERIMENT_MULTI_AGENT_BENCHMARK 20
+
+#define EXPERIMENT_SELECTION EXPERIMENT_TEXT_PREDICTION
@@ -0,0 +1,247 @@
+#include "AgentExecutor.h"
+
+#include <thread>
+#include <chrono>
+#include <algorithm>
+
+using namespace neo;
+
+bool AgentExecutor::create(int threadsPerDomain, const std::string &kernelDirectory) {
+	stopWorkers();
+
+	_threadsPerDomain = std::max(1, threadsPerDomain);
+
+	std::vector<cl::Platform> allPlatforms;
+	cl::Platform::get(&allPlatforms);
+
+	if (allPlatforms.empty()) {
+#ifdef SYS_DEBUG
+		std::cout << "No platforms found. Check your OpenCL installation." << std::endl;
+#endif
+		return false;
+	}
+
+	cl::Platform platform = allPlatforms.front();
+
+	std::vector<cl::Device> cpuDevices;
+
+	platform.getDevices(CL_DEVICE_TYPE_CPU, &cpuDevices);
+
+	if (cpuDevices.empty()) {
+#ifdef SYS_DEBUG
+		std::cout << "No CPU device found." << std::endl;
+#endif
+		return false;
+	}
+
+	cl::Device device = cpuDevices.front();
+
+	// One sub-device per NUMA node, the runtime then keeps each queue's threads on that node
+	cl_device_partition_property properties[] = {
+		CL_DEVICE_PARTITION_BY_AFFINITY_DOMAIN, CL_DEVICE_AFFINITY_DOMAIN_NUMA, 0
+	};
+
+	std::vector<cl::Device> domainDevices;
+
+	if (device.getInfo<CL_DEVICE_PARTITION_MAX_SUB_DEVICES>() <= 1 || device.createSubDevices(properties, &domainDevices) != CL_SUCCESS || domainDevices.empty())
+		domainDevices.assign(1, device);
+
+#ifdef SYS_DEBUG
+	std::cout << "Using " << domainDevices.size() << " NUMA domains." << std::endl;
+#endif
+
+	// A shared context lets a domain run agents of another when stealing
+	cl::Context context(domainDevices);
+
+	_domains.clear();
+	_domains.resize(domainDevices.size());
+
+	for (int d = 0; d < _domains.size(); d++) {
+		_domains[d]._cs.reset(new sys::ComputeSystem());
+		_domains[d]._cs->createShared(platform, domainDevices[d], context, domainDevices);
+
+		_domains[d]._workerSystems.resize(_threadsPerDomain);
+
+		for (int t = 0; t < _threadsPerDomain; t++) {
+			_domains[d]._workerSystems[t].reset(new sys::ComputeSystem());
+			_domains[d]._workerSystems[t]->createShared(platform, domainDevices[d], context, domainDevices);
+		}
+
+		_domains[d]._pendingMutex.reset(new std::mutex());
+	}
+
+	_steps.clear();
+
+	_totalTime = 0.0;
+
+	return kernelDirectory.empty() ? _program.loadModules(*_domains.front()._cs) : _program.loadModules(kernelDirectory, *_domains.front()._cs);
+}
+
+int AgentExecutor::addAgent(int domain, const StepFunction &step) {
+	int index = static_cast<int>(_steps.size());
+
+	_steps.push_back(step);
+
+	_domains[domain]._agents.push_back(index);
+
+	return index;
+}
+
+int AgentExecutor::getLeastLoadedDomain() const {
+	int best = 0;
+
+	for (int d = 1; d < _domains.size(); d++)
+		if (_domains[d]._agents.size() < _domains[best]._agents.size())
+			best = d;
+
+	return best;
+}
+
+int AgentExecutor::takeAgent(int domain, bool &stolen) {
+	// Own agents from the front
+	{
+		std::lock_guard<std::mutex> lock(*_domains[domain]._pendingMutex);
+
+		if (!_domains[domain]._pending.empty()) {
+			int agent = _domains[domain]._pending.front();
+
+			_domains[domain]._pending.pop_front();
+
+			stolen = false;
+
+			return agent;
+		}
+	}
+
+	// Steal from the back, starting with the next domain so thieves spread out
+	for (int offset = 1; offset < _domains.size(); offset++) {
+		Domain &victim = _domains[(domain + offset) % _domains.size()];
+
+		std::lock_guard<std::mutex> lock(*victim._pendingMutex);
+
+		if (!victim._pending.empty()) {
+			int agent = victim._pending.back();
+
+			victim._pending.pop_back();
+
+			stolen = true;
+
+			return agent;
+		}
+	}
+
+	return -1;
+}
+
+void AgentExecutor::work(int domain, int worker) {
+	sys::ComputeSystem &cs = *_domains[domain]._workerSystems[worker];
+
+	// Counters are summed locally and added under the lock, since all workers of a domain share them
+	DomainStats stats;
+
+	bool stolen;
+
+	for (int agent = takeAgent(domain, stolen); agent != -1; agent = takeAgent(domain, stolen)) {
+		std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+
+		_steps[agent](cs);
+
+		// The agent's next step may run on another worker's queue
+		cs.getQueue().finish();
+
+		stats._busyTime += std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+		stats._steps++;
+
+		if (stolen)
+			stats._stolenSteps++;
+	}
+
+	std::lock_guard<std::mutex> lock(*_domains[domain]._pendingMutex);
+
+	_domains[domain]._stats._steps += stats._steps;
+	_domains[domain]._stats._stolenSteps += stats._stolenSteps;
+	_domains[domain]._stats._busyTime += stats._busyTime;
+}
+
+void AgentExecutor::workerLoop(int domain, int worker, size_t round) {
+	for (;;) {
+		{
+			std::unique_lock<std::mutex> lock(_roundMutex);
+
+			_roundStart.wait(lock, [&] { return _stopping || _round != round; });
+
+			if (_stopping)
+				return;
+
+			round = _round;
+		}
+
+		work(domain, worker);
+
+		{
+			std::lock_guard<std::mutex> lock(_roundMutex);
+
+			if (--_workersBusy == 0)
+				_roundDone.notify_one();
+		}
+	}
+}
+
+void AgentExecutor::stopWorkers() {
+	{
+		std::lock_guard<std::mutex> lock(_roundMutex);
+
+		_stopping = true;
+	}
+
+	_roundStart.notify_all();
+
+	for (int i = 0; i < _workers.size(); i++)
+		_workers[i].join();
+
+	_workers.clear();
+
+	_stopping = false;
+}
+
+void AgentExecutor::step() {
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+
+	for (int d = 0; d < _domains.size(); d++)
+		_domains[d]._pending.assign(_domains[d]._agents.begin(), _domains[d]._agents.end());
+
+	// With a single domain and worker there is nothing to overlap, run inline
+	if (_domains.size() == 1 && _threadsPerDomain == 1)
+		work(0, 0);
+	else {
+		std::unique_lock<std::mutex> lock(_roundMutex);
+
+		// Workers are started on the first round and then wait for the next one, instead of being created every round
+		if (_workers.empty()) {
+			for (int d = 0; d < _domains.size(); d++)
+				for (int t = 0; t < _threadsPerDomain; t++)
+					_workers.push_back(std::thread(&AgentExecutor::workerLoop, this, d, t, _round));
+		}
+
+		_workersBusy = static_cast<int>(_workers.size());
+
+		_round++;
+
+		_roundStart.notify_all();
+
+		_roundDone.wait(lock, [&] { return _workersBusy == 0; });
+	}
+
+	_totalTime += std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+void AgentExecutor::report(std::ostream &os) const {
+	for (int d = 0; d < _domains.size(); d++) {
+		const DomainStats &stats = _domains[d]._stats;
+
+		os << "Domain " << d << ": " << _domains[d]._agents.size() << " agents, "
+			<< stats._steps << " steps (" << stats._stolenSteps << " stolen), "
+			<< (_totalTime > 0.0 ? stats._steps / _totalTime : 0.0) << " steps/s, "
+			<< (_totalTime > 0.0 ? 100.0 * stats._busyTime / (_totalTime * _threadsPerDomain) : 0.0) << "% busy" << std::endl;
+	}
+}
@@ -0,0 +1,226 @@
+#pragma once
+
+#include "Helpers.h"
+
+#include <functional>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <memory>
+#include <iostream>
+
+namespace neo {
+	/*!
+	\brief Multi-agent executor
+	Splits the CPU device into its NUMA domains, each with its own compute system (queue) in one shared context.
+	Agents are assigned a home domain, which they are created on so their buffers are first touched (and placed) there.
+	Every round steps each agent once. Domains run their own agents first, then steal from the back of the other domains' lists.
+	Worker threads persist between rounds, and each has its own queue.
+	Host threads are not pinned to their domain, only the queues are placed through the sub-devices, so pinning is left to the runtime and OS scheduler
+	*/
+	class AgentExecutor {
+	public:
+		/*!
+		\brief Steps an agent once, enqueuing through the given compute system
+		It belongs to the worker running the step, on the home domain unless stolen, so models may swap its queue while they step
+		*/
+		typedef std::function<void(sys::ComputeSystem &cs)> StepFunction;
+
+		/*!
+		\brief Per domain counters, accumulated over all rounds
+		*/
+		struct DomainStats {
+			//!@{
+			/*!
+			\brief Steps run on this domain, and how many of them were stolen from other domains
+			*/
+			size_t _steps;
+			size_t _stolenSteps;
+			//!@}
+
+			/*!
+			\brief Time spent in steps, in seconds
+			*/
+			double _busyTime;
+
+			/*!
+			\brief Initialize defaults
+			*/
+			DomainStats()
+				: _steps(0), _stolenSteps(0), _busyTime(0.0)
+			{}
+		};
+
+	private:
+		/*!
+		\brief Domain
+		*/
+		struct Domain {
+			/*!
+			\brief Compute system on the domain's sub-device, agents are created with it
+			*/
+			std::unique_ptr<sys::ComputeSystem> _cs;
+
+			/*!
+			\brief Compute system per worker thread, so models that swap the queue (asynchronous learning, pipelining, bands) do not race
+			*/
+			std::vector<std::unique_ptr<sys::ComputeSystem>> _workerSystems;
+
+			/*!
+			\brief Agents (indices) that live on this domain
+			*/
+			std::vector<int> _agents;
+
+			//!@{
+			/*!
+			\brief Agents left in the current round, and the lock guarding them against stealing
+			*/
+			std::deque<int> _pending;
+			std::unique_ptr<std::mutex> _pendingMutex;
+			//!@}
+
+			/*!
+			\brief Counters
+			*/
+			DomainStats _stats;
+		};
+
+		/*!
+		\brief Domains
+		*/
+		std::vector<Domain> _domains;
+
+		/*!
+		\brief Program built for all domains
+		*/
+		sys::ComputeProgram _program;
+
+		/*!
+		\brief Step functions of all agents
+		*/
+		std::vector<StepFunction> _steps;
+
+		/*!
+		\brief Worker threads per domain
+		*/
+		int _threadsPerDomain;
+
+		/*!
+		\brief Wall time of all rounds, in seconds
+		*/
+		double _totalTime;
+
+		//!@{
+		/*!
+		\brief Persistent worker threads, and the round counter they wait on
+		*/
+		std::vector<std::thread> _workers;
+		std::mutex _roundMutex;
+		std::condition_variable _roundStart;
+		std::condition_variable _roundDone;
+		size_t _round;
+		int _workersBusy;
+		bool _stopping;
+		//!@}
+
+		/*!
+		\brief Take the next agent for a worker of a domain, own agents first, returns -1 when the round is done
+		*/
+		int takeAgent(int domain, bool &stolen);
+
+		/*!
+		\brief Step agents until the round is done
+		*/
+		void work(int domain, int worker);
+
+		/*!
+		\brief Thread function of a persistent worker, runs work once per round after the given one
+		*/
+		void workerLoop(int domain, int worker, size_t round);
+
+		/*!
+		\brief Stop and join the worker threads
+		*/
+		void stopWorkers();
+
+	public:
+		/*!
+		\brief Initialize defaults
+		*/
+		AgentExecutor()
+			: _threadsPerDomain(1), _totalTime(0.0),
+			_round(0), _workersBusy(0), _stopping(false)
+		{}
+
+		/*!
+		\brief Stops the worker threads
+		*/
+		~AgentExecutor() {
+			stopWorkers();
+		}
+
+		/*!
+		\brief Create the domains and load the kernel modules for them (embedded if kernelDirectory is empty, see ComputeProgram::loadModules)
+		Without NUMA partitioning support (or on single domain machines) the whole CPU device is used as one domain.
+		threadsPerDomain host threads drive each domain, more than one lets host work of one agent overlap kernels of another
+		*/
+		bool create(int threadsPerDomain = 1, const std::string &kernelDirectory = "");
+
+		/*!
+		\brief Add an agent to a domain, returns its index
+		The agent should be created with getComputeSystem(domain) and getProgram()
+		*/
+		int addAgent(int domain, const StepFunction &step);
+
+		/*!
+		\brief Domain with the fewest agents, for balanced placement
+		*/
+		int getLeastLoadedDomain() const;
+
+		/*!
+		\brief Step every agent once, returns when all are done
+		*/
+		void step();
+
+		/*!
+		\brief Print steps per second and stolen steps of every domain
+		*/
+		void report(std::ostream &os) const;
+
+		/*!
+		\brief Get number of domains
+		*/
+		size_t getNumDomains() const {
+			return _domains.size();
+		}
+
+		/*!
+		\brief Get the compute system of a domain
+		*/
+		sys::ComputeSystem &getComputeSystem(int domain) {
+			return *_domains[domain]._cs;
+		}
+
+		/*!
+		\brief Get the program, valid on every domain
+		*/
+		sys::ComputeProgram &getProgram() {
+			return _program;
+		}
+
+		/*!
+		\brief Get the counters of a domain
+		*/
+		const DomainStats &getDomainStats(int domain) const {
+			return _domains[domain]._stats;
+		}
+
+		/*!
+		\brief Get wall time of all rounds so far, in seconds
+		*/
+		double getTotalTime() const {
+			return _totalTime;
+		}
+	};
+}
@@ -1,186 +1,252 @@
-#pragma once
-
-#include "SparsePredictor.h"
-#include "ImageWhitener.h"
-
-namespace neo {
-	/*!
-	\brief Predictive hierarchy (no RL)
-	*/
-	class AgentPredQ {
-	public:
-		/*!
-		\brief Layer desc
-		*/
-		struct LayerDesc {
-			/*!
-			\brief Size of layer
-			*/
-			cl_int2 _size;
-
-			/*!
-			\brief Radii
-			*/
-			cl_int _feedForwardRadius, _recurrentRadius, _lateralRadius, _feedBackRadius, _predictiveRadius;
-
-			//!@{
-			/*!
-			\brief Sparse predictor parameters
-			*/
-			cl_float _spWeightEncodeAlpha;
-			cl_float _spWeightDecodeAlpha;
-			cl_float _spWeightLambda;
-			cl_float _spActiveRatio;
-			cl_float _spBiasAlpha;
-			//!@}
-
-			/*!
-			\brief Initialize defaults
-			*/
-			LayerDesc()
-				: _size({ 8, 8 }),
-				_feedForwardRadius(5), _recurrentRadius(5), _lateralRadius(5), _feedBackRadius(6), _predictiveRadius(6),
-				_spWeightEncodeAlpha(0.01f), _spWeightDecodeAlpha(0.01f), _spWeightLambda(0.95f),
-				_spActiveRatio(0.02f), _spBiasAlpha(0.001f)
-			{}
-		};
-
-		/*!
-		\brief Layer
-		*/
-		struct Layer {
-			/*!
-			\brief Sparse predictor
-			*/
-			SparsePredictor _sp;
-
-			/*!
-			\brief Layer for additional error signals
-			*/
-			cl::Image2D _additionalErrors;
-		};
-
-	private:
-		//!@{
-		/*!
-		\brief Store sizes
-		*/
-		cl_int2 _inputSize;
-		cl_int2 _actionSize;
-		cl_int2 _qSize;
-		//!@}
-
-		//!@{
-		/*!
-		\brief Layers and descs
-		*/
-		std::vector<Layer> _layers;
-		std::vector<LayerDesc> _layerDescs;
-
-		cl::Image2D _qInputLayer;
-		cl::Image2D _qRetrievalLayer;
-		cl::Image2D _qTransforms;
-		//!@}
-
-		/*!
-		\brief Input whitener
-		*/
-		ImageWhitener _inputWhitener;
-
-		/*!
-		\brief Zero layer for capping of the network
-		*/
-		cl::Image2D _zeroLayer;
-
-		/*!
-		\brief For RL
-		*/
-		float _prevValue;
-
-		//!@{
-		/*!
-		\brief Additional kernels
-		*/
-		cl::Kernel _setQKernel;
-		cl::Kernel _getQKernel;
-		//!@}
-
-	public:
-		//!@{
-		/*!
-		\brief Whitening parameters
-		*/
-		cl_int _whiteningKernelRadius;
-		cl_float _whiteningIntensity;
-		//!@}
-
-		//!@{
-		/*!
-		\brief For RL
-		*/
-		float _qAlpha;
-		float _qGamma;
-		//!@}
-
-		/*!
-		\brief Initialize defaults
-		*/
-		AgentPredQ()
-			: _whiteningKernelRadius(1),
-			_whiteningIntensity(1024.0f),
-			// RL
-			_prevValue(0.0f),
-			_qAlpha(0.5f),
-			_qGamma(0.98f)
-		{}
-
-		/*!
-		\brief Create a predictive hierarchy with random initialization
-		Requires the compute system, program with the NeoRL kernels, and initialization information
-		*/
-		void createRandom(sys::ComputeSystem &cs, sys::ComputeProgram &program,
-			cl_int2 inputSize, cl_int2 actionSize, cl_int2 qSize, const std::vector<LayerDesc> &layerDescs,
-			cl_float2 initWeightRange,
-			std::mt19937 &rng);
-
-		/*!
-		\brief Simulation step of hierarchy
-		*/
-		void simStep(sys::ComputeSystem &cs, float reward, const cl::Image2D &input, const cl::Image2D &actionTaken, bool learn = true, bool whiten = false);
-
-		/*!
-		\brief Get number of layers
-		*/
-		size_t getNumLayers() const {
-			return _layers.size();
-		}
-
-		/*!
-		\brief Get access to a layer
-		*/
-		const Layer &getLayer(int index) const {
-			return _layers[index];
-		}
-
-		/*!
-		\brief Get access to a layer desc
-		*/
-		const LayerDesc &getLayerDescs(int index) const {
-			return _layerDescs[index];
-		}
-
-		/*!
-		\brief Get the prediction
-		*/
-		const cl::Image2D &getAction() const {
-			return _layers.front()._sp.getVisibleLayer(2)._predictions[_back];
-		}
-
-		/*!
-		\brief Get input whitener
-		*/
-		const ImageWhitener &getInputWhitener() const {
-			return _inputWhitener;
-		}
-	};
+#pragma once
+
+#include "SparsePredictor.h"
+#include "ImageWhitener.h"
+
+namespace neo {
+	/*!
+	\brief Predictive hierarchy (no RL)
+	*/
+	class AgentPredQ {
+	public:
+		/*!
+		\brief Layer desc
+		*/
+		struct LayerDesc {
+			/*!
+			\brief Size of layer
+			*/
+			cl_int2 _size;
+
+			/*!
+			\brief Radii
+			*/
+			cl_int _feedForwardRadius, _recurrentRadius, _lateralRadius, _feedBackRadius, _predictiveRadius;
+
+			//!@{
+			/*!
+			\brief Sparse predictor parameters
+			*/
+			cl_float _spWeightEncodeAlpha;
+			cl_float _spWeightDecodeAlpha;
+			cl_float _spWeightLambda;
+			cl_float _spActiveRatio;
+			cl_float _spBiasAlpha;
+			//!@}
+
+			/*!
+			\brief Initialize defaults
+			*/
+			LayerDesc()
+				: _size({ 8, 8 }),
+				_feedForwardRadius(5), _recurrentRadius(5), _lateralRadius(5), _feedBackRadius(6), _predictiveRadius(6),
+				_spWeightEncodeAlpha(0.01f), _spWeightDecodeAlpha(0.01f), _spWeightLambda(0.95f),
+				_spActiveRatio(0.02f), _spBiasAlpha(0.001f)
+			{}
+		};
+
+		/*!
+		\brief Layer
+		*/
+		struct Layer {
+			/*!
+			\brief Sparse predictor
+			*/
+			SparsePredictor _sp;
+
+			/*!
+			\brief Layer for additional error signals
+			*/
+			cl::Image2D _additionalErrors;
+		};
+
+	private:
+		//!@{
+		/*!
+		\brief Store sizes
+		*/
+		cl_int2 _inputSize;
+		cl_int2 _actionSize;
+		cl_int2 _qSize;
+		//!@}
+
+		//!@{
+		/*!
+		\brief Layers and descs
+		*/
+		std::vector<Layer> _layers;
+		std::vector<LayerDesc> _layerDescs;
+
+		cl::Image2D _qInputLayer;
+		cl::Image2D _qRetrievalLayer;
+		cl::Image2D _qTransforms;
+		//!@}
+
+		/*!
+		\brief Input whitener
+		*/
+		ImageWhitener _inputWhitener;
+
+		/*!
+		\brief Input change detector, only used when _changeTileSize > 0
+		*/
+		TileChangeDetector _inputChanges;
+
+		/*!
+		\brief Whether the last change driven step whitened, its cached results only hold for the same choice
+		*/
+		bool _changeWhitened;
+
+		/*!
+		\brief Zero layer for capping of the network
+		*/
+		cl::Image2D _zeroLayer;
+
+		/*!
+		\brief For RL
+		*/
+		float _prevValue;
+
+		//!@{
+		/*!
+		\brief Asynchronous learning (see _asyncLearning)
+		Learning runs on _learnQueue from copies of the step's input and action, _learnDone marks its completion
+		*/
+		cl::CommandQueue _learnQueue;
+		cl::Image2D _learnInput;
+		cl::Image2D _learnActionTaken;
+		cl::Event _learnDone;
+		bool _learnPending;
+		//!@}
+
+		//!@{
+		/*!
+		\brief Additional kernels
+		*/
+		cl::Kernel _setQKernel;
+		cl::Kernel _getQKernel;
+		//!@}
+
+	public:
+		//!@{
+		/*!
+		\brief Whitening parameters
+		*/
+		cl_int _whiteningKernelRadius;
+		cl_float _whiteningIntensity;
+		//!@}
+
+		//!@{
+		/*!
+		\brief Change driven input processing (see TileChangeDetector)
+		With a tile size > 0 (set before createRandom), steps without learning only recompute whitening and the first layer's input encoding
+		near input tiles that changed. Above _maxChangedFraction changed tiles, or after a learning step, everything is recomputed
+		*/
+		cl_int _changeTileSize;
+		cl_float _changeThreshold;
+		cl_float _maxChangedFraction;
+		//!@}
+
+		/*!
+		\brief Whether learning runs on a second queue, off the action's critical path (set before createRandom)
+		simStep returns as soon as the action is computed, while learning runs on the device alongside whatever the host does next (e.g. physics).
+		The learn delay is zero steps: a step's learning always completes before the next step's forward pass starts,
+		so results are identical to synchronous learning. Input and action must be CL_R float images
+		*/
+		bool _asyncLearning;
+
+		//!@{
+		/*!
+		\brief For RL
+		*/
+		float _qAlpha;
+		float _qGamma;
+		//!@}
+
+		/*!
+		\brief Initialize defaults
+		*/
+		AgentPredQ()
+			: _changeWhitened(false),
+			// RL
+			_prevValue(0.0f),
+			_learnPending(false),
+			_whiteningKernelRadius(1),
+			_whiteningIntensity(1024.0f),
+			_changeTileSize(0),
+			_changeThreshold(0.0f),
+			_maxChangedFraction(0.5f),
+			_asyncLearning(false),
+			_qAlpha(0.5f),
+			_qGamma(0.98f)
+		{}
+
+		/*!
+		\brief Create a predictive hierarchy with random initialization
+		Requires the compute system, program with the NeoRL kernels, and initialization information
+		*/
+		void createRandom(sys::ComputeSystem &cs, sys::ComputeProgram &program,
+			cl_int2 inputSize, cl_int2 actionSize, cl_int2 qSize, const std::vector<LayerDesc> &layerDescs,
+			cl_float2 initWeightRange,
+			std::mt19937 &rng);
+
+		/*!
+		\brief Drop all device memory, the images go to the pool when pooling is enabled (see setImagePooling)
+		The model has to be created again before it is used
+		*/
+		void release();
+
+		/*!
+		\brief Simulation step of hierarchy
+		*/
+		void simStep(sys::ComputeSystem &cs, float reward, const cl::Image2D &input, const cl::Image2D &actionTaken, bool learn = true, bool whiten = false);
+
+		/*!
+		\brief Wait for learning still running from the last step (asynchronous learning only)
+		Needed before reading weights on the host
+		*/
+		void finishLearning();
+
+		/*!
+		\brief Get number of layers
+		*/
+		size_t getNumLayers() const {
+			return _layers.size();
+		}
+
+		/*!
+		\brief Get access to a layer
+		*/
+		const Layer &getLayer(int index) const {
+			return _layers[index];
+		}
+
+		/*!
+		\brief Get access to a layer desc
+		*/
+		const LayerDesc &getLayerDescs(int index) const {
+			return _layerDescs[index];
+		}
+
+		/*!
+		\brief Get the prediction
+		*/
+		const cl::Image2D &getAction() const {
+			return _layers.front()._sp.getVisibleLayer(2)._predictions[_back];
+		}
+
+		/*!
+		\brief Select how the input whitener gathers statistics, validated at the current whitening parameters (see ImageWhitener::setMode)
+		*/
+		bool setWhiteningMode(sys::ComputeSystem &cs, ImageWhitener::Mode mode, const cl::Image2D &validationInput, cl_float tolerance = 0.001f) {
+			return _inputWhitener.setMode(cs, mode, validationInput, _whiteningKernelRadius, _whiteningIntensity, tolerance);
+		}
+
+		/*!
+		\brief Get input whitener
+		*/
+		const ImageWhitener &getInputWhitener() const {
+			return _inputWhitener;
+		}
+	};
 }
\ No newline at end of file
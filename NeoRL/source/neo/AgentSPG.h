@@ -1,213 +1,267 @@
-#pragma once
-
-#include "ComparisonSparseCoder.h"
-#include "Predictor.h"
-#include "PredictorSwarm.h"
-#include "ImageWhitener.h"
-
-namespace neo {
-	/*!
-	\brief Policy gradient agent
-	*/
-	class AgentSPG {
-	public:
-		/*!
-		\brief Layer desc
-		*/
-		struct LayerDesc {
-			/*!
-			\brief Size of layer
-			*/
-			cl_int2 _size;
-
-			/*!
-			\brief Radii
-			*/
-			cl_int _feedForwardRadius, _recurrentRadius, _lateralRadius, _feedBackRadius, _predictiveRadius;
-
-			//!@{
-			/*!
-			\brief Sparse coder parameters
-			*/
-			cl_float _scWeightAlpha;
-			cl_float _scWeightRecurrentAlpha;
-			cl_float _scWeightLambda;
-			cl_float _scActiveRatio;
-			cl_float _scBoostAlpha;
-			//!@}
-
-			//!@{
-			/*!
-			\brief RL
-			*/
-			cl_float2 _alpha;
-			cl_float _gamma;
-			cl_float2 _lambda;
-			cl_float _noise;
-			//!@}
-
-			/*!
-			\brief Initialize defaults
-			*/
-			LayerDesc()
-				: _size({ 8, 8 }),
-				_feedForwardRadius(5), _recurrentRadius(5), _lateralRadius(5), _feedBackRadius(6), _predictiveRadius(6),
-				_scWeightAlpha(0.001f), _scWeightRecurrentAlpha(0.001f), _scWeightLambda(0.96f),
-				_scActiveRatio(0.02f), _scBoostAlpha(0.01f),
-				_alpha({ 0.01f, 0.01f }), _gamma(0.98f), _lambda({ 0.96f, 0.96f }), _noise(0.0f)
-			{}
-		};
-
-		/*!
-		\brief Layer
-		*/
-		struct Layer {
-			//!@{
-			/*!
-			\brief Sparse coder and predictor
-			*/
-			ComparisonSparseCoder _sc;
-			PredictorSwarm _pred;
-			//!@}
-
-			//!@{
-			/*!
-			\brief For prediction reward determination
-			*/
-			cl::Image2D _predReward;
-			cl::Image2D _propagatedPredReward;
-			//!@}
-		};
-
-	private:
-		/*!
-		\brief Store input size
-		*/
-		cl_int2 _inputSize;
-
-		/*!
-		\brief Store action size
-		*/
-		cl_int2 _actionSize;
-
-		//!@{
-		/*!
-		\brief Layers and descs
-		*/
-		std::vector<Layer> _layers;
-		std::vector<LayerDesc> _layerDescs;
-		//!@}
-
-		//!@{
-		/*!
-		\brief Kernels for hierarchy
-		*/
-		cl::Kernel _predictionRewardKernel;
-		cl::Kernel _predictionRewardPropagationKernel;
-		//!@}
-
-		//!@{
-		/*!
-		\brief Input whiteners
-		*/
-		ImageWhitener _inputWhitener;
-		ImageWhitener _actionWhitener;
-		//!@}
-
-	public:
-		//!@{
-		/*!
-		\brief Whitening parameters
-		*/
-		cl_int _whiteningKernelRadius;
-		cl_float _whiteningIntensity;
-		//!@}
-
-		/*!
-		\brief Action prediction parameters
-		*/
-		cl_float _actionPredAlpha;
-
-		/*!
-		\brief Initialize defaults
-		*/
-		AgentSPG()
-			: _whiteningKernelRadius(2),
-			_whiteningIntensity(1024.0f),
-			_actionPredAlpha(0.1f)
-		{}
-
-		/*!
-		\brief Create a comparison sparse coder with random initialization
-		Requires the compute system, program with the NeoRL kernels, and initialization information.
-		*/
-		void createRandom(sys::ComputeSystem &cs, sys::ComputeProgram &program,
-			cl_int2 inputSize, cl_int2 actionSize, cl_int actionPredRadius, const std::vector<LayerDesc> &layerDescs,
-			cl_float2 initWeightRange,
-			std::mt19937 &rng);
-
-		//!@{
-		/*!
-		\brief Simulation step of hierarchy
-		*/
-		void simStep(sys::ComputeSystem &cs, float reward, const cl::Image2D &input, const cl::Image2D &actionTaken, std::mt19937 &rng, bool learn = true, bool useInputWhitener = true, bool binaryOutput = false);
-		//!@}
-
-		/*!
-		\brief Clear working memory
-		*/
-		void clearMemory(sys::ComputeSystem &cs);
-
-		/*!
-		\brief Write to stream
-		*/
-		void writeToStream(sys::ComputeSystem &cs, std::ostream &os) const;
-
-		/*!
-		\brief Read from stream
-		*/
-		void readFromStream(sys::ComputeSystem &cs, sys::ComputeProgram &program, std::istream &is);
-
-		/*!
-		\brief Get number of layers
-		*/
-		size_t getNumLayers() const {
-			return _layers.size();
-		}
-
-		/*!
-		\brief Get access to a layer
-		*/
-		const Layer &getLayer(int index) const {
-			return _layers[index];
-		}
-
-		/*!
-		\brief Get access to a layer desc
-		*/
-		const LayerDesc &getLayerDescs(int index) const {
-			return _layerDescs[index];
-		}
-
-		/*!
-		\brief Get exploratory action
-		*/
-		const cl::Image2D &getAction() const {
-			return _layers.front()._pred.getHiddenStates()[_back];
-		}
-
-		/*!
-		\brief Get input whitener
-		*/
-		const ImageWhitener &getInputWhitener() const {
-			return _inputWhitener;
-		}
-
-		/*!
-		\brief Get action whitener
-		*/
-		const ImageWhitener &getActionWhitener() const {
-			return _actionWhitener;
-		}
-	};
+#pragma once
+
+#include "ComparisonSparseCoder.h"
+#include "Predictor.h"
+#include "PredictorSwarm.h"
+#include "ImageWhitener.h"
+
+namespace neo {
+	/*!
+	\brief Policy gradient agent
+	*/
+	class AgentSPG {
+	public:
+		/*!
+		\brief Layer desc
+		*/
+		struct LayerDesc {
+			/*!
+			\brief Size of layer
+			*/
+			cl_int2 _size;
+
+			/*!
+			\brief Radii
+			*/
+			cl_int _feedForwardRadius, _recurrentRadius, _lateralRadius, _feedBackRadius, _predictiveRadius;
+
+			//!@{
+			/*!
+			\brief Sparse coder parameters
+			*/
+			cl_float _scWeightAlpha;
+			cl_float _scWeightRecurrentAlpha;
+			cl_float _scWeightLambda;
+			cl_float _scActiveRatio;
+			cl_float _scBoostAlpha;
+			//!@}
+
+			//!@{
+			/*!
+			\brief RL
+			*/
+			cl_float2 _alpha;
+			cl_float _gamma;
+			cl_float2 _lambda;
+			cl_float _noise;
+			//!@}
+
+			/*!
+			\brief Clock divisor, the layer only runs every _clockDivisor steps
+			In between it holds its states and predictions, so lower layers receive the last computed feed back
+			*/
+			cl_int _clockDivisor;
+
+			/*!
+			\brief Initialize defaults
+			*/
+			LayerDesc()
+				: _size({ 8, 8 }),
+				_feedForwardRadius(5), _recurrentRadius(5), _lateralRadius(5), _feedBackRadius(6), _predictiveRadius(6),
+				_scWeightAlpha(0.001f), _scWeightRecurrentAlpha(0.001f), _scWeightLambda(0.96f),
+				_scActiveRatio(0.02f), _scBoostAlpha(0.01f),
+				_alpha({ 0.01f, 0.01f }), _gamma(0.98f), _lambda({ 0.96f, 0.96f }), _noise(0.0f),
+				_clockDivisor(1)
+			{}
+		};
+
+		/*!
+		\brief Layer
+		*/
+		struct Layer {
+			//!@{
+			/*!
+			\brief Sparse coder and predictor
+			*/
+			ComparisonSparseCoder _sc;
+			PredictorSwarm _pred;
+			//!@}
+
+			//!@{
+			/*!
+			\brief For prediction reward determination
+			*/
+			cl::Image2D _predReward;
+			cl::Image2D _propagatedPredReward;
+			//!@}
+		};
+
+	private:
+		/*!
+		\brief Store input size
+		*/
+		cl_int2 _inputSize;
+
+		/*!
+		\brief Store action size
+		*/
+		cl_int2 _actionSize;
+
+		//!@{
+		/*!
+		\brief Layers and descs
+		*/
+		std::vector<Layer> _layers;
+		std::vector<LayerDesc> _layerDescs;
+		//!@}
+
+		//!@{
+		/*!
+		\brief Kernels for hierarchy
+		*/
+		cl::Kernel _predictionRewardKernel;
+		cl::Kernel _predictionRewardPropagationKernel;
+		//!@}
+
+		//!@{
+		/*!
+		\brief Input whiteners
+		*/
+		ImageWhitener _inputWhitener;
+		ImageWhitener _actionWhitener;
+		//!@}
+
+		/*!
+		\brief Number of steps simulated so far, drives the layer clocks
+		*/
+		cl_ulong _clock;
+
+		/*!
+		\brief Whether the agent was frozen for inference
+		*/
+		bool _frozen;
+
+		//!@{
+		/*!
+		\brief Argument lists reused every step, so stepping does not allocate
+		*/
+		std::vector<cl::Image2D> _visibleStates;
+		std::vector<cl::Image2D> _visibleStatesPrev;
+		//!@}
+
+	public:
+		//!@{
+		/*!
+		\brief Whitening parameters
+		*/
+		cl_int _whiteningKernelRadius;
+		cl_float _whiteningIntensity;
+		//!@}
+
+		/*!
+		\brief Action prediction parameters
+		*/
+		cl_float _actionPredAlpha;
+
+		/*!
+		\brief Initialize defaults
+		*/
+		AgentSPG()
+			: _clock(0),
+			_frozen(false),
+			_whiteningKernelRadius(2),
+			_whiteningIntensity(1024.0f),
+			_actionPredAlpha(0.1f)
+		{}
+
+		/*!
+		\brief Create a comparison sparse coder with random initialization
+		Requires the compute system, program with the NeoRL kernels, and initialization information.
+		*/
+		void createRandom(sys::ComputeSystem &cs, sys::ComputeProgram &program,
+			cl_int2 inputSize, cl_int2 actionSize, cl_int actionPredRadius, const std::vector<LayerDesc> &layerDescs,
+			cl_float2 initWeightRange,
+			std::mt19937 &rng);
+
+		/*!
+		\brief Drop all device memory, the images go to the pool when pooling is enabled (see setImagePooling)
+		The model has to be created again before it is used
+		*/
+		void release();
+
+		//!@{
+		/*!
+		\brief Simulation step of hierarchy
+		*/
+		void simStep(sys::ComputeSystem &cs, float reward, const cl::Image2D &input, const cl::Image2D &actionTaken, std::mt19937 &rng, bool learn = true, bool useInputWhitener = true, bool binaryOutput = false);
+		//!@}
+
+		/*!
+		\brief Freeze a trained agent for inference
+		Releases the front weight buffers, traces and prediction reward images of every layer, about halving device memory.
+		Steps ignore learn afterwards
+		*/
+		void freeze();
+
+		/*!
+		\brief Whether the agent was frozen
+		*/
+		bool isFrozen() const {
+			return _frozen;
+		}
+
+		/*!
+		\brief Clear working memory
+		*/
+		void clearMemory(sys::ComputeSystem &cs);
+
+		/*!
+		\brief Write to stream
+		*/
+		void writeToStream(sys::ComputeSystem &cs, std::ostream &os) const;
+
+		/*!
+		\brief Read from stream
+		*/
+		void readFromStream(sys::ComputeSystem &cs, sys::ComputeProgram &program, std::istream &is);
+
+		/*!
+		\brief Get number of layers
+		*/
+		size_t getNumLayers() const {
+			return _layers.size();
+		}
+
+		/*!
+		\brief Get access to a layer
+		*/
+		const Layer &getLayer(int index) const {
+			return _layers[index];
+		}
+
+		/*!
+		\brief Get access to a layer desc
+		*/
+		const LayerDesc &getLayerDescs(int index) const {
+			return _layerDescs[index];
+		}
+
+		/*!
+		\brief Whether a layer runs on the current step (see LayerDesc::_clockDivisor)
+		*/
+		bool isLayerTicking(int index) const {
+			return _clock % _layerDescs[index]._clockDivisor == 0;
+		}
+
+		/*!
+		\brief Get exploratory action
+		*/
+		const cl::Image2D &getAction() const {
+			return _layers.front()._pred.getHiddenStates()[_back];
+		}
+
+		/*!
+		\brief Get input whitener
+		*/
+		const ImageWhitener &getInputWhitener() const {
+			return _inputWhitener;
+		}
+
+		/*!
+		\brief Get action whitener
+		*/
+		const ImageWhitener &getActionWhitener() const {
+			return _actionWhitener;
+		}
+	};
 }
\ No newline at end of file
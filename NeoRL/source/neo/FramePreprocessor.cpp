@@ -0,0 +1,62 @@
+#include "FramePreprocessor.h"
+
+using namespace neo;
+
+void FramePreprocessor::create(sys::ComputeSystem &cs, sys::ComputeProgram &program, cl_int2 frameSize, cl_int2 resultSize) {
+	if (!program.requireModules(cs, { "whitening" })) {
+		assert(false);
+
+		return;
+	}
+
+	MemoryScope scope("FramePreprocessor");
+
+	_frameSize = frameSize;
+	_resultSize = resultSize;
+
+	_cropOrigin = cl_int2{ 0, 0 };
+	_cropSize = frameSize;
+
+	_frame = createImage2D(cs, _frameSize, CL_RGBA, CL_UNORM_INT8, "frame");
+	_result = createImage2D(cs, _resultSize, CL_R, CL_FLOAT, "result");
+
+	_whitener.create(cs, program, _resultSize, CL_R, CL_FLOAT);
+
+	_preprocessKernel = cl::Kernel(program.getProgram(), "preprocessFrame");
+
+	_whitened = false;
+}
+
+void FramePreprocessor::process(sys::ComputeSystem &cs, const void* pixels, bool whiten, bool blocking) {
+	// Blend input is unused with a zero ratio
+	enqueue(cs, pixels, _frame, 0.0f, whiten, blocking);
+}
+
+void FramePreprocessor::processBlended(sys::ComputeSystem &cs, const void* pixels, const cl::Image2D &blend, cl_float blendRatio, bool whiten, bool blocking) {
+	enqueue(cs, pixels, blend, blendRatio, whiten, blocking);
+}
+
+void FramePreprocessor::enqueue(sys::ComputeSystem &cs, const void* pixels, const cl::Image2D &blend, cl_float blendRatio, bool whiten, bool blocking) {
+	cs.getQueue().enqueueWriteImage(_frame, blocking ? CL_TRUE : CL_FALSE, { 0, 0, 0 }, { static_cast<cl::size_type>(_frameSize.x), static_cast<cl::size_type>(_frameSize.y), 1 }, 0, 0, pixels);
+
+	int argIndex = 0;
+
+	_preprocessKernel.setArg(argIndex++, _frame);
+	_preprocessKernel.setArg(argIndex++, blend);
+	_preprocessKernel.setArg(argIndex++, _result);
+	_preprocessKernel.setArg(argIndex++, _cropOrigin);
+	_preprocessKernel.setArg(argIndex++, _cropSize);
+	_preprocessKernel.setArg(argIndex++, _resultSize);
+	_preprocessKernel.setArg(argIndex++, _channelWeights);
+	_preprocessKernel.setArg(argIndex++, _channelThreshold);
+	_preprocessKernel.setArg(argIndex++, _normalization);
+	_preprocessKernel.setArg(argIndex++, _outputRange);
+	_preprocessKernel.setArg(argIndex++, blendRatio);
+
+	cs.getQueue().enqueueNDRangeKernel(_preprocessKernel, cl::NullRange, cl::NDRange(_resultSize.x, _resultSize.y));
+
+	if (whiten)
+		_whitener.filter(cs, _result, _whiteningKernelRadius, _whiteningIntensity);
+
+	_whitened = whiten;
+}
@@ -0,0 +1,130 @@
+#pragma once
+
+#include "ImageWhitener.h"
+
+namespace neo {
+	/*!
+	\brief Frame preprocessor
+	Uploads raw RGBA8 frames and converts them on the device into the single channel image an agent consumes:
+	crop, channel weighting (grayscale by default), area resize, normalization and optional whitening
+	*/
+	class FramePreprocessor {
+	private:
+		/*!
+		\brief Kernels
+		*/
+		cl::Kernel _preprocessKernel;
+
+		//!@{
+		/*!
+		\brief Uploaded frame and preprocessed result
+		*/
+		cl::Image2D _frame;
+		cl::Image2D _result;
+		//!@}
+
+		/*!
+		\brief Whitener applied after preprocessing when requested
+		*/
+		ImageWhitener _whitener;
+
+		//!@{
+		/*!
+		\brief Sizes
+		*/
+		cl_int2 _frameSize;
+		cl_int2 _cropOrigin;
+		cl_int2 _cropSize;
+		cl_int2 _resultSize;
+		//!@}
+
+		/*!
+		\brief Whether the last processed frame was whitened
+		*/
+		bool _whitened;
+
+		/*!
+		\brief Shared by process and processBlended
+		*/
+		void enqueue(sys::ComputeSystem &cs, const void* pixels, const cl::Image2D &blend, cl_float blendRatio, bool whiten, bool blocking);
+
+	public:
+		/*!
+		\brief Channel weights, the processed value is the weighted sum of the (optionally stepped) channels
+		*/
+		cl_float4 _channelWeights;
+
+		/*!
+		\brief When >= 0, channels are stepped to 0 or 1 (greater than the threshold) before weighting
+		*/
+		cl_float _channelThreshold;
+
+		//!@{
+		/*!
+		\brief Normalization, value = clamp((value - offset) * scale, min, max)
+		*/
+		cl_float2 _normalization;
+		cl_float2 _outputRange;
+		//!@}
+
+		//!@{
+		/*!
+		\brief Whitening parameters
+		*/
+		cl_int _whiteningKernelRadius;
+		cl_float _whiteningIntensity;
+		//!@}
+
+		/*!
+		\brief Initialize defaults
+		*/
+		FramePreprocessor()
+			: _whitened(false),
+			_channelWeights({ 0.299f, 0.587f, 0.114f, 0.0f }),
+			_channelThreshold(-1.0f),
+			_normalization({ 0.0f, 1.0f }),
+			_outputRange({ 0.0f, 1.0f }),
+			_whiteningKernelRadius(1),
+			_whiteningIntensity(1024.0f)
+		{}
+
+		/*!
+		\brief Create the preprocessor
+		Requires the frame size and the size of the result. The crop defaults to the whole frame
+		*/
+		void create(sys::ComputeSystem &cs, sys::ComputeProgram &program, cl_int2 frameSize, cl_int2 resultSize);
+
+		/*!
+		\brief Set the region of the frame that is resized into the result
+		*/
+		void setCrop(cl_int2 cropOrigin, cl_int2 cropSize) {
+			_cropOrigin = cropOrigin;
+			_cropSize = cropSize;
+		}
+
+		/*!
+		\brief Upload an RGBA8 frame (e.g. sf::Image::getPixelsPtr()) and preprocess it
+		With blocking = false the pixels must stay valid until the queue has processed the upload
+		*/
+		void process(sys::ComputeSystem &cs, const void* pixels, bool whiten = false, bool blocking = true);
+
+		/*!
+		\brief Like process, but mixes the result with a single channel image of the result size: (1 - blendRatio) * frame + blendRatio * blend
+		*/
+		void processBlended(sys::ComputeSystem &cs, const void* pixels, const cl::Image2D &blend, cl_float blendRatio, bool whiten = false, bool blocking = true);
+
+		/*!
+		\brief Return the preprocessed (and whitened, if requested) result
+		*/
+		const cl::Image2D &getResult() const {
+			return _whitened ? _whitener.getResult() : _result;
+		}
+
+		/*!
+		\brief Get the result size
+		*/
+		cl_int2 getResultSize() const {
+			return _resultSize;
+		}
+	};
+}
@@ -1,119 +1,575 @@
-#include "Helpers.h"
-
-using namespace neo;
-
-DoubleBuffer2D neo::createDoubleBuffer2D(sys::ComputeSystem &cs, cl_int2 size, cl_channel_order channelOrder, cl_channel_type channelType) {
-	DoubleBuffer2D db;
-	
-	db[_front] = cl::Image2D(cs.getContext(), CL_MEM_READ_WRITE, cl::ImageFormat(channelOrder, channelType), size.x, size.y);
-	db[_back] = cl::Image2D(cs.getContext(), CL_MEM_READ_WRITE, cl::ImageFormat(channelOrder, channelType), size.x, size.y);
-
-	return db;
-}
-
-DoubleBuffer3D neo::createDoubleBuffer3D(sys::ComputeSystem &cs, cl_int3 size, cl_channel_order channelOrder, cl_channel_type channelType) {
-	DoubleBuffer3D db;
-
-	db[_front] = cl::Image3D(cs.getContext(), CL_MEM_READ_WRITE, cl::ImageFormat(channelOrder, channelType), size.x, size.y, size.z);
-	db[_back] = cl::Image3D(cs.getContext(), CL_MEM_READ_WRITE, cl::ImageFormat(channelOrder, channelType), size.x, size.y, size.z);
-
-	return db;
-}
-
-void neo::randomUniform(cl::Image2D &image2D, sys::ComputeSystem &cs, cl::Kernel &randomUniform2DKernel, cl_int2 size, cl_float2 range, std::mt19937 &rng) {
-	int argIndex = 0;
-
-	std::uniform_int_distribution<int> seedDist(0, 999);
-
-	cl_uint2 seed = { seedDist(rng), seedDist(rng) };
-
-	randomUniform2DKernel.setArg(argIndex++, image2D);
-	randomUniform2DKernel.setArg(argIndex++, seed);
-	randomUniform2DKernel.setArg(argIndex++, range);
-
-	cs.getQueue().enqueueNDRangeKernel(randomUniform2DKernel, cl::NullRange, cl::NDRange(size.x, size.y));
-}
-
-void neo::randomUniform(cl::Image3D &image3D, sys::ComputeSystem &cs, cl::Kernel &randomUniform3DKernel, cl_int3 size, cl_float2 range, std::mt19937 &rng) {
-	int argIndex = 0;
-
-	std::uniform_int_distribution<int> seedDist(0, 999);
-
-	cl_uint2 seed = { seedDist(rng), seedDist(rng) };
-
-	randomUniform3DKernel.setArg(argIndex++, image3D);
-	randomUniform3DKernel.setArg(argIndex++, seed);
-	randomUniform3DKernel.setArg(argIndex++, range);
-
-	cs.getQueue().enqueueNDRangeKernel(randomUniform3DKernel, cl::NullRange, cl::NDRange(size.x, size.y, size.z));
-}
-
-void neo::randomUniformXY(cl::Image2D &image2D, sys::ComputeSystem &cs, cl::Kernel &randomUniform2DXYKernel, cl_int2 size, cl_float2 range, std::mt19937 &rng) {
-	int argIndex = 0;
-
-	std::uniform_int_distribution<int> seedDist(0, 999);
-
-	cl_uint2 seed = { seedDist(rng), seedDist(rng) };
-
-	randomUniform2DXYKernel.setArg(argIndex++, image2D);
-	randomUniform2DXYKernel.setArg(argIndex++, seed);
-	randomUniform2DXYKernel.setArg(argIndex++, range);
-
-	cs.getQueue().enqueueNDRangeKernel(randomUniform2DXYKernel, cl::NullRange, cl::NDRange(size.x, size.y));
-}
-
-void neo::randomUniformXYZ(cl::Image2D &image2D, sys::ComputeSystem &cs, cl::Kernel &randomUniform2DXYZKernel, cl_int2 size, cl_float2 range, std::mt19937 &rng) {
-	int argIndex = 0;
-
-	std::uniform_int_distribution<int> seedDist(0, 999);
-
-	cl_uint2 seed = { seedDist(rng), seedDist(rng) };
-
-	randomUniform2DXYZKernel.setArg(argIndex++, image2D);
-	randomUniform2DXYZKernel.setArg(argIndex++, seed);
-	randomUniform2DXYZKernel.setArg(argIndex++, range);
-
-	cs.getQueue().enqueueNDRangeKernel(randomUniform2DXYZKernel, cl::NullRange, cl::NDRange(size.x, size.y));
-}
-
-void neo::randomUniformXY(cl::Image3D &image3D, sys::ComputeSystem &cs, cl::Kernel &randomUniform3DXYKernel, cl_int3 size, cl_float2 range, std::mt19937 &rng) {
-	int argIndex = 0;
-
-	std::uniform_int_distribution<int> seedDist(0, 999);
-
-	cl_uint2 seed = { seedDist(rng), seedDist(rng) };
-
-	randomUniform3DXYKernel.setArg(argIndex++, image3D);
-	randomUniform3DXYKernel.setArg(argIndex++, seed);
-	randomUniform3DXYKernel.setArg(argIndex++, range);
-
-	cs.getQueue().enqueueNDRangeKernel(randomUniform3DXYKernel, cl::NullRange, cl::NDRange(size.x, size.y, size.z));
-}
-
-void neo::randomUniformXZ(cl::Image2D &image2D, sys::ComputeSystem &cs, cl::Kernel &randomUniform2DXZKernel, cl_int2 size, cl_float2 range, std::mt19937 &rng) {
-	int argIndex = 0;
-
-	std::uniform_int_distribution<int> seedDist(0, 999);
-
-	cl_uint2 seed = { seedDist(rng), seedDist(rng) };
-
-	randomUniform2DXZKernel.setArg(argIndex++, image2D);
-	randomUniform2DXZKernel.setArg(argIndex++, seed);
-	randomUniform2DXZKernel.setArg(argIndex++, range);
-
-	cs.getQueue().enqueueNDRangeKernel(randomUniform2DXZKernel, cl::NullRange, cl::NDRange(size.x, size.y));
-}
-
-void neo::randomUniformXZ(cl::Image3D &image3D, sys::ComputeSystem &cs, cl::Kernel &randomUniform3DXZKernel, cl_int3 size, cl_float2 range, std::mt19937 &rng) {
-	int argIndex = 0;
-
-	std::uniform_int_distribution<int> seedDist(0, 999);
-
-	cl_uint2 seed = { seedDist(rng), seedDist(rng) };
-
-	randomUniform3DXZKernel.setArg(argIndex++, image3D);
-	randomUniform3DXZKernel.setArg(argIndex++, seed);
-	randomUniform3DXZKernel.setArg(argIndex++, range);
-
-	cs.getQueue().enqueueNDRangeKernel(randomUniform3DXZKernel, cl::NullRange, cl::NDRange(size.x, size.y, size.z));
-}
\ No newline at end of file
+#include "Helpers.h"
+
+#include <mutex>
+#include <map>
+#include <algorithm>
+
+using namespace neo;
+
+namespace {
+	struct Allocation {
+		// Raw handle, the registry does not keep the object alive
+		cl_mem _memory;
+
+		// Pool key, images only
+		cl_context _context;
+		bool _isImage;
+		cl_int3 _size;
+		cl_channel_order _channelOrder;
+		cl_channel_type _channelType;
+
+		std::string _owner;
+		std::string _purpose;
+		cl::size_type _bytes;
+
+		// Models whose scopes were open at allocation, see recycleImages
+		std::vector<const void*> _models;
+
+		// Only set while the image waits in the pool
+		cl::Memory _pooled;
+	};
+
+	std::mutex allocationsMutex;
+	std::vector<Allocation> allocations;
+	bool imagePooling = false;
+	size_t numImagesReused = 0;
+
+	thread_local std::vector<std::string> ownerPath;
+	thread_local std::vector<const void*> modelPath;
+
+	std::string currentOwner() {
+		std::string owner;
+
+		for (int i = 0; i < ownerPath.size(); i++)
+			owner += (i == 0 ? "" : "/") + ownerPath[i];
+
+		return owner.empty() ? "(unscoped)" : owner;
+	}
+
+	cl::size_type elementSize(cl_channel_order channelOrder, cl_channel_type channelType) {
+		cl::size_type channels;
+
+		switch (channelOrder) {
+		case CL_RG:
+			channels = 2;
+			break;
+		case CL_RGBA:
+			channels = 4;
+			break;
+		default:
+			channels = 1;
+		}
+
+		switch (channelType) {
+		case CL_UNORM_INT8:
+			return channels;
+		default:
+			return channels * sizeof(cl_float);
+		}
+	}
+
+	// Called by the runtime once an object is freed, so it may run on any thread.
+	// Memory objects must therefore never be released while allocationsMutex is held
+	void CL_CALLBACK retire(cl_mem memory, void* userData) {
+		std::lock_guard<std::mutex> lock(allocationsMutex);
+
+		for (int i = 0; i < allocations.size(); i++)
+			if (allocations[i]._memory == memory) {
+				allocations[i] = allocations.back();
+				allocations.pop_back();
+
+				break;
+			}
+	}
+
+	// Claim a pooled image of the same shape for a new owner, returns a retained handle or nullptr
+	cl_mem claim(cl_context context, cl_int3 size, cl_channel_order channelOrder, cl_channel_type channelType, const std::string &purpose) {
+		if (!imagePooling)
+			return nullptr;
+
+		for (int i = 0; i < allocations.size(); i++) {
+			Allocation &a = allocations[i];
+
+			if (a._pooled() != nullptr && a._context == context && a._size.x == size.x && a._size.y == size.y && a._size.z == size.z
+				&& a._channelOrder == channelOrder && a._channelType == channelType)
+			{
+				a._owner = currentOwner();
+				a._purpose = purpose;
+				a._models = modelPath;
+
+				numImagesReused++;
+
+				// The caller's wrapper takes over the pool's reference
+				clRetainMemObject(a._memory);
+
+				a._pooled = cl::Memory();
+
+				return a._memory;
+			}
+		}
+
+		return nullptr;
+	}
+
+	void record(const cl::Memory &memory, cl_context context, bool isImage, cl_int3 size, cl_channel_order channelOrder, cl_channel_type channelType, cl::size_type bytes, const std::string &purpose) {
+		Allocation a;
+
+		a._memory = memory();
+		a._context = context;
+		a._isImage = isImage;
+		a._size = size;
+		a._channelOrder = channelOrder;
+		a._channelType = channelType;
+		a._owner = currentOwner();
+		a._purpose = purpose;
+		a._bytes = bytes;
+		a._models = modelPath;
+
+		allocations.push_back(a);
+
+		clSetMemObjectDestructorCallback(memory(), retire, nullptr);
+	}
+
+	// Move an image into the pool, the caller drops its own reference afterwards (outside the lock)
+	void pool(const cl::Memory &image) {
+		std::lock_guard<std::mutex> lock(allocationsMutex);
+
+		if (!imagePooling || image() == nullptr)
+			return;
+
+		for (int i = 0; i < allocations.size(); i++)
+			if (allocations[i]._memory == image() && allocations[i]._isImage) {
+				if (allocations[i]._pooled() == nullptr)
+					allocations[i]._pooled = image;
+
+				break;
+			}
+	}
+
+	// Take the pool's references out under the lock, they are released when the result goes out of scope
+	std::vector<cl::Memory> drainPool() {
+		std::vector<cl::Memory> drained;
+
+		std::lock_guard<std::mutex> lock(allocationsMutex);
+
+		for (int i = 0; i < allocations.size(); i++)
+			if (allocations[i]._pooled() != nullptr) {
+				drained.push_back(allocations[i]._pooled);
+
+				allocations[i]._pooled = cl::Memory();
+			}
+
+		return drained;
+	}
+}
+
+MemoryScope::MemoryScope(const std::string &name, const void* model) {
+	ownerPath.push_back(name);
+	modelPath.push_back(model);
+}
+
+MemoryScope::~MemoryScope() {
+	ownerPath.pop_back();
+	modelPath.pop_back();
+}
+
+cl::Image2D neo::createImage2D(sys::ComputeSystem &cs, cl_int2 size, cl_channel_order channelOrder, cl_channel_type channelType, const std::string &purpose) {
+	std::lock_guard<std::mutex> lock(allocationsMutex);
+
+	cl_int3 size3 = { size.x, size.y, 1 };
+
+	cl_mem pooled = claim(cs.getContext()(), size3, channelOrder, channelType, purpose);
+
+	if (pooled != nullptr)
+		return cl::Image2D(pooled, false);
+
+	cl::Image2D image(cs.getContext(), CL_MEM_READ_WRITE, cl::ImageFormat(channelOrder, channelType), size.x, size.y);
+
+	record(image, cs.getContext()(), true, size3, channelOrder, channelType, size.x * size.y * elementSize(channelOrder, channelType), purpose);
+
+	return image;
+}
+
+cl::Image3D neo::createImage3D(sys::ComputeSystem &cs, cl_int3 size, cl_channel_order channelOrder, cl_channel_type channelType, const std::string &purpose) {
+	std::lock_guard<std::mutex> lock(allocationsMutex);
+
+	cl_mem pooled = claim(cs.getContext()(), size, channelOrder, channelType, purpose);
+
+	if (pooled != nullptr)
+		return cl::Image3D(pooled, false);
+
+	cl::Image3D image(cs.getContext(), CL_MEM_READ_WRITE, cl::ImageFormat(channelOrder, channelType), size.x, size.y, size.z);
+
+	record(image, cs.getContext()(), true, size, channelOrder, channelType, size.x * size.y * size.z * elementSize(channelOrder, channelType), purpose);
+
+	return image;
+}
+
+cl::Buffer neo::createBuffer(sys::ComputeSystem &cs, cl_mem_flags flags, cl::size_type size, const std::string &purpose) {
+	std::lock_guard<std::mutex> lock(allocationsMutex);
+
+	cl::Buffer buffer(cs.getContext(), flags, size);
+
+	record(buffer, cs.getContext()(), false, cl_int3{ 0, 0, 0 }, 0, 0, size, purpose);
+
+	return buffer;
+}
+
+DoubleBuffer2D neo::createDoubleBuffer2D(sys::ComputeSystem &cs, cl_int2 size, cl_channel_order channelOrder, cl_channel_type channelType, const std::string &purpose) {
+	DoubleBuffer2D db;
+	
+	db[_front] = createImage2D(cs, size, channelOrder, channelType, purpose);
+	db[_back] = createImage2D(cs, size, channelOrder, channelType, purpose);
+
+	return db;
+}
+
+DoubleBuffer3D neo::createDoubleBuffer3D(sys::ComputeSystem &cs, cl_int3 size, cl_channel_order channelOrder, cl_channel_type channelType, const std::string &purpose) {
+	DoubleBuffer3D db;
+
+	db[_front] = createImage3D(cs, size, channelOrder, channelType, purpose);
+	db[_back] = createImage3D(cs, size, channelOrder, channelType, purpose);
+
+	return db;
+}
+
+void neo::setImagePooling(bool pooling) {
+	{
+		std::lock_guard<std::mutex> lock(allocationsMutex);
+
+		imagePooling = pooling;
+	}
+
+	if (!pooling)
+		drainPool();
+}
+
+void neo::recycleImage(cl::Image2D &image) {
+	pool(image);
+
+	image = cl::Image2D();
+}
+
+void neo::recycleImage(cl::Image3D &image) {
+	pool(image);
+
+	image = cl::Image3D();
+}
+
+void neo::recycleImages(const void* model) {
+	std::lock_guard<std::mutex> lock(allocationsMutex);
+
+	if (!imagePooling || model == nullptr)
+		return;
+
+	// The pool takes its own reference, which keeps the images once the model drops its handles
+	for (int i = 0; i < allocations.size(); i++) {
+		Allocation &a = allocations[i];
+
+		if (a._isImage && a._pooled() == nullptr && std::find(a._models.begin(), a._models.end(), model) != a._models.end())
+			a._pooled = cl::Memory(a._memory, true);
+	}
+}
+
+void neo::releasePooledImages() {
+	drainPool();
+}
+
+cl::size_type neo::getMemoryInUse() {
+	std::lock_guard<std::mutex> lock(allocationsMutex);
+
+	cl::size_type bytes = 0;
+
+	for (int i = 0; i < allocations.size(); i++)
+		if (allocations[i]._pooled() == nullptr)
+			bytes += allocations[i]._bytes;
+
+	return bytes;
+}
+
+size_t neo::getNumImagesReused() {
+	std::lock_guard<std::mutex> lock(allocationsMutex);
+
+	return numImagesReused;
+}
+
+cl::size_type neo::getMemoryPooled() {
+	std::lock_guard<std::mutex> lock(allocationsMutex);
+
+	cl::size_type bytes = 0;
+
+	for (int i = 0; i < allocations.size(); i++)
+		if (allocations[i]._pooled() != nullptr)
+			bytes += allocations[i]._bytes;
+
+	return bytes;
+}
+
+void neo::memoryReport(std::ostream &os) {
+	std::lock_guard<std::mutex> lock(allocationsMutex);
+
+	struct OwnerTotal {
+		std::string _owner;
+		cl::size_type _bytes;
+		std::map<std::string, std::pair<int, cl::size_type>> _purposes;
+	};
+
+	std::map<std::string, int> ownerIndices;
+	std::vector<OwnerTotal> owners;
+
+	cl::size_type liveBytes = 0;
+	cl::size_type pooledBytes = 0;
+	int numLive = 0;
+	int numPooled = 0;
+
+	for (int i = 0; i < allocations.size(); i++) {
+		const Allocation &a = allocations[i];
+
+		if (a._pooled() != nullptr) {
+			pooledBytes += a._bytes;
+			numPooled++;
+
+			continue;
+		}
+
+		liveBytes += a._bytes;
+		numLive++;
+
+		std::map<std::string, int>::iterator it = ownerIndices.find(a._owner);
+
+		if (it == ownerIndices.end()) {
+			it = ownerIndices.insert(std::make_pair(a._owner, static_cast<int>(owners.size()))).first;
+
+			OwnerTotal total;
+
+			total._owner = a._owner;
+			total._bytes = 0;
+
+			owners.push_back(total);
+		}
+
+		OwnerTotal &total = owners[it->second];
+
+		std::pair<int, cl::size_type> &purpose = total._purposes[a._purpose.empty() ? "(unnamed)" : a._purpose];
+
+		purpose.first++;
+		purpose.second += a._bytes;
+
+		total._bytes += a._bytes;
+	}
+
+	std::sort(owners.begin(), owners.end(), [](const OwnerTotal &left, const OwnerTotal &right) {
+		return left._bytes > right._bytes;
+	});
+
+	const double mb = 1.0 / (1024.0 * 1024.0);
+
+	for (int i = 0; i < owners.size(); i++) {
+		os << owners[i]._owner << ": " << owners[i]._bytes * mb << " MB" << std::endl;
+
+		for (std::map<std::string, std::pair<int, cl::size_type>>::const_iterator it = owners[i]._purposes.begin(); it != owners[i]._purposes.end(); it++)
+			os << "\t" << it->first << ": " << it->second.second * mb << " MB in " << it->second.first << (it->second.first == 1 ? " allocation" : " allocations") << std::endl;
+	}
+
+	os << "Total: " << liveBytes * mb << " MB in " << numLive << " allocations, pooled: " << pooledBytes * mb << " MB in " << numPooled << " images" << std::endl;
+}
+
+void neo::randomUniform(cl::Image2D &image2D, sys::ComputeSystem &cs, cl::Kernel &randomUniform2DKernel, cl_int2 size, cl_float2 range, std::mt19937 &rng) {
+	int argIndex = 0;
+
+	std::uniform_int_distribution<int> seedDist(0, 999);
+
+	cl_uint2 seed = { seedDist(rng), seedDist(rng) };
+
+	randomUniform2DKernel.setArg(argIndex++, image2D);
+	randomUniform2DKernel.setArg(argIndex++, seed);
+	randomUniform2DKernel.setArg(argIndex++, range);
+
+	cs.getQueue().enqueueNDRangeKernel(randomUniform2DKernel, cl::NullRange, cl::NDRange(size.x, size.y));
+}
+
+void neo::randomUniform(cl::Image3D &image3D, sys::ComputeSystem &cs, cl::Kernel &randomUniform3DKernel, cl_int3 size, cl_float2 range, std::mt19937 &rng) {
+	int argIndex = 0;
+
+	std::uniform_int_distribution<int> seedDist(0, 999);
+
+	cl_uint2 seed = { seedDist(rng), seedDist(rng) };
+
+	randomUniform3DKernel.setArg(argIndex++, image3D);
+	randomUniform3DKernel.setArg(argIndex++, seed);
+	randomUniform3DKernel.setArg(argIndex++, range);
+
+	cs.getQueue().enqueueNDRangeKernel(randomUniform3DKernel, cl::NullRange, cl::NDRange(size.x, size.y, size.z));
+}
+
+void neo::randomUniformXY(cl::Image2D &image2D, sys::ComputeSystem &cs, cl::Kernel &randomUniform2DXYKernel, cl_int2 size, cl_float2 range, std::mt19937 &rng) {
+	int argIndex = 0;
+
+	std::uniform_int_distribution<int> seedDist(0, 999);
+
+	cl_uint2 seed = { seedDist(rng), seedDist(rng) };
+
+	randomUniform2DXYKernel.setArg(argIndex++, image2D);
+	randomUniform2DXYKernel.setArg(argIndex++, seed);
+	randomUniform2DXYKernel.setArg(argIndex++, range);
+
+	cs.getQueue().enqueueNDRangeKernel(randomUniform2DXYKernel, cl::NullRange, cl::NDRange(size.x, size.y));
+}
+
+void neo::randomUniformXYZ(cl::Image2D &image2D, sys::ComputeSystem &cs, cl::Kernel &randomUniform2DXYZKernel, cl_int2 size, cl_float2 range, std::mt19937 &rng) {
+	int argIndex = 0;
+
+	std::uniform_int_distribution<int> seedDist(0, 999);
+
+	cl_uint2 seed = { seedDist(rng), seedDist(rng) };
+
+	randomUniform2DXYZKernel.setArg(argIndex++, image2D);
+	randomUniform2DXYZKernel.setArg(argIndex++, seed);
+	randomUniform2DXYZKernel.setArg(argIndex++, range);
+
+	cs.getQueue().enqueueNDRangeKernel(randomUniform2DXYZKernel, cl::NullRange, cl::NDRange(size.x, size.y));
+}
+
+void neo::randomUniformXY(cl::Image3D &image3D, sys::ComputeSystem &cs, cl::Kernel &randomUniform3DXYKernel, cl_int3 size, cl_float2 range, std::mt19937 &rng) {
+	int argIndex = 0;
+
+	std::uniform_int_distribution<int> seedDist(0, 999);
+
+	cl_uint2 seed = { seedDist(rng), seedDist(rng) };
+
+	randomUniform3DXYKernel.setArg(argIndex++, image3D);
+	randomUniform3DXYKernel.setArg(argIndex++, seed);
+	randomUniform3DXYKernel.setArg(argIndex++, range);
+
+	cs.getQueue().enqueueNDRangeKernel(randomUniform3DXYKernel, cl::NullRange, cl::NDRange(size.x, size.y, size.z));
+}
+
+void neo::randomUniformXZ(cl::Image2D &image2D, sys::ComputeSystem &cs, cl::Kernel &randomUniform2DXZKernel, cl_int2 size, cl_float2 range, std::mt19937 &rng) {
+	int argIndex = 0;
+
+	std::uniform_int_distribution<int> seedDist(0, 999);
+
+	cl_uint2 seed = { seedDist(rng), seedDist(rng) };
+
+	randomUniform2DXZKernel.setArg(argIndex++, image2D);
+	randomUniform2DXZKernel.setArg(argIndex++, seed);
+	randomUniform2DXZKernel.setArg(argIndex++, range);
+
+	cs.getQueue().enqueueNDRangeKernel(randomUniform2DXZKernel, cl::NullRange, cl::NDRange(size.x, size.y));
+}
+
+void neo::randomUniformXZ(cl::Image3D &image3D, sys::ComputeSystem &cs, cl::Kernel &randomUniform3DXZKernel, cl_int3 size, cl_float2 range, std::mt19937 &rng) {
+	int argIndex = 0;
+
+	std::uniform_int_distribution<int> seedDist(0, 999);
+
+	cl_uint2 seed = { seedDist(rng), seedDist(rng) };
+
+	randomUniform3DXZKernel.setArg(argIndex++, image3D);
+	randomUniform3DXZKernel.setArg(argIndex++, seed);
+	randomUniform3DXZKernel.setArg(argIndex++, range);
+
+	cs.getQueue().enqueueNDRangeKernel(randomUniform3DXZKernel, cl::NullRange, cl::NDRange(size.x, size.y, size.z));
+}
+
+void neo::createActiveUnitList(ActiveUnitList &list, sys::ComputeSystem &cs, sys::ComputeProgram &program, cl_int2 hiddenSize) {
+	if (!program.requireModules(cs, { "init" })) {
+		assert(false);
+
+		return;
+	}
+
+	list._count = createBuffer(cs, CL_MEM_READ_WRITE, sizeof(cl_int), "activeUnitCount");
+	list._units = createBuffer(cs, CL_MEM_READ_WRITE, hiddenSize.x * hiddenSize.y * sizeof(cl_int2), "activeUnits");
+
+	list._compactKernel = cl::Kernel(program.getProgram(), "compactActiveUnits");
+	list._copySlicesKernel = cl::Kernel(program.getProgram(), "copyActiveSlices");
+}
+
+void neo::compactActiveUnits(ActiveUnitList &list, sys::ComputeSystem &cs, const cl::Image2D &hiddenStates, cl_int2 hiddenSize) {
+	cs.getQueue().enqueueFillBuffer<cl_int>(list._count, 0, 0, sizeof(cl_int));
+
+	int argIndex = 0;
+
+	list._compactKernel.setArg(argIndex++, hiddenStates);
+	list._compactKernel.setArg(argIndex++, list._count);
+	list._compactKernel.setArg(argIndex++, list._units);
+
+	cs.getQueue().enqueueNDRangeKernel(list._compactKernel, cl::NullRange, cl::NDRange(hiddenSize.x, hiddenSize.y));
+}
+
+void neo::copyActiveSlices(ActiveUnitList &list, sys::ComputeSystem &cs, const cl::Image3D &weightsFrom, const cl::Image3D &weightsTo, cl_int2 hiddenSize, cl_int numWeights) {
+	int argIndex = 0;
+
+	list._copySlicesKernel.setArg(argIndex++, weightsFrom);
+	list._copySlicesKernel.setArg(argIndex++, weightsTo);
+	list._copySlicesKernel.setArg(argIndex++, list._count);
+	list._copySlicesKernel.setArg(argIndex++, list._units);
+	list._copySlicesKernel.setArg(argIndex++, numWeights);
+
+	cs.getQueue().enqueueNDRangeKernel(list._copySlicesKernel, cl::NullRange, cl::NDRange(hiddenSize.x * hiddenSize.y));
+}
+
+cl::size_type neo::inhibitionTileBytes(cl_int radius) {
+	cl::size_type tileDim = inhibitionTileSize + radius * 2;
+
+	return tileDim * tileDim * sizeof(cl_float);
+}
+
+bool neo::inhibitionTileFits(sys::ComputeSystem &cs, const cl::Kernel &tiledKernel, cl_int radius) {
+	cl::size_type maxGroupSize = tiledKernel.getWorkGroupInfo<CL_KERNEL_WORK_GROUP_SIZE>(cs.getDevice());
+
+	return maxGroupSize >= inhibitionTileSize * inhibitionTileSize && inhibitionTileBytes(radius) <= cs.getDevice().getInfo<CL_DEVICE_LOCAL_MEM_SIZE>();
+}
+
+void neo::enqueueInhibitionTiled(sys::ComputeSystem &cs, cl::Kernel &tiledKernel, cl_int2 size, cl_int2 origin) {
+	// Round up to whole tiles, the kernel discards positions outside of the layer
+	cl::size_type globalX = (size.x + inhibitionTileSize - 1) / inhibitionTileSize * inhibitionTileSize;
+	cl::size_type globalY = (size.y + inhibitionTileSize - 1) / inhibitionTileSize * inhibitionTileSize;
+
+	cs.getQueue().enqueueNDRangeKernel(tiledKernel, cl::NDRange(origin.x, origin.y), cl::NDRange(globalX, globalY), cl::NDRange(inhibitionTileSize, inhibitionTileSize));
+}
+
+void StepArena::grow(size_t bytes) {
+	size_t total = 0;
+
+	for (int i = 0; i < _blocks.size(); i++)
+		total += _blocks[i].size();
+
+	// At least double, so a growing step settles after a few blocks
+	_blocks.push_back(std::vector<unsigned char>(std::max(bytes, std::max<size_t>(total, 4096))));
+
+	_used = 0;
+
+	_numBlockAllocations++;
+}
+
+void StepArena::reserve(size_t bytes) {
+	if (_blocks.size() == 1 && _blocks.front().size() >= bytes)
+		return;
+
+	_blocks.clear();
+
+	grow(bytes);
+}
+
+void StepArena::reset() {
+	// Merge overflow blocks so the next step fits in one
+	if (_blocks.size() > 1) {
+		size_t total = 0;
+
+		for (int i = 0; i < _blocks.size(); i++)
+			total += _blocks[i].size();
+
+		_blocks.clear();
+
+		grow(total);
+	}
+
+	_used = 0;
+}
+
+void StepArena::rewind(const Mark &mark) {
+	// Blocks added since the mark only hold newer allocations, they are kept for reuse until the next reset merges them
+	_used = _blocks.size() == mark._numBlocks ? mark._used : 0;
+}
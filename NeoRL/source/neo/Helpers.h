@@ -1,45 +1,271 @@
-#pragma once
-
-#include "../system/ComputeSystem.h"
-#include "../system/ComputeProgram.h"
-
-#include <random>
-#include <assert.h>
-
-namespace neo {
-	/*!
-	\brief Buffer types (can be used as indices)
-	*/
-	enum BufferType {
-		_front = 0, _back = 1
-	};
-
-	//!@{
-	/*!
-	\brief Double buffer types
-	*/
-	typedef std::array<cl::Image2D, 2> DoubleBuffer2D;
-	typedef std::array<cl::Image3D, 2> DoubleBuffer3D;
-	//!@}
-
-	//!@{
-	/*!
-	\brief Double buffer creation helpers
-	*/
-	DoubleBuffer2D createDoubleBuffer2D(sys::ComputeSystem &cs, cl_int2 size, cl_channel_order channelOrder, cl_channel_type channelType);
-	DoubleBuffer3D createDoubleBuffer3D(sys::ComputeSystem &cs, cl_int3 size, cl_channel_order channelOrder, cl_channel_type channelType);
-	//!@}
-
-	//!@{
-	/*!
-	\brief Double buffer initialization helpers
-	*/
-	void randomUniform(cl::Image2D &image2D, sys::ComputeSystem &cs, cl::Kernel &randomUniform2DKernel, cl_int2 size, cl_float2 range, std::mt19937 &rng);
-	void randomUniform(cl::Image3D &image3D, sys::ComputeSystem &cs, cl::Kernel &randomUniform3DKernel, cl_int3 size, cl_float2 range, std::mt19937 &rng);
-	void randomUniformXY(cl::Image2D &image2D, sys::ComputeSystem &cs, cl::Kernel &randomUniform2DXYKernel, cl_int2 size, cl_float2 range, std::mt19937 &rng);
-	void randomUniformXYZ(cl::Image2D &image2D, sys::ComputeSystem &cs, cl::Kernel &randomUniform2DXYZKernel, cl_int2 size, cl_float2 range, std::mt19937 &rng);
-	void randomUniformXY(cl::Image3D &image3D, sys::ComputeSystem &cs, cl::Kernel &randomUniform3DXYKernel, cl_int3 size, cl_float2 range, std::mt19937 &rng);
-	void randomUniformXZ(cl::Image2D &image2D, sys::ComputeSystem &cs, cl::Kernel &randomUniform2DXZKernel, cl_int2 size, cl_float2 range, std::mt19937 &rng);
-	void randomUniformXZ(cl::Image3D &image3D, sys::ComputeSystem &cs, cl::Kernel &randomUniform3DXZKernel, cl_int3 size, cl_float2 range, std::mt19937 &rng);
-	//!@}
+#pragma once
+
+#include "../system/ComputeSystem.h"
+#include "../system/ComputeProgram.h"
+
+#include <random>
+#include <algorithm>
+#include <iostream>
+#include <assert.h>
+
+namespace neo {
+	/*!
+	\brief Buffer types (can be used as indices)
+	*/
+	enum BufferType {
+		_front = 0, _back = 1
+	};
+
+	//!@{
+	/*!
+	\brief Double buffer types
+	*/
+	typedef std::array<cl::Image2D, 2> DoubleBuffer2D;
+	typedef std::array<cl::Image3D, 2> DoubleBuffer3D;
+	//!@}
+
+	/*!
+	\brief Owner of device allocations
+	While alive, names the owner of every allocation made by the helpers below on this thread.
+	Scopes nest, so allocations are recorded under a path such as "PredictiveHierarchy/layer 1/SparsePredictor".
+	Models also pass themselves, so recycleImages can find their images when they are released
+	*/
+	class MemoryScope {
+	public:
+		/*!
+		\brief Push a name (and optionally the model it belongs to) onto this thread's owner path
+		*/
+		MemoryScope(const std::string &name, const void* model = nullptr);
+
+		/*!
+		\brief Pop it again
+		*/
+		~MemoryScope();
+	};
+
+	//!@{
+	/*!
+	\brief Allocation helpers, purpose names the allocation within its owner (e.g. "hiddenStates")
+	Every allocation is recorded by handle until the runtime frees it, the registry itself holds no reference.
+	With pooling enabled, images are taken from the pool when one of the same context, size and format was recycled (contents are undefined, as with a new image)
+	*/
+	cl::Image2D createImage2D(sys::ComputeSystem &cs, cl_int2 size, cl_channel_order channelOrder, cl_channel_type channelType, const std::string &purpose = "");
+	cl::Image3D createImage3D(sys::ComputeSystem &cs, cl_int3 size, cl_channel_order channelOrder, cl_channel_type channelType, const std::string &purpose = "");
+	cl::Buffer createBuffer(sys::ComputeSystem &cs, cl_mem_flags flags, cl::size_type size, const std::string &purpose = "");
+	//!@}
+
+	//!@{
+	/*!
+	\brief Double buffer creation helpers
+	*/
+	DoubleBuffer2D createDoubleBuffer2D(sys::ComputeSystem &cs, cl_int2 size, cl_channel_order channelOrder, cl_channel_type channelType, const std::string &purpose = "");
+	DoubleBuffer3D createDoubleBuffer3D(sys::ComputeSystem &cs, cl_int3 size, cl_channel_order channelOrder, cl_channel_type channelType, const std::string &purpose = "");
+	//!@}
+
+	/*!
+	\brief Enable or disable image pooling (default disabled), disabling releases the pool
+	Pooled images keep their context alive, so call releasePooledImages before dropping a compute system for good
+	*/
+	void setImagePooling(bool pooling);
+
+	//!@{
+	/*!
+	\brief Hand an image that is no longer used back to the pool, and clear the handle
+	The pool only keeps the image if pooling is enabled and no other handle to it is used afterwards, otherwise this just releases it
+	*/
+	void recycleImage(cl::Image2D &image);
+	void recycleImage(cl::Image3D &image);
+	//!@}
+
+	/*!
+	\brief Hand every image allocated within a scope of model to the pool, used by the models' release
+	Only for models that drop all their handles right after, as nothing stops them from using the images otherwise
+	*/
+	void recycleImages(const void* model);
+
+	/*!
+	\brief Release all images held by the pool
+	*/
+	void releasePooledImages();
+
+	/*!
+	\brief Number of images handed out from the pool so far
+	*/
+	size_t getNumImagesReused();
+
+	//!@{
+	/*!
+	\brief Bytes of live allocations, and of recycled images held by the pool
+	*/
+	cl::size_type getMemoryInUse();
+	cl::size_type getMemoryPooled();
+	//!@}
+
+	/*!
+	\brief Print the live bytes of every owner (largest first) broken down by purpose, followed by the totals
+	*/
+	void memoryReport(std::ostream &os = std::cout);
+
+	//!@{
+	/*!
+	\brief Double buffer initialization helpers
+	*/
+	void randomUniform(cl::Image2D &image2D, sys::ComputeSystem &cs, cl::Kernel &randomUniform2DKernel, cl_int2 size, cl_float2 range, std::mt19937 &rng);
+	void randomUniform(cl::Image3D &image3D, sys::ComputeSystem &cs, cl::Kernel &randomUniform3DKernel, cl_int3 size, cl_float2 range, std::mt19937 &rng);
+	void randomUniformXY(cl::Image2D &image2D, sys::ComputeSystem &cs, cl::Kernel &randomUniform2DXYKernel, cl_int2 size, cl_float2 range, std::mt19937 &rng);
+	void randomUniformXYZ(cl::Image2D &image2D, sys::ComputeSystem &cs, cl::Kernel &randomUniform2DXYZKernel, cl_int2 size, cl_float2 range, std::mt19937 &rng);
+	void randomUniformXY(cl::Image3D &image3D, sys::ComputeSystem &cs, cl::Kernel &randomUniform3DXYKernel, cl_int3 size, cl_float2 range, std::mt19937 &rng);
+	void randomUniformXZ(cl::Image2D &image2D, sys::ComputeSystem &cs, cl::Kernel &randomUniform2DXZKernel, cl_int2 size, cl_float2 range, std::mt19937 &rng);
+	void randomUniformXZ(cl::Image3D &image3D, sys::ComputeSystem &cs, cl::Kernel &randomUniform3DXZKernel, cl_int3 size, cl_float2 range, std::mt19937 &rng);
+	//!@}
+
+	/*!
+	\brief List of hidden units with a nonzero state, compacted on the device
+	Learning kernels launched over this list skip units whose update would be zero
+	*/
+	struct ActiveUnitList {
+		//!@{
+		/*!
+		\brief Number of listed units and their positions (int2)
+		*/
+		cl::Buffer _count;
+		cl::Buffer _units;
+		//!@}
+
+		//!@{
+		/*!
+		\brief Kernels
+		*/
+		cl::Kernel _compactKernel;
+		cl::Kernel _copySlicesKernel;
+		//!@}
+	};
+
+	//!@{
+	/*!
+	\brief Active unit list helpers
+	copyActiveSlices copies the weight slices of listed units only, used in place of a double buffer swap after a gated update
+	*/
+	void createActiveUnitList(ActiveUnitList &list, sys::ComputeSystem &cs, sys::ComputeProgram &program, cl_int2 hiddenSize);
+	void compactActiveUnits(ActiveUnitList &list, sys::ComputeSystem &cs, const cl::Image2D &hiddenStates, cl_int2 hiddenSize);
+	void copyActiveSlices(ActiveUnitList &list, sys::ComputeSystem &cs, const cl::Image3D &weightsFrom, const cl::Image3D &weightsTo, cl_int2 hiddenSize, cl_int numWeights);
+	//!@}
+
+	/*!
+	\brief Work group edge length of the tiled local inhibition (k-WTA) kernels
+	*/
+	const cl_int inhibitionTileSize = 8;
+
+	//!@{
+	/*!
+	\brief Tiled local inhibition helpers
+	Each work group holds its tile plus a halo of the inhibition radius in local memory.
+	enqueueInhibitionTiled covers the region of the given size starting at origin
+	*/
+	cl::size_type inhibitionTileBytes(cl_int radius);
+	bool inhibitionTileFits(sys::ComputeSystem &cs, const cl::Kernel &tiledKernel, cl_int radius);
+	void enqueueInhibitionTiled(sys::ComputeSystem &cs, cl::Kernel &tiledKernel, cl_int2 size, cl_int2 origin = { 0, 0 });
+	//!@}
+
+	/*!
+	\brief Step arena
+	Bump allocator for host temporaries that only live for one step, all reclaimed at once by reset.
+	When a step needs more than the block holds, overflow blocks are added, and the next reset merges them into one block of the new peak size.
+	Once the peak is reached, stepping no longer touches the heap
+	*/
+	class StepArena {
+	private:
+		/*!
+		\brief Blocks, allocations come from the last one
+		*/
+		std::vector<std::vector<unsigned char>> _blocks;
+
+		/*!
+		\brief Bytes used of the last block
+		*/
+		size_t _used;
+
+		/*!
+		\brief Blocks allocated so far
+		*/
+		size_t _numBlockAllocations;
+
+		/*!
+		\brief Add a block that holds at least bytes
+		*/
+		void grow(size_t bytes);
+
+	public:
+		/*!
+		\brief Position to rewind to, see getMark
+		*/
+		struct Mark {
+			size_t _numBlocks;
+			size_t _used;
+		};
+
+		/*!
+		\brief Initialize defaults
+		*/
+		StepArena()
+			: _used(0), _numBlockAllocations(0)
+		{}
+
+		/*!
+		\brief Make sure a step of up to bytes fits in one block
+		*/
+		void reserve(size_t bytes);
+
+		/*!
+		\brief Reclaim everything, call at the start of a step
+		*/
+		void reset();
+
+		//!@{
+		/*!
+		\brief Reclaim only what was allocated since getMark, for loops within a step whose temporaries die every iteration
+		*/
+		Mark getMark() const {
+			return Mark{ _blocks.size(), _used };
+		}
+
+		void rewind(const Mark &mark);
+		//!@}
+
+		//!@{
+		/*!
+		\brief Allocate count elements, valid until the next reset. Only for trivial types, no constructors or destructors are run
+		*/
+		template<class T>
+		T* allocate(size_t count) {
+			size_t offset = (_used + alignof(T) - 1) / alignof(T) * alignof(T);
+
+			if (_blocks.empty() || offset + count * sizeof(T) > _blocks.back().size()) {
+				grow(count * sizeof(T));
+
+				offset = 0;
+			}
+
+			_used = offset + count * sizeof(T);
+
+			return reinterpret_cast<T*>(_blocks.back().data() + offset);
+		}
+
+		template<class T>
+		T* allocate(size_t count, const T &value) {
+			T* elements = allocate<T>(count);
+
+			std::fill(elements, elements + count, value);
+
+			return elements;
+		}
+		//!@}
+
+		/*!
+		\brief Number of blocks allocated so far, stops changing once stepping has settled
+		*/
+		size_t getNumBlockAllocations() const {
+			return _numBlockAllocations;
+		}
+	};
 }
\ No newline at end of file
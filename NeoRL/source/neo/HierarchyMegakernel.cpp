@@ -0,0 +1,205 @@
+#include "HierarchyMegakernel.h"
+
+#include "PredictiveHierarchy.h"
+
+#include <algorithm>
+
+using namespace neo;
+
+bool HierarchyMegakernel::create(sys::ComputeSystem &cs, sys::ComputeProgram &program, const PredictiveHierarchy &ph, cl_int numGroups) {
+	if (!program.requireModules(cs, { "predictor" })) {
+		assert(false);
+
+		return false;
+	}
+
+	// Groups spin on each other in phGlobalBarrier, which only returns if they are all running at once.
+	// CPU runtimes give that with one thread per compute unit, beyond that (or on other devices) groups may wait for each other forever
+	if (numGroups < 1)
+		return false;
+
+	if (numGroups > 1) {
+		if (!(cs.getDevice().getInfo<CL_DEVICE_TYPE>() & CL_DEVICE_TYPE_CPU))
+			return false;
+
+		if (static_cast<cl_uint>(numGroups) > cs.getDevice().getInfo<CL_DEVICE_MAX_COMPUTE_UNITS>())
+			return false;
+	}
+
+	MemoryScope scope("HierarchyMegakernel");
+
+	_numLayers = static_cast<cl_int>(ph.getNumLayers());
+
+	assert(_numLayers <= _maxLayers);
+
+	_layerInts.assign(_numLayers * _intsPerLayer, 0);
+	_layerFloats.assign(_numLayers * _floatsPerLayer, 0.0f);
+
+	cl::size_type weightsSize = 0;
+	cl::size_type statesSize = 0;
+
+	for (int l = 0; l < _numLayers; l++) {
+		const SparsePredictor &sp = ph.getLayer(l)._sp;
+		const SparsePredictor::VisibleLayer &vl = sp.getVisibleLayer(0);
+		const SparsePredictor::VisibleLayerDesc &vld = sp.getVisibleLayerDesc(0);
+
+		cl_int2 hiddenSize = sp.getHiddenSize();
+		cl_int2 feedBackSize = l < _numLayers - 1 ? ph.getLayerDescs(l)._size : cl_int2{ 1, 1 };
+
+		cl_int numHidden = hiddenSize.x * hiddenSize.y;
+		cl_int numVisible = vld._size.x * vld._size.y;
+
+		cl_int encodeDiam = vld._encodeRadius * 2 + 1;
+		cl_int predDiam = vld._predDecodeRadius * 2 + 1;
+		cl_int feedBackDiam = vld._feedBackDecodeRadius * 2 + 1;
+
+		cl_int* li = &_layerInts[l * _intsPerLayer];
+		cl_float* lf = &_layerFloats[l * _floatsPerLayer];
+
+		li[0] = hiddenSize.x;
+		li[1] = hiddenSize.y;
+		li[2] = vld._size.x;
+		li[3] = vld._size.y;
+		li[4] = feedBackSize.x;
+		li[5] = feedBackSize.y;
+		li[6] = vld._useForInput ? vld._encodeRadius : -1;
+		li[7] = ph.getLayerDescs(l)._lateralRadius;
+		li[8] = vld._predDecodeRadius;
+		li[9] = vld._feedBackDecodeRadius;
+		li[10] = vld._predictThresholded;
+		li[11] = vld._ignoreMiddle;
+
+		// Weight images are RG, so every weight takes two floats
+		li[12] = static_cast<cl_int>(weightsSize);
+		weightsSize += vld._useForInput ? 2 * numHidden * encodeDiam * encodeDiam : 0;
+
+		li[13] = static_cast<cl_int>(weightsSize);
+		weightsSize += 2 * numVisible * predDiam * predDiam;
+
+		li[14] = static_cast<cl_int>(weightsSize);
+		weightsSize += 2 * numVisible * feedBackDiam * feedBackDiam;
+
+		li[15] = static_cast<cl_int>(weightsSize);
+		weightsSize += numHidden;
+
+		li[16] = static_cast<cl_int>(statesSize);
+		statesSize += numHidden;
+
+		li[17] = static_cast<cl_int>(statesSize);
+		statesSize += numHidden;
+
+		li[18] = static_cast<cl_int>(statesSize);
+		statesSize += numVisible;
+
+		lf[0] = vl._hiddenToVisible.x;
+		lf[1] = vl._hiddenToVisible.y;
+		lf[2] = vl._visibleToHidden.x;
+		lf[3] = vl._visibleToHidden.y;
+		lf[4] = vl._visibleToFeedBack.x;
+		lf[5] = vl._visibleToFeedBack.y;
+		lf[6] = ph.getLayerDescs(l)._spActiveRatio;
+	}
+
+	_weights = createBuffer(cs, CL_MEM_READ_WRITE, weightsSize * sizeof(cl_float), "weights");
+	_states = createBuffer(cs, CL_MEM_READ_WRITE, statesSize * sizeof(cl_float), "states");
+
+	_layerIntsBuffer = createBuffer(cs, CL_MEM_READ_ONLY, _layerInts.size() * sizeof(cl_int), "layerIntsBuffer");
+	_layerFloatsBuffer = createBuffer(cs, CL_MEM_READ_ONLY, _layerFloats.size() * sizeof(cl_float), "layerFloatsBuffer");
+
+	cs.getQueue().enqueueWriteBuffer(_layerIntsBuffer, CL_TRUE, 0, _layerInts.size() * sizeof(cl_int), _layerInts.data());
+	cs.getQueue().enqueueWriteBuffer(_layerFloatsBuffer, CL_TRUE, 0, _layerFloats.size() * sizeof(cl_float), _layerFloats.data());
+
+	_barrierCounter = createBuffer(cs, CL_MEM_READ_WRITE, sizeof(cl_int), "barrierCounter");
+
+	_megakernel = cl::Kernel(program.getProgram(), "phInferenceMegakernel");
+
+	_groupSize = std::min<cl::size_type>(_megakernel.getWorkGroupInfo<CL_KERNEL_WORK_GROUP_SIZE>(cs.getDevice()), 256);
+	_numGroups = numGroups;
+
+	return true;
+}
+
+void HierarchyMegakernel::uploadWeights(sys::ComputeSystem &cs, const PredictiveHierarchy &ph) {
+	cl::array<cl::size_type, 3> zeroOrigin = { 0, 0, 0 };
+
+	for (int l = 0; l < _numLayers; l++) {
+		const SparsePredictor &sp = ph.getLayer(l)._sp;
+		const SparsePredictor::VisibleLayer &vl = sp.getVisibleLayer(0);
+		const SparsePredictor::VisibleLayerDesc &vld = sp.getVisibleLayerDesc(0);
+
+		const cl_int* li = &_layerInts[l * _intsPerLayer];
+
+		cl_int encodeDiam = vld._encodeRadius * 2 + 1;
+		cl_int predDiam = vld._predDecodeRadius * 2 + 1;
+		cl_int feedBackDiam = vld._feedBackDecodeRadius * 2 + 1;
+
+		if (li[6] >= 0)
+			cs.getQueue().enqueueCopyImageToBuffer(vl._encoderWeights[_back], _weights, zeroOrigin,
+				{ static_cast<cl::size_type>(li[0]), static_cast<cl::size_type>(li[1]), static_cast<cl::size_type>(encodeDiam * encodeDiam) }, li[12] * sizeof(cl_float));
+
+		cs.getQueue().enqueueCopyImageToBuffer(vl._predDecoderWeights[_back], _weights, zeroOrigin,
+			{ static_cast<cl::size_type>(li[2]), static_cast<cl::size_type>(li[3]), static_cast<cl::size_type>(predDiam * predDiam) }, li[13] * sizeof(cl_float));
+
+		cs.getQueue().enqueueCopyImageToBuffer(vl._feedBackDecoderWeights[_back], _weights, zeroOrigin,
+			{ static_cast<cl::size_type>(li[2]), static_cast<cl::size_type>(li[3]), static_cast<cl::size_type>(feedBackDiam * feedBackDiam) }, li[14] * sizeof(cl_float));
+
+		cs.getQueue().enqueueCopyImageToBuffer(sp.getHiddenBiases()[_back], _weights, zeroOrigin,
+			{ static_cast<cl::size_type>(li[0]), static_cast<cl::size_type>(li[1]), 1 }, li[15] * sizeof(cl_float));
+	}
+}
+
+void HierarchyMegakernel::uploadStates(sys::ComputeSystem &cs, const PredictiveHierarchy &ph) {
+	cl::array<cl::size_type, 3> zeroOrigin = { 0, 0, 0 };
+
+	for (int l = 0; l < _numLayers; l++) {
+		const SparsePredictor &sp = ph.getLayer(l)._sp;
+
+		const cl_int* li = &_layerInts[l * _intsPerLayer];
+
+		cs.getQueue().enqueueCopyImageToBuffer(sp.getHiddenStates()[_back], _states, zeroOrigin,
+			{ static_cast<cl::size_type>(li[0]), static_cast<cl::size_type>(li[1]), 1 }, li[16] * sizeof(cl_float));
+
+		cs.getQueue().enqueueCopyImageToBuffer(sp.getVisibleLayer(0)._predictions[_back], _states, zeroOrigin,
+			{ static_cast<cl::size_type>(li[2]), static_cast<cl::size_type>(li[3]), 1 }, li[18] * sizeof(cl_float));
+	}
+}
+
+void HierarchyMegakernel::downloadStates(sys::ComputeSystem &cs, const PredictiveHierarchy &ph, bool all) {
+	cl::array<cl::size_type, 3> zeroOrigin = { 0, 0, 0 };
+
+	for (int l = 0; l < (all ? _numLayers : 1); l++) {
+		const SparsePredictor &sp = ph.getLayer(l)._sp;
+
+		const cl_int* li = &_layerInts[l * _intsPerLayer];
+
+		if (all)
+			cs.getQueue().enqueueCopyBufferToImage(_states, sp.getHiddenStates()[_back], li[16] * sizeof(cl_float), zeroOrigin,
+				{ static_cast<cl::size_type>(li[0]), static_cast<cl::size_type>(li[1]), 1 });
+
+		cs.getQueue().enqueueCopyBufferToImage(_states, sp.getVisibleLayer(0)._predictions[_back], li[18] * sizeof(cl_float), zeroOrigin,
+			{ static_cast<cl::size_type>(li[2]), static_cast<cl::size_type>(li[3]), 1 });
+	}
+}
+
+void HierarchyMegakernel::run(sys::ComputeSystem &cs, const cl::Image2D &input, cl_uint tickingMask) {
+	cs.getQueue().enqueueFillBuffer<cl_int>(_barrierCounter, 0, 0, sizeof(cl_int));
+
+	int argIndex = 0;
+
+	_megakernel.setArg(argIndex++, input);
+	_megakernel.setArg(argIndex++, _weights);
+	_megakernel.setArg(argIndex++, _states);
+	_megakernel.setArg(argIndex++, _layerIntsBuffer);
+	_megakernel.setArg(argIndex++, _layerFloatsBuffer);
+	_megakernel.setArg(argIndex++, _barrierCounter);
+	_megakernel.setArg(argIndex++, _numLayers);
+	_megakernel.setArg(argIndex++, tickingMask);
+
+	cs.getQueue().enqueueNDRangeKernel(_megakernel, cl::NullRange, cl::NDRange(_groupSize * _numGroups), cl::NDRange(_groupSize));
+}
+
+void HierarchyMegakernel::readPrediction(sys::ComputeSystem &cs, std::vector<cl_float> &prediction) {
+	prediction.resize(_layerInts[2] * _layerInts[3]);
+
+	cs.getQueue().enqueueReadBuffer(_states, CL_TRUE, _layerInts[18] * sizeof(cl_float), prediction.size() * sizeof(cl_float), prediction.data());
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include "Helpers.h"
+
+namespace neo {
+	class PredictiveHierarchy;
+
+	/*!
+	\brief Hierarchy megakernel
+	Runs the feed forward and feed back passes of every layer of a predictive hierarchy (no learning) in a single dispatch.
+	Weights and states are mirrored into flat buffers, layers are separated by global barriers.
+	With more than one work group the barrier spins until every group arrives. OpenCL 1.2 does not guarantee that groups of a dispatch
+	make progress alongside each other, so if the device does not keep all of them running at once the dispatch hangs
+	*/
+	class HierarchyMegakernel {
+	private:
+		//!@{
+		/*!
+		\brief Flat copies of the weights and biases, and of the hidden states, activation sums and predictions of all layers
+		*/
+		cl::Buffer _weights;
+		cl::Buffer _states;
+		//!@}
+
+		//!@{
+		/*!
+		\brief Per layer sizes, radii and buffer offsets (in floats), see phInferenceMegakernel for the layout
+		*/
+		static const int _intsPerLayer = 20;
+		static const int _floatsPerLayer = 8;
+
+		std::vector<cl_int> _layerInts;
+		std::vector<cl_float> _layerFloats;
+		cl::Buffer _layerIntsBuffer;
+		cl::Buffer _layerFloatsBuffer;
+		//!@}
+
+		/*!
+		\brief Arrival counter of the global barrier
+		*/
+		cl::Buffer _barrierCounter;
+
+		/*!
+		\brief Number of layers
+		*/
+		cl_int _numLayers;
+
+		//!@{
+		/*!
+		\brief Dispatch shape
+		*/
+		cl::size_type _groupSize;
+		cl::size_type _numGroups;
+		//!@}
+
+		/*!
+		\brief Kernels
+		*/
+		cl::Kernel _megakernel;
+
+	public:
+		/*!
+		\brief Maximum number of layers (one bit each in the ticking mask)
+		*/
+		static const int _maxLayers = 32;
+
+		/*!
+		\brief Create for a hierarchy, which must stay the same shape afterwards
+		Requires the compute system and program with the NeoRL kernels (predictor module).
+		Runs numGroups work groups. Several groups are only accepted on CPU devices, where every group runs on its own thread,
+		and never more than the device's compute units, so all of them can be resident. Returns false (creating nothing) otherwise
+		*/
+		bool create(sys::ComputeSystem &cs, sys::ComputeProgram &program, const PredictiveHierarchy &ph, cl_int numGroups = 1);
+
+		//!@{
+		/*!
+		\brief Copy the weights or the states (hidden states and predictions, the _back buffers) of the hierarchy into the flat buffers
+		*/
+		void uploadWeights(sys::ComputeSystem &cs, const PredictiveHierarchy &ph);
+		void uploadStates(sys::ComputeSystem &cs, const PredictiveHierarchy &ph);
+		//!@}
+
+		/*!
+		\brief Copy the states back into the _back buffers of the hierarchy, or only the prediction of the first layer
+		*/
+		void downloadStates(sys::ComputeSystem &cs, const PredictiveHierarchy &ph, bool all);
+
+		/*!
+		\brief Run one step without learning
+		tickingMask has a bit set for every layer that runs this step. The input is read as given, whiten it first if needed
+		*/
+		void run(sys::ComputeSystem &cs, const cl::Image2D &input, cl_uint tickingMask);
+
+		/*!
+		\brief Read the prediction of the first layer from the flat buffer (blocking)
+		*/
+		void readPrediction(sys::ComputeSystem &cs, std::vector<cl_float> &prediction);
+
+		/*!
+		\brief Number of work groups of a dispatch
+		*/
+		cl::size_type getNumGroups() const {
+			return _numGroups;
+		}
+	};
+}
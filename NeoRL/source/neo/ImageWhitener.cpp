@@ -1,23 +1,138 @@
-#include "ImageWhitener.h"
-
-using namespace neo;
-
-void ImageWhitener::create(sys::ComputeSystem &cs, sys::ComputeProgram &program, cl_int2 imageSize, cl_int imageFormat, cl_int imageType) {
-	_imageSize = imageSize;
-
-	_result = cl::Image2D(cs.getContext(), CL_MEM_READ_WRITE, cl::ImageFormat(imageFormat, imageType), imageSize.x, imageSize.y);
-
-	_whitenKernel = cl::Kernel(program.getProgram(), "whiten");
-}
-
-void ImageWhitener::filter(sys::ComputeSystem &cs, const cl::Image2D &input, cl_int kernelRadius, cl_float intensity) {
-	int argIndex = 0;
-
-	_whitenKernel.setArg(argIndex++, input);
-	_whitenKernel.setArg(argIndex++, _result);
-	_whitenKernel.setArg(argIndex++, _imageSize);
-	_whitenKernel.setArg(argIndex++, kernelRadius);
-	_whitenKernel.setArg(argIndex++, intensity);
-
-	cs.getQueue().enqueueNDRangeKernel(_whitenKernel, cl::NullRange, cl::NDRange(_imageSize.x, _imageSize.y));
-}
\ No newline at end of file
+#include "ImageWhitener.h"
+
+using namespace neo;
+
+// Radius from which the _auto mode uses window sums. Below it the direct window is about as cheap as the extra passes
+const cl_int summedMinRadius = 3;
+
+void ImageWhitener::create(sys::ComputeSystem &cs, sys::ComputeProgram &program, cl_int2 imageSize, cl_int imageFormat, cl_int imageType) {
+	if (!program.requireModules(cs, { "whitening" })) {
+		assert(false);
+
+		return;
+	}
+
+	MemoryScope scope("ImageWhitener");
+
+	_imageSize = imageSize;
+
+	_result = createImage2D(cs, imageSize, imageFormat, imageType, "result");
+
+	_rowSums = createImage2D(cs, imageSize, CL_RGBA, CL_FLOAT, "rowSums");
+	_windowSums = createImage2D(cs, imageSize, CL_RGBA, CL_FLOAT, "windowSums");
+
+	_difference = createBuffer(cs, CL_MEM_READ_WRITE, sizeof(cl_int), "difference");
+
+	_whitenKernel = cl::Kernel(program.getProgram(), "whiten");
+	_whitenChangedKernel = cl::Kernel(program.getProgram(), "whitenChanged");
+	_rowSumsKernel = cl::Kernel(program.getProgram(), "whitenRowSums");
+	_columnSumsKernel = cl::Kernel(program.getProgram(), "whitenColumnSums");
+	_fromSumsKernel = cl::Kernel(program.getProgram(), "whitenFromSums");
+	_differenceKernel = cl::Kernel(program.getProgram(), "whitenDifference");
+}
+
+void ImageWhitener::filter(sys::ComputeSystem &cs, const cl::Image2D &input, cl_int kernelRadius, cl_float intensity) {
+	bool summed = _mode == _summed || (_mode == _auto && kernelRadius >= summedMinRadius);
+
+	filter(cs, input, _result, kernelRadius, intensity, summed);
+}
+
+void ImageWhitener::filter(sys::ComputeSystem &cs, const cl::Image2D &input, const cl::Image2D &result, cl_int kernelRadius, cl_float intensity, bool summed) {
+	if (!summed) {
+		int argIndex = 0;
+
+		_whitenKernel.setArg(argIndex++, input);
+		_whitenKernel.setArg(argIndex++, result);
+		_whitenKernel.setArg(argIndex++, _imageSize);
+		_whitenKernel.setArg(argIndex++, kernelRadius);
+		_whitenKernel.setArg(argIndex++, intensity);
+
+		cs.getQueue().enqueueNDRangeKernel(_whitenKernel, cl::NullRange, cl::NDRange(_imageSize.x, _imageSize.y));
+
+		return;
+	}
+
+	{
+		int argIndex = 0;
+
+		_rowSumsKernel.setArg(argIndex++, input);
+		_rowSumsKernel.setArg(argIndex++, _rowSums);
+		_rowSumsKernel.setArg(argIndex++, _imageSize);
+		_rowSumsKernel.setArg(argIndex++, kernelRadius);
+
+		cs.getQueue().enqueueNDRangeKernel(_rowSumsKernel, cl::NullRange, cl::NDRange(_imageSize.y));
+	}
+
+	{
+		int argIndex = 0;
+
+		_columnSumsKernel.setArg(argIndex++, _rowSums);
+		_columnSumsKernel.setArg(argIndex++, _windowSums);
+		_columnSumsKernel.setArg(argIndex++, _imageSize);
+		_columnSumsKernel.setArg(argIndex++, kernelRadius);
+
+		cs.getQueue().enqueueNDRangeKernel(_columnSumsKernel, cl::NullRange, cl::NDRange(_imageSize.x));
+	}
+
+	{
+		int argIndex = 0;
+
+		_fromSumsKernel.setArg(argIndex++, input);
+		_fromSumsKernel.setArg(argIndex++, _windowSums);
+		_fromSumsKernel.setArg(argIndex++, result);
+		_fromSumsKernel.setArg(argIndex++, _imageSize);
+		_fromSumsKernel.setArg(argIndex++, kernelRadius);
+		_fromSumsKernel.setArg(argIndex++, intensity);
+
+		cs.getQueue().enqueueNDRangeKernel(_fromSumsKernel, cl::NullRange, cl::NDRange(_imageSize.x, _imageSize.y));
+	}
+}
+
+void ImageWhitener::filterChanged(sys::ComputeSystem &cs, const cl::Image2D &input, const TileChangeDetector &changes, cl_int kernelRadius, cl_float intensity) {
+	int argIndex = 0;
+
+	_whitenChangedKernel.setArg(argIndex++, input);
+	_whitenChangedKernel.setArg(argIndex++, _result);
+	_whitenChangedKernel.setArg(argIndex++, _imageSize);
+	_whitenChangedKernel.setArg(argIndex++, kernelRadius);
+	_whitenChangedKernel.setArg(argIndex++, intensity);
+
+	changes.setChangeArgs(_whitenChangedKernel, argIndex);
+
+	cs.getQueue().enqueueNDRangeKernel(_whitenChangedKernel, cl::NullRange, cl::NDRange(_imageSize.x, _imageSize.y));
+}
+
+float ImageWhitener::compareModes(sys::ComputeSystem &cs, const cl::Image2D &input, cl_int kernelRadius, cl_float intensity) {
+	cl::Image2D reference = createImage2D(cs, _imageSize, CL_RGBA, CL_FLOAT, "reference");
+	cl::Image2D summed = createImage2D(cs, _imageSize, CL_RGBA, CL_FLOAT, "summed");
+
+	filter(cs, input, reference, kernelRadius, intensity, false);
+	filter(cs, input, summed, kernelRadius, intensity, true);
+
+	cs.getQueue().enqueueFillBuffer<cl_int>(_difference, 0, 0, sizeof(cl_int));
+
+	int argIndex = 0;
+
+	_differenceKernel.setArg(argIndex++, reference);
+	_differenceKernel.setArg(argIndex++, summed);
+	_differenceKernel.setArg(argIndex++, _difference);
+
+	cs.getQueue().enqueueNDRangeKernel(_differenceKernel, cl::NullRange, cl::NDRange(_imageSize.x, _imageSize.y));
+
+	cl_float difference = 0.0f;
+
+	cs.getQueue().enqueueReadBuffer(_difference, CL_TRUE, 0, sizeof(cl_float), &difference);
+
+	return difference;
+}
+
+bool ImageWhitener::setMode(sys::ComputeSystem &cs, Mode mode, const cl::Image2D &validationInput, cl_int kernelRadius, cl_float intensity, cl_float tolerance) {
+	_mode = _direct;
+
+	if (mode != _direct && compareModes(cs, validationInput, kernelRadius, intensity) > tolerance)
+		return false;
+
+	_mode = mode;
+
+	return true;
+}
@@ -1,47 +1,123 @@
-#pragma once
-
-#include "../system/ComputeSystem.h"
-#include "../system/ComputeProgram.h"
-
-namespace neo {
-	/*!
-	\brief Image whitener
-	Applies local whitening transformation to input
-	*/
-	class ImageWhitener {
-	private:
-		/*!
-		\brief Kernels
-		*/
-		cl::Kernel _whitenKernel;
-
-		/*!
-		\brief Resulting whitened image
-		*/
-		cl::Image2D _result;
-
-		/*!
-		\brief Size of the whitened image
-		*/
-		cl_int2 _imageSize;
-
-	public:
-		/*!
-		\brief Create the image whitener
-		Requires the image size and format.
-		*/
-		void create(sys::ComputeSystem &cs, sys::ComputeProgram &program, cl_int2 imageSize, cl_int imageFormat, cl_int imageType);
-
-		/*!
-		\brief Filter (whiten) an image with a kernel radius
-		*/
-		void filter(sys::ComputeSystem &cs, const cl::Image2D &input, cl_int kernelRadius, cl_float intensity = 1024.0f);
-
-		/*!
-		\brief Return filtered image result
-		*/
-		const cl::Image2D &getResult() const {
-			return _result;
-		}
-	};
+#pragma once
+
+#include "../system/ComputeSystem.h"
+#include "../system/ComputeProgram.h"
+
+#include "TileChangeDetector.h"
+
+namespace neo {
+	/*!
+	\brief Image whitener
+	Applies local whitening transformation to input
+	*/
+	class ImageWhitener {
+	public:
+		/*!
+		\brief How local statistics are gathered
+		_direct loops over the whole window per pixel (O(r^2)) and is the default, _summed uses sliding window row and column sums (O(1) per pixel),
+		_auto picks _summed for larger radii. The sum passes run one work item per row or column and round differently, so they are opt-in
+		and setMode validates them against _direct first
+		*/
+		enum Mode {
+			_direct, _summed, _auto
+		};
+
+	private:
+		//!@{
+		/*!
+		\brief Kernels
+		*/
+		cl::Kernel _whitenKernel;
+		cl::Kernel _whitenChangedKernel;
+		cl::Kernel _rowSumsKernel;
+		cl::Kernel _columnSumsKernel;
+		cl::Kernel _fromSumsKernel;
+		cl::Kernel _differenceKernel;
+		//!@}
+
+		//!@{
+		/*!
+		\brief Window sums for the _summed mode
+		*/
+		cl::Image2D _rowSums;
+		cl::Image2D _windowSums;
+		//!@}
+
+		/*!
+		\brief Buffer for the largest difference found by compareModes
+		*/
+		cl::Buffer _difference;
+
+		/*!
+		\brief Resulting whitened image
+		*/
+		cl::Image2D _result;
+
+		/*!
+		\brief Size of the whitened image
+		*/
+		cl_int2 _imageSize;
+
+		/*!
+		\brief Statistics mode
+		*/
+		Mode _mode;
+
+		/*!
+		\brief Whiten using one of the two (resolved) modes
+		*/
+		void filter(sys::ComputeSystem &cs, const cl::Image2D &input, const cl::Image2D &result, cl_int kernelRadius, cl_float intensity, bool summed);
+
+	public:
+		/*!
+		\brief Initialize defaults
+		*/
+		ImageWhitener()
+			: _mode(_direct)
+		{}
+
+		/*!
+		\brief Create the image whitener
+		Requires the image size and format.
+		*/
+		void create(sys::ComputeSystem &cs, sys::ComputeProgram &program, cl_int2 imageSize, cl_int imageFormat, cl_int imageType);
+
+		/*!
+		\brief Filter (whiten) an image with a kernel radius
+		*/
+		void filter(sys::ComputeSystem &cs, const cl::Image2D &input, cl_int kernelRadius, cl_float intensity = 1024.0f);
+
+		/*!
+		\brief Filter (whiten) only the pixels near tiles that changed since the last detection
+		The rest of the result keeps its previous value. The detector must have run on the same input
+		*/
+		void filterChanged(sys::ComputeSystem &cs, const cl::Image2D &input, const TileChangeDetector &changes, cl_int kernelRadius, cl_float intensity = 1024.0f);
+
+		/*!
+		\brief Whiten with both modes and return the largest absolute difference (blocking, for validation)
+		The two only differ by rounding, except where a centered color is close enough to 0 for its sign to flip
+		*/
+		float compareModes(sys::ComputeSystem &cs, const cl::Image2D &input, cl_int kernelRadius, cl_float intensity = 1024.0f);
+
+		/*!
+		\brief Set the statistics mode
+		_summed and _auto are validated by whitening validationInput with both modes (see compareModes).
+		Returns false and keeps _direct if they differ by more than tolerance
+		*/
+		bool setMode(sys::ComputeSystem &cs, Mode mode, const cl::Image2D &validationInput, cl_int kernelRadius, cl_float intensity = 1024.0f, cl_float tolerance = 0.001f);
+
+		/*!
+		\brief Get the statistics mode
+		*/
+		Mode getMode() const {
+			return _mode;
+		}
+
+		/*!
+		\brief Return filtered image result
+		*/
+		const cl::Image2D &getResult() const {
+			return _result;
+		}
+	};
 }
\ No newline at end of file
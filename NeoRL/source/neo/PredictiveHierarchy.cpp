@@ -1,141 +1,508 @@
-#include "PredictiveHierarchy.h"
-
-using namespace neo;
-
-void PredictiveHierarchy::createRandom(sys::ComputeSystem &cs, sys::ComputeProgram &program,
-	cl_int2 inputSize, const std::vector<LayerDesc> &layerDescs,
-	cl_float2 initWeightRange,
-	std::mt19937 &rng)
-{
-	_inputSize = inputSize;
-
-	_layerDescs = layerDescs;
-	_layers.resize(_layerDescs.size());
-
-	cl_int2 prevLayerSize = inputSize;
-
-	for (int l = 0; l < _layers.size(); l++) {
-		std::vector<SparsePredictor::VisibleLayerDesc> spDescs;
-
-		if (l == 0) {
-			spDescs.resize(2);
-
-			spDescs[0]._size = prevLayerSize;
-			spDescs[0]._encodeRadius = _layerDescs[l]._feedForwardRadius;
-			spDescs[0]._predDecodeRadius = _layerDescs[l]._predictiveRadius;
-			spDescs[0]._feedBackDecodeRadius = _layerDescs[l]._feedBackRadius;
-			spDescs[0]._predictThresholded = false;
-			spDescs[0]._predict = true;
-			spDescs[0]._ignoreMiddle = false;
-			spDescs[0]._useForInput = true;
-
-			spDescs[1]._size = _layerDescs[l]._size;
-			spDescs[1]._encodeRadius = _layerDescs[l]._recurrentRadius;
-			spDescs[1]._predDecodeRadius = _layerDescs[l]._predictiveRadius;
-			spDescs[1]._feedBackDecodeRadius = _layerDescs[l]._feedBackRadius;
-			spDescs[1]._predictThresholded = true;
-			spDescs[1]._predict = false;
-			spDescs[1]._ignoreMiddle = true;
-			spDescs[1]._useForInput = false;
-		}
-		else {
-			spDescs.resize(2);
-
-			spDescs[0]._size = prevLayerSize;
-			spDescs[0]._encodeRadius = _layerDescs[l]._feedForwardRadius;
-			spDescs[0]._predDecodeRadius = _layerDescs[l]._predictiveRadius;
-			spDescs[0]._feedBackDecodeRadius = _layerDescs[l]._feedBackRadius;
-			spDescs[0]._predictThresholded = true;
-			spDescs[0]._predict = true;
-			spDescs[0]._ignoreMiddle = false;
-			spDescs[0]._useForInput = false;
-
-			spDescs[1]._size = _layerDescs[l]._size;
-			spDescs[1]._encodeRadius = _layerDescs[l]._recurrentRadius;
-			spDescs[1]._predDecodeRadius = _layerDescs[l]._predictiveRadius;
-			spDescs[1]._feedBackDecodeRadius = _layerDescs[l]._feedBackRadius;
-			spDescs[1]._predictThresholded = true;
-			spDescs[1]._predict = false;
-			spDescs[1]._ignoreMiddle = true;
-			spDescs[1]._useForInput = false;
-		}
-
-		std::vector<cl_int2> feedBackSizes(2);
-
-		if (l < _layers.size() - 1)
-			feedBackSizes[0] = feedBackSizes[1] = _layerDescs[l]._size;
-		else
-			feedBackSizes[0] = feedBackSizes[1] = { 1, 1 };
-
-		_layers[l]._sp.createRandom(cs, program, spDescs, _layerDescs[l]._size, feedBackSizes, _layerDescs[l]._lateralRadius, initWeightRange, rng);
-
-		_layers[l]._additionalErrors = cl::Image2D(cs.getContext(), CL_MEM_READ_WRITE, cl::ImageFormat(CL_R, CL_FLOAT), prevLayerSize.x, prevLayerSize.y);
-
-		cs.getQueue().enqueueFillImage(_layers[l]._additionalErrors, cl_float4{ 0.0f, 0.0f, 0.0f, 0.0f }, { 0, 0, 0 }, { static_cast<cl::size_type>(prevLayerSize.x), static_cast<cl::size_type>(prevLayerSize.y), 1 });
-		
-		prevLayerSize = _layerDescs[l]._size;
-	}
-
-	_inputWhitener.create(cs, program, _inputSize, CL_R, CL_FLOAT);
-
-	_zeroLayer = cl::Image2D(cs.getContext(), CL_MEM_READ_WRITE, cl::ImageFormat(CL_R, CL_FLOAT), 1, 1);
-
-	cs.getQueue().enqueueFillImage(_zeroLayer, cl_float4{ 0.0f, 0.0f, 0.0f, 0.0f }, { 0, 0, 0 }, { 1, 1, 1 });
-}
-
-void PredictiveHierarchy::simStep(sys::ComputeSystem &cs, const cl::Image2D &input, bool learn, bool whiten) {
-	// Whiten input
-	if (whiten)
-		_inputWhitener.filter(cs, input, _whiteningKernelRadius, _whiteningIntensity);
-	
-	// Feed forward
-	cl::Image2D prevLayerState = whiten ? _inputWhitener.getResult() : input;
-
-	for (int l = 0; l < _layers.size(); l++) {
-		std::vector<cl::Image2D> visibleStates(2);
-
-		visibleStates[0] = prevLayerState;
-		visibleStates[1] = _layers[l]._sp.getHiddenStates()[_back];
-
-		_layers[l]._sp.activateEncoder(cs, visibleStates, _layerDescs[l]._spActiveRatio);
-
-		prevLayerState = _layers[l]._sp.getHiddenStates()[_front];
-	}
-
-	// Feed back
-	for (int l = _layers.size() - 1; l >= 0; l--) {
-		std::vector<cl::Image2D> feedBackStates(2);
-
-		if (l < _layers.size() - 1)
-			feedBackStates[0] = feedBackStates[1] = _layers[l + 1]._sp.getVisibleLayer(0)._predictions[_back];
-		else
-			feedBackStates[0] = feedBackStates[1] = _zeroLayer;
-
-		_layers[l]._sp.activateDecoder(cs, feedBackStates);
-	}
-
-	if (learn) {
-		// Feed forward
-		prevLayerState = input;
-
-		for (int l = 0; l < _layers.size(); l++) {
-			// Encoder
-			std::vector<cl::Image2D> visibleStates(2);
-
-			visibleStates[0] = prevLayerState;
-			visibleStates[1] = _layers[l]._sp.getHiddenStates()[_front];
-
-			std::vector<cl::Image2D> feedBackStatesPrev(2);
-
-			if (l < _layers.size() - 1)
-				feedBackStatesPrev[0] = feedBackStatesPrev[1] = _layers[l + 1]._sp.getVisibleLayer(0)._predictions[_front];
-			else
-				feedBackStatesPrev[0] = feedBackStatesPrev[1] = _zeroLayer;
-
-			_layers[l]._sp.learn(cs, visibleStates, feedBackStatesPrev, { _layers[l]._additionalErrors, _layers[l]._additionalErrors },
-				_layerDescs[l]._spWeightEncodeAlpha, _layerDescs[l]._spWeightDecodeAlpha, _layerDescs[l]._spWeightLambda, _layerDescs[l]._spBiasAlpha, _layerDescs[l]._spActiveRatio);
-
-			prevLayerState = _layers[l]._sp.getHiddenStates()[_back];
-		}
-	}
-}
\ No newline at end of file
+#include "PredictiveHierarchy.h"
+
+#include <cmath>
+#include <chrono>
+#include <sstream>
+
+using namespace neo;
+
+void PredictiveHierarchy::createRandom(sys::ComputeSystem &cs, sys::ComputeProgram &program,
+	cl_int2 inputSize, const std::vector<LayerDesc> &layerDescs,
+	cl_float2 initWeightRange,
+	std::mt19937 &rng)
+{
+	// Everything the layers, whitener and megakernel need, so the modules are linked once
+	if (!program.requireModules(cs, { "init", "predictor", "whitening" })) {
+		assert(false);
+
+		return;
+	}
+
+	MemoryScope scope("PredictiveHierarchy", this);
+
+	_inputSize = inputSize;
+
+	_clock = 0;
+
+	_frozen = false;
+
+	_pipelined = false;
+
+	_megakernelEnabled = false;
+	_megakernelWeightsStale = true;
+	_megakernelStatesStale = true;
+	_imagesStale = false;
+
+	_layerDescs = layerDescs;
+
+	// A divisor below 1 would never tick (or divide by zero), treat it as running every step
+	for (int l = 0; l < _layerDescs.size(); l++)
+		_layerDescs[l]._clockDivisor = std::max(1, _layerDescs[l]._clockDivisor);
+
+	_layers.resize(_layerDescs.size());
+
+	_visibleStates.resize(2);
+	_feedBackStates.resize(2);
+	_additionalErrorStates.resize(2);
+	_lowerStates.resize(_layers.size());
+	_feedBack.resize(_layers.size());
+	_startEvents.resize(1);
+	_layerEvents.reserve(_layers.size());
+
+	cl_int2 prevLayerSize = inputSize;
+
+	for (int l = 0; l < _layers.size(); l++) {
+		MemoryScope layerScope("layer " + std::to_string(l));
+
+		std::vector<SparsePredictor::VisibleLayerDesc> spDescs;
+
+		if (l == 0) {
+			spDescs.resize(2);
+
+			spDescs[0]._size = prevLayerSize;
+			spDescs[0]._encodeRadius = _layerDescs[l]._feedForwardRadius;
+			spDescs[0]._predDecodeRadius = _layerDescs[l]._predictiveRadius;
+			spDescs[0]._feedBackDecodeRadius = _layerDescs[l]._feedBackRadius;
+			spDescs[0]._predictThresholded = false;
+			spDescs[0]._predict = true;
+			spDescs[0]._ignoreMiddle = false;
+			spDescs[0]._useForInput = true;
+
+			spDescs[1]._size = _layerDescs[l]._size;
+			spDescs[1]._encodeRadius = _layerDescs[l]._recurrentRadius;
+			spDescs[1]._predDecodeRadius = _layerDescs[l]._predictiveRadius;
+			spDescs[1]._feedBackDecodeRadius = _layerDescs[l]._feedBackRadius;
+			spDescs[1]._predictThresholded = true;
+			spDescs[1]._predict = false;
+			spDescs[1]._ignoreMiddle = true;
+			spDescs[1]._useForInput = false;
+		}
+		else {
+			spDescs.resize(2);
+
+			spDescs[0]._size = prevLayerSize;
+			spDescs[0]._encodeRadius = _layerDescs[l]._feedForwardRadius;
+			spDescs[0]._predDecodeRadius = _layerDescs[l]._predictiveRadius;
+			spDescs[0]._feedBackDecodeRadius = _layerDescs[l]._feedBackRadius;
+			spDescs[0]._predictThresholded = true;
+			spDescs[0]._predict = true;
+			spDescs[0]._ignoreMiddle = false;
+			spDescs[0]._useForInput = false;
+
+			spDescs[1]._size = _layerDescs[l]._size;
+			spDescs[1]._encodeRadius = _layerDescs[l]._recurrentRadius;
+			spDescs[1]._predDecodeRadius = _layerDescs[l]._predictiveRadius;
+			spDescs[1]._feedBackDecodeRadius = _layerDescs[l]._feedBackRadius;
+			spDescs[1]._predictThresholded = true;
+			spDescs[1]._predict = false;
+			spDescs[1]._ignoreMiddle = true;
+			spDescs[1]._useForInput = false;
+		}
+
+		std::vector<cl_int2> feedBackSizes(2);
+
+		if (l < _layers.size() - 1)
+			feedBackSizes[0] = feedBackSizes[1] = _layerDescs[l]._size;
+		else
+			feedBackSizes[0] = feedBackSizes[1] = { 1, 1 };
+
+		_layers[l]._sp.createRandom(cs, program, spDescs, _layerDescs[l]._size, feedBackSizes, _layerDescs[l]._lateralRadius, initWeightRange, rng);
+
+		_layers[l]._additionalErrors = createImage2D(cs, prevLayerSize, CL_R, CL_FLOAT, "additionalErrors");
+
+		cs.getQueue().enqueueFillImage(_layers[l]._additionalErrors, cl_float4{ 0.0f, 0.0f, 0.0f, 0.0f }, { 0, 0, 0 }, { static_cast<cl::size_type>(prevLayerSize.x), static_cast<cl::size_type>(prevLayerSize.y), 1 });
+		
+		prevLayerSize = _layerDescs[l]._size;
+	}
+
+	_inputWhitener.create(cs, program, _inputSize, CL_R, CL_FLOAT);
+
+	_zeroLayer = createImage2D(cs, { 1, 1 }, CL_R, CL_FLOAT, "zeroLayer");
+
+	cs.getQueue().enqueueFillImage(_zeroLayer, cl_float4{ 0.0f, 0.0f, 0.0f, 0.0f }, { 0, 0, 0 }, { 1, 1, 1 });
+}
+
+void PredictiveHierarchy::simStep(sys::ComputeSystem &cs, const cl::Image2D &input, bool learn, bool whiten) {
+	// A frozen hierarchy no longer has the buffers learning writes to
+	learn = learn && !_frozen;
+
+	if (_megakernelEnabled && !learn) {
+		stepMegakernel(cs, input, whiten);
+
+		return;
+	}
+
+	// The per layer path works on the images
+	syncStates(cs);
+
+	if (_pipelined) {
+		stepPipelined(cs, input, learn, whiten);
+
+		return;
+	}
+
+	// Whiten input
+	if (whiten)
+		_inputWhitener.filter(cs, input, _whiteningKernelRadius, _whiteningIntensity);
+	
+	// Feed forward
+	cl::Image2D prevLayerState = whiten ? _inputWhitener.getResult() : input;
+
+	for (int l = 0; l < _layers.size(); l++) {
+		// Held layers pass on their last computed states
+		if (!isLayerTicking(l)) {
+			prevLayerState = _layers[l]._sp.getHiddenStates()[_back];
+
+			continue;
+		}
+
+		std::vector<cl::Image2D> &visibleStates = _visibleStates;
+
+		visibleStates[0] = prevLayerState;
+		visibleStates[1] = _layers[l]._sp.getHiddenStates()[_back];
+
+		_layers[l]._sp.activateEncoder(cs, visibleStates, _layerDescs[l]._spActiveRatio);
+
+		prevLayerState = _layers[l]._sp.getHiddenStates()[_front];
+	}
+
+	// Feed back
+	for (int l = _layers.size() - 1; l >= 0; l--) {
+		if (!isLayerTicking(l))
+			continue;
+
+		std::vector<cl::Image2D> &feedBackStates = _feedBackStates;
+
+		if (l < _layers.size() - 1)
+			feedBackStates[0] = feedBackStates[1] = _layers[l + 1]._sp.getVisibleLayer(0)._predictions[_back];
+		else
+			feedBackStates[0] = feedBackStates[1] = _zeroLayer;
+
+		_layers[l]._sp.activateDecoder(cs, feedBackStates);
+	}
+
+	if (learn) {
+		// Feed forward
+		prevLayerState = input;
+
+		for (int l = 0; l < _layers.size(); l++) {
+			if (!isLayerTicking(l)) {
+				prevLayerState = _layers[l]._sp.getHiddenStates()[_back];
+
+				continue;
+			}
+
+			// Encoder
+			std::vector<cl::Image2D> &visibleStates = _visibleStates;
+
+			visibleStates[0] = prevLayerState;
+			visibleStates[1] = _layers[l]._sp.getHiddenStates()[_front];
+
+			std::vector<cl::Image2D> &feedBackStatesPrev = _feedBackStates;
+
+			// Feed back used by the previous decode. If the layer above was held this step, that is still its latest prediction
+			if (l < _layers.size() - 1)
+				feedBackStatesPrev[0] = feedBackStatesPrev[1] = _layers[l + 1]._sp.getVisibleLayer(0)._predictions[isLayerTicking(l + 1) ? _front : _back];
+			else
+				feedBackStatesPrev[0] = feedBackStatesPrev[1] = _zeroLayer;
+
+			_additionalErrorStates[0] = _additionalErrorStates[1] = _layers[l]._additionalErrors;
+
+			_layers[l]._sp.learn(cs, visibleStates, feedBackStatesPrev, _additionalErrorStates,
+				_layerDescs[l]._spWeightEncodeAlpha, _layerDescs[l]._spWeightDecodeAlpha, _layerDescs[l]._spWeightLambda, _layerDescs[l]._spBiasAlpha, _layerDescs[l]._spActiveRatio);
+
+			prevLayerState = _layers[l]._sp.getHiddenStates()[_back];
+		}
+
+		_megakernelWeightsStale = true;
+	}
+
+	_megakernelStatesStale = true;
+
+	_clock++;
+}
+
+void PredictiveHierarchy::setDeviceCalibration(cl_int2 inputSize, const std::vector<LayerDesc> &layerDescs, const std::string &kernelDirectory) {
+	// The choice only carries over to the same configuration
+	std::ostringstream key;
+
+	key << "PredictiveHierarchy " << kernelDirectory << " " << inputSize.x << "x" << inputSize.y;
+
+	for (int l = 0; l < layerDescs.size(); l++)
+		key << " " << layerDescs[l]._size.x << "x" << layerDescs[l]._size.y;
+
+	sys::ComputeSystem::setCalibration(key.str(), [=](sys::ComputeSystem &cs) {
+		sys::ComputeProgram program;
+
+		bool loaded = kernelDirectory.empty() ? program.loadModules(cs) : program.loadModules(kernelDirectory, cs);
+
+		if (!loaded || !program.requireModules(cs, { "init", "predictor", "whitening" }))
+			return -1.0;
+
+		std::mt19937 rng(0);
+
+		PredictiveHierarchy ph;
+
+		ph.createRandom(cs, program, inputSize, layerDescs, { -0.5f, 0.5f }, rng);
+
+		cl::Image2D input(cs.getContext(), CL_MEM_READ_WRITE, cl::ImageFormat(CL_R, CL_FLOAT), inputSize.x, inputSize.y);
+
+		cl::Kernel randomUniform2DKernel = cl::Kernel(program.getProgram(), "randomUniform2D");
+
+		randomUniform(input, cs, randomUniform2DKernel, inputSize, { 0.0f, 1.0f }, rng);
+
+		// Warm up, the first step pays for lazy allocation and kernel setup
+		ph.simStep(cs, input, true);
+
+		cs.getQueue().finish();
+
+		const int timedSteps = 3;
+
+		double best = -1.0;
+
+		for (int i = 0; i < timedSteps; i++) {
+			std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+
+			ph.simStep(cs, input, true);
+
+			cs.getQueue().finish();
+
+			double time = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+			if (best < 0.0 || time < best)
+				best = time;
+		}
+
+		return best;
+	});
+}
+
+bool PredictiveHierarchy::enablePipeline(sys::ComputeSystem &cs) {
+	if (cs.getNumSubQueues() == 0)
+		return false;
+
+	MemoryScope scope("PredictiveHierarchy", this);
+
+	cl::array<cl::size_type, 3> zeroOrigin = { 0, 0, 0 };
+
+	// The last decode of each layer used the current prediction of the layer above
+	_pipelineFeedBackPrev.resize(_layers.size());
+
+	for (int l = 0; l < _layers.size() - 1; l++) {
+		_pipelineFeedBackPrev[l] = createImage2D(cs, _layerDescs[l]._size, CL_R, CL_FLOAT, "pipelineFeedBackPrev");
+
+		cs.getQueue().enqueueCopyImage(_layers[l + 1]._sp.getVisibleLayer(0)._predictions[_back], _pipelineFeedBackPrev[l], zeroOrigin, zeroOrigin,
+			{ static_cast<cl::size_type>(_layerDescs[l]._size.x), static_cast<cl::size_type>(_layerDescs[l]._size.y), 1 });
+	}
+
+	_pipelineFeedBackPrev.back() = _zeroLayer;
+
+	_pipelined = true;
+
+	return true;
+}
+
+void PredictiveHierarchy::stepPipelined(sys::ComputeSystem &cs, const cl::Image2D &input, bool learn, bool whiten) {
+	if (whiten)
+		_inputWhitener.filter(cs, input, _whiteningKernelRadius, _whiteningIntensity);
+
+	cl::array<cl::size_type, 3> zeroOrigin = { 0, 0, 0 };
+
+	// Take what every layer reads from its neighbours before any of them swaps buffers.
+	// During the step layers only write their _front buffers, so these stay untouched until the join
+	std::vector<cl::Image2D> &lowerStates = _lowerStates;
+	std::vector<cl::Image2D> &feedBack = _feedBack;
+
+	for (int l = 0; l < _layers.size(); l++) {
+		if (l == 0)
+			lowerStates[l] = whiten ? _inputWhitener.getResult() : input;
+		else
+			lowerStates[l] = _layers[l - 1]._sp.getHiddenStates()[_back];
+
+		feedBack[l] = l < _layers.size() - 1 ? _layers[l + 1]._sp.getVisibleLayer(0)._predictions[_back] : _zeroLayer;
+	}
+
+	// Hand off to the layer queues once the input is ready
+	std::vector<cl::Event> &startEvents = _startEvents;
+	std::vector<cl::Event> &layerEvents = _layerEvents;
+
+	cs.getQueue().enqueueMarkerWithWaitList(nullptr, &startEvents.front());
+	cs.getQueue().flush();
+
+	layerEvents.clear();
+
+	for (int l = 0; l < _layers.size(); l++) {
+		if (!isLayerTicking(l))
+			continue;
+
+		cl::CommandQueue &layerQueue = cs.getSubQueue(l % cs.getNumSubQueues());
+
+		layerQueue.enqueueBarrierWithWaitList(&startEvents);
+
+		// Route the layer's kernels to its queue
+		cl::CommandQueue mainQueue = cs.swapQueue(layerQueue);
+
+		std::vector<cl::Image2D> &visibleStates = _visibleStates;
+
+		visibleStates[0] = lowerStates[l];
+		visibleStates[1] = _layers[l]._sp.getHiddenStates()[_back];
+
+		_layers[l]._sp.activateEncoder(cs, visibleStates, _layerDescs[l]._spActiveRatio);
+
+		_feedBackStates[0] = _feedBackStates[1] = feedBack[l];
+
+		_layers[l]._sp.activateDecoder(cs, _feedBackStates);
+
+		if (learn) {
+			visibleStates[0] = l == 0 ? input : lowerStates[l];
+			visibleStates[1] = _layers[l]._sp.getHiddenStates()[_front];
+
+			_feedBackStates[0] = _feedBackStates[1] = _pipelineFeedBackPrev[l];
+			_additionalErrorStates[0] = _additionalErrorStates[1] = _layers[l]._additionalErrors;
+
+			_layers[l]._sp.learn(cs, visibleStates, _feedBackStates, _additionalErrorStates,
+				_layerDescs[l]._spWeightEncodeAlpha, _layerDescs[l]._spWeightDecodeAlpha, _layerDescs[l]._spWeightLambda, _layerDescs[l]._spBiasAlpha, _layerDescs[l]._spActiveRatio);
+
+			_megakernelWeightsStale = true;
+		}
+
+		// Keep the feed back of this decode for the next learning step, after learning has read the old one
+		if (l < _layers.size() - 1)
+			cs.getQueue().enqueueCopyImage(feedBack[l], _pipelineFeedBackPrev[l], zeroOrigin, zeroOrigin,
+				{ static_cast<cl::size_type>(_layerDescs[l]._size.x), static_cast<cl::size_type>(_layerDescs[l]._size.y), 1 });
+
+		cs.swapQueue(mainQueue);
+
+		cl::Event layerDone;
+
+		layerQueue.enqueueMarkerWithWaitList(nullptr, &layerDone);
+		layerQueue.flush();
+
+		layerEvents.push_back(layerDone);
+	}
+
+	// Join, everything after this step sees all layers
+	if (!layerEvents.empty())
+		cs.getQueue().enqueueBarrierWithWaitList(&layerEvents);
+
+	_megakernelStatesStale = true;
+
+	_clock++;
+}
+
+void PredictiveHierarchy::freeze() {
+	for (int l = 0; l < _layers.size(); l++) {
+		_layers[l]._sp.freeze();
+
+		_layers[l]._additionalErrors = cl::Image2D();
+	}
+
+	_frozen = true;
+}
+
+void PredictiveHierarchy::stepMegakernel(sys::ComputeSystem &cs, const cl::Image2D &input, bool whiten) {
+	if (whiten)
+		_inputWhitener.filter(cs, input, _whiteningKernelRadius, _whiteningIntensity);
+
+	if (_megakernelWeightsStale) {
+		_megakernel.uploadWeights(cs, *this);
+
+		_megakernelWeightsStale = false;
+	}
+
+	if (_megakernelStatesStale) {
+		_megakernel.uploadStates(cs, *this);
+
+		_megakernelStatesStale = false;
+	}
+
+	cl_uint tickingMask = 0;
+
+	for (int l = 0; l < _layers.size(); l++)
+		if (isLayerTicking(l))
+			tickingMask |= 1u << l;
+
+	_megakernel.run(cs, whiten ? _inputWhitener.getResult() : input, tickingMask);
+
+	// Only the prediction is copied back every step, the rest waits for syncStates
+	_megakernel.downloadStates(cs, *this, false);
+
+	_imagesStale = true;
+
+	_clock++;
+}
+
+bool PredictiveHierarchy::enableMegakernel(sys::ComputeSystem &cs, sys::ComputeProgram &program, const cl::Image2D &validationInput, bool whiten,
+	cl_int numGroups, cl_float tolerance)
+{
+	MemoryScope scope("PredictiveHierarchy", this);
+
+	_megakernelEnabled = false;
+
+	if (static_cast<int>(_layers.size()) > HierarchyMegakernel::_maxLayers)
+		return false;
+
+	syncStates(cs);
+
+	if (!_megakernel.create(cs, program, *this, numGroups))
+		return false;
+
+	_megakernel.uploadWeights(cs, *this);
+	_megakernel.uploadStates(cs, *this);
+
+	// Step the megakernel from the current states, then the regular path from the same states
+	cl_uint tickingMask = 0;
+
+	for (int l = 0; l < _layers.size(); l++)
+		if (isLayerTicking(l))
+			tickingMask |= 1u << l;
+
+	if (whiten)
+		_inputWhitener.filter(cs, validationInput, _whiteningKernelRadius, _whiteningIntensity);
+
+	_megakernel.run(cs, whiten ? _inputWhitener.getResult() : validationInput, tickingMask);
+
+	std::vector<cl_float> megakernelPrediction;
+
+	_megakernel.readPrediction(cs, megakernelPrediction);
+
+	simStep(cs, validationInput, false, whiten);
+
+	cl_int2 predictionSize = _layers.front()._sp.getVisibleLayerDesc(0)._size;
+
+	std::vector<cl_float> prediction(predictionSize.x * predictionSize.y);
+
+	cs.getQueue().enqueueReadImage(getPrediction(), CL_TRUE, { 0, 0, 0 }, { static_cast<cl::size_type>(predictionSize.x), static_cast<cl::size_type>(predictionSize.y), 1 }, 0, 0, prediction.data());
+
+	for (int i = 0; i < prediction.size(); i++)
+		if (std::abs(prediction[i] - megakernelPrediction[i]) > tolerance)
+			return false;
+
+	_megakernelEnabled = true;
+
+	// The buffers hold the same step, but refresh them from the images to start out identical
+	_megakernelWeightsStale = false;
+	_megakernelStatesStale = true;
+
+	return true;
+}
+
+void PredictiveHierarchy::disableMegakernel(sys::ComputeSystem &cs) {
+	syncStates(cs);
+
+	_megakernelEnabled = false;
+}
+
+void PredictiveHierarchy::syncStates(sys::ComputeSystem &cs) {
+	if (_imagesStale) {
+		_megakernel.downloadStates(cs, *this, true);
+
+		_imagesStale = false;
+	}
+}
+
+void PredictiveHierarchy::release() {
+	recycleImages(this);
+
+	*this = PredictiveHierarchy();
+}
@@ -1,153 +1,327 @@
-#pragma once
-
-#include "SparsePredictor.h"
-#include "ImageWhitener.h"
-
-namespace neo {
-	/*!
-	\brief Predictive hierarchy (no RL)
-	*/
-	class PredictiveHierarchy {
-	public:
-		/*!
-		\brief Layer desc
-		*/
-		struct LayerDesc {
-			/*!
-			\brief Size of layer
-			*/
-			cl_int2 _size;
-
-			/*!
-			\brief Radii
-			*/
-			cl_int _feedForwardRadius, _recurrentRadius, _lateralRadius, _feedBackRadius, _predictiveRadius;
-
-			//!@{
-			/*!
-			\brief Sparse predictor parameters
-			*/
-			cl_float _spWeightEncodeAlpha;
-			cl_float _spWeightDecodeAlpha;
-			cl_float _spWeightLambda;
-			cl_float _spActiveRatio;
-			cl_float _spBiasAlpha;
-			//!@}
-
-			/*!
-			\brief Initialize defaults
-			*/
-			LayerDesc()
-				: _size({ 8, 8 }),
-				_feedForwardRadius(5), _recurrentRadius(5), _lateralRadius(5), _feedBackRadius(6), _predictiveRadius(6),
-				_spWeightEncodeAlpha(0.001f), _spWeightDecodeAlpha(0.02f), _spWeightLambda(0.9f),
-				_spActiveRatio(0.08f), _spBiasAlpha(0.1f)
-			{}
-		};
-
-		/*!
-		\brief Layer
-		*/
-		struct Layer {
-			/*!
-			\brief Sparse predictor
-			*/
-			SparsePredictor _sp;
-
-			/*!
-			\brief Layer for additional error signals
-			*/
-			cl::Image2D _additionalErrors;
-		};
-
-	private:
-		/*!
-		\brief Store input size
-		*/
-		cl_int2 _inputSize;
-
-		//!@{
-		/*!
-		\brief Layers and descs
-		*/
-		std::vector<Layer> _layers;
-		std::vector<LayerDesc> _layerDescs;
-		//!@}
-
-		/*!
-		\brief Input whitener
-		*/
-		ImageWhitener _inputWhitener;
-
-		/*!
-		\brief Zero layer for capping of the network
-		*/
-		cl::Image2D _zeroLayer;
-
-	public:
-		//!@{
-		/*!
-		\brief Whitening parameters
-		*/
-		cl_int _whiteningKernelRadius;
-		cl_float _whiteningIntensity;
-		//!@}
-
-		/*!
-		\brief Initialize defaults
-		*/
-		PredictiveHierarchy()
-			: _whiteningKernelRadius(1),
-			_whiteningIntensity(1024.0f)
-		{}
-
-		/*!
-		\brief Create a predictive hierarchy with random initialization
-		Requires the compute system, program with the NeoRL kernels, and initialization information
-		*/
-		void createRandom(sys::ComputeSystem &cs, sys::ComputeProgram &program,
-			cl_int2 inputSize, const std::vector<LayerDesc> &layerDescs,
-			cl_float2 initWeightRange,
-			std::mt19937 &rng);
-
-		/*!
-		\brief Simulation step of hierarchy
-		*/
-		void simStep(sys::ComputeSystem &cs, const cl::Image2D &input, bool learn = true, bool whiten = false);
-
-		/*!
-		\brief Get number of layers
-		*/
-		size_t getNumLayers() const {
-			return _layers.size();
-		}
-
-		/*!
-		\brief Get access to a layer
-		*/
-		const Layer &getLayer(int index) const {
-			return _layers[index];
-		}
-
-		/*!
-		\brief Get access to a layer desc
-		*/
-		const LayerDesc &getLayerDescs(int index) const {
-			return _layerDescs[index];
-		}
-
-		/*!
-		\brief Get the prediction
-		*/
-		const cl::Image2D &getPrediction() const {
-			return _layers.front()._sp.getVisibleLayer(0)._predictions[_back];
-		}
-
-		/*!
-		\brief Get input whitener
-		*/
-		const ImageWhitener &getInputWhitener() const {
-			return _inputWhitener;
-		}
-	};
+#pragma once
+
+#include "SparsePredictor.h"
+#include "ImageWhitener.h"
+#include "HierarchyMegakernel.h"
+
+namespace neo {
+	/*!
+	\brief Predictive hierarchy (no RL)
+	*/
+	class PredictiveHierarchy {
+	public:
+		/*!
+		\brief Layer desc
+		*/
+		struct LayerDesc {
+			/*!
+			\brief Size of layer
+			*/
+			cl_int2 _size;
+
+			/*!
+			\brief Radii
+			*/
+			cl_int _feedForwardRadius, _recurrentRadius, _lateralRadius, _feedBackRadius, _predictiveRadius;
+
+			//!@{
+			/*!
+			\brief Sparse predictor parameters
+			*/
+			cl_float _spWeightEncodeAlpha;
+			cl_float _spWeightDecodeAlpha;
+			cl_float _spWeightLambda;
+			cl_float _spActiveRatio;
+			cl_float _spBiasAlpha;
+			//!@}
+
+			/*!
+			\brief Clock divisor, the layer only encodes, decodes and learns every _clockDivisor steps
+			In between it holds its states and predictions, so lower layers receive the last computed feed back
+			*/
+			cl_int _clockDivisor;
+
+			/*!
+			\brief Initialize defaults
+			*/
+			LayerDesc()
+				: _size({ 8, 8 }),
+				_feedForwardRadius(5), _recurrentRadius(5), _lateralRadius(5), _feedBackRadius(6), _predictiveRadius(6),
+				_spWeightEncodeAlpha(0.001f), _spWeightDecodeAlpha(0.02f), _spWeightLambda(0.9f),
+				_spActiveRatio(0.08f), _spBiasAlpha(0.1f),
+				_clockDivisor(1)
+			{}
+		};
+
+		/*!
+		\brief Layer
+		*/
+		struct Layer {
+			/*!
+			\brief Sparse predictor
+			*/
+			SparsePredictor _sp;
+
+			/*!
+			\brief Layer for additional error signals
+			*/
+			cl::Image2D _additionalErrors;
+		};
+
+	private:
+		/*!
+		\brief Store input size
+		*/
+		cl_int2 _inputSize;
+
+		//!@{
+		/*!
+		\brief Layers and descs
+		*/
+		std::vector<Layer> _layers;
+		std::vector<LayerDesc> _layerDescs;
+		//!@}
+
+		/*!
+		\brief Input whitener
+		*/
+		ImageWhitener _inputWhitener;
+
+		/*!
+		\brief Zero layer for capping of the network
+		*/
+		cl::Image2D _zeroLayer;
+
+		/*!
+		\brief Number of steps simulated so far, drives the layer clocks
+		*/
+		cl_ulong _clock;
+
+		/*!
+		\brief Whether the hierarchy was frozen for inference
+		*/
+		bool _frozen;
+
+		/*!
+		\brief Single dispatch path for steps without learning
+		*/
+		HierarchyMegakernel _megakernel;
+
+		//!@{
+		/*!
+		\brief Megakernel state. The stale flags mark whether the megakernel buffers are behind the images (weights, states) or the reverse
+		*/
+		bool _megakernelEnabled;
+		bool _megakernelWeightsStale;
+		bool _megakernelStatesStale;
+		bool _imagesStale;
+		//!@}
+
+		/*!
+		\brief Step without learning through the megakernel
+		*/
+		void stepMegakernel(sys::ComputeSystem &cs, const cl::Image2D &input, bool whiten);
+
+		/*!
+		\brief Whether layers run as a pipeline (see enablePipeline)
+		*/
+		bool _pipelined;
+
+		/*!
+		\brief Per layer copy of the feed back its last decode used, which learning needs after the layer above has overwritten it
+		*/
+		std::vector<cl::Image2D> _pipelineFeedBackPrev;
+
+		//!@{
+		/*!
+		\brief Argument lists and pipeline scratch reused every step, so stepping does not allocate
+		*/
+		std::vector<cl::Image2D> _visibleStates;
+		std::vector<cl::Image2D> _feedBackStates;
+		std::vector<cl::Image2D> _additionalErrorStates;
+		std::vector<cl::Image2D> _lowerStates;
+		std::vector<cl::Image2D> _feedBack;
+		std::vector<cl::Event> _startEvents;
+		std::vector<cl::Event> _layerEvents;
+		//!@}
+
+		/*!
+		\brief Pipelined step
+		*/
+		void stepPipelined(sys::ComputeSystem &cs, const cl::Image2D &input, bool learn, bool whiten);
+
+	public:
+		//!@{
+		/*!
+		\brief Whitening parameters
+		*/
+		cl_int _whiteningKernelRadius;
+		cl_float _whiteningIntensity;
+		//!@}
+
+		/*!
+		\brief Initialize defaults
+		*/
+		PredictiveHierarchy()
+			: _clock(0),
+			_frozen(false),
+			_megakernelEnabled(false),
+			_megakernelWeightsStale(true),
+			_megakernelStatesStale(true),
+			_imagesStale(false),
+			_pipelined(false),
+			_whiteningKernelRadius(1),
+			_whiteningIntensity(1024.0f)
+		{}
+
+		/*!
+		\brief Create a predictive hierarchy with random initialization
+		Requires the compute system, program with the NeoRL kernels, and initialization information
+		*/
+		void createRandom(sys::ComputeSystem &cs, sys::ComputeProgram &program,
+			cl_int2 inputSize, const std::vector<LayerDesc> &layerDescs,
+			cl_float2 initWeightRange,
+			std::mt19937 &rng);
+
+		/*!
+		\brief Drop all device memory, the images go to the pool when pooling is enabled (see setImagePooling)
+		The model has to be created again before it is used
+		*/
+		void release();
+
+		/*!
+		\brief Simulation step of hierarchy
+		*/
+		void simStep(sys::ComputeSystem &cs, const cl::Image2D &input, bool learn = true, bool whiten = false);
+
+		/*!
+		\brief Make a hierarchy of this configuration the calibration workload of ComputeSystem::_auto device selection
+		Each candidate builds the kernel modules (embedded if kernelDirectory is empty), then a learning step is timed (best of a few, after a warm up step)
+		*/
+		static void setDeviceCalibration(cl_int2 inputSize, const std::vector<LayerDesc> &layerDescs, const std::string &kernelDirectory = "");
+
+		/*!
+		\brief Freeze a trained hierarchy for inference
+		Releases the front weight buffers, error images and other learning state of every layer, about halving device memory.
+		Steps ignore learn afterwards
+		*/
+		void freeze();
+
+		/*!
+		\brief Whether the hierarchy was frozen
+		*/
+		bool isFrozen() const {
+			return _frozen;
+		}
+
+		/*!
+		\brief Run the layers as a pipeline over the sub-device queues of the compute system (created with numSubDevices > 0)
+		Each layer encodes the states its lower layer had at the end of the previous step and decodes with the previous step's feed back,
+		so layer l at step t runs concurrently with layer l + 1 working on what layer l produced at t - 1.
+		Feed forward gains a step of latency per layer, so results differ from the sequential schedule.
+		Returns false if the compute system has no sub-device queues
+		*/
+		bool enablePipeline(sys::ComputeSystem &cs);
+
+		/*!
+		\brief Go back to the sequential schedule
+		*/
+		void disablePipeline() {
+			_pipelined = false;
+		}
+
+		/*!
+		\brief Whether layers run as a pipeline
+		*/
+		bool isPipelined() const {
+			return _pipelined;
+		}
+
+		/*!
+		\brief Decompose the activation of a layer into bands over the sub-devices (see SparsePredictor::decompose)
+		*/
+		void decomposeLayer(sys::ComputeSystem &cs, int l, int numBands) {
+			MemoryScope scope("PredictiveHierarchy", this);
+			MemoryScope layerScope("layer " + std::to_string(l));
+
+			_layers[l]._sp.decompose(cs, numBands);
+		}
+
+		/*!
+		\brief Run steps without learning as a single dispatch (see HierarchyMegakernel)
+		The megakernel is validated first by stepping validationInput through it and through the regular path, which advances the hierarchy by one step.
+		Returns false and keeps the regular path if the predictions differ by more than tolerance.
+		A single work group occupies one compute unit, so on GPUs this is usually slower than the per layer kernels.
+		numGroups > 1 is refused (returning false) unless the device is a CPU with at least that many compute units, see HierarchyMegakernel::create
+		*/
+		bool enableMegakernel(sys::ComputeSystem &cs, sys::ComputeProgram &program, const cl::Image2D &validationInput, bool whiten = false,
+			cl_int numGroups = 1, cl_float tolerance = 0.001f);
+
+		/*!
+		\brief Go back to launching kernels per layer
+		*/
+		void disableMegakernel(sys::ComputeSystem &cs);
+
+		/*!
+		\brief Whether steps without learning use the megakernel
+		*/
+		bool isMegakernelEnabled() const {
+			return _megakernelEnabled;
+		}
+
+		/*!
+		\brief Bring the hidden states of all layers up to date after megakernel steps
+		Megakernel steps only copy back the prediction, call this before reading other layer images
+		*/
+		void syncStates(sys::ComputeSystem &cs);
+
+		/*!
+		\brief Get number of layers
+		*/
+		size_t getNumLayers() const {
+			return _layers.size();
+		}
+
+		/*!
+		\brief Get access to a layer
+		*/
+		const Layer &getLayer(int index) const {
+			return _layers[index];
+		}
+
+		/*!
+		\brief Get access to a layer desc
+		*/
+		const LayerDesc &getLayerDescs(int index) const {
+			return _layerDescs[index];
+		}
+
+		/*!
+		\brief Whether a layer runs on the current step (see LayerDesc::_clockDivisor)
+		*/
+		bool isLayerTicking(int index) const {
+			return _clock % _layerDescs[index]._clockDivisor == 0;
+		}
+
+		/*!
+		\brief Get the prediction
+		*/
+		const cl::Image2D &getPrediction() const {
+			return _layers.front()._sp.getVisibleLayer(0)._predictions[_back];
+		}
+
+		/*!
+		\brief Select how the input whitener gathers statistics, validated at the current whitening parameters (see ImageWhitener::setMode)
+		*/
+		bool setWhiteningMode(sys::ComputeSystem &cs, ImageWhitener::Mode mode, const cl::Image2D &validationInput, cl_float tolerance = 0.001f) {
+			return _inputWhitener.setMode(cs, mode, validationInput, _whiteningKernelRadius, _whiteningIntensity, tolerance);
+		}
+
+		/*!
+		\brief Get input whitener
+		*/
+		const ImageWhitener &getInputWhitener() const {
+			return _inputWhitener;
+		}
+	};
 }
\ No newline at end of file
@@ -1,308 +1,549 @@
-#include "SparseCoder.h"
-
-using namespace neo;
-
-void SparseCoder::createRandom(sys::ComputeSystem &cs, sys::ComputeProgram &program,
-	const std::vector<VisibleLayerDesc> &visibleLayerDescs, cl_int2 hiddenSize, cl_int lateralRadius, cl_float2 initWeightRange, cl_float2 initLateralWeightRange, cl_float initThreshold,
-	std::mt19937 &rng)
-{
-	_visibleLayerDescs = visibleLayerDescs;
-
-	_hiddenSize = hiddenSize;
-
-	_lateralRadius = lateralRadius;
-
-	cl_float4 zeroColor = { 0.0f, 0.0f, 0.0f, 0.0f };
-	cl_float4 thresholdColor = { initThreshold, initThreshold, initThreshold, initThreshold };
-
-	cl::array<cl::size_type, 3> zeroOrigin = { 0, 0, 0 };
-	cl::array<cl::size_type, 3> hiddenRegion = { _hiddenSize.x, _hiddenSize.y, 1 };
-
-	_visibleLayers.resize(_visibleLayerDescs.size());
-
-	cl::Kernel randomUniform2DKernel = cl::Kernel(program.getProgram(), "randomUniform2D");
-	cl::Kernel randomUniform3DKernel = cl::Kernel(program.getProgram(), "randomUniform3D");
-	
-	// Create layers
-	for (int vli = 0; vli < _visibleLayers.size(); vli++) {
-		VisibleLayer &vl = _visibleLayers[vli];
-		VisibleLayerDesc &vld = _visibleLayerDescs[vli];
-
-		const cl_channel_order weightChannels = vld._useTraces ? CL_RG : CL_R;
-
-		vl._hiddenToVisible = cl_float2{ static_cast<float>(vld._size.x) / static_cast<float>(_hiddenSize.x),
-			static_cast<float>(vld._size.y) / static_cast<float>(_hiddenSize.y)
-		};
-
-		vl._visibleToHidden = cl_float2{ static_cast<float>(_hiddenSize.x) / static_cast<float>(vld._size.x),
-			static_cast<float>(_hiddenSize.y) / static_cast<float>(vld._size.y)
-		};
-
-		vl._reverseRadii = cl_int2 { static_cast<int>(std::ceil(vl._visibleToHidden.x * vld._radius)), static_cast<int>(std::ceil(vl._visibleToHidden.y * vld._radius)) };
-
-		// Create images
-		int weightDiam = vld._radius * 2 + 1;
-
-		int numWeights = weightDiam * weightDiam;
-
-		cl_int3 weightsSize = cl_int3{ _hiddenSize.x, _hiddenSize.y, numWeights };
-
-		vl._weights = createDoubleBuffer3D(cs, weightsSize, weightChannels, CL_FLOAT);
-
-		randomUniform(vl._weights[_back], cs, randomUniform3DKernel, weightsSize, initWeightRange, rng);
-	}
-
-	// Hidden state data
-	_hiddenStates = createDoubleBuffer2D(cs, _hiddenSize, CL_R, CL_FLOAT);
-	_hiddenSpikes = createDoubleBuffer2D(cs, _hiddenSize, CL_R, CL_FLOAT);
-	_hiddenActivations = createDoubleBuffer2D(cs, _hiddenSize, CL_R, CL_FLOAT);
-
-	_hiddenThresholds = createDoubleBuffer2D(cs, _hiddenSize, CL_R, CL_FLOAT);
-
-	_hiddenSummationTemp = createDoubleBuffer2D(cs, _hiddenSize, CL_R, CL_FLOAT);
-
-	{
-		int lateralWeightDiam = lateralRadius * 2 + 1;
-
-		int numLateralWeights = lateralWeightDiam * lateralWeightDiam;
-
-		cl_int3 lateralWeightsSize = cl_int3 { _hiddenSize.x, _hiddenSize.y, numLateralWeights };
-
-		_lateralWeights = createDoubleBuffer3D(cs, lateralWeightsSize, CL_R, CL_FLOAT);
-	
-		randomUniform(_lateralWeights[_back], cs, randomUniform3DKernel, lateralWeightsSize, initLateralWeightRange, rng);
-	}
-
-	cs.getQueue().enqueueFillImage(_hiddenThresholds[_back], thresholdColor, zeroOrigin, hiddenRegion);
-
-	cs.getQueue().enqueueFillImage(_hiddenSpikes[_back], zeroColor, zeroOrigin, hiddenRegion);
-	cs.getQueue().enqueueFillImage(_hiddenStates[_back], zeroColor, zeroOrigin, hiddenRegion);
-	cs.getQueue().enqueueFillImage(_hiddenActivations[_back], zeroColor, zeroOrigin, hiddenRegion);
-
-	// Create kernels
-	_reconstructVisibleKernel = cl::Kernel(program.getProgram(), "scReconstructVisible");
-	_activateKernel = cl::Kernel(program.getProgram(), "scActivate");
-	_solveHiddenKernel = cl::Kernel(program.getProgram(), "scSolveHidden");
-	_learnThresholdsKernel = cl::Kernel(program.getProgram(), "scLearnThresholds");
-	_learnWeightsKernel = cl::Kernel(program.getProgram(), "scLearnSparseCoderWeights");
-	_learnWeightsTracesKernel = cl::Kernel(program.getProgram(), "scLearnSparseCoderWeightsTraces");
-	_learnWeightsLateralKernel = cl::Kernel(program.getProgram(), "scLearnSparseCoderWeightsLateral");
-}
-
-void SparseCoder::activate(sys::ComputeSystem &cs, const std::vector<cl::Image2D> &visibleStates, cl_int iterations, cl_float leak) {
-	// Clear previous aggregate state information
-	{
-		cl_float4 zeroColor = { 0.0f, 0.0f, 0.0f, 0.0f };
-
-		cl::array<cl::size_type, 3> zeroOrigin = { 0, 0, 0 };
-		cl::array<cl::size_type, 3> hiddenRegion = { _hiddenSize.x, _hiddenSize.y, 1 };
-
-		cs.getQueue().enqueueFillImage(_hiddenStates[_back], zeroColor, zeroOrigin, hiddenRegion);
-		cs.getQueue().enqueueFillImage(_hiddenActivations[_back], zeroColor, zeroOrigin, hiddenRegion);
-	}
-
-	// Start by clearing summation buffer
-	{
-		cl_float4 zeroColor = { 0.0f, 0.0f, 0.0f, 0.0f };
-
-		cl::array<cl::size_type, 3> zeroOrigin = { 0, 0, 0 };
-		cl::array<cl::size_type, 3> hiddenRegion = { _hiddenSize.x, _hiddenSize.y, 1 };
-
-		cs.getQueue().enqueueFillImage(_hiddenSummationTemp[_back], zeroColor, zeroOrigin, hiddenRegion);
-	}
-
-	for (int vli = 0; vli < _visibleLayers.size(); vli++) {
-		VisibleLayer &vl = _visibleLayers[vli];
-		VisibleLayerDesc &vld = _visibleLayerDescs[vli];
-
-		int argIndex = 0;
-
-		_activateKernel.setArg(argIndex++, visibleStates[vli]);
-		_activateKernel.setArg(argIndex++, _hiddenSummationTemp[_back]);
-		_activateKernel.setArg(argIndex++, _hiddenSummationTemp[_front]);
-		_activateKernel.setArg(argIndex++, vl._weights[_back]);
-		_activateKernel.setArg(argIndex++, vld._size);
-		_activateKernel.setArg(argIndex++, vl._hiddenToVisible);
-		_activateKernel.setArg(argIndex++, vld._radius);
-
-		cs.getQueue().enqueueNDRangeKernel(_activateKernel, cl::NullRange, cl::NDRange(_hiddenSize.x, _hiddenSize.y));
-
-		// Swap buffers
-		std::swap(_hiddenSummationTemp[_front], _hiddenSummationTemp[_back]);
-	}
-
-	for (cl_int iter = 0; iter < iterations; iter++) {		
-		// Back now contains the sums. Solve sparse codes from this
-		{
-			int argIndex = 0;
-
-			_solveHiddenKernel.setArg(argIndex++, _hiddenSummationTemp[_back]);
-			_solveHiddenKernel.setArg(argIndex++, _hiddenSpikes[_back]);
-			_solveHiddenKernel.setArg(argIndex++, _hiddenSpikes[_front]);
-			_solveHiddenKernel.setArg(argIndex++, _hiddenStates[_back]);
-			_solveHiddenKernel.setArg(argIndex++, _hiddenStates[_front]);
-			_solveHiddenKernel.setArg(argIndex++, _hiddenActivations[_back]);
-			_solveHiddenKernel.setArg(argIndex++, _hiddenActivations[_front]);
-			_solveHiddenKernel.setArg(argIndex++, _hiddenThresholds[_back]);
-			_solveHiddenKernel.setArg(argIndex++, _lateralWeights[_back]);
-			_solveHiddenKernel.setArg(argIndex++, _hiddenSize);
-			_solveHiddenKernel.setArg(argIndex++, _lateralRadius);
-			_solveHiddenKernel.setArg(argIndex++, leak);
-			_solveHiddenKernel.setArg(argIndex++, 1.0f / (1.0f + iter));
-
-			cs.getQueue().enqueueNDRangeKernel(_solveHiddenKernel, cl::NullRange, cl::NDRange(_hiddenSize.x, _hiddenSize.y));
-		}
-
-		// Swap hidden state buffers
-		std::swap(_hiddenSpikes[_front], _hiddenSpikes[_back]);
-		std::swap(_hiddenStates[_front], _hiddenStates[_back]);
-		std::swap(_hiddenActivations[_front], _hiddenActivations[_back]);
-	}
-}
-
-void SparseCoder::learn(sys::ComputeSystem &cs, const std::vector<cl::Image2D> &visibleStates, float weightLateralAlpha, float thresholdAlpha, float activeRatio) {
-	// Learn Thresholds
-	{
-		int argIndex = 0;
-
-		_learnThresholdsKernel.setArg(argIndex++, _hiddenThresholds[_back]);
-		_learnThresholdsKernel.setArg(argIndex++, _hiddenThresholds[_front]);
-		_learnThresholdsKernel.setArg(argIndex++, _hiddenStates[_back]);
-		_learnThresholdsKernel.setArg(argIndex++, thresholdAlpha);
-		_learnThresholdsKernel.setArg(argIndex++, activeRatio);
-
-		cs.getQueue().enqueueNDRangeKernel(_learnThresholdsKernel, cl::NullRange, cl::NDRange(_hiddenSize.x, _hiddenSize.y));
-
-		std::swap(_hiddenThresholds[_front], _hiddenThresholds[_back]);
-	}
-
-	// Learn weights
-	for (int vli = 0; vli < _visibleLayers.size(); vli++) {
-		VisibleLayer &vl = _visibleLayers[vli];
-		VisibleLayerDesc &vld = _visibleLayerDescs[vli];
-
-		int argIndex = 0;
-
-		_learnWeightsKernel.setArg(argIndex++, visibleStates[vli]);
-		_learnWeightsKernel.setArg(argIndex++, _hiddenStates[_back]);
-		_learnWeightsKernel.setArg(argIndex++, vl._weights[_back]);
-		_learnWeightsKernel.setArg(argIndex++, vl._weights[_front]);
-		_learnWeightsKernel.setArg(argIndex++, vld._size);
-		_learnWeightsKernel.setArg(argIndex++, vl._hiddenToVisible);
-		_learnWeightsKernel.setArg(argIndex++, vld._radius);
-		_learnWeightsKernel.setArg(argIndex++, vld._weightAlpha);
-
-		cs.getQueue().enqueueNDRangeKernel(_learnWeightsKernel, cl::NullRange, cl::NDRange(_hiddenSize.x, _hiddenSize.y));
-
-		std::swap(vl._weights[_front], vl._weights[_back]);
-	}
-
-	// Learn lateral weights
-	{
-		int argIndex = 0;
-
-		_learnWeightsLateralKernel.setArg(argIndex++, _hiddenStates[_back]);
-		_learnWeightsLateralKernel.setArg(argIndex++, _lateralWeights[_back]);
-		_learnWeightsLateralKernel.setArg(argIndex++, _lateralWeights[_front]);
-		_learnWeightsLateralKernel.setArg(argIndex++, _hiddenSize);
-		_learnWeightsLateralKernel.setArg(argIndex++, _lateralRadius);
-		_learnWeightsLateralKernel.setArg(argIndex++, weightLateralAlpha);
-		_learnWeightsLateralKernel.setArg(argIndex++, activeRatio * activeRatio);
-
-		cs.getQueue().enqueueNDRangeKernel(_learnWeightsLateralKernel, cl::NullRange, cl::NDRange(_hiddenSize.x, _hiddenSize.y));
-
-		std::swap(_lateralWeights[_front], _lateralWeights[_back]);
-	}
-}
-
-void SparseCoder::learn(sys::ComputeSystem &cs, const cl::Image2D &rewards, const std::vector<cl::Image2D> &visibleStates, float weightLateralAlpha, float thresholdAlpha, float activeRatio) {
-	// Learn Thresholds
-	{
-		int argIndex = 0;
-
-		_learnThresholdsKernel.setArg(argIndex++, _hiddenThresholds[_back]);
-		_learnThresholdsKernel.setArg(argIndex++, _hiddenThresholds[_front]);
-		_learnThresholdsKernel.setArg(argIndex++, _hiddenStates[_back]);
-		_learnThresholdsKernel.setArg(argIndex++, thresholdAlpha);
-		_learnThresholdsKernel.setArg(argIndex++, activeRatio);
-
-		cs.getQueue().enqueueNDRangeKernel(_learnThresholdsKernel, cl::NullRange, cl::NDRange(_hiddenSize.x, _hiddenSize.y));
-
-		std::swap(_hiddenThresholds[_front], _hiddenThresholds[_back]);
-	}
-
-	// Learn weights
-	for (int vli = 0; vli < _visibleLayers.size(); vli++) {
-		VisibleLayer &vl = _visibleLayers[vli];
-		VisibleLayerDesc &vld = _visibleLayerDescs[vli];
-
-		if (vld._useTraces) {
-			int argIndex = 0;
-
-			_learnWeightsTracesKernel.setArg(argIndex++, visibleStates[vli]);
-			_learnWeightsTracesKernel.setArg(argIndex++, _hiddenStates[_back]);
-			_learnWeightsTracesKernel.setArg(argIndex++, vl._weights[_back]);
-			_learnWeightsTracesKernel.setArg(argIndex++, vl._weights[_front]);
-			_learnWeightsTracesKernel.setArg(argIndex++, rewards);
-			_learnWeightsTracesKernel.setArg(argIndex++, vld._size);
-			_learnWeightsTracesKernel.setArg(argIndex++, vl._hiddenToVisible);
-			_learnWeightsTracesKernel.setArg(argIndex++, vld._radius);
-			_learnWeightsTracesKernel.setArg(argIndex++, vld._weightAlpha);
-			_learnWeightsTracesKernel.setArg(argIndex++, vld._weightLambda);
-
-			cs.getQueue().enqueueNDRangeKernel(_learnWeightsTracesKernel, cl::NullRange, cl::NDRange(_hiddenSize.x, _hiddenSize.y));
-		}
-		else {
-			int argIndex = 0;
-
-			_learnWeightsKernel.setArg(argIndex++, visibleStates[vli]);
-			_learnWeightsKernel.setArg(argIndex++, _hiddenStates[_back]);
-			_learnWeightsKernel.setArg(argIndex++, vl._weights[_back]);
-			_learnWeightsKernel.setArg(argIndex++, vl._weights[_front]);
-			_learnWeightsKernel.setArg(argIndex++, vld._size);
-			_learnWeightsKernel.setArg(argIndex++, vl._hiddenToVisible);
-			_learnWeightsKernel.setArg(argIndex++, vld._radius);
-			_learnWeightsKernel.setArg(argIndex++, vld._weightAlpha);
-
-			cs.getQueue().enqueueNDRangeKernel(_learnWeightsKernel, cl::NullRange, cl::NDRange(_hiddenSize.x, _hiddenSize.y));
-		}
-
-		std::swap(vl._weights[_front], vl._weights[_back]);
-	}
-
-	// Learn lateral weights
-	{
-		int argIndex = 0;
-
-		_learnWeightsLateralKernel.setArg(argIndex++, _hiddenStates[_back]);
-		_learnWeightsLateralKernel.setArg(argIndex++, _lateralWeights[_back]);
-		_learnWeightsLateralKernel.setArg(argIndex++, _lateralWeights[_front]);
-		_learnWeightsLateralKernel.setArg(argIndex++, _hiddenSize);
-		_learnWeightsLateralKernel.setArg(argIndex++, _lateralRadius);
-		_learnWeightsLateralKernel.setArg(argIndex++, weightLateralAlpha);
-		_learnWeightsLateralKernel.setArg(argIndex++, activeRatio * activeRatio);
-
-		cs.getQueue().enqueueNDRangeKernel(_learnWeightsLateralKernel, cl::NullRange, cl::NDRange(_hiddenSize.x, _hiddenSize.y));
-
-		std::swap(_lateralWeights[_front], _lateralWeights[_back]);
-	}
-}
-
-void SparseCoder::reconstruct(sys::ComputeSystem &cs, const cl::Image2D &hiddenStates, int visibleLayerIndex, cl::Image2D &visibleStates) {
-	VisibleLayer &vl = _visibleLayers[visibleLayerIndex];
-	VisibleLayerDesc &vld = _visibleLayerDescs[visibleLayerIndex];
-
-	int argIndex = 0;
-
-	_reconstructVisibleKernel.setArg(argIndex++, hiddenStates);
-	_reconstructVisibleKernel.setArg(argIndex++, visibleStates);
-	_reconstructVisibleKernel.setArg(argIndex++, vl._weights[_back]);
-	_reconstructVisibleKernel.setArg(argIndex++, vld._size);
-	_reconstructVisibleKernel.setArg(argIndex++, _hiddenSize);
-	_reconstructVisibleKernel.setArg(argIndex++, vl._visibleToHidden);
-	_reconstructVisibleKernel.setArg(argIndex++, vl._hiddenToVisible);
-	_reconstructVisibleKernel.setArg(argIndex++, vld._radius);
-	_reconstructVisibleKernel.setArg(argIndex++, vl._reverseRadii);
-
-	cs.getQueue().enqueueNDRangeKernel(_reconstructVisibleKernel, cl::NullRange, cl::NDRange(vld._size.x, vld._size.y));
+#include "SparseCoder.h"
+
+using namespace neo;
+
+void SparseCoder::createRandom(sys::ComputeSystem &cs, sys::ComputeProgram &program,
+	const std::vector<VisibleLayerDesc> &visibleLayerDescs, cl_int2 hiddenSize, cl_int lateralRadius, cl_float2 initWeightRange, cl_float2 initLateralWeightRange, cl_float initThreshold,
+	std::mt19937 &rng)
+{
+	if (!program.requireModules(cs, { "init", "sparseCoder" })) {
+		assert(false);
+
+		return;
+	}
+
+	MemoryScope scope("SparseCoder");
+
+	_visibleLayerDescs = visibleLayerDescs;
+
+	_hiddenSize = hiddenSize;
+
+	_lateralRadius = lateralRadius;
+
+	cl_float4 zeroColor = { 0.0f, 0.0f, 0.0f, 0.0f };
+	cl_float4 thresholdColor = { initThreshold, initThreshold, initThreshold, initThreshold };
+
+	cl::array<cl::size_type, 3> zeroOrigin = { 0, 0, 0 };
+	cl::array<cl::size_type, 3> hiddenRegion = { _hiddenSize.x, _hiddenSize.y, 1 };
+
+	_visibleLayers.resize(_visibleLayerDescs.size());
+
+	cl::Kernel randomUniform2DKernel = cl::Kernel(program.getProgram(), "randomUniform2D");
+	cl::Kernel randomUniform3DKernel = cl::Kernel(program.getProgram(), "randomUniform3D");
+	
+	// Create layers
+	for (int vli = 0; vli < _visibleLayers.size(); vli++) {
+		VisibleLayer &vl = _visibleLayers[vli];
+		VisibleLayerDesc &vld = _visibleLayerDescs[vli];
+
+		const cl_channel_order weightChannels = vld._useTraces ? CL_RG : CL_R;
+
+		vl._hiddenToVisible = cl_float2{ static_cast<float>(vld._size.x) / static_cast<float>(_hiddenSize.x),
+			static_cast<float>(vld._size.y) / static_cast<float>(_hiddenSize.y)
+		};
+
+		vl._visibleToHidden = cl_float2{ static_cast<float>(_hiddenSize.x) / static_cast<float>(vld._size.x),
+			static_cast<float>(_hiddenSize.y) / static_cast<float>(vld._size.y)
+		};
+
+		vl._reverseRadii = cl_int2 { static_cast<int>(std::ceil(vl._visibleToHidden.x * vld._radius)), static_cast<int>(std::ceil(vl._visibleToHidden.y * vld._radius)) };
+
+		// Create images
+		int weightDiam = vld._radius * 2 + 1;
+
+		int numWeights = weightDiam * weightDiam;
+
+		cl_int3 weightsSize = cl_int3{ _hiddenSize.x, _hiddenSize.y, numWeights };
+
+		vl._weights = createDoubleBuffer3D(cs, weightsSize, weightChannels, CL_FLOAT, "weights");
+
+		randomUniform(vl._weights[_back], cs, randomUniform3DKernel, weightsSize, initWeightRange, rng);
+
+		if (vld._useTraces && vld._lazyTraces) {
+			vl._pendingTraces = createDoubleBuffer2D(cs, _hiddenSize, CL_RG, CL_FLOAT, "pendingTraces");
+
+			cs.getQueue().enqueueFillImage(vl._pendingTraces[_back], cl_float4{ 0.0f, 1.0f, 0.0f, 0.0f }, zeroOrigin, hiddenRegion);
+		}
+	}
+
+	_noPendingTraces = createImage2D(cs, { 1, 1 }, CL_RG, CL_FLOAT, "noPendingTraces");
+
+	// Hidden state data
+	_hiddenStates = createDoubleBuffer2D(cs, _hiddenSize, CL_R, CL_FLOAT, "hiddenStates");
+	_hiddenSpikes = createDoubleBuffer2D(cs, _hiddenSize, CL_R, CL_FLOAT, "hiddenSpikes");
+	_hiddenActivations = createDoubleBuffer2D(cs, _hiddenSize, CL_R, CL_FLOAT, "hiddenActivations");
+
+	_hiddenThresholds = createDoubleBuffer2D(cs, _hiddenSize, CL_R, CL_FLOAT, "hiddenThresholds");
+
+	_hiddenSummationTemp = createDoubleBuffer2D(cs, _hiddenSize, CL_R, CL_FLOAT, "hiddenSummationTemp");
+
+	{
+		int lateralWeightDiam = lateralRadius * 2 + 1;
+
+		int numLateralWeights = lateralWeightDiam * lateralWeightDiam;
+
+		cl_int3 lateralWeightsSize = cl_int3 { _hiddenSize.x, _hiddenSize.y, numLateralWeights };
+
+		_lateralWeights = createDoubleBuffer3D(cs, lateralWeightsSize, CL_R, CL_FLOAT, "lateralWeights");
+	
+		randomUniform(_lateralWeights[_back], cs, randomUniform3DKernel, lateralWeightsSize, initLateralWeightRange, rng);
+	}
+
+	cs.getQueue().enqueueFillImage(_hiddenThresholds[_back], thresholdColor, zeroOrigin, hiddenRegion);
+
+	cs.getQueue().enqueueFillImage(_hiddenSpikes[_back], zeroColor, zeroOrigin, hiddenRegion);
+	cs.getQueue().enqueueFillImage(_hiddenStates[_back], zeroColor, zeroOrigin, hiddenRegion);
+	cs.getQueue().enqueueFillImage(_hiddenActivations[_back], zeroColor, zeroOrigin, hiddenRegion);
+
+	// Create kernels
+	_reconstructVisibleKernel = cl::Kernel(program.getProgram(), "scReconstructVisible");
+	_activateKernel = cl::Kernel(program.getProgram(), "scActivate");
+	_activate2Kernel = cl::Kernel(program.getProgram(), "scActivate2");
+	_solveHiddenKernel = cl::Kernel(program.getProgram(), "scSolveHidden");
+	_solveHiddenPersistentKernel = cl::Kernel(program.getProgram(), "scSolveHiddenPersistent");
+	_learnThresholdsKernel = cl::Kernel(program.getProgram(), "scLearnThresholds");
+	_learnWeightsKernel = cl::Kernel(program.getProgram(), "scLearnSparseCoderWeights");
+	_learnWeightsActiveKernel = cl::Kernel(program.getProgram(), "scLearnSparseCoderWeightsActive");
+	_learnWeightsTracesKernel = cl::Kernel(program.getProgram(), "scLearnSparseCoderWeightsTraces");
+	_learnWeightsTracesLazyKernel = cl::Kernel(program.getProgram(), "scLearnSparseCoderWeightsTracesLazy");
+	_advanceLazyTracesKernel = cl::Kernel(program.getProgram(), "scAdvanceLazyTraces");
+	_flushLazyTracesKernel = cl::Kernel(program.getProgram(), "scFlushLazyTraces");
+	_learnWeightsLateralKernel = cl::Kernel(program.getProgram(), "scLearnSparseCoderWeightsLateral");
+
+	// The single launch solver can only be used if the spikes and activations of the whole layer fit in local memory
+	{
+		cl::size_type numHidden = _hiddenSize.x * _hiddenSize.y;
+
+		cl::size_type localMemRequired = numHidden * (2 * sizeof(cl_uchar) + sizeof(cl_float));
+
+		cl::size_type maxGroupSize = _solveHiddenPersistentKernel.getWorkGroupInfo<CL_KERNEL_WORK_GROUP_SIZE>(cs.getDevice());
+
+		if (localMemRequired <= cs.getDevice().getInfo<CL_DEVICE_LOCAL_MEM_SIZE>())
+			_persistentSolveGroupSize = std::min(numHidden, maxGroupSize);
+		else
+			_persistentSolveGroupSize = 0;
+	}
+
+	_persistentSolve = false;
+
+	createActiveUnitList(_activeUnits, cs, program, _hiddenSize);
+
+	_solveStats = createBuffer(cs, CL_MEM_READ_WRITE, 5 * sizeof(cl_int), "solveStats");
+
+	resetSolveStats(cs);
+}
+
+void SparseCoder::activate(sys::ComputeSystem &cs, const std::vector<cl::Image2D> &visibleStates, cl_int iterations, cl_float leak, cl_int convergenceCheckInterval) {
+	const bool persistent = usesPersistentSolver() && iterations > 0;
+
+	// Clear previous aggregate state information (the persistent solver starts from zero on its own)
+	if (!persistent) {
+		cl_float4 zeroColor = { 0.0f, 0.0f, 0.0f, 0.0f };
+
+		cl::array<cl::size_type, 3> zeroOrigin = { 0, 0, 0 };
+		cl::array<cl::size_type, 3> hiddenRegion = { _hiddenSize.x, _hiddenSize.y, 1 };
+
+		cs.getQueue().enqueueFillImage(_hiddenStates[_back], zeroColor, zeroOrigin, hiddenRegion);
+		cs.getQueue().enqueueFillImage(_hiddenActivations[_back], zeroColor, zeroOrigin, hiddenRegion);
+	}
+
+	// Sum visible layers two at a time with the fused kernel, the first pair starts from zero
+	int vli = 0;
+
+	for (; vli + 1 < _visibleLayers.size(); vli += 2) {
+		VisibleLayer &vl0 = _visibleLayers[vli];
+		VisibleLayerDesc &vld0 = _visibleLayerDescs[vli];
+		VisibleLayer &vl1 = _visibleLayers[vli + 1];
+		VisibleLayerDesc &vld1 = _visibleLayerDescs[vli + 1];
+
+		int argIndex = 0;
+
+		_activate2Kernel.setArg(argIndex++, visibleStates[vli]);
+		_activate2Kernel.setArg(argIndex++, visibleStates[vli + 1]);
+		_activate2Kernel.setArg(argIndex++, _hiddenSummationTemp[_back]);
+		_activate2Kernel.setArg(argIndex++, _hiddenSummationTemp[_front]);
+		_activate2Kernel.setArg(argIndex++, vl0._weights[_back]);
+		_activate2Kernel.setArg(argIndex++, vl1._weights[_back]);
+		_activate2Kernel.setArg(argIndex++, getPendingTracesArg(vli));
+		_activate2Kernel.setArg(argIndex++, getPendingTracesArg(vli + 1));
+		_activate2Kernel.setArg(argIndex++, vld0._size);
+		_activate2Kernel.setArg(argIndex++, vld1._size);
+		_activate2Kernel.setArg(argIndex++, vl0._hiddenToVisible);
+		_activate2Kernel.setArg(argIndex++, vl1._hiddenToVisible);
+		_activate2Kernel.setArg(argIndex++, vld0._radius);
+		_activate2Kernel.setArg(argIndex++, vld1._radius);
+		_activate2Kernel.setArg(argIndex++, static_cast<cl_uchar>(usesLazyTraces(vli)));
+		_activate2Kernel.setArg(argIndex++, static_cast<cl_uchar>(usesLazyTraces(vli + 1)));
+		_activate2Kernel.setArg(argIndex++, static_cast<cl_uchar>(vli != 0));
+
+		cs.getQueue().enqueueNDRangeKernel(_activate2Kernel, cl::NullRange, cl::NDRange(_hiddenSize.x, _hiddenSize.y));
+
+		// Swap buffers
+		std::swap(_hiddenSummationTemp[_front], _hiddenSummationTemp[_back]);
+	}
+
+	// Odd layer out (or no layers at all)
+	if (_visibleLayers.size() < 2) {
+		cl_float4 zeroColor = { 0.0f, 0.0f, 0.0f, 0.0f };
+
+		cl::array<cl::size_type, 3> zeroOrigin = { 0, 0, 0 };
+		cl::array<cl::size_type, 3> hiddenRegion = { _hiddenSize.x, _hiddenSize.y, 1 };
+
+		cs.getQueue().enqueueFillImage(_hiddenSummationTemp[_back], zeroColor, zeroOrigin, hiddenRegion);
+	}
+
+	if (vli < _visibleLayers.size()) {
+		VisibleLayer &vl = _visibleLayers[vli];
+		VisibleLayerDesc &vld = _visibleLayerDescs[vli];
+
+		int argIndex = 0;
+
+		_activateKernel.setArg(argIndex++, visibleStates[vli]);
+		_activateKernel.setArg(argIndex++, _hiddenSummationTemp[_back]);
+		_activateKernel.setArg(argIndex++, _hiddenSummationTemp[_front]);
+		_activateKernel.setArg(argIndex++, vl._weights[_back]);
+		_activateKernel.setArg(argIndex++, getPendingTracesArg(vli));
+		_activateKernel.setArg(argIndex++, vld._size);
+		_activateKernel.setArg(argIndex++, vl._hiddenToVisible);
+		_activateKernel.setArg(argIndex++, vld._radius);
+		_activateKernel.setArg(argIndex++, static_cast<cl_uchar>(usesLazyTraces(vli)));
+
+		cs.getQueue().enqueueNDRangeKernel(_activateKernel, cl::NullRange, cl::NDRange(_hiddenSize.x, _hiddenSize.y));
+
+		// Swap buffers
+		std::swap(_hiddenSummationTemp[_front], _hiddenSummationTemp[_back]);
+	}
+
+	// Small layers solve all iterations in one work group
+	if (persistent) {
+		int argIndex = 0;
+
+		cl::size_type numHidden = _hiddenSize.x * _hiddenSize.y;
+
+		_solveHiddenPersistentKernel.setArg(argIndex++, _hiddenSummationTemp[_back]);
+		_solveHiddenPersistentKernel.setArg(argIndex++, _hiddenSpikes[_back]);
+		_solveHiddenPersistentKernel.setArg(argIndex++, _hiddenSpikes[_front]);
+		_solveHiddenPersistentKernel.setArg(argIndex++, _hiddenStates[_front]);
+		_solveHiddenPersistentKernel.setArg(argIndex++, _hiddenActivations[_front]);
+		_solveHiddenPersistentKernel.setArg(argIndex++, _hiddenThresholds[_back]);
+		_solveHiddenPersistentKernel.setArg(argIndex++, _lateralWeights[_back]);
+		_solveHiddenPersistentKernel.setArg(argIndex++, cl::Local(numHidden * sizeof(cl_uchar)));
+		_solveHiddenPersistentKernel.setArg(argIndex++, cl::Local(numHidden * sizeof(cl_uchar)));
+		_solveHiddenPersistentKernel.setArg(argIndex++, cl::Local(numHidden * sizeof(cl_float)));
+		_solveHiddenPersistentKernel.setArg(argIndex++, _solveStats);
+		_solveHiddenPersistentKernel.setArg(argIndex++, _hiddenSize);
+		_solveHiddenPersistentKernel.setArg(argIndex++, _lateralRadius);
+		_solveHiddenPersistentKernel.setArg(argIndex++, leak);
+		_solveHiddenPersistentKernel.setArg(argIndex++, iterations);
+		_solveHiddenPersistentKernel.setArg(argIndex++, static_cast<cl_uchar>(convergenceCheckInterval > 0));
+
+		cs.getQueue().enqueueNDRangeKernel(_solveHiddenPersistentKernel, cl::NullRange, cl::NDRange(_persistentSolveGroupSize), cl::NDRange(_persistentSolveGroupSize));
+
+		// Swap hidden state buffers
+		std::swap(_hiddenSpikes[_front], _hiddenSpikes[_back]);
+		std::swap(_hiddenStates[_front], _hiddenStates[_back]);
+		std::swap(_hiddenActivations[_front], _hiddenActivations[_back]);
+
+		return;
+	}
+
+	cl_int iterationsUsed = iterations;
+
+	if (convergenceCheckInterval > 0)
+		cs.getQueue().enqueueFillBuffer<cl_int>(_solveStats, 0, 0, sizeof(cl_int));
+
+	for (cl_int iter = 0; iter < iterations; iter++) {		
+		// Back now contains the sums. Solve sparse codes from this
+		{
+			int argIndex = 0;
+
+			_solveHiddenKernel.setArg(argIndex++, _hiddenSummationTemp[_back]);
+			_solveHiddenKernel.setArg(argIndex++, _hiddenSpikes[_back]);
+			_solveHiddenKernel.setArg(argIndex++, _hiddenSpikes[_front]);
+			_solveHiddenKernel.setArg(argIndex++, _hiddenStates[_back]);
+			_solveHiddenKernel.setArg(argIndex++, _hiddenStates[_front]);
+			_solveHiddenKernel.setArg(argIndex++, _hiddenActivations[_back]);
+			_solveHiddenKernel.setArg(argIndex++, _hiddenActivations[_front]);
+			_solveHiddenKernel.setArg(argIndex++, _hiddenThresholds[_back]);
+			_solveHiddenKernel.setArg(argIndex++, _lateralWeights[_back]);
+			_solveHiddenKernel.setArg(argIndex++, _solveStats);
+			_solveHiddenKernel.setArg(argIndex++, _hiddenSize);
+			_solveHiddenKernel.setArg(argIndex++, _lateralRadius);
+			_solveHiddenKernel.setArg(argIndex++, leak);
+			_solveHiddenKernel.setArg(argIndex++, 1.0f / (1.0f + iter));
+			_solveHiddenKernel.setArg(argIndex++, static_cast<cl_uchar>(convergenceCheckInterval > 0));
+
+			cs.getQueue().enqueueNDRangeKernel(_solveHiddenKernel, cl::NullRange, cl::NDRange(_hiddenSize.x, _hiddenSize.y));
+		}
+
+		// Swap hidden state buffers
+		std::swap(_hiddenSpikes[_front], _hiddenSpikes[_back]);
+		std::swap(_hiddenStates[_front], _hiddenStates[_back]);
+		std::swap(_hiddenActivations[_front], _hiddenActivations[_back]);
+
+		// Check whether any spike changed during the last interval, this synchronizes with the device
+		if (convergenceCheckInterval > 0 && (iter + 1) % convergenceCheckInterval == 0 && iter + 1 < iterations) {
+			cl_int spikesChanged;
+
+			cs.getQueue().enqueueReadBuffer(_solveStats, CL_TRUE, 0, sizeof(cl_int), &spikesChanged);
+
+			if (spikesChanged == 0) {
+				iterationsUsed = iter + 1;
+
+				break;
+			}
+
+			cs.getQueue().enqueueFillBuffer<cl_int>(_solveStats, 0, 0, sizeof(cl_int));
+		}
+	}
+
+	_hostSolveStats._totalIterations += iterationsUsed;
+	_hostSolveStats._minIterations = _hostSolveStats._steps == 0 ? iterationsUsed : std::min(_hostSolveStats._minIterations, iterationsUsed);
+	_hostSolveStats._maxIterations = std::max(_hostSolveStats._maxIterations, iterationsUsed);
+	_hostSolveStats._steps++;
+}
+
+SparseCoder::SolveStats SparseCoder::getSolveStats(sys::ComputeSystem &cs) const {
+	cl_int deviceStats[5];
+
+	cs.getQueue().enqueueReadBuffer(_solveStats, CL_TRUE, 0, 5 * sizeof(cl_int), deviceStats);
+
+	SolveStats stats = _hostSolveStats;
+
+	// Merge in the steps solved by the persistent kernel
+	if (deviceStats[2] > 0) {
+		stats._minIterations = stats._steps == 0 ? deviceStats[4] : std::min(stats._minIterations, deviceStats[4]);
+		stats._maxIterations = std::max(stats._maxIterations, deviceStats[3]);
+		stats._totalIterations += deviceStats[1];
+		stats._steps += deviceStats[2];
+	}
+
+	return stats;
+}
+
+void SparseCoder::resetSolveStats(sys::ComputeSystem &cs) {
+	cl_int deviceStats[5] = { 0, 0, 0, 0, std::numeric_limits<cl_int>::max() };
+
+	cs.getQueue().enqueueWriteBuffer(_solveStats, CL_TRUE, 0, 5 * sizeof(cl_int), deviceStats);
+
+	_hostSolveStats = SolveStats();
+}
+
+void SparseCoder::learn(sys::ComputeSystem &cs, const std::vector<cl::Image2D> &visibleStates, float weightLateralAlpha, float thresholdAlpha, float activeRatio) {
+	// Learn Thresholds
+	{
+		int argIndex = 0;
+
+		_learnThresholdsKernel.setArg(argIndex++, _hiddenThresholds[_back]);
+		_learnThresholdsKernel.setArg(argIndex++, _hiddenThresholds[_front]);
+		_learnThresholdsKernel.setArg(argIndex++, _hiddenStates[_back]);
+		_learnThresholdsKernel.setArg(argIndex++, thresholdAlpha);
+		_learnThresholdsKernel.setArg(argIndex++, activeRatio);
+
+		cs.getQueue().enqueueNDRangeKernel(_learnThresholdsKernel, cl::NullRange, cl::NDRange(_hiddenSize.x, _hiddenSize.y));
+
+		std::swap(_hiddenThresholds[_front], _hiddenThresholds[_back]);
+	}
+
+	// Learn weights, only spiking units have a nonzero update
+	compactActiveUnits(_activeUnits, cs, _hiddenStates[_back], _hiddenSize);
+
+	for (int vli = 0; vli < _visibleLayers.size(); vli++) {
+		VisibleLayer &vl = _visibleLayers[vli];
+		VisibleLayerDesc &vld = _visibleLayerDescs[vli];
+
+		learnWeightsActive(cs, visibleStates[vli], vl, vld);
+	}
+
+	// Learn lateral weights
+	{
+		int argIndex = 0;
+
+		_learnWeightsLateralKernel.setArg(argIndex++, _hiddenStates[_back]);
+		_learnWeightsLateralKernel.setArg(argIndex++, _lateralWeights[_back]);
+		_learnWeightsLateralKernel.setArg(argIndex++, _lateralWeights[_front]);
+		_learnWeightsLateralKernel.setArg(argIndex++, _hiddenSize);
+		_learnWeightsLateralKernel.setArg(argIndex++, _lateralRadius);
+		_learnWeightsLateralKernel.setArg(argIndex++, weightLateralAlpha);
+		_learnWeightsLateralKernel.setArg(argIndex++, activeRatio * activeRatio);
+
+		cs.getQueue().enqueueNDRangeKernel(_learnWeightsLateralKernel, cl::NullRange, cl::NDRange(_hiddenSize.x, _hiddenSize.y));
+
+		std::swap(_lateralWeights[_front], _lateralWeights[_back]);
+	}
+}
+
+void SparseCoder::learn(sys::ComputeSystem &cs, const cl::Image2D &rewards, const std::vector<cl::Image2D> &visibleStates, float weightLateralAlpha, float thresholdAlpha, float activeRatio) {
+	// Learn Thresholds
+	{
+		int argIndex = 0;
+
+		_learnThresholdsKernel.setArg(argIndex++, _hiddenThresholds[_back]);
+		_learnThresholdsKernel.setArg(argIndex++, _hiddenThresholds[_front]);
+		_learnThresholdsKernel.setArg(argIndex++, _hiddenStates[_back]);
+		_learnThresholdsKernel.setArg(argIndex++, thresholdAlpha);
+		_learnThresholdsKernel.setArg(argIndex++, activeRatio);
+
+		cs.getQueue().enqueueNDRangeKernel(_learnThresholdsKernel, cl::NullRange, cl::NDRange(_hiddenSize.x, _hiddenSize.y));
+
+		std::swap(_hiddenThresholds[_front], _hiddenThresholds[_back]);
+	}
+
+	// Learn weights, without traces (or with lazy traces) only spiking units need their rows updated
+	compactActiveUnits(_activeUnits, cs, _hiddenStates[_back], _hiddenSize);
+
+	for (int vli = 0; vli < _visibleLayers.size(); vli++) {
+		VisibleLayer &vl = _visibleLayers[vli];
+		VisibleLayerDesc &vld = _visibleLayerDescs[vli];
+
+		if (vld._useTraces && vld._lazyTraces) {
+			// Bring spiking rows up to date and learn on them
+			{
+				int argIndex = 0;
+
+				_learnWeightsTracesLazyKernel.setArg(argIndex++, visibleStates[vli]);
+				_learnWeightsTracesLazyKernel.setArg(argIndex++, _hiddenStates[_back]);
+				_learnWeightsTracesLazyKernel.setArg(argIndex++, vl._weights[_back]);
+				_learnWeightsTracesLazyKernel.setArg(argIndex++, vl._weights[_front]);
+				_learnWeightsTracesLazyKernel.setArg(argIndex++, rewards);
+				_learnWeightsTracesLazyKernel.setArg(argIndex++, vl._pendingTraces[_back]);
+				_learnWeightsTracesLazyKernel.setArg(argIndex++, _activeUnits._count);
+				_learnWeightsTracesLazyKernel.setArg(argIndex++, _activeUnits._units);
+				_learnWeightsTracesLazyKernel.setArg(argIndex++, vld._size);
+				_learnWeightsTracesLazyKernel.setArg(argIndex++, vl._hiddenToVisible);
+				_learnWeightsTracesLazyKernel.setArg(argIndex++, vld._radius);
+				_learnWeightsTracesLazyKernel.setArg(argIndex++, vld._weightAlpha);
+				_learnWeightsTracesLazyKernel.setArg(argIndex++, vld._weightLambda);
+
+				cs.getQueue().enqueueNDRangeKernel(_learnWeightsTracesLazyKernel, cl::NullRange, cl::NDRange(_hiddenSize.x * _hiddenSize.y));
+
+				int weightDiam = vld._radius * 2 + 1;
+
+				copyActiveSlices(_activeUnits, cs, vl._weights[_front], vl._weights[_back], _hiddenSize, weightDiam * weightDiam);
+			}
+
+			// Silent rows only accumulate decay and reward
+			{
+				int argIndex = 0;
+
+				_advanceLazyTracesKernel.setArg(argIndex++, _hiddenStates[_back]);
+				_advanceLazyTracesKernel.setArg(argIndex++, rewards);
+				_advanceLazyTracesKernel.setArg(argIndex++, vl._pendingTraces[_back]);
+				_advanceLazyTracesKernel.setArg(argIndex++, vl._pendingTraces[_front]);
+				_advanceLazyTracesKernel.setArg(argIndex++, vld._weightLambda);
+
+				cs.getQueue().enqueueNDRangeKernel(_advanceLazyTracesKernel, cl::NullRange, cl::NDRange(_hiddenSize.x, _hiddenSize.y));
+
+				std::swap(vl._pendingTraces[_front], vl._pendingTraces[_back]);
+			}
+		}
+		else if (vld._useTraces) {
+			int argIndex = 0;
+
+			_learnWeightsTracesKernel.setArg(argIndex++, visibleStates[vli]);
+			_learnWeightsTracesKernel.setArg(argIndex++, _hiddenStates[_back]);
+			_learnWeightsTracesKernel.setArg(argIndex++, vl._weights[_back]);
+			_learnWeightsTracesKernel.setArg(argIndex++, vl._weights[_front]);
+			_learnWeightsTracesKernel.setArg(argIndex++, rewards);
+			_learnWeightsTracesKernel.setArg(argIndex++, vld._size);
+			_learnWeightsTracesKernel.setArg(argIndex++, vl._hiddenToVisible);
+			_learnWeightsTracesKernel.setArg(argIndex++, vld._radius);
+			_learnWeightsTracesKernel.setArg(argIndex++, vld._weightAlpha);
+			_learnWeightsTracesKernel.setArg(argIndex++, vld._weightLambda);
+
+			cs.getQueue().enqueueNDRangeKernel(_learnWeightsTracesKernel, cl::NullRange, cl::NDRange(_hiddenSize.x, _hiddenSize.y));
+
+			std::swap(vl._weights[_front], vl._weights[_back]);
+		}
+		else
+			learnWeightsActive(cs, visibleStates[vli], vl, vld);
+	}
+
+	// Learn lateral weights
+	{
+		int argIndex = 0;
+
+		_learnWeightsLateralKernel.setArg(argIndex++, _hiddenStates[_back]);
+		_learnWeightsLateralKernel.setArg(argIndex++, _lateralWeights[_back]);
+		_learnWeightsLateralKernel.setArg(argIndex++, _lateralWeights[_front]);
+		_learnWeightsLateralKernel.setArg(argIndex++, _hiddenSize);
+		_learnWeightsLateralKernel.setArg(argIndex++, _lateralRadius);
+		_learnWeightsLateralKernel.setArg(argIndex++, weightLateralAlpha);
+		_learnWeightsLateralKernel.setArg(argIndex++, activeRatio * activeRatio);
+
+		cs.getQueue().enqueueNDRangeKernel(_learnWeightsLateralKernel, cl::NullRange, cl::NDRange(_hiddenSize.x, _hiddenSize.y));
+
+		std::swap(_lateralWeights[_front], _lateralWeights[_back]);
+	}
+}
+
+void SparseCoder::learnWeightsActive(sys::ComputeSystem &cs, const cl::Image2D &visibleStates, VisibleLayer &vl, const VisibleLayerDesc &vld) {
+	int argIndex = 0;
+
+	_learnWeightsActiveKernel.setArg(argIndex++, visibleStates);
+	_learnWeightsActiveKernel.setArg(argIndex++, _hiddenStates[_back]);
+	_learnWeightsActiveKernel.setArg(argIndex++, vl._weights[_back]);
+	_learnWeightsActiveKernel.setArg(argIndex++, vl._weights[_front]);
+	_learnWeightsActiveKernel.setArg(argIndex++, _activeUnits._count);
+	_learnWeightsActiveKernel.setArg(argIndex++, _activeUnits._units);
+	_learnWeightsActiveKernel.setArg(argIndex++, vld._size);
+	_learnWeightsActiveKernel.setArg(argIndex++, vl._hiddenToVisible);
+	_learnWeightsActiveKernel.setArg(argIndex++, vld._radius);
+	_learnWeightsActiveKernel.setArg(argIndex++, vld._weightAlpha);
+
+	cs.getQueue().enqueueNDRangeKernel(_learnWeightsActiveKernel, cl::NullRange, cl::NDRange(_hiddenSize.x * _hiddenSize.y));
+
+	// Only the active slices changed, copy those back instead of swapping
+	int weightDiam = vld._radius * 2 + 1;
+
+	copyActiveSlices(_activeUnits, cs, vl._weights[_front], vl._weights[_back], _hiddenSize, weightDiam * weightDiam);
+}
+
+void SparseCoder::flushLazyTraces(sys::ComputeSystem &cs) {
+	cl::array<cl::size_type, 3> zeroOrigin = { 0, 0, 0 };
+	cl::array<cl::size_type, 3> hiddenRegion = { _hiddenSize.x, _hiddenSize.y, 1 };
+
+	for (int vli = 0; vli < _visibleLayers.size(); vli++) {
+		VisibleLayer &vl = _visibleLayers[vli];
+		VisibleLayerDesc &vld = _visibleLayerDescs[vli];
+
+		if (!vld._useTraces || !vld._lazyTraces)
+			continue;
+
+		int weightDiam = vld._radius * 2 + 1;
+
+		int argIndex = 0;
+
+		_flushLazyTracesKernel.setArg(argIndex++, vl._weights[_back]);
+		_flushLazyTracesKernel.setArg(argIndex++, vl._weights[_front]);
+		_flushLazyTracesKernel.setArg(argIndex++, vl._pendingTraces[_back]);
+		_flushLazyTracesKernel.setArg(argIndex++, weightDiam * weightDiam);
+
+		cs.getQueue().enqueueNDRangeKernel(_flushLazyTracesKernel, cl::NullRange, cl::NDRange(_hiddenSize.x, _hiddenSize.y));
+
+		std::swap(vl._weights[_front], vl._weights[_back]);
+
+		cs.getQueue().enqueueFillImage(vl._pendingTraces[_back], cl_float4{ 0.0f, 1.0f, 0.0f, 0.0f }, zeroOrigin, hiddenRegion);
+	}
+}
+
+void SparseCoder::reconstruct(sys::ComputeSystem &cs, const cl::Image2D &hiddenStates, int visibleLayerIndex, cl::Image2D &visibleStates) {
+	VisibleLayer &vl = _visibleLayers[visibleLayerIndex];
+	VisibleLayerDesc &vld = _visibleLayerDescs[visibleLayerIndex];
+
+	int argIndex = 0;
+
+	_reconstructVisibleKernel.setArg(argIndex++, hiddenStates);
+	_reconstructVisibleKernel.setArg(argIndex++, visibleStates);
+	_reconstructVisibleKernel.setArg(argIndex++, vl._weights[_back]);
+	_reconstructVisibleKernel.setArg(argIndex++, getPendingTracesArg(visibleLayerIndex));
+	_reconstructVisibleKernel.setArg(argIndex++, vld._size);
+	_reconstructVisibleKernel.setArg(argIndex++, _hiddenSize);
+	_reconstructVisibleKernel.setArg(argIndex++, vl._visibleToHidden);
+	_reconstructVisibleKernel.setArg(argIndex++, vl._hiddenToVisible);
+	_reconstructVisibleKernel.setArg(argIndex++, vld._radius);
+	_reconstructVisibleKernel.setArg(argIndex++, vl._reverseRadii);
+	_reconstructVisibleKernel.setArg(argIndex++, static_cast<cl_uchar>(usesLazyTraces(visibleLayerIndex)));
+
+	cs.getQueue().enqueueNDRangeKernel(_reconstructVisibleKernel, cl::NullRange, cl::NDRange(vld._size.x, vld._size.y));
 }
\ No newline at end of file
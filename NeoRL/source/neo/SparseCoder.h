@@ -1,199 +1,336 @@
-#pragma once
-
-#include "Helpers.h"
-
-namespace neo {
-	/*!
-	\brief Sparse coder
-	Performs iterative sparse coding with explaining-away
-	*/
-	class SparseCoder {
-	public:
-		/*!
-		\brief Visible layer desc
-		*/
-		struct VisibleLayerDesc {
-			/*!
-			\brief Size of layer
-			*/
-			cl_int2 _size;
-
-			/*!
-			\brief Radius
-			*/
-			cl_int _radius;
-
-			//!@{
-			/*!
-			\brief Learning parameters
-			*/
-			cl_float _weightAlpha;
-			cl_float _weightLambda;
-			//!@}
-
-			/*!
-			\brief Whether or not to ignore middle node
-			When recurrent, ignore middle node (self) if desired
-			*/
-			bool _ignoreMiddle;
-
-			/*!
-			\brief Whether or not to use eligibility traces
-			*/
-			bool _useTraces;
-
-			/*!
-			\brief Initialize defaults
-			*/
-			VisibleLayerDesc()
-				: _size({ 8, 8 }), _radius(4), _weightAlpha(0.01f), _weightLambda(0.95f),
-				_ignoreMiddle(false), _useTraces(false)
-			{}
-		};
-
-		/*!
-		\brief Visible layer
-		*/
-		struct VisibleLayer {
-			/*!
-			\brief Weights
-			*/
-			DoubleBuffer3D _weights;
-
-			//!@{
-			/*!
-			\brief Transformations
-			*/
-			cl_float2 _hiddenToVisible;
-			cl_float2 _visibleToHidden;
-			//!@}
-
-			/*!
-			\brief Radius onto hidden (reverse from visible layer desc)
-			*/
-			cl_int2 _reverseRadii;
-		};
-
-	private:
-		//!@{
-		/*!
-		\brief Spiking, resulting state, activations, and neuron threshold buffers
-		*/
-		DoubleBuffer2D _hiddenSpikes;
-		DoubleBuffer2D _hiddenStates;
-		DoubleBuffer2D _hiddenActivations;
-		DoubleBuffer2D _hiddenThresholds;
-		//!@}
-
-		/*!
-		\brief Lateral (inhibition) weights
-		*/
-		DoubleBuffer3D _lateralWeights;
-
-		/*!
-		\brief Lateral (inhibition) radius
-		*/
-		cl_int _lateralRadius;
-
-		/*!
-		\brief Hidden size
-		*/
-		cl_int2 _hiddenSize;
-
-		/*!
-		\brief Summation temporary buffer
-		*/
-		DoubleBuffer2D _hiddenSummationTemp;
-
-		//!@{
-		/*!
-		\brief Visible layers and descs
-		*/
-		std::vector<VisibleLayerDesc> _visibleLayerDescs;
-		std::vector<VisibleLayer> _visibleLayers;
-		//!@}
-
-		//!@{
-		/*!
-		\brief Kernels
-		*/
-		cl::Kernel _reconstructVisibleKernel;
-		cl::Kernel _activateKernel;
-		cl::Kernel _solveHiddenKernel;
-		cl::Kernel _learnThresholdsKernel;
-		cl::Kernel _learnWeightsKernel;
-		cl::Kernel _learnWeightsTracesKernel;
-		cl::Kernel _learnWeightsLateralKernel;
-		//!@}
-
-	public:
-		/*!
-		\brief Create a comparison sparse coder with random initialization
-		Requires the compute system, program with the NeoRL kernels, and initialization information
-		*/
-		void createRandom(sys::ComputeSystem &cs, sys::ComputeProgram &program,
-			const std::vector<VisibleLayerDesc> &visibleLayerDescs, cl_int2 hiddenSize, cl_int lateralRadius, cl_float2 initWeightRange, cl_float2 initLateralWeightRange, cl_float initThreshold,
-			std::mt19937 &rng);
-
-		/*!
-		\brief Create a comparison sparse coder with random initialization
-		Requires the compute system, program with the NeoRL kernels, and initialization information
-		*/
-		void activate(sys::ComputeSystem &cs, const std::vector<cl::Image2D> &visibleStates, cl_int iterations, cl_float leak);
-
-		//!@{
-		/*!
-		\brief Learn functions, with and without eligibility traces/rewards
-		*/
-		void learn(sys::ComputeSystem &cs, const std::vector<cl::Image2D> &visibleStates, float weightLateralAlpha, float thresholdAlpha, float activeRatio);
-		void learn(sys::ComputeSystem &cs, const cl::Image2D &rewards, const std::vector<cl::Image2D> &visibleStates, float weightLateralAlpha, float thresholdAlpha, float activeRatio);
-		//!@}
-
-		/*!
-		\brief Reconstruct (find input from sparse codes)
-		*/
-		void reconstruct(sys::ComputeSystem &cs, const cl::Image2D &hiddenStates, int visibleLayerIndex, cl::Image2D &visibleStates);
-
-		/*!
-		\brief Get number of visible layers
-		*/
-		size_t getNumVisibleLayers() const {
-			return _visibleLayers.size();
-		}
-
-		/*!
-		\brief Get access to a visible layer
-		*/
-		const VisibleLayer &getVisibleLayer(int index) const {
-			return _visibleLayers[index];
-		}
-
-		/*!
-		\brief Get visible layer descs
-		*/
-		const VisibleLayerDesc &getVisibleLayerDesc(int index) const {
-			return _visibleLayerDescs[index];
-		}
-
-		/*!
-		\brief Get hidden size
-		*/
-		cl_int2 getHiddenSize() const {
-			return _hiddenSize;
-		}
-
-		/*!
-		\brief Get hidden states
-		*/
-		const DoubleBuffer2D &getHiddenStates() const {
-			return _hiddenStates;
-		}
-
-		/*!
-		\brief Get hidden thresholds
-		*/
-		const DoubleBuffer2D &getHiddenThresholds() const {
-			return _hiddenThresholds;
-		}
-	};
+#pragma once
+
+#include "Helpers.h"
+
+#include <limits>
+
+namespace neo {
+	/*!
+	\brief Sparse coder
+	Performs iterative sparse coding with explaining-away
+	*/
+	class SparseCoder {
+	public:
+		/*!
+		\brief Visible layer desc
+		*/
+		struct VisibleLayerDesc {
+			/*!
+			\brief Size of layer
+			*/
+			cl_int2 _size;
+
+			/*!
+			\brief Radius
+			*/
+			cl_int _radius;
+
+			//!@{
+			/*!
+			\brief Learning parameters
+			*/
+			cl_float _weightAlpha;
+			cl_float _weightLambda;
+			//!@}
+
+			/*!
+			\brief Whether or not to ignore middle node
+			When recurrent, ignore middle node (self) if desired
+			*/
+			bool _ignoreMiddle;
+
+			/*!
+			\brief Whether or not to use eligibility traces
+			*/
+			bool _useTraces;
+
+			/*!
+			\brief Whether to decay traces lazily (only with _useTraces)
+			Weight rows of silent units are then only touched when they spike again, reward learning cost scales with activity
+			*/
+			bool _lazyTraces;
+
+			/*!
+			\brief Initialize defaults
+			*/
+			VisibleLayerDesc()
+				: _size({ 8, 8 }), _radius(4), _weightAlpha(0.01f), _weightLambda(0.95f),
+				_ignoreMiddle(false), _useTraces(false), _lazyTraces(false)
+			{}
+		};
+
+		/*!
+		\brief Visible layer
+		*/
+		struct VisibleLayer {
+			/*!
+			\brief Weights
+			*/
+			DoubleBuffer3D _weights;
+
+			//!@{
+			/*!
+			\brief Transformations
+			*/
+			cl_float2 _hiddenToVisible;
+			cl_float2 _visibleToHidden;
+			//!@}
+
+			/*!
+			\brief Radius onto hidden (reverse from visible layer desc)
+			*/
+			cl_int2 _reverseRadii;
+
+			/*!
+			\brief Per hidden unit reward integral (x) and trace decay (y) not yet applied to its weight row
+			Only allocated if the layer uses lazy traces
+			*/
+			DoubleBuffer2D _pendingTraces;
+		};
+
+		/*!
+		\brief Statistics on the solver iterations actually used per step
+		*/
+		struct SolveStats {
+			//!@{
+			/*!
+			\brief Number of steps and iterations summed over them
+			*/
+			cl_int _steps;
+			cl_int _totalIterations;
+			//!@}
+
+			//!@{
+			/*!
+			\brief Iteration count range
+			*/
+			cl_int _minIterations;
+			cl_int _maxIterations;
+			//!@}
+
+			/*!
+			\brief Initialize defaults
+			*/
+			SolveStats()
+				: _steps(0), _totalIterations(0),
+				_minIterations(0), _maxIterations(0)
+			{}
+
+			/*!
+			\brief Average iterations used per step
+			*/
+			float getAverageIterations() const {
+				return _steps > 0 ? static_cast<float>(_totalIterations) / _steps : 0.0f;
+			}
+		};
+
+	private:
+		//!@{
+		/*!
+		\brief Spiking, resulting state, activations, and neuron threshold buffers
+		*/
+		DoubleBuffer2D _hiddenSpikes;
+		DoubleBuffer2D _hiddenStates;
+		DoubleBuffer2D _hiddenActivations;
+		DoubleBuffer2D _hiddenThresholds;
+		//!@}
+
+		/*!
+		\brief Lateral (inhibition) weights
+		*/
+		DoubleBuffer3D _lateralWeights;
+
+		/*!
+		\brief Lateral (inhibition) radius
+		*/
+		cl_int _lateralRadius;
+
+		/*!
+		\brief Hidden size
+		*/
+		cl_int2 _hiddenSize;
+
+		/*!
+		\brief Summation temporary buffer
+		*/
+		DoubleBuffer2D _hiddenSummationTemp;
+
+		/*!
+		\brief Work group size of the single launch solver, 0 if the layer is too large for it
+		*/
+		cl::size_type _persistentSolveGroupSize;
+
+		/*!
+		\brief Whether the single launch solver is enabled (off by default, see setPersistentSolver)
+		*/
+		bool _persistentSolve;
+
+		/*!
+		\brief Device side change flag and iteration statistics (see scSolveHiddenPersistent for the layout)
+		*/
+		cl::Buffer _solveStats;
+
+		/*!
+		\brief Iteration statistics gathered on the host by the per-iteration solver
+		*/
+		SolveStats _hostSolveStats;
+
+		/*!
+		\brief Spiking units, weight learning only visits these
+		*/
+		ActiveUnitList _activeUnits;
+
+		/*!
+		\brief Placeholder bound in place of the pending traces of layers without lazy traces (the kernels do not read it)
+		*/
+		cl::Image2D _noPendingTraces;
+
+		//!@{
+		/*!
+		\brief Visible layers and descs
+		*/
+		std::vector<VisibleLayerDesc> _visibleLayerDescs;
+		std::vector<VisibleLayer> _visibleLayers;
+		//!@}
+
+		//!@{
+		/*!
+		\brief Kernels
+		*/
+		cl::Kernel _reconstructVisibleKernel;
+		cl::Kernel _activateKernel;
+		cl::Kernel _activate2Kernel;
+		cl::Kernel _solveHiddenKernel;
+		cl::Kernel _solveHiddenPersistentKernel;
+		cl::Kernel _learnThresholdsKernel;
+		cl::Kernel _learnWeightsKernel;
+		cl::Kernel _learnWeightsActiveKernel;
+		cl::Kernel _learnWeightsTracesKernel;
+		cl::Kernel _learnWeightsTracesLazyKernel;
+		cl::Kernel _advanceLazyTracesKernel;
+		cl::Kernel _flushLazyTracesKernel;
+		cl::Kernel _learnWeightsLateralKernel;
+		//!@}
+
+		/*!
+		\brief Learn the weights of one visible layer for the units in _activeUnits only, updating the back buffer in place
+		*/
+		void learnWeightsActive(sys::ComputeSystem &cs, const cl::Image2D &visibleStates, VisibleLayer &vl, const VisibleLayerDesc &vld);
+
+		/*!
+		\brief Whether a visible layer decays its traces lazily
+		*/
+		bool usesLazyTraces(int visibleLayerIndex) const {
+			return _visibleLayerDescs[visibleLayerIndex]._useTraces && _visibleLayerDescs[visibleLayerIndex]._lazyTraces;
+		}
+
+		/*!
+		\brief Pending traces of a visible layer to bind to the activation and reconstruction kernels
+		*/
+		const cl::Image2D &getPendingTracesArg(int visibleLayerIndex) const {
+			return usesLazyTraces(visibleLayerIndex) ? _visibleLayers[visibleLayerIndex]._pendingTraces[_back] : _noPendingTraces;
+		}
+
+	public:
+		/*!
+		\brief Create a comparison sparse coder with random initialization
+		Requires the compute system, program with the NeoRL kernels, and initialization information
+		*/
+		void createRandom(sys::ComputeSystem &cs, sys::ComputeProgram &program,
+			const std::vector<VisibleLayerDesc> &visibleLayerDescs, cl_int2 hiddenSize, cl_int lateralRadius, cl_float2 initWeightRange, cl_float2 initLateralWeightRange, cl_float initThreshold,
+			std::mt19937 &rng);
+
+		/*!
+		\brief Activate the sparse coder (find sparse codes)
+		If convergenceCheckInterval > 0, solving stops early once the spike pattern no longer changes.
+		Large layers check on the host every convergenceCheckInterval iterations, small layers check every iteration on the device
+		*/
+		void activate(sys::ComputeSystem &cs, const std::vector<cl::Image2D> &visibleStates, cl_int iterations, cl_float leak, cl_int convergenceCheckInterval = 0);
+
+		//!@{
+		/*!
+		\brief Learn functions, with and without eligibility traces/rewards
+		*/
+		void learn(sys::ComputeSystem &cs, const std::vector<cl::Image2D> &visibleStates, float weightLateralAlpha, float thresholdAlpha, float activeRatio);
+		void learn(sys::ComputeSystem &cs, const cl::Image2D &rewards, const std::vector<cl::Image2D> &visibleStates, float weightLateralAlpha, float thresholdAlpha, float activeRatio);
+		//!@}
+
+		/*!
+		\brief Apply all pending lazy trace decay to the stored weights, so they can be read or written out directly
+		*/
+		void flushLazyTraces(sys::ComputeSystem &cs);
+
+		/*!
+		\brief Reconstruct (find input from sparse codes)
+		*/
+		void reconstruct(sys::ComputeSystem &cs, const cl::Image2D &hiddenStates, int visibleLayerIndex, cl::Image2D &visibleStates);
+
+		/*!
+		\brief Get number of visible layers
+		*/
+		size_t getNumVisibleLayers() const {
+			return _visibleLayers.size();
+		}
+
+		/*!
+		\brief Get access to a visible layer
+		*/
+		const VisibleLayer &getVisibleLayer(int index) const {
+			return _visibleLayers[index];
+		}
+
+		/*!
+		\brief Get visible layer descs
+		*/
+		const VisibleLayerDesc &getVisibleLayerDesc(int index) const {
+			return _visibleLayerDescs[index];
+		}
+
+		/*!
+		\brief Get hidden size
+		*/
+		cl_int2 getHiddenSize() const {
+			return _hiddenSize;
+		}
+
+		/*!
+		\brief Get hidden states
+		*/
+		const DoubleBuffer2D &getHiddenStates() const {
+			return _hiddenStates;
+		}
+
+		/*!
+		\brief Enable or disable solving all iterations in a single launch
+		The whole solve then runs in one work group, so on one compute unit. This only pays off where launch overhead dominates,
+		such as small layers or devices with few compute units. Layers too large for local memory always use the per-iteration launches
+		*/
+		void setPersistentSolver(bool persistent) {
+			_persistentSolve = persistent;
+		}
+
+		/*!
+		\brief Whether activation solves all iterations in a single launch
+		*/
+		bool usesPersistentSolver() const {
+			return _persistentSolve && _persistentSolveGroupSize > 0;
+		}
+
+		/*!
+		\brief Get statistics on the solver iterations used since the last reset. Blocks until the device is done
+		*/
+		SolveStats getSolveStats(sys::ComputeSystem &cs) const;
+
+		/*!
+		\brief Reset solver iteration statistics
+		*/
+		void resetSolveStats(sys::ComputeSystem &cs);
+
+		/*!
+		\brief Get hidden thresholds
+		*/
+		const DoubleBuffer2D &getHiddenThresholds() const {
+			return _hiddenThresholds;
+		}
+	};
 }
\ No newline at end of file
@@ -1,316 +1,707 @@
-#include "SparsePredictor.h"
-
-using namespace neo;
-
-void SparsePredictor::createRandom(sys::ComputeSystem &cs, sys::ComputeProgram &program,
-	const std::vector<VisibleLayerDesc> &visibleLayerDescs, cl_int2 hiddenSize, const std::vector<cl_int2> &feedBackSizes, cl_int lateralRadius, cl_float2 initWeightRange,
-	std::mt19937 &rng)
-{
-	cl_float4 zeroColor = { 0.0f, 0.0f, 0.0f, 0.0f };
-
-	_visibleLayerDescs = visibleLayerDescs;
-
-	_hiddenSize = hiddenSize;
-	_feedBackSizes = feedBackSizes;
-	_lateralRadius = lateralRadius;
-
-	cl::array<cl::size_type, 3> zeroOrigin = { 0, 0, 0 };
-	cl::array<cl::size_type, 3> hiddenRegion = { _hiddenSize.x, _hiddenSize.y, 1 };
-
-	_visibleLayers.resize(_visibleLayerDescs.size());
-
-	cl::Kernel randomUniform2DKernel = cl::Kernel(program.getProgram(), "randomUniform2D");
-	cl::Kernel randomUniform3DKernel = cl::Kernel(program.getProgram(), "randomUniform3D");
-
-	// Create layers
-	for (int vli = 0; vli < _visibleLayers.size(); vli++) {
-		VisibleLayer &vl = _visibleLayers[vli];
-		VisibleLayerDesc &vld = _visibleLayerDescs[vli];
-
-		vl._hiddenToVisible = cl_float2{ static_cast<float>(vld._size.x) / static_cast<float>(_hiddenSize.x),
-			static_cast<float>(vld._size.y) / static_cast<float>(_hiddenSize.y)
-		};
-
-		vl._visibleToHidden = cl_float2{ static_cast<float>(_hiddenSize.x) / static_cast<float>(vld._size.x),
-			static_cast<float>(_hiddenSize.y) / static_cast<float>(vld._size.y)
-		};
-
-		vl._visibleToFeedBack = cl_float2{ static_cast<float>(_feedBackSizes[vli].x) / static_cast<float>(vld._size.x),
-			static_cast<float>(_feedBackSizes[vli].y) / static_cast<float>(vld._size.y)
-		};
-
-		if (vld._useForInput) {
-			int weightDiam = vld._encodeRadius * 2 + 1;
-
-			int numWeights = weightDiam * weightDiam;
-
-			cl_int3 weightsSize = { _hiddenSize.x, _hiddenSize.y, numWeights };
-
-			vl._encoderWeights = createDoubleBuffer3D(cs, weightsSize, CL_RG, CL_FLOAT);
-
-			randomUniform(vl._encoderWeights[_back], cs, randomUniform3DKernel, weightsSize, initWeightRange, rng);
-		}
-
-		if (vld._predict) {
-			{
-				int weightDiam = vld._predDecodeRadius * 2 + 1;
-
-				int numWeights = weightDiam * weightDiam;
-
-				cl_int3 weightsSize = { vld._size.x, vld._size.y, numWeights };
-
-				vl._predDecoderWeights = createDoubleBuffer3D(cs, weightsSize, CL_RG, CL_FLOAT);
-
-				randomUniform(vl._predDecoderWeights[_back], cs, randomUniform3DKernel, weightsSize, initWeightRange, rng);
-			}
-
-			{
-				int weightDiam = vld._feedBackDecodeRadius * 2 + 1;
-
-				int numWeights = weightDiam * weightDiam;
-
-				cl_int3 weightsSize = { vld._size.x, vld._size.y, numWeights };
-
-				vl._feedBackDecoderWeights = createDoubleBuffer3D(cs, weightsSize, CL_RG, CL_FLOAT);
-
-				randomUniform(vl._feedBackDecoderWeights[_back], cs, randomUniform3DKernel, weightsSize, initWeightRange, rng);
-			}
-
-			vl._predictions = createDoubleBuffer2D(cs, vld._size, CL_R, CL_FLOAT);
-
-			cs.getQueue().enqueueFillImage(vl._predictions[_back], zeroColor, zeroOrigin, { static_cast<cl::size_type>(vld._size.x), static_cast<cl::size_type>(vld._size.y), 1 });
-
-			vl._predError = cl::Image2D(cs.getContext(), CL_MEM_READ_WRITE, cl::ImageFormat(CL_R, CL_FLOAT), vld._size.x, vld._size.y);
-		}
-	}
-
-	// Hidden state data
-	_hiddenStates = createDoubleBuffer2D(cs, _hiddenSize, CL_R, CL_FLOAT);
-	_hiddenBiases = createDoubleBuffer2D(cs, _hiddenSize, CL_R, CL_FLOAT);
-
-	_hiddenActivationSummationTemp = createDoubleBuffer2D(cs, _hiddenSize, CL_R, CL_FLOAT);
-
-	_hiddenErrorSummationTemp = createDoubleBuffer2D(cs, _hiddenSize, CL_R, CL_FLOAT);
-
-	cs.getQueue().enqueueFillImage(_hiddenStates[_back], zeroColor, zeroOrigin, hiddenRegion);
-
-	randomUniform(_hiddenBiases[_back], cs, randomUniform2DKernel, _hiddenSize, initWeightRange, rng);
-
-	// Create kernels
-	_encodeKernel = cl::Kernel(program.getProgram(), "spEncode");
-	_decodeKernel = cl::Kernel(program.getProgram(), "spDecode");
-	_solveHiddenKernel = cl::Kernel(program.getProgram(), "spSolveHidden");
-	_predictionErrorKernel = cl::Kernel(program.getProgram(), "spPredictionError");
-	_errorPropagationKernel = cl::Kernel(program.getProgram(), "spErrorPropagation");
-	_learnEncoderWeightsKernel = cl::Kernel(program.getProgram(), "spLearnEncoderWeights");
-	_learnDecoderWeightsKernel = cl::Kernel(program.getProgram(), "spLearnDecoderWeights");
-	_learnBiasesKernel = cl::Kernel(program.getProgram(), "spLearnBiases");
-}
-
-void SparsePredictor::activateEncoder(sys::ComputeSystem &cs, const std::vector<cl::Image2D> &visibleStates, float activeRatio) {
-	// Start by clearing activation summation buffer
-	{
-		cl::array<cl::size_type, 3> zeroOrigin = { 0, 0, 0 };
-		cl::array<cl::size_type, 3> hiddenRegion = { _hiddenSize.x, _hiddenSize.y, 1 };
-
-		cs.getQueue().enqueueCopyImage(_hiddenBiases[_back], _hiddenActivationSummationTemp[_back], zeroOrigin, zeroOrigin, hiddenRegion);
-	}
-
-	for (int vli = 0; vli < _visibleLayers.size(); vli++) {
-		VisibleLayer &vl = _visibleLayers[vli];
-		VisibleLayerDesc &vld = _visibleLayerDescs[vli];
-
-		if (vld._useForInput) {
-			int argIndex = 0;
-
-			_encodeKernel.setArg(argIndex++, visibleStates[vli]);
-			_encodeKernel.setArg(argIndex++, _hiddenActivationSummationTemp[_back]);
-			_encodeKernel.setArg(argIndex++, _hiddenActivationSummationTemp[_front]);
-			_encodeKernel.setArg(argIndex++, vl._encoderWeights[_back]);
-			_encodeKernel.setArg(argIndex++, vld._size);
-			_encodeKernel.setArg(argIndex++, vl._hiddenToVisible);
-			_encodeKernel.setArg(argIndex++, vld._encodeRadius);
-			_encodeKernel.setArg(argIndex++, vld._ignoreMiddle);
-
-			cs.getQueue().enqueueNDRangeKernel(_encodeKernel, cl::NullRange, cl::NDRange(_hiddenSize.x, _hiddenSize.y));
-
-			// Swap buffers
-			std::swap(_hiddenActivationSummationTemp[_front], _hiddenActivationSummationTemp[_back]);
-		}
-	}
-
-	{
-		int argIndex = 0;
-
-		_solveHiddenKernel.setArg(argIndex++, _hiddenActivationSummationTemp[_back]);
-		_solveHiddenKernel.setArg(argIndex++, _hiddenStates[_front]);
-		_solveHiddenKernel.setArg(argIndex++, _hiddenSize);
-		_solveHiddenKernel.setArg(argIndex++, _lateralRadius);
-		_solveHiddenKernel.setArg(argIndex++, activeRatio);
-
-		cs.getQueue().enqueueNDRangeKernel(_solveHiddenKernel, cl::NullRange, cl::NDRange(_hiddenSize.x, _hiddenSize.y));
-	}
-	
-	// No buffer swapping yet, this happens in the decoding phase
-}
-
-void SparsePredictor::activateDecoder(sys::ComputeSystem &cs, const std::vector<cl::Image2D> &feedBackStates) {
-	// Now decode
-	for (int vli = 0; vli < _visibleLayers.size(); vli++) {
-		VisibleLayer &vl = _visibleLayers[vli];
-		VisibleLayerDesc &vld = _visibleLayerDescs[vli];
-
-		if (vld._predict) {
-			int argIndex = 0;
-
-			_decodeKernel.setArg(argIndex++, _hiddenStates[_front]);
-			_decodeKernel.setArg(argIndex++, feedBackStates[vli]);
-			_decodeKernel.setArg(argIndex++, vl._predictions[_front]);
-			_decodeKernel.setArg(argIndex++, vl._predDecoderWeights[_back]);
-			_decodeKernel.setArg(argIndex++, vl._feedBackDecoderWeights[_back]);
-			_decodeKernel.setArg(argIndex++, _hiddenSize);
-			_decodeKernel.setArg(argIndex++, _feedBackSizes[vli]);
-			_decodeKernel.setArg(argIndex++, vl._visibleToHidden);
-			_decodeKernel.setArg(argIndex++, vl._visibleToFeedBack);
-			_decodeKernel.setArg(argIndex++, vld._predDecodeRadius);
-			_decodeKernel.setArg(argIndex++, vld._feedBackDecodeRadius);
-			_decodeKernel.setArg(argIndex++, vld._predictThresholded);
-
-			cs.getQueue().enqueueNDRangeKernel(_decodeKernel, cl::NullRange, cl::NDRange(vld._size.x, vld._size.y));
-		}
-	}
-
-	// Swap buffers
-	std::swap(_hiddenStates[_front], _hiddenStates[_back]);
-
-	for (int vli = 0; vli < _visibleLayers.size(); vli++) {
-		VisibleLayer &vl = _visibleLayers[vli];
-		VisibleLayerDesc &vld = _visibleLayerDescs[vli];
-
-		if (vld._predict)
-			std::swap(vl._predictions[_front], vl._predictions[_back]);
-	}
-}
-
-void SparsePredictor::learn(sys::ComputeSystem &cs, const std::vector<cl::Image2D> &visibleStates,
-	const std::vector<cl::Image2D> &feedBackStatesPrev, const std::vector<cl::Image2D> &addidionalErrors, float weightEncodeAlpha, float weightDecodeAlpha, float weightLambda, float biasAlpha, float activeRatio)
-{
-	// Start by clearing error summation buffer
-	{
-		cl_float4 zeroColor = { 0.0f, 0.0f, 0.0f, 0.0f };
-
-		cl::array<cl::size_type, 3> zeroOrigin = { 0, 0, 0 };
-		cl::array<cl::size_type, 3> hiddenRegion = { _hiddenSize.x, _hiddenSize.y, 1 };
-
-		cs.getQueue().enqueueFillImage(_hiddenErrorSummationTemp[_back], zeroColor, zeroOrigin, hiddenRegion);
-	}
-
-	// Find error
-	for (int vli = 0; vli < _visibleLayers.size(); vli++) {
-		VisibleLayer &vl = _visibleLayers[vli];
-		VisibleLayerDesc &vld = _visibleLayerDescs[vli];
-
-		if (vld._predict) {
-			{
-				int argIndex = 0;
-
-				_predictionErrorKernel.setArg(argIndex++, vl._predictions[_front]);
-				_predictionErrorKernel.setArg(argIndex++, visibleStates[vli]);
-				_predictionErrorKernel.setArg(argIndex++, addidionalErrors[vli]);
-				_predictionErrorKernel.setArg(argIndex++, vl._predError);
-
-				cs.getQueue().enqueueNDRangeKernel(_predictionErrorKernel, cl::NullRange, cl::NDRange(vld._size.x, vld._size.y));
-			}
-
-			// Propagate the error
-			{
-				cl_int2 reversePredDecodeRadii = { static_cast<int>(std::ceil(vl._visibleToHidden.x * (vld._predDecodeRadius + 0.5f))), static_cast<int>(std::ceil(vl._visibleToHidden.y * (vld._predDecodeRadius + 0.5f))) };
-
-				int argIndex = 0;
-
-				_errorPropagationKernel.setArg(argIndex++, vl._predError);
-				_errorPropagationKernel.setArg(argIndex++, _hiddenErrorSummationTemp[_back]);
-				_errorPropagationKernel.setArg(argIndex++, _hiddenErrorSummationTemp[_front]);
-				_errorPropagationKernel.setArg(argIndex++, vl._predDecoderWeights[_back]);
-				_errorPropagationKernel.setArg(argIndex++, vld._size);
-				_errorPropagationKernel.setArg(argIndex++, _hiddenSize);
-				_errorPropagationKernel.setArg(argIndex++, vl._visibleToHidden);
-				_errorPropagationKernel.setArg(argIndex++, vl._hiddenToVisible);
-				_errorPropagationKernel.setArg(argIndex++, vld._predDecodeRadius);
-				_errorPropagationKernel.setArg(argIndex++, reversePredDecodeRadii);
-
-				cs.getQueue().enqueueNDRangeKernel(_errorPropagationKernel, cl::NullRange, cl::NDRange(_hiddenSize.x, _hiddenSize.y));
-			}
-
-			std::swap(_hiddenErrorSummationTemp[_front], _hiddenErrorSummationTemp[_back]);
-		}
-	}
-	
-	// Learn weights
-	for (int vli = 0; vli < _visibleLayers.size(); vli++) {
-		VisibleLayer &vl = _visibleLayers[vli];
-		VisibleLayerDesc &vld = _visibleLayerDescs[vli];
-
-		// Decoder
-		if (vld._predict) {
-			int argIndex = 0;
-
-			_learnDecoderWeightsKernel.setArg(argIndex++, vl._predError);
-			_learnDecoderWeightsKernel.setArg(argIndex++, _hiddenStates[_front]);
-			_learnDecoderWeightsKernel.setArg(argIndex++, feedBackStatesPrev[vli]);
-			_learnDecoderWeightsKernel.setArg(argIndex++, vl._predDecoderWeights[_back]);
-			_learnDecoderWeightsKernel.setArg(argIndex++, vl._predDecoderWeights[_front]);
-			_learnDecoderWeightsKernel.setArg(argIndex++, vl._feedBackDecoderWeights[_back]);
-			_learnDecoderWeightsKernel.setArg(argIndex++, vl._feedBackDecoderWeights[_front]);
-			_learnDecoderWeightsKernel.setArg(argIndex++, _hiddenSize);
-			_learnDecoderWeightsKernel.setArg(argIndex++, _feedBackSizes[vli]);
-			_learnDecoderWeightsKernel.setArg(argIndex++, vl._visibleToHidden);
-			_learnDecoderWeightsKernel.setArg(argIndex++, vl._visibleToFeedBack);
-			_learnDecoderWeightsKernel.setArg(argIndex++, vld._predDecodeRadius);
-			_learnDecoderWeightsKernel.setArg(argIndex++, vld._feedBackDecodeRadius);
-			_learnDecoderWeightsKernel.setArg(argIndex++, weightDecodeAlpha);
-
-			cs.getQueue().enqueueNDRangeKernel(_learnDecoderWeightsKernel, cl::NullRange, cl::NDRange(vld._size.x, vld._size.y));
-
-			std::swap(vl._predDecoderWeights[_front], vl._predDecoderWeights[_back]);
-			std::swap(vl._feedBackDecoderWeights[_front], vl._feedBackDecoderWeights[_back]);
-		}
-
-		// Encoder
-		if (vld._useForInput) {
-			int argIndex = 0;
-
-			_learnEncoderWeightsKernel.setArg(argIndex++, _hiddenErrorSummationTemp[_back]);
-			_learnEncoderWeightsKernel.setArg(argIndex++, _hiddenStates[_back]);
-			_learnEncoderWeightsKernel.setArg(argIndex++, _hiddenStates[_front]);
-			_learnEncoderWeightsKernel.setArg(argIndex++, _hiddenActivationSummationTemp[_back]);
-			_learnEncoderWeightsKernel.setArg(argIndex++, visibleStates[vli]);
-			_learnEncoderWeightsKernel.setArg(argIndex++, vl._encoderWeights[_back]);
-			_learnEncoderWeightsKernel.setArg(argIndex++, vl._encoderWeights[_front]);
-			_learnEncoderWeightsKernel.setArg(argIndex++, vld._size);
-			_learnEncoderWeightsKernel.setArg(argIndex++, vl._hiddenToVisible);
-			_learnEncoderWeightsKernel.setArg(argIndex++, vld._encodeRadius);
-			_learnEncoderWeightsKernel.setArg(argIndex++, weightEncodeAlpha);
-			_learnEncoderWeightsKernel.setArg(argIndex++, weightLambda);
-
-			cs.getQueue().enqueueNDRangeKernel(_learnEncoderWeightsKernel, cl::NullRange, cl::NDRange(_hiddenSize.x, _hiddenSize.y));
-
-			std::swap(vl._encoderWeights[_front], vl._encoderWeights[_back]);
-		}
-	}
-
-	// Biases
-	{
-		int argIndex = 0;
-
-		_learnBiasesKernel.setArg(argIndex++, _hiddenStates[_back]);
-		_learnBiasesKernel.setArg(argIndex++, _hiddenBiases[_back]);
-		_learnBiasesKernel.setArg(argIndex++, _hiddenBiases[_front]);
-		_learnBiasesKernel.setArg(argIndex++, biasAlpha);
-		_learnBiasesKernel.setArg(argIndex++, activeRatio);
-
-		cs.getQueue().enqueueNDRangeKernel(_learnBiasesKernel, cl::NullRange, cl::NDRange(_hiddenSize.x, _hiddenSize.y));
-
-		std::swap(_hiddenBiases[_front], _hiddenBiases[_back]);
-	}
+#include "SparsePredictor.h"
+
+#include <algorithm>
+
+using namespace neo;
+
+void SparsePredictor::createRandom(sys::ComputeSystem &cs, sys::ComputeProgram &program,
+	const std::vector<VisibleLayerDesc> &visibleLayerDescs, cl_int2 hiddenSize, const std::vector<cl_int2> &feedBackSizes, cl_int lateralRadius, cl_float2 initWeightRange,
+	std::mt19937 &rng)
+{
+	if (!program.requireModules(cs, { "init", "predictor" })) {
+		assert(false);
+
+		return;
+	}
+
+	MemoryScope scope("SparsePredictor");
+
+	cl_float4 zeroColor = { 0.0f, 0.0f, 0.0f, 0.0f };
+
+	_visibleLayerDescs = visibleLayerDescs;
+
+	_hiddenSize = hiddenSize;
+	_feedBackSizes = feedBackSizes;
+	_lateralRadius = lateralRadius;
+
+	cl::array<cl::size_type, 3> zeroOrigin = { 0, 0, 0 };
+	cl::array<cl::size_type, 3> hiddenRegion = { _hiddenSize.x, _hiddenSize.y, 1 };
+
+	_visibleLayers.resize(_visibleLayerDescs.size());
+
+	cl::Kernel randomUniform2DKernel = cl::Kernel(program.getProgram(), "randomUniform2D");
+	cl::Kernel randomUniform3DKernel = cl::Kernel(program.getProgram(), "randomUniform3D");
+
+	// Create layers
+	for (int vli = 0; vli < _visibleLayers.size(); vli++) {
+		VisibleLayer &vl = _visibleLayers[vli];
+		VisibleLayerDesc &vld = _visibleLayerDescs[vli];
+
+		vl._hiddenToVisible = cl_float2{ static_cast<float>(vld._size.x) / static_cast<float>(_hiddenSize.x),
+			static_cast<float>(vld._size.y) / static_cast<float>(_hiddenSize.y)
+		};
+
+		vl._visibleToHidden = cl_float2{ static_cast<float>(_hiddenSize.x) / static_cast<float>(vld._size.x),
+			static_cast<float>(_hiddenSize.y) / static_cast<float>(vld._size.y)
+		};
+
+		vl._visibleToFeedBack = cl_float2{ static_cast<float>(_feedBackSizes[vli].x) / static_cast<float>(vld._size.x),
+			static_cast<float>(_feedBackSizes[vli].y) / static_cast<float>(vld._size.y)
+		};
+
+		if (vld._useForInput) {
+			int weightDiam = vld._encodeRadius * 2 + 1;
+
+			int numWeights = weightDiam * weightDiam;
+
+			cl_int3 weightsSize = { _hiddenSize.x, _hiddenSize.y, numWeights };
+
+			vl._encoderWeights = createDoubleBuffer3D(cs, weightsSize, CL_RG, CL_FLOAT, "encoderWeights");
+
+			randomUniform(vl._encoderWeights[_back], cs, randomUniform3DKernel, weightsSize, initWeightRange, rng);
+
+			if (vld._encodeChanged) {
+				vl._encodeCache = createDoubleBuffer2D(cs, _hiddenSize, CL_R, CL_FLOAT, "encodeCache");
+
+				cs.getQueue().enqueueFillImage(vl._encodeCache[_back], zeroColor, zeroOrigin, hiddenRegion);
+			}
+		}
+
+		if (vld._predict) {
+			{
+				int weightDiam = vld._predDecodeRadius * 2 + 1;
+
+				int numWeights = weightDiam * weightDiam;
+
+				cl_int3 weightsSize = { vld._size.x, vld._size.y, numWeights };
+
+				vl._predDecoderWeights = createDoubleBuffer3D(cs, weightsSize, CL_RG, CL_FLOAT, "predDecoderWeights");
+
+				randomUniform(vl._predDecoderWeights[_back], cs, randomUniform3DKernel, weightsSize, initWeightRange, rng);
+			}
+
+			{
+				int weightDiam = vld._feedBackDecodeRadius * 2 + 1;
+
+				int numWeights = weightDiam * weightDiam;
+
+				cl_int3 weightsSize = { vld._size.x, vld._size.y, numWeights };
+
+				vl._feedBackDecoderWeights = createDoubleBuffer3D(cs, weightsSize, CL_RG, CL_FLOAT, "feedBackDecoderWeights");
+
+				randomUniform(vl._feedBackDecoderWeights[_back], cs, randomUniform3DKernel, weightsSize, initWeightRange, rng);
+			}
+
+			vl._predictions = createDoubleBuffer2D(cs, vld._size, CL_R, CL_FLOAT, "predictions");
+
+			cs.getQueue().enqueueFillImage(vl._predictions[_back], zeroColor, zeroOrigin, { static_cast<cl::size_type>(vld._size.x), static_cast<cl::size_type>(vld._size.y), 1 });
+
+			vl._predError = createImage2D(cs, vld._size, CL_R, CL_FLOAT, "predError");
+		}
+	}
+
+	// Hidden state data
+	_hiddenStates = createDoubleBuffer2D(cs, _hiddenSize, CL_R, CL_FLOAT, "hiddenStates");
+	_hiddenBiases = createDoubleBuffer2D(cs, _hiddenSize, CL_R, CL_FLOAT, "hiddenBiases");
+
+	_hiddenActivationSummationTemp = createDoubleBuffer2D(cs, _hiddenSize, CL_R, CL_FLOAT, "hiddenActivationSummationTemp");
+
+	_hiddenErrorSummationTemp = createDoubleBuffer2D(cs, _hiddenSize, CL_R, CL_FLOAT, "hiddenErrorSummationTemp");
+
+	cs.getQueue().enqueueFillImage(_hiddenStates[_back], zeroColor, zeroOrigin, hiddenRegion);
+
+	randomUniform(_hiddenBiases[_back], cs, randomUniform2DKernel, _hiddenSize, initWeightRange, rng);
+
+	// Create kernels
+	_encodeKernel = cl::Kernel(program.getProgram(), "spEncode");
+	_encode2Kernel = cl::Kernel(program.getProgram(), "spEncode2");
+	_encodeChangedKernel = cl::Kernel(program.getProgram(), "spEncodeChanged");
+	_decodeKernel = cl::Kernel(program.getProgram(), "spDecode");
+	_solveHiddenKernel = cl::Kernel(program.getProgram(), "spSolveHidden");
+	_solveHiddenTiledKernel = cl::Kernel(program.getProgram(), "spSolveHiddenTiled");
+	_predictionErrorKernel = cl::Kernel(program.getProgram(), "spPredictionError");
+	_errorPropagationKernel = cl::Kernel(program.getProgram(), "spErrorPropagation");
+	_learnEncoderWeightsKernel = cl::Kernel(program.getProgram(), "spLearnEncoderWeights");
+	_learnDecoderWeightsKernel = cl::Kernel(program.getProgram(), "spLearnDecoderWeights");
+	_learnBiasesKernel = cl::Kernel(program.getProgram(), "spLearnBiases");
+
+	_useTiledSolve = inhibitionTileFits(cs, _solveHiddenTiledKernel, _lateralRadius);
+
+	_frozen = false;
+
+	_bands.clear();
+}
+
+void SparsePredictor::activateEncoder(sys::ComputeSystem &cs, const std::vector<cl::Image2D> &visibleStates, float activeRatio,
+	const TileChangeDetector* changes, cl_int changeDilation)
+{
+	if (!_bands.empty()) {
+		activateEncoderBands(cs, visibleStates, activeRatio, changes);
+
+		return;
+	}
+
+	encodeRows(cs, visibleStates, _hiddenActivationSummationTemp, 0, 0, _hiddenSize.y, changes, changeDilation);
+
+	solveRows(cs, _hiddenActivationSummationTemp[_back], 0, _hiddenStates[_front], 0, 0, _hiddenSize.y, activeRatio);
+	
+	// No buffer swapping yet, this happens in the decoding phase
+}
+
+void SparsePredictor::encodeRows(sys::ComputeSystem &cs, const std::vector<cl::Image2D> &visibleStates, DoubleBuffer2D &summation, cl_int summationRowStart,
+	cl_int rowStart, cl_int rowCount, const TileChangeDetector* changes, cl_int changeDilation)
+{
+	cl::NDRange offset(0, rowStart);
+	cl::NDRange range(_hiddenSize.x, rowCount);
+
+	cl_int2 summationOrigin = { 0, summationRowStart };
+
+	cl::array<cl::size_type, 3> biasesOrigin = { 0, static_cast<cl::size_type>(rowStart), 0 };
+	cl::array<cl::size_type, 3> summationRowsOrigin = { 0, static_cast<cl::size_type>(rowStart - summationRowStart), 0 };
+	cl::array<cl::size_type, 3> rowsRegion = { static_cast<cl::size_type>(_hiddenSize.x), static_cast<cl::size_type>(rowCount), 1 };
+
+	// Sum input layers two at a time with the fused kernel, starting from the biases.
+	// Summation images that hold only some rows get the biases of those rows copied in first, so every kernel reads and writes them at the same origin
+	cl::Image2D summationStart = _hiddenBiases[_back];
+	bool launched = false;
+
+	if (summationRowStart != 0) {
+		cs.getQueue().enqueueCopyImage(_hiddenBiases[_back], summation[_back], biasesOrigin, summationRowsOrigin, rowsRegion);
+
+		summationStart = summation[_back];
+	}
+
+	// Change driven layers first, each reusing its cached contribution away from changed tiles
+	if (changes != nullptr) {
+		for (int vli = 0; vli < _visibleLayers.size(); vli++) {
+			VisibleLayer &vl = _visibleLayers[vli];
+			VisibleLayerDesc &vld = _visibleLayerDescs[vli];
+
+			if (!vld._useForInput || !vld._encodeChanged)
+				continue;
+
+			int argIndex = 0;
+
+			_encodeChangedKernel.setArg(argIndex++, visibleStates[vli]);
+			_encodeChangedKernel.setArg(argIndex++, summationStart);
+			_encodeChangedKernel.setArg(argIndex++, summation[_front]);
+			_encodeChangedKernel.setArg(argIndex++, vl._encodeCache[_back]);
+			_encodeChangedKernel.setArg(argIndex++, vl._encodeCache[_front]);
+			_encodeChangedKernel.setArg(argIndex++, vl._encoderWeights[_back]);
+			_encodeChangedKernel.setArg(argIndex++, vld._size);
+			_encodeChangedKernel.setArg(argIndex++, vl._hiddenToVisible);
+			_encodeChangedKernel.setArg(argIndex++, vld._encodeRadius);
+			_encodeChangedKernel.setArg(argIndex++, vld._ignoreMiddle);
+
+			changes->setChangeArgs(_encodeChangedKernel, argIndex);
+
+			_encodeChangedKernel.setArg(argIndex++, changeDilation);
+			_encodeChangedKernel.setArg(argIndex++, summationOrigin);
+
+			cs.getQueue().enqueueNDRangeKernel(_encodeChangedKernel, offset, range);
+
+			// Swap buffers
+			std::swap(summation[_front], summation[_back]);
+			std::swap(vl._encodeCache[_front], vl._encodeCache[_back]);
+
+			summationStart = summation[_back];
+			launched = true;
+		}
+	}
+
+	int pending = -1;
+
+	for (int vli = 0; vli < _visibleLayers.size(); vli++) {
+		if (!_visibleLayerDescs[vli]._useForInput)
+			continue;
+
+		if (changes != nullptr && _visibleLayerDescs[vli]._encodeChanged)
+			continue;
+
+		if (pending == -1) {
+			pending = vli;
+
+			continue;
+		}
+
+		VisibleLayer &vl0 = _visibleLayers[pending];
+		VisibleLayerDesc &vld0 = _visibleLayerDescs[pending];
+		VisibleLayer &vl1 = _visibleLayers[vli];
+		VisibleLayerDesc &vld1 = _visibleLayerDescs[vli];
+
+		int argIndex = 0;
+
+		_encode2Kernel.setArg(argIndex++, visibleStates[pending]);
+		_encode2Kernel.setArg(argIndex++, visibleStates[vli]);
+		_encode2Kernel.setArg(argIndex++, summationStart);
+		_encode2Kernel.setArg(argIndex++, summation[_front]);
+		_encode2Kernel.setArg(argIndex++, vl0._encoderWeights[_back]);
+		_encode2Kernel.setArg(argIndex++, vl1._encoderWeights[_back]);
+		_encode2Kernel.setArg(argIndex++, vld0._size);
+		_encode2Kernel.setArg(argIndex++, vld1._size);
+		_encode2Kernel.setArg(argIndex++, vl0._hiddenToVisible);
+		_encode2Kernel.setArg(argIndex++, vl1._hiddenToVisible);
+		_encode2Kernel.setArg(argIndex++, vld0._encodeRadius);
+		_encode2Kernel.setArg(argIndex++, vld1._encodeRadius);
+		_encode2Kernel.setArg(argIndex++, vld0._ignoreMiddle);
+		_encode2Kernel.setArg(argIndex++, vld1._ignoreMiddle);
+		_encode2Kernel.setArg(argIndex++, summationOrigin);
+
+		cs.getQueue().enqueueNDRangeKernel(_encode2Kernel, offset, range);
+
+		// Swap buffers
+		std::swap(summation[_front], summation[_back]);
+
+		summationStart = summation[_back];
+		launched = true;
+
+		pending = -1;
+	}
+
+	if (pending != -1) {
+		VisibleLayer &vl = _visibleLayers[pending];
+		VisibleLayerDesc &vld = _visibleLayerDescs[pending];
+
+		int argIndex = 0;
+
+		_encodeKernel.setArg(argIndex++, visibleStates[pending]);
+		_encodeKernel.setArg(argIndex++, summationStart);
+		_encodeKernel.setArg(argIndex++, summation[_front]);
+		_encodeKernel.setArg(argIndex++, vl._encoderWeights[_back]);
+		_encodeKernel.setArg(argIndex++, vld._size);
+		_encodeKernel.setArg(argIndex++, vl._hiddenToVisible);
+		_encodeKernel.setArg(argIndex++, vld._encodeRadius);
+		_encodeKernel.setArg(argIndex++, vld._ignoreMiddle);
+		_encodeKernel.setArg(argIndex++, summationOrigin);
+
+		cs.getQueue().enqueueNDRangeKernel(_encodeKernel, offset, range);
+
+		// Swap buffers
+		std::swap(summation[_front], summation[_back]);
+	}
+	else if (!launched && summationRowStart == 0) {
+		// No input layers, activations are just the biases (already copied in for partial summation images)
+		cs.getQueue().enqueueCopyImage(_hiddenBiases[_back], summation[_back], biasesOrigin, summationRowsOrigin, rowsRegion);
+	}
+}
+
+void SparsePredictor::solveRows(sys::ComputeSystem &cs, const cl::Image2D &summation, cl_int summationRowStart, const cl::Image2D &hiddenStates, cl_int statesRowStart,
+	cl_int rowStart, cl_int rowCount, float activeRatio)
+{
+	cl_int2 summationOrigin = { 0, summationRowStart };
+	cl_int2 statesOrigin = { 0, statesRowStart };
+
+	if (_useTiledSolve) {
+		int argIndex = 0;
+
+		_solveHiddenTiledKernel.setArg(argIndex++, summation);
+		_solveHiddenTiledKernel.setArg(argIndex++, hiddenStates);
+		_solveHiddenTiledKernel.setArg(argIndex++, cl::Local(inhibitionTileBytes(_lateralRadius)));
+		_solveHiddenTiledKernel.setArg(argIndex++, _hiddenSize);
+		_solveHiddenTiledKernel.setArg(argIndex++, _lateralRadius);
+		_solveHiddenTiledKernel.setArg(argIndex++, activeRatio);
+		_solveHiddenTiledKernel.setArg(argIndex++, summationOrigin);
+		_solveHiddenTiledKernel.setArg(argIndex++, statesOrigin);
+
+		enqueueInhibitionTiled(cs, _solveHiddenTiledKernel, { _hiddenSize.x, rowCount }, { 0, rowStart });
+	}
+	else {
+		int argIndex = 0;
+
+		_solveHiddenKernel.setArg(argIndex++, summation);
+		_solveHiddenKernel.setArg(argIndex++, hiddenStates);
+		_solveHiddenKernel.setArg(argIndex++, _hiddenSize);
+		_solveHiddenKernel.setArg(argIndex++, _lateralRadius);
+		_solveHiddenKernel.setArg(argIndex++, activeRatio);
+		_solveHiddenKernel.setArg(argIndex++, summationOrigin);
+		_solveHiddenKernel.setArg(argIndex++, statesOrigin);
+
+		cs.getQueue().enqueueNDRangeKernel(_solveHiddenKernel, cl::NDRange(0, rowStart), cl::NDRange(_hiddenSize.x, rowCount));
+	}
+}
+
+void SparsePredictor::activateDecoder(sys::ComputeSystem &cs, const std::vector<cl::Image2D> &feedBackStates) {
+	// Now decode
+	if (!_bands.empty())
+		activateDecoderBands(cs, feedBackStates);
+	else {
+		for (int vli = 0; vli < _visibleLayers.size(); vli++) {
+			if (_visibleLayerDescs[vli]._predict)
+				decodeRows(cs, vli, feedBackStates[vli], _visibleLayers[vli]._predictions[_front], 0, 0, _visibleLayerDescs[vli]._size.y);
+		}
+	}
+
+	// Swap buffers
+	std::swap(_hiddenStates[_front], _hiddenStates[_back]);
+
+	for (int vli = 0; vli < _visibleLayers.size(); vli++) {
+		VisibleLayer &vl = _visibleLayers[vli];
+		VisibleLayerDesc &vld = _visibleLayerDescs[vli];
+
+		if (vld._predict)
+			std::swap(vl._predictions[_front], vl._predictions[_back]);
+	}
+}
+
+void SparsePredictor::decodeRows(sys::ComputeSystem &cs, int vli, const cl::Image2D &feedBackStates, const cl::Image2D &predictions, cl_int predictionsRowStart,
+	cl_int rowStart, cl_int rowCount)
+{
+	VisibleLayer &vl = _visibleLayers[vli];
+	VisibleLayerDesc &vld = _visibleLayerDescs[vli];
+
+	int argIndex = 0;
+
+	_decodeKernel.setArg(argIndex++, _hiddenStates[_front]);
+	_decodeKernel.setArg(argIndex++, feedBackStates);
+	_decodeKernel.setArg(argIndex++, predictions);
+	_decodeKernel.setArg(argIndex++, vl._predDecoderWeights[_back]);
+	_decodeKernel.setArg(argIndex++, vl._feedBackDecoderWeights[_back]);
+	_decodeKernel.setArg(argIndex++, _hiddenSize);
+	_decodeKernel.setArg(argIndex++, _feedBackSizes[vli]);
+	_decodeKernel.setArg(argIndex++, vl._visibleToHidden);
+	_decodeKernel.setArg(argIndex++, vl._visibleToFeedBack);
+	_decodeKernel.setArg(argIndex++, vld._predDecodeRadius);
+	_decodeKernel.setArg(argIndex++, vld._feedBackDecodeRadius);
+	_decodeKernel.setArg(argIndex++, vld._predictThresholded);
+	_decodeKernel.setArg(argIndex++, cl_int2{ 0, predictionsRowStart });
+
+	cs.getQueue().enqueueNDRangeKernel(_decodeKernel, cl::NDRange(0, rowStart), cl::NDRange(vld._size.x, rowCount));
+}
+
+void SparsePredictor::decompose(sys::ComputeSystem &cs, int numBands) {
+	_bands.clear();
+
+	numBands = std::min(numBands, _hiddenSize.y);
+
+	if (numBands <= 1 || cs.getNumSubQueues() == 0)
+		return;
+
+	MemoryScope scope("SparsePredictor bands");
+
+	_bands.resize(numBands);
+
+	for (int b = 0; b < numBands; b++) {
+		HiddenBand &band = _bands[b];
+
+		band._queueIndex = b % cs.getNumSubQueues();
+
+		band._rowStart = b * _hiddenSize.y / numBands;
+		band._rowEnd = (b + 1) * _hiddenSize.y / numBands;
+
+		// Inhibition reads lateral radius rows past the band
+		band._haloStart = std::max(0, band._rowStart - _lateralRadius);
+		band._haloEnd = std::min(_hiddenSize.y, band._rowEnd + _lateralRadius);
+
+		cl_int2 bandSize = { _hiddenSize.x, band._rowEnd - band._rowStart };
+
+		band._summation = createDoubleBuffer2D(cs, bandSize, CL_R, CL_FLOAT, "summation");
+		band._solveInput = createImage2D(cs, { _hiddenSize.x, band._haloEnd - band._haloStart }, CL_R, CL_FLOAT, "solveInput");
+		band._states = createImage2D(cs, bandSize, CL_R, CL_FLOAT, "states");
+
+		band._visibleRows.resize(_visibleLayers.size());
+		band._predictions.resize(_visibleLayers.size());
+
+		// Visible rows are split in the same proportions
+		for (int vli = 0; vli < _visibleLayers.size(); vli++) {
+			VisibleLayerDesc &vld = _visibleLayerDescs[vli];
+
+			band._visibleRows[vli] = { b * vld._size.y / numBands, (b + 1) * vld._size.y / numBands };
+
+			// Visible layers smaller than the number of bands leave some bands without rows
+			if (vld._predict && band._visibleRows[vli].x < band._visibleRows[vli].y)
+				band._predictions[vli] = createImage2D(cs, { vld._size.x, band._visibleRows[vli].y - band._visibleRows[vli].x }, CL_R, CL_FLOAT, "predictions");
+		}
+	}
+}
+
+void SparsePredictor::activateEncoderBands(sys::ComputeSystem &cs, const std::vector<cl::Image2D> &visibleStates, float activeRatio,
+	const TileChangeDetector* changes)
+{
+	// Encoding caches are shared between bands
+	assert(changes == nullptr);
+
+	cl::size_type width = static_cast<cl::size_type>(_hiddenSize.x);
+
+	// Bands start once everything before this step is done
+	cl::Event start;
+
+	cs.getQueue().enqueueMarkerWithWaitList(nullptr, &start);
+	cs.getQueue().flush();
+
+	std::vector<cl::Event> startEvents = { start };
+
+	// Encode, each band writes only its own images
+	for (int b = 0; b < _bands.size(); b++) {
+		HiddenBand &band = _bands[b];
+
+		cl::CommandQueue &bandQueue = cs.getSubQueue(band._queueIndex);
+
+		bandQueue.enqueueBarrierWithWaitList(&startEvents);
+
+		cl::CommandQueue mainQueue = cs.swapQueue(bandQueue);
+
+		encodeRows(cs, visibleStates, band._summation, band._rowStart, band._rowStart, band._rowEnd - band._rowStart, nullptr, 0);
+
+		cs.swapQueue(mainQueue);
+
+		bandQueue.enqueueMarkerWithWaitList(nullptr, &band._encoded);
+		bandQueue.flush();
+	}
+
+	// Halo exchange and solve. Inhibition reads lateral radius rows past the band, which are copied from the bands that own them
+	std::vector<cl::Event> solvedEvents;
+
+	for (int b = 0; b < _bands.size(); b++) {
+		HiddenBand &band = _bands[b];
+
+		cl::CommandQueue &bandQueue = cs.getSubQueue(band._queueIndex);
+
+		std::vector<cl::Event> haloEvents;
+
+		for (int n = 0; n < _bands.size(); n++)
+			if (n != b && _bands[n]._rowStart < band._haloEnd && _bands[n]._rowEnd > band._haloStart)
+				haloEvents.push_back(_bands[n]._encoded);
+
+		if (!haloEvents.empty())
+			bandQueue.enqueueBarrierWithWaitList(&haloEvents);
+
+		for (int n = 0; n < _bands.size(); n++) {
+			cl_int rowStart = std::max(band._haloStart, _bands[n]._rowStart);
+			cl_int rowEnd = std::min(band._haloEnd, _bands[n]._rowEnd);
+
+			if (rowStart >= rowEnd)
+				continue;
+
+			cl::array<cl::size_type, 3> srcOrigin = { 0, static_cast<cl::size_type>(rowStart - _bands[n]._rowStart), 0 };
+			cl::array<cl::size_type, 3> dstOrigin = { 0, static_cast<cl::size_type>(rowStart - band._haloStart), 0 };
+
+			bandQueue.enqueueCopyImage(_bands[n]._summation[_back], band._solveInput, srcOrigin, dstOrigin, { width, static_cast<cl::size_type>(rowEnd - rowStart), 1 });
+		}
+
+		cl::CommandQueue mainQueue = cs.swapQueue(bandQueue);
+
+		solveRows(cs, band._solveInput, band._haloStart, band._states, band._rowStart, band._rowStart, band._rowEnd - band._rowStart, activeRatio);
+
+		cs.swapQueue(mainQueue);
+
+		cl::Event solved;
+
+		bandQueue.enqueueMarkerWithWaitList(nullptr, &solved);
+		bandQueue.flush();
+
+		solvedEvents.push_back(solved);
+	}
+
+	// Gather the bands into the layer images, for the layers around this one and for learning
+	cs.getQueue().enqueueBarrierWithWaitList(&solvedEvents);
+
+	for (int b = 0; b < _bands.size(); b++) {
+		HiddenBand &band = _bands[b];
+
+		cl::array<cl::size_type, 3> bandOrigin = { 0, 0, 0 };
+		cl::array<cl::size_type, 3> rowsOrigin = { 0, static_cast<cl::size_type>(band._rowStart), 0 };
+		cl::array<cl::size_type, 3> rowsRegion = { width, static_cast<cl::size_type>(band._rowEnd - band._rowStart), 1 };
+
+		cs.getQueue().enqueueCopyImage(band._summation[_back], _hiddenActivationSummationTemp[_back], bandOrigin, rowsOrigin, rowsRegion);
+		cs.getQueue().enqueueCopyImage(band._states, _hiddenStates[_front], bandOrigin, rowsOrigin, rowsRegion);
+	}
+}
+
+void SparsePredictor::activateDecoderBands(sys::ComputeSystem &cs, const std::vector<cl::Image2D> &feedBackStates) {
+	// Decoding reads the gathered hidden states and the feed back, both complete once the main queue gets here
+	cl::Event start;
+
+	cs.getQueue().enqueueMarkerWithWaitList(nullptr, &start);
+	cs.getQueue().flush();
+
+	std::vector<cl::Event> startEvents = { start };
+	std::vector<cl::Event> decodedEvents;
+
+	for (int b = 0; b < _bands.size(); b++) {
+		HiddenBand &band = _bands[b];
+
+		cl::CommandQueue &bandQueue = cs.getSubQueue(band._queueIndex);
+
+		bandQueue.enqueueBarrierWithWaitList(&startEvents);
+
+		cl::CommandQueue mainQueue = cs.swapQueue(bandQueue);
+
+		// Visible layers smaller than the number of bands leave some bands without rows
+		for (int vli = 0; vli < _visibleLayers.size(); vli++) {
+			if (_visibleLayerDescs[vli]._predict && band._visibleRows[vli].x < band._visibleRows[vli].y)
+				decodeRows(cs, vli, feedBackStates[vli], band._predictions[vli], band._visibleRows[vli].x, band._visibleRows[vli].x, band._visibleRows[vli].y - band._visibleRows[vli].x);
+		}
+
+		cs.swapQueue(mainQueue);
+
+		cl::Event decoded;
+
+		bandQueue.enqueueMarkerWithWaitList(nullptr, &decoded);
+		bandQueue.flush();
+
+		decodedEvents.push_back(decoded);
+	}
+
+	cs.getQueue().enqueueBarrierWithWaitList(&decodedEvents);
+
+	for (int b = 0; b < _bands.size(); b++) {
+		HiddenBand &band = _bands[b];
+
+		for (int vli = 0; vli < _visibleLayers.size(); vli++) {
+			VisibleLayerDesc &vld = _visibleLayerDescs[vli];
+
+			if (!vld._predict || band._visibleRows[vli].x >= band._visibleRows[vli].y)
+				continue;
+
+			cl::array<cl::size_type, 3> bandOrigin = { 0, 0, 0 };
+			cl::array<cl::size_type, 3> rowsOrigin = { 0, static_cast<cl::size_type>(band._visibleRows[vli].x), 0 };
+
+			cs.getQueue().enqueueCopyImage(band._predictions[vli], _visibleLayers[vli]._predictions[_front], bandOrigin, rowsOrigin,
+				{ static_cast<cl::size_type>(vld._size.x), static_cast<cl::size_type>(band._visibleRows[vli].y - band._visibleRows[vli].x), 1 });
+		}
+	}
+}
+
+void SparsePredictor::freeze() {
+	// Activation only reads the _back weights and biases, the _front images are the targets of learning updates
+	for (int vli = 0; vli < _visibleLayers.size(); vli++) {
+		VisibleLayer &vl = _visibleLayers[vli];
+
+		vl._encoderWeights[_front] = cl::Image3D();
+		vl._predDecoderWeights[_front] = cl::Image3D();
+		vl._feedBackDecoderWeights[_front] = cl::Image3D();
+
+		vl._predError = cl::Image2D();
+	}
+
+	_hiddenBiases[_front] = cl::Image2D();
+
+	_hiddenErrorSummationTemp = DoubleBuffer2D();
+
+	_frozen = true;
+}
+
+void SparsePredictor::learn(sys::ComputeSystem &cs, const std::vector<cl::Image2D> &visibleStates,
+	const std::vector<cl::Image2D> &feedBackStatesPrev, const std::vector<cl::Image2D> &addidionalErrors, float weightEncodeAlpha, float weightDecodeAlpha, float weightLambda, float biasAlpha, float activeRatio)
+{
+	assert(!_frozen);
+
+	// Start by clearing error summation buffer
+	{
+		cl_float4 zeroColor = { 0.0f, 0.0f, 0.0f, 0.0f };
+
+		cl::array<cl::size_type, 3> zeroOrigin = { 0, 0, 0 };
+		cl::array<cl::size_type, 3> hiddenRegion = { _hiddenSize.x, _hiddenSize.y, 1 };
+
+		cs.getQueue().enqueueFillImage(_hiddenErrorSummationTemp[_back], zeroColor, zeroOrigin, hiddenRegion);
+	}
+
+	// Find error
+	for (int vli = 0; vli < _visibleLayers.size(); vli++) {
+		VisibleLayer &vl = _visibleLayers[vli];
+		VisibleLayerDesc &vld = _visibleLayerDescs[vli];
+
+		if (vld._predict) {
+			{
+				int argIndex = 0;
+
+				_predictionErrorKernel.setArg(argIndex++, vl._predictions[_front]);
+				_predictionErrorKernel.setArg(argIndex++, visibleStates[vli]);
+				_predictionErrorKernel.setArg(argIndex++, addidionalErrors[vli]);
+				_predictionErrorKernel.setArg(argIndex++, vl._predError);
+
+				cs.getQueue().enqueueNDRangeKernel(_predictionErrorKernel, cl::NullRange, cl::NDRange(vld._size.x, vld._size.y));
+			}
+
+			// Propagate the error
+			{
+				cl_int2 reversePredDecodeRadii = { static_cast<int>(std::ceil(vl._visibleToHidden.x * (vld._predDecodeRadius + 0.5f))), static_cast<int>(std::ceil(vl._visibleToHidden.y * (vld._predDecodeRadius + 0.5f))) };
+
+				int argIndex = 0;
+
+				_errorPropagationKernel.setArg(argIndex++, vl._predError);
+				_errorPropagationKernel.setArg(argIndex++, _hiddenErrorSummationTemp[_back]);
+				_errorPropagationKernel.setArg(argIndex++, _hiddenErrorSummationTemp[_front]);
+				_errorPropagationKernel.setArg(argIndex++, vl._predDecoderWeights[_back]);
+				_errorPropagationKernel.setArg(argIndex++, vld._size);
+				_errorPropagationKernel.setArg(argIndex++, _hiddenSize);
+				_errorPropagationKernel.setArg(argIndex++, vl._visibleToHidden);
+				_errorPropagationKernel.setArg(argIndex++, vl._hiddenToVisible);
+				_errorPropagationKernel.setArg(argIndex++, vld._predDecodeRadius);
+				_errorPropagationKernel.setArg(argIndex++, reversePredDecodeRadii);
+
+				cs.getQueue().enqueueNDRangeKernel(_errorPropagationKernel, cl::NullRange, cl::NDRange(_hiddenSize.x, _hiddenSize.y));
+			}
+
+			std::swap(_hiddenErrorSummationTemp[_front], _hiddenErrorSummationTemp[_back]);
+		}
+	}
+	
+	// Learn weights
+	for (int vli = 0; vli < _visibleLayers.size(); vli++) {
+		VisibleLayer &vl = _visibleLayers[vli];
+		VisibleLayerDesc &vld = _visibleLayerDescs[vli];
+
+		// Decoder
+		if (vld._predict) {
+			int argIndex = 0;
+
+			_learnDecoderWeightsKernel.setArg(argIndex++, vl._predError);
+			_learnDecoderWeightsKernel.setArg(argIndex++, _hiddenStates[_front]);
+			_learnDecoderWeightsKernel.setArg(argIndex++, feedBackStatesPrev[vli]);
+			_learnDecoderWeightsKernel.setArg(argIndex++, vl._predDecoderWeights[_back]);
+			_learnDecoderWeightsKernel.setArg(argIndex++, vl._predDecoderWeights[_front]);
+			_learnDecoderWeightsKernel.setArg(argIndex++, vl._feedBackDecoderWeights[_back]);
+			_learnDecoderWeightsKernel.setArg(argIndex++, vl._feedBackDecoderWeights[_front]);
+			_learnDecoderWeightsKernel.setArg(argIndex++, _hiddenSize);
+			_learnDecoderWeightsKernel.setArg(argIndex++, _feedBackSizes[vli]);
+			_learnDecoderWeightsKernel.setArg(argIndex++, vl._visibleToHidden);
+			_learnDecoderWeightsKernel.setArg(argIndex++, vl._visibleToFeedBack);
+			_learnDecoderWeightsKernel.setArg(argIndex++, vld._predDecodeRadius);
+			_learnDecoderWeightsKernel.setArg(argIndex++, vld._feedBackDecodeRadius);
+			_learnDecoderWeightsKernel.setArg(argIndex++, weightDecodeAlpha);
+
+			cs.getQueue().enqueueNDRangeKernel(_learnDecoderWeightsKernel, cl::NullRange, cl::NDRange(vld._size.x, vld._size.y));
+
+			std::swap(vl._predDecoderWeights[_front], vl._predDecoderWeights[_back]);
+			std::swap(vl._feedBackDecoderWeights[_front], vl._feedBackDecoderWeights[_back]);
+		}
+
+		// Encoder
+		if (vld._useForInput) {
+			int argIndex = 0;
+
+			_learnEncoderWeightsKernel.setArg(argIndex++, _hiddenErrorSummationTemp[_back]);
+			_learnEncoderWeightsKernel.setArg(argIndex++, _hiddenStates[_back]);
+			_learnEncoderWeightsKernel.setArg(argIndex++, _hiddenStates[_front]);
+			_learnEncoderWeightsKernel.setArg(argIndex++, _hiddenActivationSummationTemp[_back]);
+			_learnEncoderWeightsKernel.setArg(argIndex++, visibleStates[vli]);
+			_learnEncoderWeightsKernel.setArg(argIndex++, vl._encoderWeights[_back]);
+			_learnEncoderWeightsKernel.setArg(argIndex++, vl._encoderWeights[_front]);
+			_learnEncoderWeightsKernel.setArg(argIndex++, vld._size);
+			_learnEncoderWeightsKernel.setArg(argIndex++, vl._hiddenToVisible);
+			_learnEncoderWeightsKernel.setArg(argIndex++, vld._encodeRadius);
+			_learnEncoderWeightsKernel.setArg(argIndex++, weightEncodeAlpha);
+			_learnEncoderWeightsKernel.setArg(argIndex++, weightLambda);
+
+			cs.getQueue().enqueueNDRangeKernel(_learnEncoderWeightsKernel, cl::NullRange, cl::NDRange(_hiddenSize.x, _hiddenSize.y));
+
+			std::swap(vl._encoderWeights[_front], vl._encoderWeights[_back]);
+		}
+	}
+
+	// Biases
+	{
+		int argIndex = 0;
+
+		_learnBiasesKernel.setArg(argIndex++, _hiddenStates[_back]);
+		_learnBiasesKernel.setArg(argIndex++, _hiddenBiases[_back]);
+		_learnBiasesKernel.setArg(argIndex++, _hiddenBiases[_front]);
+		_learnBiasesKernel.setArg(argIndex++, biasAlpha);
+		_learnBiasesKernel.setArg(argIndex++, activeRatio);
+
+		cs.getQueue().enqueueNDRangeKernel(_learnBiasesKernel, cl::NullRange, cl::NDRange(_hiddenSize.x, _hiddenSize.y));
+
+		std::swap(_hiddenBiases[_front], _hiddenBiases[_back]);
+	}
 }
\ No newline at end of file
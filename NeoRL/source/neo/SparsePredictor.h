@@ -1,215 +1,343 @@
-#pragma once
-
-#include "Helpers.h"
-
-namespace neo {
-	/*!
-	\brief Sparse predictor
-	Learns a sparse code that is then used to predict the next input. Can be used with multiple layers
-	*/
-	class SparsePredictor {
-	public:
-		/*!
-		\brief Visible layer desc
-		*/
-		struct VisibleLayerDesc {
-			/*!
-			\brief Size of layer
-			*/
-			cl_int2 _size;
-
-			/*!
-			\brief Radius onto input
-			*/
-			cl_int _encodeRadius;
-
-			/*!
-			\brief Radius onto hidden
-			*/
-			cl_int _predDecodeRadius;
-
-			/*!
-			\brief Radius onto higher prediction
-			*/
-			cl_int _feedBackDecodeRadius;
-
-			/*!
-			\brief Whether or not the predictions should be binary
-			*/
-			unsigned char _predictThresholded;
-
-			/*!
-			\brief Whether or not the middle (center) input should be ignored (self in recurrent schemes)
-			*/
-			unsigned char _ignoreMiddle;
-
-			/*!
-			\brief Whether this layer should be predicted
-			*/
-			bool _predict;
-
-			/*!
-			\brief Whether this layer should be used as input (encoded)
-			*/
-			bool _useForInput;
-
-			/*!
-			\brief Initialize defaults
-			*/
-			VisibleLayerDesc()
-				: _size({ 8, 8 }), _encodeRadius(4), _predDecodeRadius(4), _feedBackDecodeRadius(4),
-				_predictThresholded(true), _ignoreMiddle(false), _predict(true), _useForInput(true)
-			{}
-		};
-
-		/*!
-		\brief Visible layer
-		*/
-		struct VisibleLayer {
-			/*!
-			\brief Predictions
-			*/
-			DoubleBuffer2D _predictions;
-
-			//!@{
-			/*!
-			\brief Temporary error buffers
-			*/
-			cl::Image2D _predError;
-			//!@}
-
-			//!@{
-			/*!
-			\brief Weights
-			*/
-			DoubleBuffer3D _encoderWeights; // Encoding weights (creates spatio-temporal sparse code)
-			DoubleBuffer3D _predDecoderWeights; // Predictive decoding weights (points to t + 1)
-			DoubleBuffer3D _feedBackDecoderWeights; // Feed back decoding weights (points to t + 1)
-			//!@}
-
-			//!@{
-			/*!
-			\brief Transformations
-			*/
-			cl_float2 _hiddenToVisible;
-			cl_float2 _visibleToHidden;
-			cl_float2 _visibleToFeedBack;
-			//!@}
-		};
-
-	private:
-		//!@{
-		/*!
-		\brief Hidden states, biases
-		*/
-		DoubleBuffer2D _hiddenStates;
-		DoubleBuffer2D _hiddenBiases;
-		//!@}
-
-		/*!
-		\brief Hidden size
-		*/
-		cl_int2 _hiddenSize;
-
-		/*!
-		\brief Feed back size
-		*/
-		std::vector<cl_int2> _feedBackSizes;
-
-		/*!
-		\brief Lateral (inhibitory) radius
-		*/
-		cl_int _lateralRadius;
-
-		/*!
-		\brief Hidden activation summation temporary buffer
-		*/
-		DoubleBuffer2D _hiddenActivationSummationTemp;
-
-		/*!
-		\brief Hidden error summation temporary buffer
-		*/
-		DoubleBuffer2D _hiddenErrorSummationTemp;
-
-		//!@{
-		/*!
-		\brief Layers and descs
-		*/
-		std::vector<VisibleLayerDesc> _visibleLayerDescs;
-		std::vector<VisibleLayer> _visibleLayers;
-		//!@}
-
-		//!@{
-		/*!
-		\brief Kernels
-		*/
-		cl::Kernel _encodeKernel;
-		cl::Kernel _decodeKernel;
-		cl::Kernel _solveHiddenKernel;
-		cl::Kernel _predictionErrorKernel;
-		cl::Kernel _errorPropagationKernel;
-		cl::Kernel _learnEncoderWeightsKernel;
-		cl::Kernel _learnDecoderWeightsKernel;
-		cl::Kernel _learnBiasesKernel;
-		//!@}
-
-	public:
-		/*!
-		\brief Create a comparison sparse coder with random initialization
-		Requires the compute system, program with the NeoRL kernels, and initialization information
-		*/
-		void createRandom(sys::ComputeSystem &cs, sys::ComputeProgram &program,
-			const std::vector<VisibleLayerDesc> &visibleLayerDescs, cl_int2 hiddenSize, const std::vector<cl_int2> &feedBackSizes, cl_int lateralRadius, cl_float2 initWeightRange,
-			std::mt19937 &rng);
-
-		/*!
-		\brief Activate predictor
-		*/
-		void activateEncoder(sys::ComputeSystem &cs, const std::vector<cl::Image2D> &visibleStates, float activeRatio);
-		void activateDecoder(sys::ComputeSystem &cs, const std::vector<cl::Image2D> &feedBackStates);
-
-		//!@{
-		/*!
-		\brief Learning functions
-		*/
-		void learn(sys::ComputeSystem &cs, const std::vector<cl::Image2D> &visibleStates,
-			const std::vector<cl::Image2D> &feedBackStatesPrev, const std::vector<cl::Image2D> &addidionalErrors,
-			float weightEncodeAlpha, float weightDecodeAlpha, float weightLambda, float biasAlpha, float activeRatio);
-		//!@}
-
-		/*!
-		\brief Get number of visible layers
-		*/
-		size_t getNumVisibleLayers() const {
-			return _visibleLayers.size();
-		}
-
-		/*!
-		\brief Get access to visible layer
-		*/
-		const VisibleLayer &getVisibleLayer(int index) const {
-			return _visibleLayers[index];
-		}
-
-		/*!
-		\brief Get access to visible layer
-		*/
-		const VisibleLayerDesc &getVisibleLayerDesc(int index) const {
-			return _visibleLayerDescs[index];
-		}
-
-		/*!
-		\brief Get hidden size
-		*/
-		cl_int2 getHiddenSize() const {
-			return _hiddenSize;
-		}
-
-		/*!
-		\brief Get hidden states
-		*/
-		const DoubleBuffer2D &getHiddenStates() const {
-			return _hiddenStates;
-		}
-	};
+#pragma once
+
+#include "Helpers.h"
+#include "TileChangeDetector.h"
+
+namespace neo {
+	/*!
+	\brief Sparse predictor
+	Learns a sparse code that is then used to predict the next input. Can be used with multiple layers
+	*/
+	class SparsePredictor {
+	public:
+		/*!
+		\brief Visible layer desc
+		*/
+		struct VisibleLayerDesc {
+			/*!
+			\brief Size of layer
+			*/
+			cl_int2 _size;
+
+			/*!
+			\brief Radius onto input
+			*/
+			cl_int _encodeRadius;
+
+			/*!
+			\brief Radius onto hidden
+			*/
+			cl_int _predDecodeRadius;
+
+			/*!
+			\brief Radius onto higher prediction
+			*/
+			cl_int _feedBackDecodeRadius;
+
+			/*!
+			\brief Whether or not the predictions should be binary
+			*/
+			unsigned char _predictThresholded;
+
+			/*!
+			\brief Whether or not the middle (center) input should be ignored (self in recurrent schemes)
+			*/
+			unsigned char _ignoreMiddle;
+
+			/*!
+			\brief Whether this layer should be predicted
+			*/
+			bool _predict;
+
+			/*!
+			\brief Whether this layer should be used as input (encoded)
+			*/
+			bool _useForInput;
+
+			/*!
+			\brief Whether the encoding of this layer is only recomputed where its input changed (when given a change detector)
+			*/
+			bool _encodeChanged;
+
+			/*!
+			\brief Initialize defaults
+			*/
+			VisibleLayerDesc()
+				: _size({ 8, 8 }), _encodeRadius(4), _predDecodeRadius(4), _feedBackDecodeRadius(4),
+				_predictThresholded(true), _ignoreMiddle(false), _predict(true), _useForInput(true), _encodeChanged(false)
+			{}
+		};
+
+		/*!
+		\brief Visible layer
+		*/
+		struct VisibleLayer {
+			/*!
+			\brief Predictions
+			*/
+			DoubleBuffer2D _predictions;
+
+			//!@{
+			/*!
+			\brief Temporary error buffers
+			*/
+			cl::Image2D _predError;
+			//!@}
+
+			//!@{
+			/*!
+			\brief Weights
+			*/
+			DoubleBuffer3D _encoderWeights; // Encoding weights (creates spatio-temporal sparse code)
+			DoubleBuffer3D _predDecoderWeights; // Predictive decoding weights (points to t + 1)
+			DoubleBuffer3D _feedBackDecoderWeights; // Feed back decoding weights (points to t + 1)
+			//!@}
+
+			/*!
+			\brief Contribution of this layer to the hidden activations, reused where the input did not change
+			*/
+			DoubleBuffer2D _encodeCache;
+
+			//!@{
+			/*!
+			\brief Transformations
+			*/
+			cl_float2 _hiddenToVisible;
+			cl_float2 _visibleToHidden;
+			cl_float2 _visibleToFeedBack;
+			//!@}
+		};
+
+	private:
+		//!@{
+		/*!
+		\brief Hidden states, biases
+		*/
+		DoubleBuffer2D _hiddenStates;
+		DoubleBuffer2D _hiddenBiases;
+		//!@}
+
+		/*!
+		\brief Hidden size
+		*/
+		cl_int2 _hiddenSize;
+
+		/*!
+		\brief Feed back size
+		*/
+		std::vector<cl_int2> _feedBackSizes;
+
+		/*!
+		\brief Lateral (inhibitory) radius
+		*/
+		cl_int _lateralRadius;
+
+		/*!
+		\brief Whether the inhibition tile fits in local memory, otherwise the untiled kernel is used
+		*/
+		bool _useTiledSolve;
+
+		/*!
+		\brief Whether the learning state was released (see freeze)
+		*/
+		bool _frozen;
+
+		/*!
+		\brief Hidden activation summation temporary buffer
+		*/
+		DoubleBuffer2D _hiddenActivationSummationTemp;
+
+		/*!
+		\brief Band of hidden rows run on its own sub-device queue (see decompose)
+		Bands write only into their own images, which hold just the band rows (plus the inhibition halo for the solve input).
+		The kernels still run on the layer's row range and are given the first row of each image as its origin
+		*/
+		struct HiddenBand {
+			//!@{
+			/*!
+			\brief Hidden rows [start, end), the rows [haloStart, haloEnd) inhibition reads and, per visible layer, the visible rows (x = start, y = end) it computes
+			*/
+			cl_int _rowStart;
+			cl_int _rowEnd;
+			cl_int _haloStart;
+			cl_int _haloEnd;
+			std::vector<cl_int2> _visibleRows;
+			//!@}
+
+			/*!
+			\brief Index of the sub-device queue
+			*/
+			int _queueIndex;
+
+			//!@{
+			/*!
+			\brief Band activation sums, the sums plus the halo of the neighbouring bands, states and predictions
+			*/
+			DoubleBuffer2D _summation;
+			cl::Image2D _solveInput;
+			cl::Image2D _states;
+			std::vector<cl::Image2D> _predictions;
+			//!@}
+
+			/*!
+			\brief Marks the band sums as complete for the neighbours' halo copies
+			*/
+			cl::Event _encoded;
+		};
+
+		/*!
+		\brief Bands of a decomposed layer, empty if not decomposed
+		*/
+		std::vector<HiddenBand> _bands;
+
+		/*!
+		\brief Hidden error summation temporary buffer
+		*/
+		DoubleBuffer2D _hiddenErrorSummationTemp;
+
+		//!@{
+		/*!
+		\brief Layers and descs
+		*/
+		std::vector<VisibleLayerDesc> _visibleLayerDescs;
+		std::vector<VisibleLayer> _visibleLayers;
+		//!@}
+
+		//!@{
+		/*!
+		\brief Kernels
+		*/
+		cl::Kernel _encodeKernel;
+		cl::Kernel _encode2Kernel;
+		cl::Kernel _encodeChangedKernel;
+		cl::Kernel _decodeKernel;
+		cl::Kernel _solveHiddenKernel;
+		cl::Kernel _solveHiddenTiledKernel;
+		cl::Kernel _predictionErrorKernel;
+		cl::Kernel _errorPropagationKernel;
+		cl::Kernel _learnEncoderWeightsKernel;
+		cl::Kernel _learnDecoderWeightsKernel;
+		cl::Kernel _learnBiasesKernel;
+		//!@}
+
+		//!@{
+		/*!
+		\brief Activation over a range of rows, enqueued on the current queue of the compute system
+		The images passed in hold the rows from their row start argument on (0 for full layer images)
+		*/
+		void encodeRows(sys::ComputeSystem &cs, const std::vector<cl::Image2D> &visibleStates, DoubleBuffer2D &summation, cl_int summationRowStart,
+			cl_int rowStart, cl_int rowCount, const TileChangeDetector* changes, cl_int changeDilation);
+		void solveRows(sys::ComputeSystem &cs, const cl::Image2D &summation, cl_int summationRowStart, const cl::Image2D &hiddenStates, cl_int statesRowStart,
+			cl_int rowStart, cl_int rowCount, float activeRatio);
+		void decodeRows(sys::ComputeSystem &cs, int vli, const cl::Image2D &feedBackStates, const cl::Image2D &predictions, cl_int predictionsRowStart,
+			cl_int rowStart, cl_int rowCount);
+		//!@}
+
+		//!@{
+		/*!
+		\brief Decomposed activation
+		*/
+		void activateEncoderBands(sys::ComputeSystem &cs, const std::vector<cl::Image2D> &visibleStates, float activeRatio,
+			const TileChangeDetector* changes);
+		void activateDecoderBands(sys::ComputeSystem &cs, const std::vector<cl::Image2D> &feedBackStates);
+		//!@}
+
+	public:
+		/*!
+		\brief Create a comparison sparse coder with random initialization
+		Requires the compute system, program with the NeoRL kernels, and initialization information
+		*/
+		void createRandom(sys::ComputeSystem &cs, sys::ComputeProgram &program,
+			const std::vector<VisibleLayerDesc> &visibleLayerDescs, cl_int2 hiddenSize, const std::vector<cl_int2> &feedBackSizes, cl_int lateralRadius, cl_float2 initWeightRange,
+			std::mt19937 &rng);
+
+		/*!
+		\brief Activate predictor
+		Layers with _encodeChanged are only re-encoded near tiles flagged by changes, if given.
+		changeDilation widens the footprint, for inputs that were filtered after detection (e.g. the whitening radius)
+		*/
+		void activateEncoder(sys::ComputeSystem &cs, const std::vector<cl::Image2D> &visibleStates, float activeRatio,
+			const TileChangeDetector* changes = nullptr, cl_int changeDilation = 0);
+		void activateDecoder(sys::ComputeSystem &cs, const std::vector<cl::Image2D> &feedBackStates);
+
+		/*!
+		\brief Split activation of the hidden grid into bands of rows, spread over the sub-device queues of the compute system
+		Bands encode their rows, exchange the lateral radius rows the inhibition reads across band edges, solve, and decode the matching visible rows.
+		Results are identical to the undecomposed layer. Learning still runs on the whole layer.
+		Band images hold only the band's rows, so all bands together add about one layer's activation images plus the halos.
+		Change driven encoding is not supported while decomposed. numBands <= 1 (or no sub-devices) removes the decomposition
+		*/
+		void decompose(sys::ComputeSystem &cs, int numBands);
+
+		/*!
+		\brief Number of bands, 0 if not decomposed
+		*/
+		size_t getNumBands() const {
+			return _bands.size();
+		}
+
+		/*!
+		\brief Release everything only learning uses (front weight and bias buffers, error buffers), keeping inference intact
+		Learning is no longer possible afterwards
+		*/
+		void freeze();
+
+		/*!
+		\brief Whether freeze was called
+		*/
+		bool isFrozen() const {
+			return _frozen;
+		}
+
+		//!@{
+		/*!
+		\brief Learning functions
+		*/
+		void learn(sys::ComputeSystem &cs, const std::vector<cl::Image2D> &visibleStates,
+			const std::vector<cl::Image2D> &feedBackStatesPrev, const std::vector<cl::Image2D> &addidionalErrors,
+			float weightEncodeAlpha, float weightDecodeAlpha, float weightLambda, float biasAlpha, float activeRatio);
+		//!@}
+
+		/*!
+		\brief Get number of visible layers
+		*/
+		size_t getNumVisibleLayers() const {
+			return _visibleLayers.size();
+		}
+
+		/*!
+		\brief Get access to visible layer
+		*/
+		const VisibleLayer &getVisibleLayer(int index) const {
+			return _visibleLayers[index];
+		}
+
+		/*!
+		\brief Get access to visible layer
+		*/
+		const VisibleLayerDesc &getVisibleLayerDesc(int index) const {
+			return _visibleLayerDescs[index];
+		}
+
+		/*!
+		\brief Get hidden size
+		*/
+		cl_int2 getHiddenSize() const {
+			return _hiddenSize;
+		}
+
+		/*!
+		\brief Get hidden states
+		*/
+		const DoubleBuffer2D &getHiddenStates() const {
+			return _hiddenStates;
+		}
+
+		/*!
+		\brief Get hidden biases
+		*/
+		const DoubleBuffer2D &getHiddenBiases() const {
+			return _hiddenBiases;
+		}
+	};
 }
\ No newline at end of file
@@ -0,0 +1,77 @@
+#include "TileChangeDetector.h"
+
+using namespace neo;
+
+void TileChangeDetector::create(sys::ComputeSystem &cs, sys::ComputeProgram &program, cl_int2 imageSize, cl_int tileSize) {
+	if (!program.requireModules(cs, { "whitening" })) {
+		assert(false);
+
+		return;
+	}
+
+	MemoryScope scope("TileChangeDetector");
+
+	cl_float4 zeroColor = { 0.0f, 0.0f, 0.0f, 0.0f };
+
+	cl::array<cl::size_type, 3> zeroOrigin = { 0, 0, 0 };
+	cl::array<cl::size_type, 3> imageRegion = { imageSize.x, imageSize.y, 1 };
+
+	_imageSize = imageSize;
+	_tileSize = tileSize;
+
+	_tileCounts = cl_int2{ (imageSize.x + tileSize - 1) / tileSize, (imageSize.y + tileSize - 1) / tileSize };
+
+	_inputPrev = createDoubleBuffer2D(cs, _imageSize, CL_RGBA, CL_FLOAT, "inputPrev");
+
+	cs.getQueue().enqueueFillImage(_inputPrev[_back], zeroColor, zeroOrigin, imageRegion);
+
+	_changedTiles = createBuffer(cs, CL_MEM_READ_WRITE, _tileCounts.x * _tileCounts.y * sizeof(cl_int), "changedTiles");
+	_changedCount = createBuffer(cs, CL_MEM_READ_WRITE, sizeof(cl_int), "changedCount");
+
+	cs.getQueue().enqueueFillBuffer<cl_int>(_changedCount, 0, 0, sizeof(cl_int));
+
+	_detectKernel = cl::Kernel(program.getProgram(), "detectChangedTiles");
+
+	_maxChangedTiles = -1;
+	_primed = false;
+}
+
+void TileChangeDetector::detect(sys::ComputeSystem &cs, const cl::Image2D &input, cl_float threshold, cl_float maxChangedFraction) {
+	cs.getQueue().enqueueFillBuffer<cl_int>(_changedCount, 0, 0, sizeof(cl_int));
+
+	int argIndex = 0;
+
+	_detectKernel.setArg(argIndex++, input);
+	_detectKernel.setArg(argIndex++, _inputPrev[_back]);
+	_detectKernel.setArg(argIndex++, _inputPrev[_front]);
+	_detectKernel.setArg(argIndex++, _changedTiles);
+	_detectKernel.setArg(argIndex++, _changedCount);
+	_detectKernel.setArg(argIndex++, _imageSize);
+	_detectKernel.setArg(argIndex++, _tileSize);
+	_detectKernel.setArg(argIndex++, threshold);
+
+	cs.getQueue().enqueueNDRangeKernel(_detectKernel, cl::NullRange, cl::NDRange(_tileCounts.x, _tileCounts.y));
+
+	std::swap(_inputPrev[_front], _inputPrev[_back]);
+
+	// The fallback is decided on the device from the changed count, so no read back is needed here
+	_maxChangedTiles = _primed ? static_cast<cl_int>(maxChangedFraction * _tileCounts.x * _tileCounts.y) : -1;
+
+	_primed = true;
+}
+
+void TileChangeDetector::setChangeArgs(cl::Kernel &kernel, int &argIndex) const {
+	kernel.setArg(argIndex++, _changedTiles);
+	kernel.setArg(argIndex++, _changedCount);
+	kernel.setArg(argIndex++, _maxChangedTiles);
+	kernel.setArg(argIndex++, _tileCounts);
+	kernel.setArg(argIndex++, _tileSize);
+}
+
+float TileChangeDetector::getChangedFraction(sys::ComputeSystem &cs) const {
+	cl_int changedCount = 0;
+
+	cs.getQueue().enqueueReadBuffer(_changedCount, CL_TRUE, 0, sizeof(cl_int), &changedCount);
+
+	return static_cast<float>(changedCount) / static_cast<float>(_tileCounts.x * _tileCounts.y);
+}
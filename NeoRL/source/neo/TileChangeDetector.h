@@ -0,0 +1,110 @@
+#pragma once
+
+#include "Helpers.h"
+
+namespace neo {
+	/*!
+	\brief Tile change detector
+	Compares each tile of an input image against the previous frame on the device and keeps per-tile changed flags.
+	Kernels that take the flags recompute only outputs whose footprint touches a changed tile
+	*/
+	class TileChangeDetector {
+	private:
+		/*!
+		\brief Kernels
+		*/
+		cl::Kernel _detectKernel;
+
+		/*!
+		\brief Copy of the last frame, compared against in the next detection
+		*/
+		DoubleBuffer2D _inputPrev;
+
+		//!@{
+		/*!
+		\brief Changed flag per tile (int) and number of changed tiles
+		*/
+		cl::Buffer _changedTiles;
+		cl::Buffer _changedCount;
+		//!@}
+
+		//!@{
+		/*!
+		\brief Sizes
+		*/
+		cl_int2 _imageSize;
+		cl_int2 _tileCounts;
+		cl_int _tileSize;
+		//!@}
+
+		/*!
+		\brief Above this many changed tiles, everything is recomputed. -1 forces a full recompute
+		*/
+		cl_int _maxChangedTiles;
+
+		/*!
+		\brief Whether a frame has been stored yet
+		*/
+		bool _primed;
+
+	public:
+		/*!
+		\brief Initialize defaults
+		*/
+		TileChangeDetector()
+			: _maxChangedTiles(-1), _primed(false)
+		{}
+
+		/*!
+		\brief Create the change detector
+		Requires the image size and the tile edge length
+		*/
+		void create(sys::ComputeSystem &cs, sys::ComputeProgram &program, cl_int2 imageSize, cl_int tileSize = 8);
+
+		/*!
+		\brief Detect changed tiles of a new frame
+		A pixel counts as changed when any channel differs by more than threshold. When more than maxChangedFraction of the tiles changed,
+		users fall back to a full recompute. Cached results go stale when anything but the input changes (e.g. learned weights),
+		users then call invalidate
+		*/
+		void detect(sys::ComputeSystem &cs, const cl::Image2D &input, cl_float threshold = 0.0f, cl_float maxChangedFraction = 0.5f);
+
+		/*!
+		\brief Force a full recompute on the next detection
+		*/
+		void invalidate() {
+			_primed = false;
+		}
+
+		/*!
+		\brief Set the change arguments (flags, count, max changed tiles, tile counts, tile size) of a kernel, in that order
+		*/
+		void setChangeArgs(cl::Kernel &kernel, int &argIndex) const;
+
+		/*!
+		\brief Read back the fraction of tiles that changed in the last detection (blocking, for diagnostics)
+		*/
+		float getChangedFraction(sys::ComputeSystem &cs) const;
+
+		/*!
+		\brief Whether the last detection forced a full recompute
+		*/
+		bool isFullRecompute() const {
+			return _maxChangedTiles < 0;
+		}
+
+		/*!
+		\brief Get the image size
+		*/
+		cl_int2 getImageSize() const {
+			return _imageSize;
+		}
+
+		/*!
+		\brief Get the tile edge length
+		*/
+		cl_int getTileSize() const {
+			return _tileSize;
+		}
+	};
+}
@@ -1,38 +1,154 @@
-#include "ComputeProgram.h"
-
-#include <fstream>
-#include <iostream>
-
-using namespace sys;
-
-bool ComputeProgram::loadFromFile(const std::string &name, ComputeSystem &cs) {
-	std::ifstream fromFile(name);
-
-	if (!fromFile.is_open()) {
-#ifdef SYS_DEBUG
-		std::cerr << "Could not open file " << name << "!" << std::endl;
-#endif
-		return false;
-	}
-
-	std::string source = "";
-
-	while (!fromFile.eof() && fromFile.good()) {
-		std::string line; 
-
-		std::getline(fromFile, line);
-
-		source += line + "\n";
-	}
-
-	_program = cl::Program(cs.getContext(), source);
-
-	if (_program.build(std::vector<cl::Device>(1, cs.getDevice())) != CL_SUCCESS) {
-#ifdef SYS_DEBUG
-		std::cerr << "Error building: " << _program.getBuildInfo<CL_PROGRAM_BUILD_LOG>(cs.getDevice()) << std::endl;
-#endif
-		return false;
-	}
-
-	return true;
-}
\ No newline at end of file
+#include "ComputeProgram.h"
+
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+#include <cstdlib>
+
+#ifdef NEO_EMBEDDED_KERNELS
+#include <neoKernelSources.h>
+#endif
+
+using namespace sys;
+
+namespace {
+	bool readSource(const std::string &name, std::string &source) {
+		std::ifstream fromFile(name, std::ios::binary);
+
+		if (!fromFile.is_open()) {
+#ifdef SYS_DEBUG
+			std::cerr << "Could not open file " << name << "!" << std::endl;
+#endif
+			return false;
+		}
+
+		// Read in one go
+		fromFile.seekg(0, std::ios::end);
+
+		source.resize(static_cast<size_t>(fromFile.tellg()));
+
+		fromFile.seekg(0, std::ios::beg);
+		fromFile.read(&source[0], source.size());
+
+		return true;
+	}
+}
+
+bool ComputeProgram::loadFromFile(const std::string &name, ComputeSystem &cs) {
+	std::string source;
+
+	if (!readSource(name, source))
+		return false;
+
+	_useModules = false;
+	_moduleDirectory = "";
+	_moduleNames.clear();
+	_modules.clear();
+
+	_program = cl::Program(cs.getContext(), source);
+
+	if (_program.build(cs.getContextDevices()) != CL_SUCCESS) {
+#ifdef SYS_DEBUG
+		std::cerr << "Error building: " << _program.getBuildInfo<CL_PROGRAM_BUILD_LOG>(cs.getDevice()) << std::endl;
+#endif
+		return false;
+	}
+
+	return true;
+}
+
+bool ComputeProgram::loadModules(const std::string &directory, ComputeSystem &cs) {
+	_moduleDirectory = directory;
+
+	if (!readModule("common", _commonSource))
+		return false;
+
+	_useModules = true;
+	_moduleNames.clear();
+	_modules.clear();
+
+	_program = cl::Program();
+
+	return true;
+}
+
+bool ComputeProgram::loadModules(ComputeSystem &cs) {
+	const char* overridePath = std::getenv("NEORL_KERNEL_PATH");
+
+	if (overridePath != nullptr)
+		return loadModules(overridePath, cs);
+
+#ifdef NEO_EMBEDDED_KERNELS
+	return loadModules("", cs);
+#else
+	return loadModules("resources/kernels", cs);
+#endif
+}
+
+bool ComputeProgram::readModule(const std::string &name, std::string &source) const {
+	if (!_moduleDirectory.empty())
+		return readSource(_moduleDirectory + "/" + name + ".cl", source);
+
+#ifdef NEO_EMBEDDED_KERNELS
+	for (const neoKernels::Source* embedded = neoKernels::sources; embedded->_name != nullptr; embedded++)
+		if (name == embedded->_name) {
+			source = reinterpret_cast<const char*>(embedded->_data);
+
+			return true;
+		}
+#endif
+
+#ifdef SYS_DEBUG
+	std::cerr << "No kernel module named " << name << "!" << std::endl;
+#endif
+
+	return false;
+}
+
+bool ComputeProgram::requireModules(ComputeSystem &cs, const std::vector<std::string> &names) {
+	if (!_useModules)
+		return true;
+
+	bool added = false;
+
+	for (int i = 0; i < names.size(); i++) {
+		if (std::find(_moduleNames.begin(), _moduleNames.end(), names[i]) != _moduleNames.end())
+			continue;
+
+		std::string source;
+
+		if (!readModule(names[i], source))
+			return false;
+
+		// Common helpers are static, every module compiles its own copy
+		cl::Program module(cs.getContext(), _commonSource + source);
+
+		if (module.compile(_compileOptions.c_str()) != CL_SUCCESS) {
+#ifdef SYS_DEBUG
+			std::cerr << "Error compiling module " << names[i] << ": " << module.getBuildInfo<CL_PROGRAM_BUILD_LOG>(cs.getDevice()) << std::endl;
+#endif
+			return false;
+		}
+
+		_moduleNames.push_back(names[i]);
+		_modules.push_back(module);
+
+		added = true;
+	}
+
+	if (!added)
+		return true;
+
+	cl_int error;
+
+	_program = cl::linkProgram(_modules, nullptr, nullptr, nullptr, &error);
+
+	if (error != CL_SUCCESS) {
+#ifdef SYS_DEBUG
+		std::cerr << "Error linking modules: " << _program.getBuildInfo<CL_PROGRAM_BUILD_LOG>(cs.getDevice()) << std::endl;
+#endif
+		return false;
+	}
+
+	return true;
+}
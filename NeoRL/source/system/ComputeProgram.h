@@ -1,33 +1,90 @@
-#pragma once
-
-#include <system/ComputeSystem.h>
-
-#include <assert.h>
-
-namespace sys {
-	/*!
-	\brief Compute program
-	Holds OpenCL compute program with their associated kernels
-	*/
-	class ComputeProgram {
-	private:
-		/*!
-		\brief OpenCL program
-		*/
-		cl::Program _program;
-
-	public:
-		/*!
-		\brief Load from file
-		Load program from a file
-		*/
-		bool loadFromFile(const std::string &name, ComputeSystem &cs);
-
-		/*!
-		\brief Get the underlying OpenCL program
-		*/
-		cl::Program &getProgram() {
-			return _program;
-		}
-	};
-}
\ No newline at end of file
+#pragma once
+
+#include <system/ComputeSystem.h>
+
+#include <assert.h>
+
+namespace sys {
+	/*!
+	\brief Compute program
+	Holds OpenCL compute program with their associated kernels
+	*/
+	class ComputeProgram {
+	private:
+		/*!
+		\brief OpenCL program
+		*/
+		cl::Program _program;
+
+		//!@{
+		/*!
+		\brief Module library (see loadModules)
+		Whether it is in use, directory (empty for the embedded sources), source of the common part every module is compiled with,
+		and the compiled modules in link order
+		*/
+		bool _useModules;
+		std::string _moduleDirectory;
+		std::string _commonSource;
+		std::vector<std::string> _moduleNames;
+		std::vector<cl::Program> _modules;
+		//!@}
+
+		/*!
+		\brief Options modules are compiled with
+		*/
+		std::string _compileOptions;
+
+		/*!
+		\brief Get the source of a module, from the directory or embedded
+		*/
+		bool readModule(const std::string &name, std::string &source) const;
+
+	public:
+		/*!
+		\brief Initialize defaults
+		*/
+		ComputeProgram()
+			: _useModules(false), _compileOptions("-cl-std=CL1.2")
+		{}
+
+		/*!
+		\brief Load from file
+		Load program from a file
+		*/
+		bool loadFromFile(const std::string &name, ComputeSystem &cs);
+
+		/*!
+		\brief Use the kernel modules in a directory (common.cl plus one file per module)
+		Nothing is compiled yet, modules are compiled when first required and linked into the program
+		*/
+		bool loadModules(const std::string &directory, ComputeSystem &cs);
+
+		/*!
+		\brief Use the kernel modules compiled into the binary (see EmbedKernels.cmake), no files are read
+		The environment variable NEORL_KERNEL_PATH overrides them with a module directory, for working on the kernels without rebuilding.
+		Builds without embedded kernels fall back to resources/kernels
+		*/
+		bool loadModules(ComputeSystem &cs);
+
+		/*!
+		\brief Set the options modules are compiled with (default "-cl-std=CL1.2"), applies to modules not compiled yet
+		*/
+		void setCompileOptions(const std::string &options) {
+			_compileOptions = options;
+		}
+
+		/*!
+		\brief Compile the named modules if they are not yet, and relink the program with them
+		Kernels created earlier keep working. Does nothing if the program was loaded whole (loadFromFile).
+		Every call that adds modules links again, so models require everything their parts need in one call up front
+		*/
+		bool requireModules(ComputeSystem &cs, const std::vector<std::string> &names);
+
+		/*!
+		\brief Get the underlying OpenCL program
+		*/
+		cl::Program &getProgram() {
+			return _program;
+		}
+	};
+}
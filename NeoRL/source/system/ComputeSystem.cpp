@@ -1,94 +1,300 @@
-#include "ComputeSystem.h"
-
-#include <iostream>
-
-using namespace sys;
-
-bool ComputeSystem::create(DeviceType type, bool createFromGLContext) {
-	if (type == _none) {
-#ifdef SYS_DEBUG
-		std::cout << "No OpenCL context created." << std::endl;
-#endif
-		return true;
-	}
-
-	std::vector<cl::Platform> allPlatforms;
-	cl::Platform::get(&allPlatforms);
-
-	if (allPlatforms.empty()) {
-#ifdef SYS_DEBUG
-		std::cout << "No platforms found. Check your OpenCL installation." << std::endl;
-#endif
-		return false;
-	}
-
-	_platform = allPlatforms.front();
-
-#ifdef SYS_DEBUG
-	std::cout << "Using platform: " << _platform.getInfo<CL_PLATFORM_NAME>() << std::endl;
-#endif
-
-	std::vector<cl::Device> allDevices;
-
-	switch (type) {
-	case _cpu:
-		_platform.getDevices(CL_DEVICE_TYPE_CPU, &allDevices);
-		break;
-	case _gpu:
-		_platform.getDevices(CL_DEVICE_TYPE_GPU, &allDevices);
-		break;
-	case _all:
-		_platform.getDevices(CL_DEVICE_TYPE_ALL, &allDevices);
-		break;
-	}
-
-	if (allDevices.empty()) {
-#ifdef SYS_DEBUG
-		std::cout << "No devices found. Check your OpenCL installation." << std::endl;
-#endif
-		return false;
-	}
-
-	_device = allDevices.front();
-
-#ifdef SYS_DEBUG
-	std::cout << "Using device: " << _device.getInfo<CL_DEVICE_NAME>() << std::endl;
-#endif
-	
-#if(SYS_ALLOW_CL_GL_CONTEXT)
-	if (createFromGLContext) {
-#if defined (__APPLE__) || defined(MACOSX)
-		CGLContextObj kCGLContext = CGLGetCurrentContext();
-		CGLShareGroupObj kCGLShareGroup = CGLGetShareGroup(kCGLContext);
-		cl_context_properties props[] = {
-			CL_CONTEXT_PROPERTY_USE_CGL_SHAREGROUP_APPLE, (cl_context_properties)kCGLShareGroup,
-			0
-		};
-#else
-#if defined WIN32
-		cl_context_properties props[] = {
-			CL_GL_CONTEXT_KHR, (cl_context_properties)wglGetCurrentContext(),
-			CL_WGL_HDC_KHR, (cl_context_properties)wglGetCurrentDC(),
-			CL_CONTEXT_PLATFORM, (cl_context_properties)static_cast<cl_platform_id>(_platform()),
-			0
-		};
-#else
-		cl_context_properties props[] = {
-			CL_GL_CONTEXT_KHR, (cl_context_properties)glXGetCurrentContext(),
-			CL_GLX_DISPLAY_KHR, (cl_context_properties)glXGetCurrentDisplay(),
-			CL_CONTEXT_PLATFORM, (cl_context_properties)static_cast<cl_platform_id>(_platform()),
-			0
-		};
-#endif
-#endif
-
-		_context = cl::Context(_device, props);
-	}
-	else
-#endif
-		_context = _device;
-
-	_queue = cl::CommandQueue(_context, _device);
-
-	return true;
+#include "ComputeSystem.h"
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <cstdlib>
+#include <cctype>
+
+using namespace sys;
+
+ComputeSystem::CalibrationFunction ComputeSystem::_calibration;
+std::string ComputeSystem::_calibrationKey;
+
+std::vector<ComputeSystem::DeviceDesc> ComputeSystem::listDevices() {
+	std::vector<DeviceDesc> devices;
+
+	std::vector<cl::Platform> allPlatforms;
+	cl::Platform::get(&allPlatforms);
+
+	for (int p = 0; p < allPlatforms.size(); p++) {
+		std::vector<cl::Device> platformDevices;
+
+		allPlatforms[p].getDevices(CL_DEVICE_TYPE_ALL, &platformDevices);
+
+		for (int d = 0; d < platformDevices.size(); d++) {
+			DeviceDesc desc;
+
+			desc._platform = allPlatforms[p];
+			desc._device = platformDevices[d];
+			desc._platformName = allPlatforms[p].getInfo<CL_PLATFORM_NAME>();
+			desc._deviceName = platformDevices[d].getInfo<CL_DEVICE_NAME>();
+			desc._type = platformDevices[d].getInfo<CL_DEVICE_TYPE>();
+
+			devices.push_back(desc);
+		}
+	}
+
+	return devices;
+}
+
+int ComputeSystem::selectAuto(const std::vector<DeviceDesc> &devices) {
+	if (!_calibration) {
+		for (int i = 0; i < devices.size(); i++)
+			if (devices[i]._type & CL_DEVICE_TYPE_GPU)
+				return i;
+
+		return 0;
+	}
+
+	const char* cacheName = std::getenv("NEORL_DEVICE_CACHE");
+
+	std::string cacheFileName = cacheName != nullptr ? cacheName : "neoDevice.cache";
+
+	// Cache lines are: key, platform name, device name, tab separated
+	std::vector<std::string> cacheLines;
+
+	{
+		std::ifstream fromFile(cacheFileName);
+
+		std::string line;
+
+		while (std::getline(fromFile, line)) {
+			std::istringstream fields(line);
+
+			std::string key, platformName, deviceName;
+
+			std::getline(fields, key, '\t');
+			std::getline(fields, platformName, '\t');
+			std::getline(fields, deviceName, '\t');
+
+			if (key != _calibrationKey) {
+				cacheLines.push_back(line);
+
+				continue;
+			}
+
+			for (int i = 0; i < devices.size(); i++)
+				if (devices[i]._platformName == platformName && devices[i]._deviceName == deviceName) {
+#ifdef SYS_DEBUG
+					std::cout << "Using cached device choice." << std::endl;
+#endif
+					return i;
+				}
+		}
+	}
+
+	int best = 0;
+	double bestTime = -1.0;
+
+	for (int i = 0; i < devices.size(); i++) {
+		ComputeSystem candidate;
+
+		std::vector<cl::Device> candidateDevices(1, devices[i]._device);
+
+		candidate.createShared(devices[i]._platform, devices[i]._device, cl::Context(candidateDevices), candidateDevices);
+
+		double time = _calibration(candidate);
+
+#ifdef SYS_DEBUG
+		std::cout << "Calibration on " << devices[i]._deviceName << " (" << devices[i]._platformName << "): ";
+
+		if (time < 0.0)
+			std::cout << "failed" << std::endl;
+		else
+			std::cout << time * 1000.0 << " ms" << std::endl;
+#endif
+
+		if (time >= 0.0 && (bestTime < 0.0 || time < bestTime)) {
+			best = i;
+			bestTime = time;
+		}
+	}
+
+	cacheLines.push_back(_calibrationKey + "\t" + devices[best]._platformName + "\t" + devices[best]._deviceName);
+
+	std::ofstream toFile(cacheFileName);
+
+	for (int i = 0; i < cacheLines.size(); i++)
+		toFile << cacheLines[i] << std::endl;
+
+	return best;
+}
+
+bool ComputeSystem::create(DeviceType type, bool createFromGLContext, int numSubDevices) {
+	if (type == _none) {
+#ifdef SYS_DEBUG
+		std::cout << "No OpenCL context created." << std::endl;
+#endif
+		return true;
+	}
+
+	std::vector<DeviceDesc> candidates = listDevices();
+
+	if (candidates.empty()) {
+#ifdef SYS_DEBUG
+		std::cout << "No devices found. Check your OpenCL installation." << std::endl;
+#endif
+		return false;
+	}
+
+	int chosen = -1;
+
+	const char* selection = std::getenv("NEORL_DEVICE");
+
+	if (selection != nullptr) {
+		std::string name(selection);
+
+		if (name == "auto")
+			type = _auto;
+		else if (!name.empty() && std::all_of(name.begin(), name.end(), ::isdigit)) {
+			int index = std::stoi(name);
+
+			if (index < candidates.size())
+				chosen = index;
+		}
+		else {
+			for (int i = 0; i < candidates.size(); i++)
+				if (candidates[i]._deviceName.find(name) != std::string::npos || candidates[i]._platformName.find(name) != std::string::npos) {
+					chosen = i;
+
+					break;
+				}
+		}
+
+#ifdef SYS_DEBUG
+		if (chosen == -1 && type != _auto)
+			std::cout << "NEORL_DEVICE=" << name << " matches no device, ignoring it." << std::endl;
+#endif
+	}
+
+	if (chosen == -1) {
+		if (type == _auto)
+			chosen = selectAuto(candidates);
+		else {
+			cl_device_type typeBits = type == _cpu ? CL_DEVICE_TYPE_CPU : (type == _gpu ? CL_DEVICE_TYPE_GPU : CL_DEVICE_TYPE_ALL);
+
+			for (int i = 0; i < candidates.size(); i++)
+				if (candidates[i]._type & typeBits) {
+					chosen = i;
+
+					break;
+				}
+		}
+	}
+
+	if (chosen == -1) {
+#ifdef SYS_DEBUG
+		std::cout << "No devices found. Check your OpenCL installation." << std::endl;
+#endif
+		return false;
+	}
+
+	_platform = candidates[chosen]._platform;
+	_device = candidates[chosen]._device;
+
+#ifdef SYS_DEBUG
+	std::cout << "Using platform: " << candidates[chosen]._platformName << std::endl;
+	std::cout << "Using device: " << candidates[chosen]._deviceName << std::endl;
+#endif
+
+	// Devices of the same platform and type, for spreading work over when the device can not be partitioned.
+	// The chosen device comes first, so it is always among the ones used
+	std::vector<cl::Device> allDevices(1, _device);
+
+	for (int i = 0; i < candidates.size(); i++)
+		if (i != chosen && candidates[i]._platform() == _platform() && candidates[i]._type == candidates[chosen]._type)
+			allDevices.push_back(candidates[i]._device);
+
+	_contextDevices.assign(1, _device);
+
+	_subDevices.clear();
+	_subQueues.clear();
+
+	if (numSubDevices > 0 && !createFromGLContext) {
+		cl_uint computeUnits = _device.getInfo<CL_DEVICE_MAX_COMPUTE_UNITS>();
+
+		cl_device_partition_property properties[] = {
+			CL_DEVICE_PARTITION_EQUALLY, static_cast<cl_device_partition_property>(std::max<cl_uint>(1, computeUnits / numSubDevices)), 0
+		};
+
+		std::vector<cl::Device> subDevices;
+
+		if (_device.getInfo<CL_DEVICE_PARTITION_MAX_SUB_DEVICES>() > 1 && _device.createSubDevices(properties, &subDevices) == CL_SUCCESS && subDevices.size() > 1) {
+			subDevices.resize(std::min<size_t>(subDevices.size(), numSubDevices));
+
+			// The parent stays in the context so the main queue keeps the whole device
+			_subDevices = subDevices;
+
+			_contextDevices.insert(_contextDevices.end(), _subDevices.begin(), _subDevices.end());
+		}
+		else if (allDevices.size() > 1) {
+			_subDevices.assign(allDevices.begin(), allDevices.begin() + std::min<size_t>(allDevices.size(), numSubDevices));
+
+			// Starts with the device, which the main queue is created on
+			_contextDevices = _subDevices;
+		}
+
+#ifdef SYS_DEBUG
+		std::cout << "Using " << _subDevices.size() << " sub-devices." << std::endl;
+#endif
+	}
+	
+#if(SYS_ALLOW_CL_GL_CONTEXT)
+	if (createFromGLContext) {
+#if defined (__APPLE__) || defined(MACOSX)
+		CGLContextObj kCGLContext = CGLGetCurrentContext();
+		CGLShareGroupObj kCGLShareGroup = CGLGetShareGroup(kCGLContext);
+		cl_context_properties props[] = {
+			CL_CONTEXT_PROPERTY_USE_CGL_SHAREGROUP_APPLE, (cl_context_properties)kCGLShareGroup,
+			0
+		};
+#else
+#if defined WIN32
+		cl_context_properties props[] = {
+			CL_GL_CONTEXT_KHR, (cl_context_properties)wglGetCurrentContext(),
+			CL_WGL_HDC_KHR, (cl_context_properties)wglGetCurrentDC(),
+			CL_CONTEXT_PLATFORM, (cl_context_properties)static_cast<cl_platform_id>(_platform()),
+			0
+		};
+#else
+		cl_context_properties props[] = {
+			CL_GL_CONTEXT_KHR, (cl_context_properties)glXGetCurrentContext(),
+			CL_GLX_DISPLAY_KHR, (cl_context_properties)glXGetCurrentDisplay(),
+			CL_CONTEXT_PLATFORM, (cl_context_properties)static_cast<cl_platform_id>(_platform()),
+			0
+		};
+#endif
+#endif
+
+		_context = cl::Context(_device, props);
+	}
+	else
+#endif
+		_context = cl::Context(_contextDevices);
+
+	_queue = cl::CommandQueue(_context, _device);
+
+	for (int i = 0; i < _subDevices.size(); i++)
+		_subQueues.push_back(cl::CommandQueue(_context, _subDevices[i]));
+
+	// Nothing to spread over, separate queues on the device can still overlap
+	if (numSubDevices > 0 && _subQueues.empty())
+		for (int i = 0; i < numSubDevices; i++)
+			_subQueues.push_back(createQueue());
+
+	return true;
+}
+
+void ComputeSystem::createShared(const cl::Platform &platform, const cl::Device &device, const cl::Context &context, const std::vector<cl::Device> &contextDevices) {
+	_platform = platform;
+	_device = device;
+	_context = context;
+	_contextDevices = contextDevices;
+
+	_subDevices.clear();
+	_subQueues.clear();
+
+	_queue = cl::CommandQueue(_context, _device);
 }
\ No newline at end of file
@@ -1,71 +1,195 @@
-#pragma once
-
-#include <system/Uncopyable.h>
-
-#define CL_HPP_MINIMUM_OPENCL_VERSION 200
-#define CL_HPP_TARGET_OPENCL_VERSION 200
-
-#include <CL/cl2.hpp>
-
-#define SYS_DEBUG
-
-#define SYS_ALLOW_CL_GL_CONTEXT 0
-
-namespace sys {
-	/*!
-	\brief Compute system
-	Holds OpenCL platform, device, context, and command queue
-	*/
-	class ComputeSystem : private Uncopyable {
-	public:
-		enum DeviceType {
-			_cpu, _gpu, _all, _none
-		};
-
-	private:
-		//!@{
-		/*!
-		\brief OpenCL handles
-		*/
-		cl::Platform _platform;
-		cl::Device _device;
-		cl::Context _context;
-		cl::CommandQueue _queue;
-		//!@}
-
-	public:
-		/*!
-		\brief Create compute system with a given device type
-		Optional: Create from an OpenGL context
-		*/
-		bool create(DeviceType type, bool createFromGLContext = false);
-
-		/*!
-		\brief Get underlying OpenCL platform
-		*/
-		cl::Platform &getPlatform() {
-			return _platform;
-		}
-
-		/*!
-		\brief Get underlying OpenCL device
-		*/
-		cl::Device &getDevice() {
-			return _device;
-		}
-
-		/*!
-		\brief Get underlying OpenCL context
-		*/
-		cl::Context &getContext() {
-			return _context;
-		}
-
-		/*!
-		\brief Get underlying OpenCL command queue
-		*/
-		cl::CommandQueue &getQueue() {
-			return _queue;
-		}
-	};
+#pragma once
+
+#include <system/Uncopyable.h>
+
+#define CL_HPP_MINIMUM_OPENCL_VERSION 200
+#define CL_HPP_TARGET_OPENCL_VERSION 200
+
+#include <CL/cl2.hpp>
+
+#include <functional>
+
+#define SYS_DEBUG
+
+#define SYS_ALLOW_CL_GL_CONTEXT 0
+
+namespace sys {
+	/*!
+	\brief Compute system
+	Holds OpenCL platform, device, context, and command queue
+	*/
+	class ComputeSystem : private Uncopyable {
+	public:
+		enum DeviceType {
+			_cpu, _gpu, _all, _auto, _none
+		};
+
+		/*!
+		\brief Platform/device pair found by listDevices
+		*/
+		struct DeviceDesc {
+			//!@{
+			/*!
+			\brief OpenCL handles
+			*/
+			cl::Platform _platform;
+			cl::Device _device;
+			//!@}
+
+			//!@{
+			/*!
+			\brief Names, as reported by the platform and device
+			*/
+			std::string _platformName;
+			std::string _deviceName;
+			//!@}
+
+			/*!
+			\brief Device type bits
+			*/
+			cl_device_type _type;
+		};
+
+		/*!
+		\brief Workload timed on each candidate device by _auto selection, returns seconds (negative if it could not run)
+		*/
+		typedef std::function<double(ComputeSystem &cs)> CalibrationFunction;
+
+	private:
+		//!@{
+		/*!
+		\brief OpenCL handles
+		*/
+		cl::Platform _platform;
+		cl::Device _device;
+		cl::Context _context;
+		cl::CommandQueue _queue;
+		//!@}
+
+		/*!
+		\brief Devices the context was created with (the device, plus any sub-devices or other devices)
+		*/
+		std::vector<cl::Device> _contextDevices;
+
+		//!@{
+		/*!
+		\brief Devices and queues that independent work (e.g. pipelined layers) can be spread over
+		Sub-devices of the device, other devices of the platform, or if neither is available, more queues on the device
+		*/
+		std::vector<cl::Device> _subDevices;
+		std::vector<cl::CommandQueue> _subQueues;
+		//!@}
+
+		//!@{
+		/*!
+		\brief Calibration used by _auto selection, and the key its cached choice is stored under
+		*/
+		static CalibrationFunction _calibration;
+		static std::string _calibrationKey;
+		//!@}
+
+		/*!
+		\brief Pick a device for _auto, by calibration (cached) if set, otherwise the first GPU
+		*/
+		static int selectAuto(const std::vector<DeviceDesc> &devices);
+
+	public:
+		/*!
+		\brief List every platform/device pair, in platform then device order (the index used by NEORL_DEVICE)
+		*/
+		static std::vector<DeviceDesc> listDevices();
+
+		/*!
+		\brief Set the workload _auto selection times, key identifies it (e.g. its configuration) in the cache
+		*/
+		static void setCalibration(const std::string &key, const CalibrationFunction &calibration) {
+			_calibrationKey = key;
+			_calibration = calibration;
+		}
+
+		/*!
+		\brief Create compute system with a given device type
+		The environment variable NEORL_DEVICE overrides the type: an index into listDevices, part of a device or platform name, or "auto".
+		_auto times the calibration workload on every device and picks the fastest. The choice is cached per calibration key
+		in the file named by NEORL_DEVICE_CACHE (default neoDevice.cache), and reused while that device is present.
+		Optional: Create from an OpenGL context.
+		With numSubDevices > 0 the device is partitioned into that many sub-devices (clCreateSubDevices, mostly CPU devices) with a queue each.
+		Without partitioning support, other devices of the platform are used instead, or failing that, extra queues on the device
+		*/
+		bool create(DeviceType type, bool createFromGLContext = false, int numSubDevices = 0);
+
+		/*!
+		\brief Create on one device of an existing context (e.g. one affinity domain of a partitioned device), with its own queue
+		Compute systems created this way share memory objects and programs built for contextDevices
+		*/
+		void createShared(const cl::Platform &platform, const cl::Device &device, const cl::Context &context, const std::vector<cl::Device> &contextDevices);
+
+		/*!
+		\brief Get underlying OpenCL platform
+		*/
+		cl::Platform &getPlatform() {
+			return _platform;
+		}
+
+		/*!
+		\brief Get underlying OpenCL device
+		*/
+		cl::Device &getDevice() {
+			return _device;
+		}
+
+		/*!
+		\brief Get all devices of the context, programs are built for these
+		*/
+		const std::vector<cl::Device> &getContextDevices() const {
+			return _contextDevices;
+		}
+
+		/*!
+		\brief Get underlying OpenCL context
+		*/
+		cl::Context &getContext() {
+			return _context;
+		}
+
+		/*!
+		\brief Get underlying OpenCL command queue
+		*/
+		cl::CommandQueue &getQueue() {
+			return _queue;
+		}
+
+		/*!
+		\brief Get number of sub-device queues (0 unless created with numSubDevices > 0)
+		*/
+		size_t getNumSubQueues() const {
+			return _subQueues.size();
+		}
+
+		/*!
+		\brief Get a sub-device queue
+		*/
+		cl::CommandQueue &getSubQueue(int index) {
+			return _subQueues[index];
+		}
+
+		/*!
+		\brief Create an additional in-order queue on the same device, for work that should overlap with the main queue
+		*/
+		cl::CommandQueue createQueue() {
+			return cl::CommandQueue(_context, _device);
+		}
+
+		/*!
+		\brief Route getQueue to another queue, returns the queue it replaces
+		Lets code that enqueues through getQueue run on a queue from createQueue without changes. Swap back when done
+		*/
+		cl::CommandQueue swapQueue(const cl::CommandQueue &queue) {
+			cl::CommandQueue previous = _queue;
+
+			_queue = queue;
+
+			return previous;
+		}
+	};
 }
\ No newline at end of file